@@ -20,6 +20,9 @@
 
 #include "vtkPlanarContourToClosedSurfaceConversionRule.h"
 
+// SlicerRT includes
+#include "SlicerRtCommon.h"
+
 // VTK includes
 #include <vtkVersion.h>
 #include <vtkObjectFactory.h>
@@ -46,10 +49,267 @@
 #include <vtkTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkUnstructuredGrid.h>
+#include <vtkTimerLog.h>
+#include <vtkVariant.h>
+#include <vtkPointLocator.h>
 
 // STD includes
 #include <algorithm>
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Index of the XY bounding boxes of the lines on a contour plane, used to find the lines
+  /// that may overlap with a line on the adjacent plane without testing every pair of lines.
+  /// The lines are sorted by the lower X bound of their bounding box, so the lines that start
+  /// before the end of the query interval are found by binary search, and only those are
+  /// checked for overlap.
+  class PlaneLineBoundsIndex
+  {
+  public:
+    /// \param lineBounds Bounds of all the lines (6 values per line)
+    /// \param firstLineIndex Index of the first line on the plane
+    /// \param numberOfLines Number of lines on the plane
+    PlaneLineBoundsIndex(const std::vector<double>& lineBounds, vtkIdType firstLineIndex, int numberOfLines)
+      : LineBounds(lineBounds)
+      {
+      this->SortedLines.reserve(numberOfLines);
+      for (vtkIdType lineIndex = firstLineIndex; lineIndex < firstLineIndex + numberOfLines; ++lineIndex)
+        {
+        this->SortedLines.push_back(std::make_pair(lineBounds[6*lineIndex], lineIndex));
+        }
+      std::sort(this->SortedLines.begin(), this->SortedLines.end());
+      }
+
+    /// Get the indices of the indexed lines whose bounding box overlaps with the given bounds.
+    /// The indices are returned in increasing order.
+    void FindOverlappingLines(const double* bounds, std::vector<vtkIdType>& overlappingLineIndices) const
+      {
+      overlappingLineIndices.clear();
+      // Only the lines that start before the end of the query interval can overlap
+      std::vector<std::pair<double, vtkIdType> >::const_iterator candidatesEnd = std::lower_bound(
+        this->SortedLines.begin(), this->SortedLines.end(), std::make_pair(bounds[1], static_cast<vtkIdType>(-1)));
+      for (std::vector<std::pair<double, vtkIdType> >::const_iterator lineIt = this->SortedLines.begin(); lineIt != candidatesEnd; ++lineIt)
+        {
+        const double* candidateBounds = &(this->LineBounds[6*lineIt->second]);
+        if (vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(bounds, candidateBounds))
+          {
+          overlappingLineIndices.push_back(lineIt->second);
+          }
+        }
+      std::sort(overlappingLineIndices.begin(), overlappingLineIndices.end());
+      }
+
+  private:
+    const std::vector<double>& LineBounds;
+    /// Lower X bound and index of the lines, sorted by lower X bound
+    std::vector<std::pair<double, vtkIdType> > SortedLines;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Triangles and triangulation flags computed for a pair of adjacent planes
+  struct PlanePairTriangulationResult
+  {
+    /// Triangles between the lines of the two planes
+    vtkSmartPointer<vtkCellArray> Polygons;
+    /// Flags for the lines on the lower plane telling if they were triangulated to a line on the upper plane
+    std::vector<bool> LineTriangulatedToAbove;
+    /// Flags for the lines on the upper plane telling if they were triangulated to a line on the lower plane
+    std::vector<bool> LineTriangulatedToBelow;
+  };
+}
+
+//----------------------------------------------------------------------------
+/// Lightweight closest point locator for the points of a contour line.
+/// The points are stored in flat arrays, ordered as an implicit 2D KD-tree: the range of points is split
+/// at its median along the axis (X or Y) of its larger extent, the median point is stored in the middle
+/// of the range, and the two halves are split recursively. Small ranges are searched linearly.
+/// Distances are computed in 3D, so the result is the same as a linear search over all the points
+/// (if multiple points are at the same distance, then the first one in the line is returned).
+/// The locator is not modified by queries, so it can be used from multiple threads.
+class vtkPlanarContourToClosedSurfaceConversionRule::LinePointLocator
+{
+public:
+  /// Build the locator
+  /// \param points Points of the polydata containing the line
+  /// \param linePointIds IDs of the points in the line
+  void BuildLocator(vtkPoints* points, vtkIdList* linePointIds)
+    {
+    int numberOfPoints = linePointIds->GetNumberOfIds();
+    std::vector<double> lineCoordinates(3*numberOfPoints);
+    std::vector<int> positions(numberOfPoints);
+    for (int position = 0; position < numberOfPoints; ++position)
+      {
+      points->GetPoint(linePointIds->GetId(position), &(lineCoordinates[3*position]));
+      positions[position] = position;
+      }
+    this->SplitAxes.assign(numberOfPoints, 0);
+    this->BuildRange(lineCoordinates, positions, 0, numberOfPoints);
+
+    // Store the points in tree order
+    this->Coordinates.resize(3*numberOfPoints);
+    this->Positions.resize(numberOfPoints);
+    for (int index = 0; index < numberOfPoints; ++index)
+      {
+      this->Positions[index] = positions[index];
+      for (int axis = 0; axis < 3; ++axis)
+        {
+        this->Coordinates[3*index+axis] = lineCoordinates[3*positions[index]+axis];
+        }
+      }
+    }
+
+  /// Find the point of the line closest to the given point
+  /// \return Position of the closest point in the line (index in the point ID list), -1 if the line has no points
+  vtkIdType FindClosestPoint(const double point[3]) const
+    {
+    vtkIdType closestPosition = -1;
+    double minimumDistance2 = VTK_DOUBLE_MAX;
+    this->FindClosestPointInRange(point, 0, static_cast<int>(this->Positions.size()), closestPosition, minimumDistance2);
+    return closestPosition;
+    }
+
+protected:
+  /// Ranges with at most this many points are not split
+  static const int LeafSize = 8;
+
+  /// Compares positions by one coordinate of the corresponding points
+  class PositionComparator
+    {
+    public:
+      PositionComparator(const std::vector<double>& coordinates, int axis) : Coordinates(coordinates), Axis(axis) { }
+      bool operator()(int position1, int position2) const
+        {
+        return this->Coordinates[3*position1+this->Axis] < this->Coordinates[3*position2+this->Axis];
+        }
+    private:
+      const std::vector<double>& Coordinates;
+      int Axis;
+    };
+
+  void BuildRange(const std::vector<double>& coordinates, std::vector<int>& positions, int begin, int end)
+    {
+    if (end - begin <= LeafSize)
+      {
+      return;
+      }
+    // Split along the axis of larger extent
+    double bounds[4] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int index = begin; index < end; ++index)
+      {
+      const double* coordinate = &(coordinates[3*positions[index]]);
+      bounds[0] = std::min(bounds[0], coordinate[0]);
+      bounds[1] = std::max(bounds[1], coordinate[0]);
+      bounds[2] = std::min(bounds[2], coordinate[1]);
+      bounds[3] = std::max(bounds[3], coordinate[1]);
+      }
+    int axis = (bounds[1] - bounds[0] >= bounds[3] - bounds[2] ? 0 : 1);
+    int middle = (begin + end) / 2;
+    std::nth_element(positions.begin() + begin, positions.begin() + middle, positions.begin() + end,
+      PositionComparator(coordinates, axis));
+    this->SplitAxes[middle] = axis;
+    this->BuildRange(coordinates, positions, begin, middle);
+    this->BuildRange(coordinates, positions, middle + 1, end);
+    }
+
+  void CheckPoint(const double point[3], int index, vtkIdType& closestPosition, double& minimumDistance2) const
+    {
+    double distance2 = vtkMath::Distance2BetweenPoints(point, &(this->Coordinates[3*index]));
+    if (distance2 < minimumDistance2 || (distance2 == minimumDistance2 && this->Positions[index] < closestPosition))
+      {
+      minimumDistance2 = distance2;
+      closestPosition = this->Positions[index];
+      }
+    }
+
+  void FindClosestPointInRange(const double point[3], int begin, int end, vtkIdType& closestPosition, double& minimumDistance2) const
+    {
+    if (end - begin <= LeafSize)
+      {
+      for (int index = begin; index < end; ++index)
+        {
+        this->CheckPoint(point, index, closestPosition, minimumDistance2);
+        }
+      return;
+      }
+    int middle = (begin + end) / 2;
+    this->CheckPoint(point, middle, closestPosition, minimumDistance2);
+    int axis = this->SplitAxes[middle];
+    double difference = point[axis] - this->Coordinates[3*middle+axis];
+    // Search the half containing the point first, then the other half only if it may contain a closer point
+    // (or a point at the same distance, which may be earlier in the line)
+    if (difference < 0)
+      {
+      this->FindClosestPointInRange(point, begin, middle, closestPosition, minimumDistance2);
+      if (difference*difference <= minimumDistance2)
+        {
+        this->FindClosestPointInRange(point, middle + 1, end, closestPosition, minimumDistance2);
+        }
+      }
+    else
+      {
+      this->FindClosestPointInRange(point, middle + 1, end, closestPosition, minimumDistance2);
+      if (difference*difference <= minimumDistance2)
+        {
+        this->FindClosestPointInRange(point, begin, middle, closestPosition, minimumDistance2);
+        }
+      }
+    }
+
+protected:
+  /// Point coordinates in tree order (3 values per point)
+  std::vector<double> Coordinates;
+  /// Position of the points in the line, in tree order
+  std::vector<vtkIdType> Positions;
+  /// Split axis of the ranges, stored at the index of their median point
+  std::vector<char> SplitAxes;
+};
+
+//----------------------------------------------------------------------------
+/// Triangulate a range of plane pairs. Used for processing the plane pairs in parallel with SlicerRtCommon::SmpFor.
+class vtkPlanarContourToClosedSurfaceConversionRule::PlanePairTriangulationFunctor
+{
+public:
+  PlanePairTriangulationFunctor(vtkPlanarContourToClosedSurfaceConversionRule* rule, vtkPolyData* inputROIPoints,
+    const std::vector<std::pair<vtkIdType, int> >& planes, const std::vector<vtkSmartPointer<vtkLine> >& lines,
+    const std::vector<double>& lineBounds, const std::vector<vtkSmartPointer<vtkIdList> >& linePointIdLists,
+    const std::vector<LinePointLocator>& linePointLocators, std::vector<PlanePairTriangulationResult>& results)
+    : Rule(rule)
+    , InputROIPoints(inputROIPoints)
+    , Planes(planes)
+    , Lines(lines)
+    , LineBounds(lineBounds)
+    , LinePointIdLists(linePointIdLists)
+    , LinePointLocators(linePointLocators)
+    , Results(results)
+    {
+    }
+
+  void operator()(vtkIdType beginPlanePairIndex, vtkIdType endPlanePairIndex)
+    {
+    for (vtkIdType planePairIndex = beginPlanePairIndex; planePairIndex < endPlanePairIndex; ++planePairIndex)
+      {
+      PlanePairTriangulationResult& result = this->Results[planePairIndex];
+      result.Polygons = vtkSmartPointer<vtkCellArray>::New();
+      this->Rule->TriangulatePlanePair(this->InputROIPoints,
+        this->Planes[planePairIndex].first, this->Planes[planePairIndex].second,
+        this->Planes[planePairIndex+1].first, this->Planes[planePairIndex+1].second,
+        this->Lines, this->LineBounds, this->LinePointIdLists, this->LinePointLocators,
+        result.Polygons, result.LineTriangulatedToAbove, result.LineTriangulatedToBelow);
+      }
+    }
+
+private:
+  vtkPlanarContourToClosedSurfaceConversionRule* Rule;
+  vtkPolyData* InputROIPoints;
+  const std::vector<std::pair<vtkIdType, int> >& Planes;
+  const std::vector<vtkSmartPointer<vtkLine> >& Lines;
+  const std::vector<double>& LineBounds;
+  const std::vector<vtkSmartPointer<vtkIdList> >& LinePointIdLists;
+  const std::vector<LinePointLocator>& LinePointLocators;
+  std::vector<PlanePairTriangulationResult>& Results;
+};
+
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToClosedSurfaceConversionRule);
 
@@ -67,7 +327,8 @@ vtkPlanarContourToClosedSurfaceConversionRule::vtkPlanarContourToClosedSurfaceCo
   this->ImagePadding[1] = 4;
   this->ImagePadding[2] = 0;
 
-  //this->ConversionParameters[GetXYParameterName()] = std::make_pair("value", "description");
+  this->ConversionParameters[GetNumberOfThreadsParameterName()] = std::make_pair("0",
+    "Number of threads used for triangulating the pairs of adjacent contour planes (0: use all available threads, 1: single-threaded). The result does not depend on the number of threads.");
 }
 
 //----------------------------------------------------------------------------
@@ -126,6 +387,9 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     return false;
     }
 
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+
   // Copy the contours so that we can make modifications without affecting the original
   vtkSmartPointer<vtkPolyData> inputContoursCopy = vtkSmartPointer<vtkPolyData>::New();
   
@@ -158,18 +422,22 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
 
   double spacing = this->GetSpacingBetweenLines(inputContoursCopy);
 
-  std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators(numberOfLines);
+  double checkpointPreprocessingEnd = timer->GetUniversalTime();
+
+  // The lines are copied and their bounds and point locators are computed only once, as the input lines
+  // are not modified until end-capping
+  std::vector<vtkSmartPointer<vtkLine> > lines(numberOfLines);
+  std::vector<double> lineBounds(6*numberOfLines);
   std::vector<vtkSmartPointer<vtkIdList> > linePointIdLists(numberOfLines);
+  std::vector<LinePointLocator> linePointLocators(numberOfLines);
   for(int lineIndex = 0; lineIndex < numberOfLines; ++lineIndex)
     {
     vtkSmartPointer<vtkLine> currentLine = vtkSmartPointer<vtkLine>::New();
     currentLine->DeepCopy(inputContoursCopy->GetCell(lineIndex));
+    lines[lineIndex] = currentLine;
+    currentLine->GetBounds(&(lineBounds[6*lineIndex]));
     linePointIdLists[lineIndex] = currentLine->GetPointIds();
-    vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-    linePolyData->SetPoints(currentLine->GetPoints());
-    pointLocators[lineIndex] = vtkSmartPointer<vtkPointLocator>::New();
-    pointLocators[lineIndex]->SetDataSet(linePolyData);
-    pointLocators[lineIndex]->BuildLocator();
+    linePointLocators[lineIndex].BuildLocator(inputContoursCopy->GetPoints(), currentLine->GetPointIds());
     }
 
   // Vector of booleans to determine which lines are triangulated from above and from below.
@@ -181,124 +449,61 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     lineTriganulatedToBelow[i] = false;
     }
 
-  // Get two consecutive planes.
-  vtkIdType firstLineOnPlane1Index = 0; // pointer to first line on plane 1.
-  int numberOfLinesInPlane1 = this->GetNumberOfLinesOnPlane(inputContoursCopy, 0, spacing);
-
-  // Loop through all of the contours in the polydata
-  while (firstLineOnPlane1Index + numberOfLinesInPlane1 < numberOfLines)
+  // Find the planes (first line index and number of lines for each plane).
+  // Each pair of consecutive planes is triangulated independently from the other pairs.
+  std::vector<std::pair<vtkIdType, int> > planes;
+  vtkIdType firstLineOnPlaneIndex = 0;
+  while (firstLineOnPlaneIndex < numberOfLines)
     {
-    vtkIdType firstLineOnPlane2Index = firstLineOnPlane1Index + numberOfLinesInPlane1; // pointer to first line on plane 2
-    int numberOfLinesInPlane2 = this->GetNumberOfLinesOnPlane(inputContoursCopy, firstLineOnPlane2Index, spacing); // number of lines on plane 2
-
-    // initialize overlaps lists. - list of list
-    // Each internal list represents a line from the plane and will store the pointers to the overlap lines
+    int numberOfLinesInPlane = this->GetNumberOfLinesOnPlane(inputContoursCopy, firstLineOnPlaneIndex, spacing);
+    planes.push_back(std::make_pair(firstLineOnPlaneIndex, numberOfLinesInPlane));
+    firstLineOnPlaneIndex += numberOfLinesInPlane;
+    }
+  int numberOfPlanePairs = std::max(static_cast<int>(planes.size()) - 1, 0);
 
-    // List of Overlaps for lines from plane 1
-    std::vector< std::vector< vtkIdType > > plane1Overlaps;
-    for (int line1Index = 0; line1Index < numberOfLinesInPlane1; ++line1Index)
-      {
-      std::vector< vtkIdType > temp;
-      plane1Overlaps.push_back(temp);
-      }
+  // Triangulate the plane pairs. The triangles of each plane pair are collected separately
+  // and appended to the output in plane order, so the result does not depend on the order
+  // in which the plane pairs are processed.
+  std::vector<PlanePairTriangulationResult> planePairResults(numberOfPlanePairs);
+  PlanePairTriangulationFunctor triangulationFunctor(this, inputContoursCopy, planes, lines, lineBounds, linePointIdLists, linePointLocators, planePairResults);
+  int numberOfThreads = vtkVariant(this->ConversionParameters[GetNumberOfThreadsParameterName()].first).ToInt();
+  SlicerRtCommon::SmpFor(0, numberOfPlanePairs, 1, triangulationFunctor, numberOfThreads);
 
-    // overlaps for lines from plane 2
-    std::vector< std::vector< vtkIdType > > plane2Overlaps;
-    for (int line2Index=0; line2Index < numberOfLinesInPlane2; ++line2Index)
+  for (int planePairIndex = 0; planePairIndex < numberOfPlanePairs; ++planePairIndex)
+    {
+    PlanePairTriangulationResult& result = planePairResults[planePairIndex];
+    vtkIdType npts = 0;
+    vtkIdType* pts = NULL;
+    for (result.Polygons->InitTraversal(); result.Polygons->GetNextCell(npts, pts); )
       {
-      std::vector< vtkIdType > temp;
-      plane2Overlaps.push_back(temp);
+      outputPolygons->InsertNextCell(npts, pts);
       }
 
-    // Loop through the lines in the first plane
-    for (int line1Index=0; line1Index < numberOfLinesInPlane1; ++line1Index)
+    vtkIdType firstLineOnPlane1Index = planes[planePairIndex].first;
+    for (unsigned int line1Index = 0; line1Index < result.LineTriangulatedToAbove.size(); ++line1Index)
       {
-      vtkSmartPointer<vtkLine> line1 = vtkSmartPointer<vtkLine>::New();
-      line1->DeepCopy(inputContoursCopy->GetCell(firstLineOnPlane1Index+line1Index));
-
-      // Loop through the lines in the second plane
-      for (int line2Index=0; line2Index < numberOfLinesInPlane2; ++line2Index)
+      if (result.LineTriangulatedToAbove[line1Index])
         {
-        vtkSmartPointer<vtkLine> line2 = vtkSmartPointer<vtkLine>::New();
-        line2->DeepCopy(inputContoursCopy->GetCell(firstLineOnPlane2Index+line2Index));
-
-        // If the two lines overlap, then add them to the lists
-        if (this->DoLinesOverlap(line1, line2))
-          {
-          // line from plane 1 overlaps with line from plane 2
-          plane1Overlaps[line1Index].push_back(firstLineOnPlane2Index+line2Index);
-          plane2Overlaps[line2Index].push_back(firstLineOnPlane1Index+line1Index);
-          }
+        lineTriganulatedToAbove[firstLineOnPlane1Index + line1Index] = true;
         }
       }
-
-    // Loop through all of the lines in the first plane
-    for (int line1Index = firstLineOnPlane1Index; line1Index < firstLineOnPlane1Index+numberOfLinesInPlane1; ++line1Index)
+    vtkIdType firstLineOnPlane2Index = planes[planePairIndex+1].first;
+    for (unsigned int line2Index = 0; line2Index < result.LineTriangulatedToBelow.size(); ++line2Index)
       {
-      vtkSmartPointer<vtkLine> line1 = vtkSmartPointer<vtkLine>::New();
-      line1->DeepCopy(inputContoursCopy->GetCell(line1Index));
-
-      bool intersects = false;
-
-      std::vector<vtkSmartPointer<vtkPointLocator> > overlap1PointLocators(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
-      std::vector<vtkSmartPointer<vtkIdList> > overlap1PointIds(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
-
-      // Loop through all of the lines in the second plane that overlap with the current line in the first plane
-      for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
+      if (result.LineTriangulatedToBelow[line2Index])
         {
-        int j = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
-        overlap1PointLocators[overlapIndex] = (pointLocators[j]);
-        overlap1PointIds[overlapIndex] = (linePointIdLists[j]);
-        }
-
-      // Loop through all of the lines in the second plane that overlap with the current line in the first plane
-      for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
-        {
-        int line2Index = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
-
-        vtkSmartPointer<vtkLine> line2 = vtkSmartPointer<vtkLine>::New();
-        line2->DeepCopy(inputContoursCopy->GetCell(line2Index));
-
-        std::vector<vtkSmartPointer<vtkPointLocator> > overlap2PointLocators(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
-        std::vector<vtkSmartPointer<vtkIdList> > overlap2PointIds(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
-
-        for (int i=0; i<plane2Overlaps[line2Index-firstLineOnPlane2Index].size(); ++i)
-          {
-          int j = plane2Overlaps[line2Index-firstLineOnPlane2Index][i];
-          overlap2PointLocators[i] = (pointLocators[j]);
-          overlap2PointIds[i] = (linePointIdLists[j]);
-          }
-
-        // Get the portion of line 1 that is close to line 2,
-        vtkSmartPointer<vtkLine> dividedLine1 = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputContoursCopy, line1, line2Index, plane1Overlaps[line1Index-firstLineOnPlane1Index], overlap1PointLocators, overlap1PointIds, dividedLine1);
-        vtkSmartPointer<vtkIdList> dividedPointsInLine1 = dividedLine1->GetPointIds();
-        int numberOfdividedPointsInLine1 = dividedLine1->GetNumberOfPoints();
-
-        // Get the portion of line 2 that is close to line 1.
-        vtkSmartPointer<vtkLine> dividedLine2 = vtkSmartPointer<vtkLine>::New();
-        this->Branch(inputContoursCopy, line2, line1Index, plane2Overlaps[line2Index-firstLineOnPlane2Index], overlap2PointLocators, overlap2PointIds, dividedLine2);
-        vtkSmartPointer<vtkIdList> dividedPointsInLine2 = dividedLine2->GetPointIds();
-        int numberOfdividedPointsInLine2 = dividedLine2->GetNumberOfPoints();
-
-        if (numberOfdividedPointsInLine1 > 1 && numberOfdividedPointsInLine2 > 1)
-          {
-          lineTriganulatedToAbove[line1Index] = true;
-          lineTriganulatedToBelow[line2Index] = true;
-          this->TriangulateContours(inputContoursCopy, dividedPointsInLine1, dividedPointsInLine2, outputPolygons);
-          }
-
+        lineTriganulatedToBelow[firstLineOnPlane2Index + line2Index] = true;
         }
       }
-
-    // Advance the points
-    firstLineOnPlane1Index = firstLineOnPlane2Index;
-    numberOfLinesInPlane1 = numberOfLinesInPlane2;
     }
 
+  double checkpointTriangulationEnd = timer->GetUniversalTime();
+
   // Triangulate all contours which are exposed.
   this->EndCapping( inputContoursCopy, outputPolygons, lineTriganulatedToAbove, lineTriganulatedToBelow);
 
+  double checkpointEndCappingEnd = timer->GetUniversalTime();
+
   // Initialize the output data.
   closedSurfacePolyData->SetPoints(outputPoints);
   //closedSurfacePolyData->SetLines(outputLines); // Do not include lines in poly data for nicer visualization
@@ -314,9 +519,116 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
   transformPolyDataToRASFilter->Update();
   closedSurfacePolyData->DeepCopy(transformPolyDataToRASFilter->GetOutput());
 
+  double checkpointEnd = timer->GetUniversalTime();
+  vtkDebugMacro("Convert: Total conversion time for " << numberOfLines << " contours: " << checkpointEnd-checkpointStart << " s\n"
+    << "\tPreprocessing contours: " << checkpointPreprocessingEnd-checkpointStart << " s\n"
+    << "\tTriangulating between contours: " << checkpointTriangulationEnd-checkpointPreprocessingEnd << " s\n"
+    << "\tEnd-capping: " << checkpointEndCappingEnd-checkpointTriangulationEnd << " s\n"
+    << "\tTransforming output: " << checkpointEnd-checkpointEndCappingEnd << " s");
+
   return true;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::TriangulatePlanePair(vtkPolyData* inputROIPoints,
+  vtkIdType firstLineOnPlane1Index, int numberOfLinesInPlane1, vtkIdType firstLineOnPlane2Index, int numberOfLinesInPlane2,
+  const std::vector<vtkSmartPointer<vtkLine> >& lines, const std::vector<double>& lineBounds,
+  const std::vector<vtkSmartPointer<vtkIdList> >& linePointIdLists, const std::vector<LinePointLocator>& linePointLocators,
+  vtkCellArray* outputPolygons, std::vector<bool>& lineTriangulatedToAbove, std::vector<bool>& lineTriangulatedToBelow)
+{
+  if (!inputROIPoints)
+    {
+    vtkErrorMacro("TriangulatePlanePair: Invalid vtkPolyData!");
+    return;
+    }
+
+  if (!outputPolygons)
+    {
+    vtkErrorMacro("TriangulatePlanePair: Invalid vtkCellArray!");
+    return;
+    }
+
+  lineTriangulatedToAbove.assign(numberOfLinesInPlane1, false);
+  lineTriangulatedToBelow.assign(numberOfLinesInPlane2, false);
+
+  // initialize overlaps lists. - list of list
+  // Each internal list represents a line from the plane and will store the pointers to the overlap lines
+
+  // List of Overlaps for lines from plane 1
+  std::vector< std::vector< vtkIdType > > plane1Overlaps(numberOfLinesInPlane1);
+
+  // overlaps for lines from plane 2
+  std::vector< std::vector< vtkIdType > > plane2Overlaps(numberOfLinesInPlane2);
+
+  // Loop through the lines in the first plane, and find the overlapping lines in the second plane
+  // using the bounding box index of the second plane
+  PlaneLineBoundsIndex plane2Index(lineBounds, firstLineOnPlane2Index, numberOfLinesInPlane2);
+  std::vector<vtkIdType> overlappingLineIndices;
+  for (int line1Index=0; line1Index < numberOfLinesInPlane1; ++line1Index)
+    {
+    plane2Index.FindOverlappingLines(&(lineBounds[6*(firstLineOnPlane1Index+line1Index)]), overlappingLineIndices);
+    for (std::vector<vtkIdType>::iterator line2It = overlappingLineIndices.begin(); line2It != overlappingLineIndices.end(); ++line2It)
+      {
+      // line from plane 1 overlaps with line from plane 2
+      plane1Overlaps[line1Index].push_back(*line2It);
+      plane2Overlaps[*line2It-firstLineOnPlane2Index].push_back(firstLineOnPlane1Index+line1Index);
+      }
+    }
+
+  // Loop through all of the lines in the first plane
+  for (int line1Index = firstLineOnPlane1Index; line1Index < firstLineOnPlane1Index+numberOfLinesInPlane1; ++line1Index)
+    {
+    vtkLine* line1 = lines[line1Index];
+
+    std::vector<const LinePointLocator*> overlap1PointLocators(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
+    std::vector<vtkSmartPointer<vtkIdList> > overlap1PointIds(plane1Overlaps[line1Index-firstLineOnPlane1Index].size());
+
+    // Loop through all of the lines in the second plane that overlap with the current line in the first plane
+    for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
+      {
+      int j = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
+      overlap1PointLocators[overlapIndex] = &(linePointLocators[j]);
+      overlap1PointIds[overlapIndex] = (linePointIdLists[j]);
+      }
+
+    // Loop through all of the lines in the second plane that overlap with the current line in the first plane
+    for (int overlapIndex = 0; overlapIndex < plane1Overlaps[line1Index-firstLineOnPlane1Index].size(); ++overlapIndex) // lines on plane 2 that overlap with line 1
+      {
+      int line2Index = plane1Overlaps[line1Index-firstLineOnPlane1Index][overlapIndex];
+      vtkLine* line2 = lines[line2Index];
+
+      std::vector<const LinePointLocator*> overlap2PointLocators(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
+      std::vector<vtkSmartPointer<vtkIdList> > overlap2PointIds(plane2Overlaps[line2Index-firstLineOnPlane2Index].size());
+
+      for (int i=0; i<plane2Overlaps[line2Index-firstLineOnPlane2Index].size(); ++i)
+        {
+        int j = plane2Overlaps[line2Index-firstLineOnPlane2Index][i];
+        overlap2PointLocators[i] = &(linePointLocators[j]);
+        overlap2PointIds[i] = (linePointIdLists[j]);
+        }
+
+      // Get the portion of line 1 that is close to line 2,
+      vtkSmartPointer<vtkLine> dividedLine1 = vtkSmartPointer<vtkLine>::New();
+      this->Branch(inputROIPoints, line1, line2Index, plane1Overlaps[line1Index-firstLineOnPlane1Index], overlap1PointLocators, overlap1PointIds, dividedLine1);
+      vtkSmartPointer<vtkIdList> dividedPointsInLine1 = dividedLine1->GetPointIds();
+      int numberOfdividedPointsInLine1 = dividedLine1->GetNumberOfPoints();
+
+      // Get the portion of line 2 that is close to line 1.
+      vtkSmartPointer<vtkLine> dividedLine2 = vtkSmartPointer<vtkLine>::New();
+      this->Branch(inputROIPoints, line2, line1Index, plane2Overlaps[line2Index-firstLineOnPlane2Index], overlap2PointLocators, overlap2PointIds, dividedLine2);
+      vtkSmartPointer<vtkIdList> dividedPointsInLine2 = dividedLine2->GetPointIds();
+      int numberOfdividedPointsInLine2 = dividedLine2->GetNumberOfPoints();
+
+      if (numberOfdividedPointsInLine1 > 1 && numberOfdividedPointsInLine2 > 1)
+        {
+        lineTriangulatedToAbove[line1Index-firstLineOnPlane1Index] = true;
+        lineTriangulatedToBelow[line2Index-firstLineOnPlane2Index] = true;
+        this->TriangulateContours(inputROIPoints, dividedPointsInLine1, dividedPointsInLine2, outputPolygons);
+        }
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyData* inputROIPoints, vtkIdList* pointsInLine1, vtkIdList* pointsInLine2, vtkCellArray* outputPolygons)
 {
@@ -347,6 +659,10 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
   int numberOfPointsInLine2 = pointsInLine2->GetNumberOfIds();
 
   // Pre-calculate and store the closest points.
+  LinePointLocator line1PointLocator;
+  line1PointLocator.BuildLocator(inputROIPoints->GetPoints(), pointsInLine1);
+  LinePointLocator line2PointLocator;
+  line2PointLocator.BuildLocator(inputROIPoints->GetPoints(), pointsInLine2);
 
   // Closest point from line 1 to line 2
   std::vector< int > closestPointFromLine1ToLine2Ids;
@@ -355,7 +671,7 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
     double line1Point[3] = {0,0,0};
     inputROIPoints->GetPoint(pointsInLine1->GetId(line1PointIndex), line1Point);
 
-    closestPointFromLine1ToLine2Ids.push_back(this->GetClosestPoint(inputROIPoints, line1Point, pointsInLine2));
+    closestPointFromLine1ToLine2Ids.push_back(line2PointLocator.FindClosestPoint(line1Point));
     }
 
   // Closest from line 2 to line 1
@@ -365,7 +681,7 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
     double line2Point[3] = {0,0,0};
     inputROIPoints->GetPoint(pointsInLine2->GetId(line2PointIndex),line2Point);
 
-    closestPointFromLine2ToLine1Ids.push_back(this->GetClosestPoint(inputROIPoints, line2Point, pointsInLine1));
+    closestPointFromLine2ToLine1Ids.push_back(line1PointLocator.FindClosestPoint(line2Point));
     }
 
   // Orient loops.
@@ -562,45 +878,6 @@ vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetEndLoop(vtkIdType st
   return numberOfPoints-1;
 }
 
-//----------------------------------------------------------------------------
-vtkIdType vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoint(vtkPolyData* inputROIPoints, double* originalPoint, vtkIdList* linePointIds)
-{
-  if (!inputROIPoints)
-    {
-    vtkErrorMacro("inputROIPoints: Invalid vtkPolyData!");
-    return 0;
-    }
-
-  if (!linePointIds)
-    {
-    vtkErrorMacro("GetClosestPoint: Invalid vtkIdList!");
-    return 0;
-    }
-
-  double pointOnLine[3] = {0,0,0}; // point from the given line
-  inputROIPoints->GetPoint(linePointIds->GetId(0), pointOnLine);
-
-  double minimumDistance = vtkMath::Distance2BetweenPoints(originalPoint, pointOnLine); // minimum distance from the point to the line
-  double closestPointIndex = 0;
-
-  int numberOfPoints = linePointIds->GetNumberOfIds();
-
-  // Loop through all of the points in the current line
-  for (int currentPointIndex = 1; currentPointIndex < numberOfPoints; ++currentPointIndex)
-    {
-    inputROIPoints->GetPoint(linePointIds->GetId(currentPointIndex), pointOnLine);
-
-    double distanceBetweenPoints = vtkMath::Distance2BetweenPoints(originalPoint, pointOnLine);
-    if (distanceBetweenPoints < minimumDistance)
-      {
-      minimumDistance = distanceBetweenPoints;
-      closestPointIndex = currentPointIndex;
-      }
-    }
-
-  return closestPointIndex;
-}
-
 //----------------------------------------------------------------------------
 void vtkPlanarContourToClosedSurfaceConversionRule::SortContours(vtkPolyData* inputROIPoints)
 {
@@ -972,6 +1249,12 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(vtkLine* line
   double bounds2[6];
   line2->GetBounds(bounds2);
 
+  return DoLinesOverlap(bounds1, bounds2);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(const double* bounds1, const double* bounds2)
+{
   return bounds1[0] < bounds2[1] &&
          bounds1[1] > bounds2[0] &&
          bounds1[2] < bounds2[3] &&
@@ -979,7 +1262,7 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(vtkLine* line
 }
 // TODO: It may be possible to speed up this function by only calling the branch function once. -- need to look into this
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists, vtkLine* outputLine)
+void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, const std::vector< vtkIdType >& overlappingLineIds, const std::vector<const LinePointLocator*>& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists, vtkLine* outputLine)
 {
   if (!inputROIPoints)
     {
@@ -1044,7 +1327,7 @@ void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROI
 }
 
 //----------------------------------------------------------------------------
-int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, std::vector< vtkIdType > overlappingLineIds,  std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists)
+int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, const std::vector< vtkIdType >& overlappingLineIds, const std::vector<const LinePointLocator*>& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists)
 {
   if (!inputROIPoints)
     {
@@ -1114,7 +1397,8 @@ void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(vtkPolyData* inpu
       this->CreateEndCapContour(inputROIPoints, currentLine, externalLines, lineSpacing);
 
       std::vector<vtkIdType> overlapLineIds;
-      std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators;
+      std::vector<LinePointLocator> linePointLocators(externalLines->GetNumberOfCells());
+      std::vector<const LinePointLocator*> pointLocators;
       std::vector<vtkSmartPointer<vtkIdList> >  idLists;
 
       // Loop through all of the external lines that were created
@@ -1134,13 +1418,8 @@ void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(vtkPolyData* inpu
 
         this->TriangulateLine(newLine, outputPolygons, true);
 
-        vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-        linePolyData->SetPoints(newLine->GetPoints());
-
-        vtkSmartPointer<vtkPointLocator> pointLocator = vtkSmartPointer<vtkPointLocator>::New();
-        pointLocator->SetDataSet(linePolyData);
-        pointLocator->BuildLocator();
-        pointLocators.push_back(pointLocator);
+        linePointLocators[currentLineId].BuildLocator(inputROIPoints->GetPoints(), lineIdList);
+        pointLocators.push_back(&(linePointLocators[currentLineId]));
 
         }
 
@@ -1162,7 +1441,8 @@ void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(vtkPolyData* inpu
       this->CreateEndCapContour(inputROIPoints, currentLine, externalLines, -lineSpacing);
 
       std::vector<vtkIdType> overlapLineIds;
-      std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators;
+      std::vector<LinePointLocator> linePointLocators(externalLines->GetNumberOfCells());
+      std::vector<const LinePointLocator*> pointLocators;
       std::vector<vtkSmartPointer<vtkIdList> >  idLists;
 
       // Loop through all of the external lines that were created
@@ -1181,13 +1461,8 @@ void vtkPlanarContourToClosedSurfaceConversionRule::EndCapping(vtkPolyData* inpu
 
         overlapLineIds.push_back(currentLineId);
 
-        vtkSmartPointer<vtkPolyData> linePolyData = vtkSmartPointer<vtkPolyData>::New();
-        linePolyData->SetPoints(newLine->GetPoints());
-
-        vtkSmartPointer<vtkPointLocator> pointLocator = vtkSmartPointer<vtkPointLocator>::New();
-        pointLocator->SetDataSet(linePolyData);
-        pointLocator->BuildLocator();
-        pointLocators.push_back(pointLocator);
+        linePointLocators[currentLineId].BuildLocator(inputROIPoints->GetPoints(), lineIdList);
+        pointLocators.push_back(&(linePointLocators[currentLineId]));
 
         idLists.push_back(lineIdList);
         }
@@ -28,7 +28,10 @@
 #include "vtkSlicerDicomRtImportExportConversionRulesExport.h"
 
 // VTK includes
-#include "vtkPointLocator.h"
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
 
 class vtkPolyData;
 class vtkIdList;
@@ -78,10 +81,26 @@ public:
   /// Human-readable name of the target representation
   virtual const char* GetTargetRepresentationName() VTK_OVERRIDE { return vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(); };
 
+  /// Name of the conversion parameter specifying the number of threads used for triangulating the pairs of adjacent planes
+  static const std::string GetNumberOfThreadsParameterName() { return "Number of threads"; };
+
+  /// Determine if two contours overlap in the XY axis.
+  /// \param The first line
+  /// \param The second line
+  bool DoLinesOverlap(vtkLine* line1, vtkLine* line2);
+
+  /// Determine if two contours overlap in the XY axis based on their bounds.
+  /// \param bounds1 Bounds of the first line
+  /// \param bounds2 Bounds of the second line
+  static bool DoLinesOverlap(const double* bounds1, const double* bounds2);
+
 protected:
   vtkPlanarContourToClosedSurfaceConversionRule();
   virtual ~vtkPlanarContourToClosedSurfaceConversionRule();
 
+  /// Closest point locator for the points of a contour line (2D KD-tree)
+  class LinePointLocator;
+
   /// Construct a surface triangulation between two lines using a dynamic programming algorithm.
   /// \param inputROIPoints Polydata containing all of the points and contours
   /// \param pointsInLine1 List of points that are contained in the line to be triangulated
@@ -89,6 +108,26 @@ protected:
   /// \param Cell array that polygons are added to by the triangulation algorithm
   void TriangulateContours(vtkPolyData* inputROIPoints, vtkIdList* pointsInLine1, vtkIdList* pointsInLine2, vtkCellArray* outputPolygons);
 
+  /// Construct the surface between the lines of two adjacent planes, handling branching.
+  /// Only reads the input lines, so can be called for multiple plane pairs concurrently.
+  /// \param inputROIPoints Polydata containing all of the points and contours
+  /// \param firstLineOnPlane1Index Index of the first line on the lower plane
+  /// \param numberOfLinesInPlane1 Number of lines on the lower plane
+  /// \param firstLineOnPlane2Index Index of the first line on the upper plane (follows the lines on the lower plane)
+  /// \param numberOfLinesInPlane2 Number of lines on the upper plane
+  /// \param lines Copies of all the lines in the input polydata
+  /// \param lineBounds Bounds of all the lines (6 values per line)
+  /// \param linePointIdLists Point ID lists of all the lines
+  /// \param linePointLocators Point locators of all the lines
+  /// \param outputPolygons Cell array that the triangles are added to
+  /// \param lineTriangulatedToAbove Output flags for the lines on the lower plane telling if they were triangulated
+  /// \param lineTriangulatedToBelow Output flags for the lines on the upper plane telling if they were triangulated
+  void TriangulatePlanePair(vtkPolyData* inputROIPoints,
+    vtkIdType firstLineOnPlane1Index, int numberOfLinesInPlane1, vtkIdType firstLineOnPlane2Index, int numberOfLinesInPlane2,
+    const std::vector<vtkSmartPointer<vtkLine> >& lines, const std::vector<double>& lineBounds,
+    const std::vector<vtkSmartPointer<vtkIdList> >& linePointIdLists, const std::vector<LinePointLocator>& linePointLocators,
+    vtkCellArray* outputPolygons, std::vector<bool>& lineTriangulatedToAbove, std::vector<bool>& lineTriangulatedToBelow);
+
   /// Find the index of the last point in a contour.
   /// \param startLoopIndex The index of the first point in the contour
   /// \param numberOfPoints The number of points in the contour
@@ -96,13 +135,6 @@ protected:
   /// \return The index of the last point in the contour
   vtkIdType GetEndLoop(vtkIdType startLoopIndex, int numberOfPoints, bool loopClosed);
 
-  /// Find the point on the given line that is closest to the given point.
-  /// \param inputROIPoints Polydata containing all of the points and contours
-  /// \param originalPoint The point that is being compared to the line
-  /// \param linePointIds The line that is being compared to the point
-  /// \return The index of the point in the line that is closet to the specified point
-  vtkIdType GetClosestPoint(vtkPolyData* inputROIPoints, double* originalPoint, vtkIdList* linePointIds);
-
   /// Sort the contours based on Z value.
   /// \param inputROIPoints Polydata containing all of the points and contours
   void SortContours(vtkPolyData* inputROIPoints);
@@ -134,11 +166,6 @@ protected:
   /// \param spacing The spacing between lines
   int GetNumberOfLinesOnPlane(vtkPolyData* inputROIPoints, vtkIdType originalLineIndex, double spacing);
 
-  /// Determine if two contours overlap in the XY axis.
-  /// \param The first line
-  /// \param The second line
-  bool DoLinesOverlap(vtkLine* line1, vtkLine* line2);
-
   /// Create a branching pattern for overlapping contours.
   /// \param inputROIPoints Polydata containing all of the points and contours
   /// \param branchingLine The orignal line that is being divided
@@ -147,7 +174,7 @@ protected:
   /// \param pointLocators List of point locators for lines in the overlap list
   /// \param lineIdLists List of vtkIdLists for all of the lines in the overlap list
   /// \param outputLine The output branched line
-  void Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists, vtkLine* outputLine);
+  void Branch(vtkPolyData* inputROIPoints, vtkLine* branchingLine, vtkIdType currentLineId, const std::vector< vtkIdType >& overlappingLineIds, const std::vector<const LinePointLocator*>& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists, vtkLine* outputLine);
 
   /// Find the branch closest from the point on the trunk
   /// \param inputROIPoints Polydata containing all of the points and contours
@@ -155,7 +182,7 @@ protected:
   /// \param overlappingLineIds List of line IDs for lines that overlap with the current line
   /// \param pointLocators List of point locators for lines in the overlap list
   /// \param lineIdLists List of vtkIdLists for all of the lines in the overlap list
-  int GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, std::vector< vtkIdType > overlappingLineIds, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists);
+  int GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, const std::vector< vtkIdType >& overlappingLineIds, const std::vector<const LinePointLocator*>& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists);
 
   /// Seal the exterior contours of the mesh.
   /// \param inputROIPoints Polydata containing all of the points and contours
@@ -255,6 +282,8 @@ protected:
   // Image padding size that is used in the end-capping process
   int ImagePadding[3];
 
+  class PlanePairTriangulationFunctor;
+
 private:
   vtkPlanarContourToClosedSurfaceConversionRule(const vtkPlanarContourToClosedSurfaceConversionRule&); // Not implemented
   void operator=(const vtkPlanarContourToClosedSurfaceConversionRule&);               // Not implemented
@@ -77,7 +77,6 @@
 #include <dcmtk/dcmrt/drtdose.h>
 #include <dcmtk/dcmrt/drtimage.h>
 #include <dcmtk/dcmrt/drtplan.h>
-#include <dcmtk/dcmrt/drtstrct.h>
 
 // MRML includes
 #include <vtkMRMLColorTableNode.h>
@@ -100,14 +99,19 @@
 #include <vtkPolyData.h>
 #include <vtkImageData.h>
 #include <vtkLookupTable.h>
-#include <vtkImageCast.h>
+#include <vtkImageShiftScale.h>
 #include <vtkStringArray.h>
 #include <vtkObjectFactory.h>
 #include <vtkGeneralTransform.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkCellArray.h>
 #include <vtkCutter.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMath.h>
 #include <vtkStripper.h>
 #include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkTriangleFilter.h>
 
 // ITK includes
 #include <itkImage.h>
@@ -122,13 +126,223 @@ vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, IsodoseLogic, vtkS
 vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, PlanarImageLogic, vtkSlicerPlanarImageModuleLogic);
 vtkCxxSetObjectMacro(vtkSlicerDicomRtImportExportModuleLogic, BeamsLogic, vtkSlicerBeamsModuleLogic);
 
+//----------------------------------------------------------------------------
+// Values longer than this (in bytes) are not loaded when examining files with partial read.
+// They are only read from the file if they are accessed (e.g. contour data in structure sets)
+static const Uint32 EXAMINE_MAX_READ_LENGTH = 4096;
+
+namespace
+{
+  //---------------------------------------------------------------------------
+  /// Geometry of the anatomical image slices at which the closed surfaces are cut for export
+  struct ExportSliceGeometry
+  {
+    /// Origin of the first slice plane (image origin)
+    double Origin[3];
+    /// Slice plane normal (image Z axis, including the slice spacing)
+    double Normal[3];
+    /// Image extent
+    int Extent[6];
+    /// Instance UIDs of the image slices
+    const std::vector<std::string>* SliceUIDs;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Planar contours of a closed surface segment, in the form passed to vtkSlicerDicomRtWriter::AddStructure
+  struct SegmentExportContours
+  {
+    /// Closed surface in world coordinates
+    vtkSmartPointer<vtkPolyData> ClosedSurface;
+    std::vector<int> SliceNumbers;
+    std::vector<std::string> SliceUIDs;
+    std::vector<vtkSmartPointer<vtkPolyData> > SliceContours;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Cut closed surface at all image slices in one sweep. The cells are binned by the range of slices they span,
+  /// so each cell is only cut by the slices it intersects. The contour of each slice is the output of the same
+  /// vtkCutter and vtkStripper pipeline as for cutting the whole surface, run on the cells spanning that slice.
+  void CutClosedSurfaceAtSlices(const ExportSliceGeometry& geometry, SegmentExportContours& segmentContours)
+  {
+    vtkSmartPointer<vtkPolyData> closedSurface = segmentContours.ClosedSurface;
+    if (closedSurface->GetNumberOfStrips() > 0)
+    {
+      vtkSmartPointer<vtkTriangleFilter> triangulator = vtkSmartPointer<vtkTriangleFilter>::New();
+      triangulator->SetInputData(closedSurface);
+      triangulator->PassVertsOff();
+      triangulator->PassLinesOff();
+      triangulator->Update();
+      closedSurface = triangulator->GetOutput();
+    }
+    double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
+    closedSurface->GetBounds(bounds);
+
+    // Slices from the first one until the last one (the last slice is not cut)
+    int firstSlice = geometry.Extent[4];
+    int numberOfSlices = geometry.Extent[5] - geometry.Extent[4];
+    if (numberOfSlices <= 0 || !closedSurface->GetPoints())
+    {
+      return;
+    }
+
+    // Bin the cells by the slices they span. The position of a point along the slice normal in slice units is
+    // dot(normal, point-origin) / dot(normal, normal), and slice s intersects a cell if s is within their range
+    const double normalLength2 = vtkMath::Dot(geometry.Normal, geometry.Normal);
+    const double tolerance = 1.0e-6;
+    // The cells are stored by their location in the connectivity array of the polygons (the cell array
+    // is not traversed with InitTraversal, as it may be shared with the segment representation)
+    std::vector<std::vector<vtkIdType> > sliceCells(numberOfSlices);
+    vtkPoints* points = closedSurface->GetPoints();
+    vtkIdTypeArray* polysConnectivity = closedSurface->GetPolys()->GetData();
+    vtkIdType connectivitySize = polysConnectivity->GetNumberOfValues();
+    for (vtkIdType cellLocation=0; cellLocation<connectivitySize; cellLocation += polysConnectivity->GetValue(cellLocation) + 1)
+    {
+      vtkIdType numberOfCellPoints = polysConnectivity->GetValue(cellLocation);
+      vtkIdType* cellPointIds = polysConnectivity->GetPointer(cellLocation + 1);
+      if (numberOfCellPoints == 0)
+      {
+        continue;
+      }
+      double minimumPosition = VTK_DOUBLE_MAX;
+      double maximumPosition = VTK_DOUBLE_MIN;
+      for (vtkIdType i=0; i<numberOfCellPoints; ++i)
+      {
+        double point[3] = {0.0, 0.0, 0.0};
+        points->GetPoint(cellPointIds[i], point);
+        double position = ( (point[0]-geometry.Origin[0])*geometry.Normal[0] + (point[1]-geometry.Origin[1])*geometry.Normal[1]
+          + (point[2]-geometry.Origin[2])*geometry.Normal[2] ) / normalLength2;
+        minimumPosition = std::min(minimumPosition, position);
+        maximumPosition = std::max(maximumPosition, position);
+      }
+      int firstSpannedSlice = std::max(firstSlice, static_cast<int>(ceil(minimumPosition - tolerance)));
+      int lastSpannedSlice = std::min(firstSlice + numberOfSlices - 1, static_cast<int>(floor(maximumPosition + tolerance)));
+      for (int slice=firstSpannedSlice; slice<=lastSpannedSlice; ++slice)
+      {
+        sliceCells[slice-firstSlice].push_back(cellLocation);
+      }
+    }
+
+    // Cutter pipeline for the cells of one slice
+    vtkSmartPointer<vtkPolyData> slicePolyData = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
+    slicePlane->SetNormal(geometry.Normal[0], geometry.Normal[1], geometry.Normal[2]);
+    vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
+    cutter->SetInputData(slicePolyData);
+    cutter->SetCutFunction(slicePlane);
+    cutter->SetGenerateCutScalars(0);
+    vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
+    stripper->SetInputConnection(cutter->GetOutputPort());
+
+    std::vector<vtkIdType> pointIdMap(closedSurface->GetNumberOfPoints(), -1);
+    for (int slice=firstSlice; slice<firstSlice+numberOfSlices; ++slice)
+    {
+      // Calculate slice origin
+      double origin[3] = { geometry.Origin[0] + slice*geometry.Normal[0],
+                           geometry.Origin[1] + slice*geometry.Normal[1],
+                           geometry.Origin[2] + slice*geometry.Normal[2] };
+      if (origin[2] < bounds[4] || origin[2] > bounds[5])
+      {
+        // No contours outside surface bounds
+        continue;
+      }
+
+      // Get instance UID of corresponding slice
+      int sliceNumber = slice-geometry.Extent[0];
+      segmentContours.SliceNumbers.push_back(sliceNumber);
+      std::string sliceInstanceUID = (geometry.SliceUIDs->size() > sliceNumber ? (*geometry.SliceUIDs)[sliceNumber] : "");
+      segmentContours.SliceUIDs.push_back(sliceInstanceUID);
+
+      // Copy the cells spanning the slice (in their original order) and their points
+      const std::vector<vtkIdType>& cells = sliceCells[slice-firstSlice];
+      vtkSmartPointer<vtkPoints> slicePoints = vtkSmartPointer<vtkPoints>::New();
+      slicePoints->SetDataType(points->GetDataType());
+      vtkSmartPointer<vtkCellArray> slicePolys = vtkSmartPointer<vtkCellArray>::New();
+      std::vector<vtkIdType> usedPointIds;
+      for (std::vector<vtkIdType>::const_iterator cellIt=cells.begin(); cellIt!=cells.end(); ++cellIt)
+      {
+        vtkIdType* cell = polysConnectivity->GetPointer(*cellIt);
+        slicePolys->InsertNextCell(cell[0]);
+        for (vtkIdType i=1; i<=cell[0]; ++i)
+        {
+          if (pointIdMap[cell[i]] < 0)
+          {
+            pointIdMap[cell[i]] = slicePoints->InsertNextPoint(points->GetPoint(cell[i]));
+            usedPointIds.push_back(cell[i]);
+          }
+          slicePolys->InsertCellPoint(pointIdMap[cell[i]]);
+        }
+      }
+      for (std::vector<vtkIdType>::iterator pointIt=usedPointIds.begin(); pointIt!=usedPointIds.end(); ++pointIt)
+      {
+        pointIdMap[*pointIt] = -1;
+      }
+      slicePolyData->SetPoints(slicePoints);
+      slicePolyData->SetPolys(slicePolys);
+
+      // Cut the cells at the slice and save slice contour
+      slicePlane->SetOrigin(origin);
+      stripper->Update();
+      vtkSmartPointer<vtkPolyData> sliceContour = vtkSmartPointer<vtkPolyData>::New();
+      sliceContour->SetPoints(stripper->GetOutput()->GetPoints());
+      sliceContour->SetPolys(stripper->GetOutput()->GetLines());
+      segmentContours.SliceContours.push_back(sliceContour);
+    } // For each anatomical image slice
+  }
+
+  //---------------------------------------------------------------------------
+  // Functor cutting the closed surfaces of a range of segments, used with vtkSMPTools
+  class CutClosedSurfacesFunctor
+  {
+  public:
+    CutClosedSurfacesFunctor(const ExportSliceGeometry& geometry, std::vector<SegmentExportContours>& segments)
+      : Geometry(geometry)
+      , Segments(segments)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType index=begin; index<end; ++index)
+      {
+        CutClosedSurfaceAtSlices(this->Geometry, this->Segments[index]);
+      }
+    }
+
+  private:
+    const ExportSliceGeometry& Geometry;
+    std::vector<SegmentExportContours>& Segments;
+  };
+}
+
 //----------------------------------------------------------------------------
 class vtkSlicerDicomRtImportExportModuleLogic::vtkInternal
 {
+public:
+  /// Result of examining one file, from which the loadable is created
+  struct ExaminedFile
+  {
+    ExaminedFile() : Loadable(false) { };
+    bool Loadable;
+    OFString SOPClassUID;
+    OFString Name;
+    std::vector<OFString> ReferencedSOPInstanceUIDs;
+  };
+
+  class ExamineFilesFunctor;
+
 public:
   vtkInternal(vtkSlicerDicomRtImportExportModuleLogic* external);
   ~vtkInternal() { };
 
+  /// Parse a DICOM file and examine it if it contains a supported RT object.
+  /// Does not access the MRML scene or the DICOM database, so it can be called concurrently for different files.
+  /// \param partialRead Stop parsing at the pixel data and skip reading long values, see \sa EXAMINE_MAX_READ_LENGTH
+  void ExamineFile(const std::string& fileName, bool partialRead, ExaminedFile& examinedFile);
+
+  /// Append the label of the referenced RT plan to the names of the examined RT dose files.
+  /// The label is taken from the DICOM database, so it must be called from the main thread.
+  void AddReferencedRtPlanLabelToRtDoseNames(std::vector<ExaminedFile>& examinedFiles);
+
   /// Examine RT Dose dataset and assemble name and referenced SOP instances
   void ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs);
 
@@ -172,6 +386,34 @@ public:
   vtkSlicerDicomRtImportExportModuleLogic* External;
 };
 
+//----------------------------------------------------------------------------
+// Functor examining a range of files, used with vtkSMPTools
+class vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineFilesFunctor
+{
+public:
+  ExamineFilesFunctor(vtkInternal* internal, vtkStringArray* fileList, bool partialRead, std::vector<ExaminedFile>& examinedFiles)
+    : Internal(internal)
+    , FileList(fileList)
+    , PartialRead(partialRead)
+    , ExaminedFiles(examinedFiles)
+  {
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType fileIndex=begin; fileIndex<end; ++fileIndex)
+    {
+      this->Internal->ExamineFile(this->FileList->GetValue(fileIndex), this->PartialRead, this->ExaminedFiles[fileIndex]);
+    }
+  }
+
+private:
+  vtkInternal* Internal;
+  vtkStringArray* FileList;
+  bool PartialRead;
+  std::vector<ExaminedFile>& ExaminedFiles;
+};
+
 //----------------------------------------------------------------------------
 // vtkInternal methods
 
@@ -182,46 +424,99 @@ vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::vtkInternal(vtkSlicerDicom
 }
 
 //-----------------------------------------------------------------------------
-void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs)
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineFile(const std::string& fileName, bool partialRead, ExaminedFile& examinedFile)
 {
-  if (!dataset)
-    {
-    return;
-    }
+  examinedFile.Loadable = false;
 
-  // Assemble name
-  name += "RTDOSE";
-  OFString instanceNumber;
-  dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
-  OFString seriesDescription;
-  dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
-  if (!seriesDescription.empty())
+  // Load file in DCMTK
+  DcmFileFormat fileformat;
+  OFCondition result;
+  if (partialRead)
   {
-    name += ": " + seriesDescription;
+#if OFFIS_DCMTK_VERSION_NUMBER >= 362
+    result = fileformat.loadFileUntilTag(fileName.c_str(), EXS_Unknown, EGL_noChange, EXAMINE_MAX_READ_LENGTH, ERM_autoDetect, DCM_PixelData);
+#else
+    result = fileformat.loadFile(fileName.c_str(), EXS_Unknown, EGL_noChange, EXAMINE_MAX_READ_LENGTH);
+#endif
   }
-  if (!instanceNumber.empty())
+  else
   {
-    name += " [" + instanceNumber + "]";
+    result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
+  }
+  if (!result.good())
+  {
+    return; // Failed to parse this file, skip it
   }
 
-  // Find RTPlan name for RTDose series
-  OFString referencedSOPInstanceUID("");
-  DRTDoseIOD rtDoseObject;
-  if (rtDoseObject.read(*dataset).good())
+  // Check SOP Class UID for one of the supported RT objects
+  DcmDataset *dataset = fileformat.getDataset();
+  OFString& sopClass = examinedFile.SOPClassUID;
+  if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
+  {
+    return; // Failed to parse this file, skip it
+  }
+
+  // DICOM parsing is successful, now check if the object is loadable
+  OFString& name = examinedFile.Name;
+  OFString seriesNumber("");
+  dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
+  if (!seriesNumber.empty())
+  {
+    name += seriesNumber + ": ";
+  }
+
+  // RTDose
+  if (sopClass == UID_RTDoseStorage)
+  {
+    this->ExamineRtDoseDataset(dataset, name, examinedFile.ReferencedSOPInstanceUIDs);
+  }
+  // RTPlan
+  else if (sopClass == UID_RTPlanStorage)
+  {
+    this->ExamineRtPlanDataset(dataset, name, examinedFile.ReferencedSOPInstanceUIDs);
+  }
+  // RTStructureSet
+  else if (sopClass == UID_RTStructureSetStorage)
+  {
+    this->ExamineRtStructureSetDataset(dataset, name, examinedFile.ReferencedSOPInstanceUIDs);
+  }
+  // RTImage
+  else if (sopClass == UID_RTImageStorage)
+  {
+    this->ExamineRtImageDataset(dataset, name, examinedFile.ReferencedSOPInstanceUIDs);
+  }
+  /* Not yet supported
+  else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
+  else if (sopClass == UID_RTIonPlanStorage)
+  else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
+  */
+  else
+  {
+    return; // Not an RT file
+  }
+
+  examinedFile.Loadable = true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::AddReferencedRtPlanLabelToRtDoseNames(std::vector<ExaminedFile>& examinedFiles)
+{
+  // Only open the DICOM database if there is an RT dose referencing an RT plan
+  bool rtPlanReferenceFound = false;
+  std::vector<ExaminedFile>::iterator fileIt;
+  for (fileIt = examinedFiles.begin(); fileIt != examinedFiles.end(); ++fileIt)
   {
-    DRTReferencedRTPlanSequence &referencedRTPlanSequence = rtDoseObject.getReferencedRTPlanSequence();
-    if (referencedRTPlanSequence.gotoFirstItem().good())
+    if ( fileIt->Loadable && fileIt->SOPClassUID == UID_RTDoseStorage
+      && !fileIt->ReferencedSOPInstanceUIDs.empty() && !fileIt->ReferencedSOPInstanceUIDs[0].empty() )
     {
-      DRTReferencedRTPlanSequence::Item &referencedRTPlanSequenceItem = referencedRTPlanSequence.getCurrentItem();
-      if (referencedRTPlanSequenceItem.isValid())
-      {
-        if (referencedRTPlanSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-        {
-          referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-        }
-      }
+      rtPlanReferenceFound = true;
+      break;
     }
   }
+  if (!rtPlanReferenceFound)
+  {
+    return;
+  }
 
   // Create and open DICOM database to perform database operations for getting RTPlan name
   QSettings settings;
@@ -232,10 +527,18 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
 
   // Get RTPlan name to show it with the dose
   QString rtPlanLabelTag("300a,0002");
-  QString rtPlanFileName = dicomDatabase->fileForInstance(referencedSOPInstanceUID.c_str());
-  if (!rtPlanFileName.isEmpty())
+  for (fileIt = examinedFiles.begin(); fileIt != examinedFiles.end(); ++fileIt)
   {
-    name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toLatin1().constData());
+    if ( !fileIt->Loadable || fileIt->SOPClassUID != UID_RTDoseStorage
+      || fileIt->ReferencedSOPInstanceUIDs.empty() || fileIt->ReferencedSOPInstanceUIDs[0].empty() )
+    {
+      continue;
+    }
+    QString rtPlanFileName = dicomDatabase->fileForInstance(fileIt->ReferencedSOPInstanceUIDs[0].c_str());
+    if (!rtPlanFileName.isEmpty())
+    {
+      fileIt->Name += OFString(": ") + OFString(dicomDatabase->fileValue(rtPlanFileName,rtPlanLabelTag).toLatin1().constData());
+    }
   }
 
   // Close and delete DICOM database
@@ -245,6 +548,42 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(
   QSqlDatabase::removeDatabase(QString(vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME.c_str()) + "TagCache");
 }
 
+//-----------------------------------------------------------------------------
+void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtDoseDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs)
+{
+  if (!dataset)
+    {
+    return;
+    }
+
+  // Assemble name
+  name += "RTDOSE";
+  OFString instanceNumber;
+  dataset->findAndGetOFString(DCM_InstanceNumber, instanceNumber);
+  OFString seriesDescription;
+  dataset->findAndGetOFString(DCM_SeriesDescription, seriesDescription);
+  if (!seriesDescription.empty())
+  {
+    name += ": " + seriesDescription;
+  }
+  if (!instanceNumber.empty())
+  {
+    name += " [" + instanceNumber + "]";
+  }
+
+  // Find referenced RTPlan for RTDose series (its name is added in AddReferencedRtPlanLabelToRtDoseNames).
+  // The sequence is accessed directly in the dataset instead of reading the whole RT dose IOD, which would copy the pixel data
+  DcmItem* referencedRTPlanSequenceItem = NULL;
+  if (dataset->findAndGetSequenceItem(DCM_ReferencedRTPlanSequence, referencedRTPlanSequenceItem, 0).good() && referencedRTPlanSequenceItem)
+  {
+    OFString referencedSOPInstanceUID("");
+    if (referencedRTPlanSequenceItem->findAndGetOFString(DCM_ReferencedSOPInstanceUID, referencedSOPInstanceUID).good())
+    {
+      referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtPlanDataset(DcmDataset* dataset, OFString &name, std::vector<OFString> &referencedSOPInstanceUIDs)
 {
@@ -298,98 +637,28 @@ void vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::ExamineRtStructureSet
     name += ": " + structLabel;
   }
 
-  // Get referenced image instance UIDs
-  OFString referencedSOPInstanceUID("");
-  DRTStructureSetIOD rtStructureSetObject;
-  if (rtStructureSetObject.read(*dataset).good())
+  // Get referenced image instance UIDs from the contour image sequence of the referenced series.
+  // Only the needed elements are accessed instead of reading the whole structure set IOD, so that the
+  // long values skipped by the partial read (e.g. contour data) are not loaded from the file.
+  // The contour image references of the individual contours are not used, as before.
+  DcmItem* referencedFrameOfReferenceItem = NULL;
+  DcmItem* referencedStudyItem = NULL;
+  DcmItem* referencedSeriesItem = NULL;
+  DcmSequenceOfItems* contourImageSequence = NULL;
+  if ( dataset->findAndGetSequenceItem(DCM_ReferencedFrameOfReferenceSequence, referencedFrameOfReferenceItem, 0).good()
+    && referencedFrameOfReferenceItem->findAndGetSequenceItem(DCM_RTReferencedStudySequence, referencedStudyItem, 0).good()
+    && referencedStudyItem->findAndGetSequenceItem(DCM_RTReferencedSeriesSequence, referencedSeriesItem, 0).good()
+    && referencedSeriesItem->findAndGetSequence(DCM_ContourImageSequence, contourImageSequence).good() )
   {
-    DRTROIContourSequence &rtROIContourSequenceObject = rtStructureSetObject.getROIContourSequence();
-    if (rtROIContourSequenceObject.gotoFirstItem().good())
+    for (unsigned long itemIndex=0; itemIndex<contourImageSequence->card(); ++itemIndex)
     {
-      do // For all ROIs
+      OFString referencedSOPInstanceUID("");
+      if (contourImageSequence->getItem(itemIndex)->findAndGetOFString(DCM_ReferencedSOPInstanceUID, referencedSOPInstanceUID).good())
       {
-        DRTROIContourSequence::Item &currentRoiObject = rtROIContourSequenceObject.getCurrentItem();
-        if (currentRoiObject.isValid())
-        {
-          DRTContourSequence &rtContourSequenceObject = currentRoiObject.getContourSequence();
-          if (rtContourSequenceObject.gotoFirstItem().good())
-          {
-            do // For all contours
-            {
-              DRTContourSequence::Item &contourItem = rtContourSequenceObject.getCurrentItem();
-              if (!contourItem.isValid())
-              {
-                DRTContourImageSequence &rtContourImageSequenceObject = contourItem.getContourImageSequence();
-                if (rtContourImageSequenceObject.gotoFirstItem().good())
-                {
-                  DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                  if (rtContourImageSequenceItem.isValid())
-                  {
-                    OFString referencedSOPInstanceUID("");
-                    if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                    {
-                      referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                    }
-                  }
-                }
-              }
-            } // For all contours
-            while (rtContourSequenceObject.gotoNextItem().good());
-          }
-        }
-      } // For all ROIs
-      while (rtROIContourSequenceObject.gotoNextItem().good());
-    } // End ROIContourSequence
-
-    // If the above tags do not store the referenced instance UIDs, then look at the other possible place
-    if (referencedSOPInstanceUIDs.empty())
-    {
-      DRTReferencedFrameOfReferenceSequence &rtReferencedFrameOfReferenceSequenceObject = rtStructureSetObject.getReferencedFrameOfReferenceSequence();
-      if (rtReferencedFrameOfReferenceSequenceObject.gotoFirstItem().good())
-      {
-        DRTReferencedFrameOfReferenceSequence::Item &currentReferencedFrameOfReferenceSequenceItem = rtReferencedFrameOfReferenceSequenceObject.getCurrentItem();
-        if (currentReferencedFrameOfReferenceSequenceItem.isValid())
-        {
-          DRTRTReferencedStudySequence &rtReferencedStudySequenceObject = currentReferencedFrameOfReferenceSequenceItem.getRTReferencedStudySequence();
-          if (rtReferencedStudySequenceObject.gotoFirstItem().good())
-          {
-            DRTRTReferencedStudySequence::Item &rtReferencedStudySequenceItem = rtReferencedStudySequenceObject.getCurrentItem();
-            if (rtReferencedStudySequenceItem.isValid())
-            {
-              DRTRTReferencedSeriesSequence &rtReferencedSeriesSequenceObject = rtReferencedStudySequenceItem.getRTReferencedSeriesSequence();
-              if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
-              {
-                if (rtReferencedSeriesSequenceObject.gotoFirstItem().good())
-                {
-                  DRTRTReferencedSeriesSequence::Item &rtReferencedSeriesSequenceItem = rtReferencedSeriesSequenceObject.getCurrentItem();
-                  if (rtReferencedSeriesSequenceItem.isValid())
-                  {
-                    DRTContourImageSequence &rtContourImageSequenceObject = rtReferencedSeriesSequenceItem.getContourImageSequence();
-                    if (rtContourImageSequenceObject.gotoFirstItem().good())
-                    {
-                      do
-                      {
-                        DRTContourImageSequence::Item &rtContourImageSequenceItem = rtContourImageSequenceObject.getCurrentItem();
-                        if (rtContourImageSequenceItem.isValid())
-                        {
-                          OFString referencedSOPInstanceUID("");
-                          if (rtContourImageSequenceItem.getReferencedSOPInstanceUID(referencedSOPInstanceUID).good())
-                          {
-                            referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
-                          }
-                        }
-                      } // For all contours
-                      while (rtContourImageSequenceObject.gotoNextItem().good());
-                    }
-                  }
-                }
-              }
-            }
-          }
-        }
+        referencedSOPInstanceUIDs.push_back(referencedSOPInstanceUID);
       }
-    } // End DRTReferencedFrameOfReferenceSequence
-  } // End finding referenced instance UIDs
+    }
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -439,56 +708,61 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtDose(vtkSlicerD
   const char* fileName = loadable->GetFiles()->GetValue(0);
   const char* seriesName = loadable->GetName();
 
-  // Load Volume
-  vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
   vtkSmartPointer<vtkMRMLScalarVolumeNode> volumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
-  volumeStorageNode->SetFileName(fileName);
-  volumeStorageNode->ResetFileNameList();
-  volumeStorageNode->SetSingleFile(1);
-
-  // Read volume from disk
-  if (!volumeStorageNode->ReadData(volumeNode))
-  {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
-    return false;
-  }
-
-  volumeNode->SetScene(this->External->GetMRMLScene());
   std::string volumeNodeName = scene->GenerateUniqueName(seriesName);
-  volumeNode->SetName(volumeNodeName.c_str());
-
-  // Set new spacing
-  double* initialSpacing = volumeNode->GetSpacing();
-  double* correctSpacing = rtReader->GetPixelSpacing();
-  volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
-  volumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
-  scene->AddNode(volumeNode);
 
-  // Apply dose grid scaling
   if (!rtReader->GetDoseGridScaling())
   {
-    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << volumeNode->GetName());
+    vtkErrorWithObjectMacro(this->External, "LoadRtDose: Empty dose unit value found for dose volume " << volumeNodeName);
   }
   double doseGridScaling = vtkVariant(rtReader->GetDoseGridScaling()).ToDouble();
 
-  vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
-
-  vtkSmartPointer<vtkImageCast> imageCast = vtkSmartPointer<vtkImageCast>::New();
-  imageCast->SetInputData(volumeNode->GetImageData());
-  imageCast->SetOutputScalarTypeToFloat();
-  imageCast->Update();
-  floatVolumeData->DeepCopy(imageCast->GetOutput());
-
-  float value = 0.0;
-  float* floatPtr = (float*)floatVolumeData->GetScalarPointer();
-  for (long i=0; i<floatVolumeData->GetNumberOfPoints(); ++i)
+  if (rtReader->GetDoseImageData() && rtReader->GetDoseIJKToRASMatrix())
   {
-    value = (*floatPtr) * doseGridScaling;
-    (*floatPtr) = value;
-    ++floatPtr;
+    // The reader already decoded the dose volume from the parsed dataset and applied the dose grid scaling
+    volumeNode->SetIJKToRASMatrix(rtReader->GetDoseIJKToRASMatrix());
+    volumeNode->SetAndObserveImageData(rtReader->GetDoseImageData());
+    volumeNode->SetScene(this->External->GetMRMLScene());
+    volumeNode->SetName(volumeNodeName.c_str());
+    volumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+    scene->AddNode(volumeNode);
   }
+  else
+  {
+    // Load Volume
+    vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode> volumeStorageNode = vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New();
+    volumeStorageNode->SetFileName(fileName);
+    volumeStorageNode->ResetFileNameList();
+    volumeStorageNode->SetSingleFile(1);
+
+    // Read volume from disk
+    if (!volumeStorageNode->ReadData(volumeNode))
+    {
+      vtkErrorWithObjectMacro(this->External, "LoadRtDose: Failed to load dose volume file '" << fileName << "' (series name '" << seriesName << "')");
+      return false;
+    }
 
-  volumeNode->SetAndObserveImageData(floatVolumeData);
+    volumeNode->SetScene(this->External->GetMRMLScene());
+    volumeNode->SetName(volumeNodeName.c_str());
+
+    // Set new spacing
+    double* initialSpacing = volumeNode->GetSpacing();
+    double* correctSpacing = rtReader->GetPixelSpacing();
+    volumeNode->SetSpacing(correctSpacing[0], correctSpacing[1], initialSpacing[2]);
+    volumeNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_DOSE_VOLUME_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
+    scene->AddNode(volumeNode);
+
+    // Apply dose grid scaling while casting to float, without intermediate copies
+    vtkSmartPointer<vtkImageShiftScale> imageShiftScale = vtkSmartPointer<vtkImageShiftScale>::New();
+    imageShiftScale->SetInputData(volumeNode->GetImageData());
+    imageShiftScale->SetOutputScalarTypeToFloat();
+    imageShiftScale->SetScale(doseGridScaling);
+    imageShiftScale->Update();
+
+    vtkSmartPointer<vtkImageData> floatVolumeData = vtkSmartPointer<vtkImageData>::New();
+    floatVolumeData->ShallowCopy(imageShiftScale->GetOutput());
+    volumeNode->SetAndObserveImageData(floatVolumeData);
+  }
 
   // Get default isodose color table and default dose color table
   vtkMRMLColorTableNode* defaultIsodoseColorTable = vtkSlicerIsodoseModuleLogic::CreateDefaultIsodoseColorTable(scene);
@@ -836,18 +1110,21 @@ bool vtkSlicerDicomRtImportExportModuleLogic::vtkInternal::LoadRtStructureSet(vt
     const char* roiLabel = rtReader->GetRoiName(internalROIIndex);
     double *roiColor = rtReader->GetRoiDisplayColor(internalROIIndex);
 
-    // Get structure
-    vtkPolyData* roiPolyData = rtReader->GetRoiPolyData(internalROIIndex);
-    if (roiPolyData == NULL)
+    // Skip empty ROIs without creating their contour model
+    vtkIdType roiNumberOfPoints = rtReader->GetRoiNumberOfPoints(internalROIIndex);
+    if (roiNumberOfPoints == 0)
     {
-      vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Invalid structure ROI data for ROI named '"
+      vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Structure ROI data does not contain any points for ROI named '"
         << (roiLabel?roiLabel:"Unnamed") << "' in file '" << fileName
         << "' (internal ROI index: " << internalROIIndex << ")");
       continue;
     }
-    if (roiPolyData->GetNumberOfPoints() == 0)
+
+    // Get structure (contour model is created by the reader at this point)
+    vtkPolyData* roiPolyData = rtReader->GetRoiPolyData(internalROIIndex);
+    if (roiPolyData == NULL || roiPolyData->GetNumberOfPoints() == 0)
     {
-      vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Structure ROI data does not contain any points for ROI named '"
+      vtkWarningWithObjectMacro(this->External, "LoadRtStructureSet: Invalid structure ROI data for ROI named '"
         << (roiLabel?roiLabel:"Unnamed") << "' in file '" << fileName
         << "' (internal ROI index: " << internalROIIndex << ")");
       continue;
@@ -1509,6 +1786,9 @@ vtkSlicerDicomRtImportExportModuleLogic::vtkSlicerDicomRtImportExportModuleLogic
   this->BeamsLogic = NULL;
 
   this->BeamModelsInSeparateBranch = true;
+  this->ExamineWithPartialRead = true;
+  this->NumberOfThreadsForExamine = 0;
+  this->NumberOfThreadsForExport = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -1529,6 +1809,11 @@ vtkSlicerDicomRtImportExportModuleLogic::~vtkSlicerDicomRtImportExportModuleLogi
 void vtkSlicerDicomRtImportExportModuleLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "BeamModelsInSeparateBranch: " << (this->BeamModelsInSeparateBranch ? "true" : "false") << "\n";
+  os << indent << "ExamineWithPartialRead: " << (this->ExamineWithPartialRead ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreadsForExamine: " << this->NumberOfThreadsForExamine << "\n";
+  os << indent << "NumberOfThreadsForExport: " << this->NumberOfThreadsForExport << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -1577,73 +1862,31 @@ void vtkSlicerDicomRtImportExportModuleLogic::ExamineForLoad(vtkStringArray* fil
   }
   loadables->RemoveAllItems();
 
-  for (int fileIndex=0; fileIndex<fileList->GetNumberOfValues(); ++fileIndex)
-  {
-    // Load file in DCMTK
-    DcmFileFormat fileformat;
-    vtkStdString fileName = fileList->GetValue(fileIndex);
-    OFCondition result = fileformat.loadFile(fileName.c_str(), EXS_Unknown);
-    if (!result.good())
-    {
-      continue; // Failed to parse this file, skip it
-    }
-
-    // Check SOP Class UID for one of the supported RT objects
-    DcmDataset *dataset = fileformat.getDataset();
-    OFString sopClass;
-    if (!dataset->findAndGetOFString(DCM_SOPClassUID, sopClass).good() || sopClass.empty())
-    {
-      continue; // Failed to parse this file, skip it
-    }
+  // Parse and examine the files. This is the time consuming part, so it is done concurrently
+  vtkIdType numberOfFiles = fileList->GetNumberOfValues();
+  std::vector<vtkInternal::ExaminedFile> examinedFiles(numberOfFiles);
+  vtkInternal::ExamineFilesFunctor examineFunctor(this->Internal, fileList, this->ExamineWithPartialRead, examinedFiles);
+  SlicerRtCommon::SmpFor(0, numberOfFiles, 1, examineFunctor, this->NumberOfThreadsForExamine);
 
-    // DICOM parsing is successful, now check if the object is loadable
-    OFString name("");
-    OFString seriesNumber("");
-    std::vector<OFString> referencedSOPInstanceUIDs;
-    dataset->findAndGetOFString(DCM_SeriesNumber, seriesNumber);
-    if (!seriesNumber.empty())
-    {
-      name += seriesNumber + ": ";
-    }
+  // Get RT plan names from the DICOM database (not thread-safe, so it is done for all doses afterwards)
+  this->Internal->AddReferencedRtPlanLabelToRtDoseNames(examinedFiles);
 
-    // RTDose
-    if (sopClass == UID_RTDoseStorage)
-    {
-      this->Internal->ExamineRtDoseDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTPlan
-    else if (sopClass == UID_RTPlanStorage)
-    {
-      this->Internal->ExamineRtPlanDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTStructureSet
-    else if (sopClass == UID_RTStructureSetStorage)
-    {
-      this->Internal->ExamineRtStructureSetDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    // RTImage
-    else if (sopClass == UID_RTImageStorage)
-    {
-      this->Internal->ExamineRtImageDataset(dataset, name, referencedSOPInstanceUIDs);
-    }
-    /* Not yet supported
-    else if (sopClass == UID_RTTreatmentSummaryRecordStorage)
-    else if (sopClass == UID_RTIonPlanStorage)
-    else if (sopClass == UID_RTIonBeamsTreatmentRecordStorage)
-    */
-    else
+  // Create and set up loadables for the loadable RT objects in the order of the files
+  for (vtkIdType fileIndex=0; fileIndex<numberOfFiles; ++fileIndex)
+  {
+    vtkInternal::ExaminedFile& examinedFile = examinedFiles[fileIndex];
+    if (!examinedFile.Loadable)
     {
-      continue; // Not an RT file
+      continue;
     }
 
-    // The file is a loadable RT object, create and set up loadable
     vtkSmartPointer<vtkSlicerDICOMLoadable> loadable = vtkSmartPointer<vtkSlicerDICOMLoadable>::New();
-    loadable->SetName(name.c_str());
-    loadable->AddFile(fileName.c_str());
+    loadable->SetName(examinedFile.Name.c_str());
+    loadable->AddFile(fileList->GetValue(fileIndex).c_str());
     loadable->SetConfidence(1.0);
     loadable->SetSelected(true);
     std::vector<OFString>::iterator uidIt;
-    for (uidIt = referencedSOPInstanceUIDs.begin(); uidIt != referencedSOPInstanceUIDs.end(); ++uidIt)
+    for (uidIt = examinedFile.ReferencedSOPInstanceUIDs.begin(); uidIt != examinedFile.ReferencedSOPInstanceUIDs.end(); ++uidIt)
     {
       loadable->AddReferencedInstanceUID(uidIt->c_str());
     }
@@ -1668,6 +1911,7 @@ bool vtkSlicerDicomRtImportExportModuleLogic::LoadDicomRT(vtkSlicerDICOMLoadable
 
   vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
   rtReader->SetFileName(firstFileName);
+  rtReader->LoadRoiContoursOnDemandOn(); // Contour models are created one by one when the segments are created
   rtReader->Update();
 
   // One series can contain composite information, e.g, an RTPLAN series can contain structure sets and plans as well
@@ -2039,20 +2283,26 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
       vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
       transformPolyData->SetTransform(nodeToWorldTransform);
 
-      // Initialize cutting plane with normal of the Z axis of the anatomical image
+      // Geometry of the slice planes: normal of the Z axis of the anatomical image
       vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
       imageOrientedImageData->GetImageToWorldMatrix(imageToWorldMatrix);
-      double normal[3] = { imageToWorldMatrix->GetElement(0,2), imageToWorldMatrix->GetElement(1,2), imageToWorldMatrix->GetElement(2,2) };
-      vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
-      slicePlane->SetNormal(normal);
+      ExportSliceGeometry sliceGeometry;
+      for (int i=0; i<3; ++i)
+      {
+        sliceGeometry.Origin[i] = imageToWorldMatrix->GetElement(i,3);
+        sliceGeometry.Normal[i] = imageToWorldMatrix->GetElement(i,2);
+      }
+      imageOrientedImageData->GetExtent(sliceGeometry.Extent);
+      sliceGeometry.SliceUIDs = &imageSliceUIDs;
 
-      // Export each segment in segmentation
+      // Get closed surface of each segment in world coordinates
       std::vector< std::string > segmentIDs;
       segmentationNode->GetSegmentation()->GetSegmentIDs(segmentIDs);
-      for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+      std::vector<SegmentExportContours> segmentContours(segmentIDs.size());
+      for (unsigned int segmentIndex=0; segmentIndex<segmentIDs.size(); ++segmentIndex)
       {
-        std::string segmentID = *segmentIdIt;
-        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(*segmentIdIt);
+        std::string segmentID = segmentIDs[segmentIndex];
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentID);
 
         // Get closed surface representation
         vtkPolyData* closedSurfacePolyData = vtkPolyData::SafeDownCast(
@@ -2064,69 +2314,36 @@ std::string vtkSlicerDicomRtImportExportModuleLogic::ExportDicomRTStudy(vtkColle
           return error;
         }
 
-        // Initialize cutter pipeline for segment
         transformPolyData->SetInputData(closedSurfacePolyData);
-        vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
-        cutter->SetInputConnection(transformPolyData->GetOutputPort());
-        cutter->SetGenerateCutScalars(0);
-        vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
-        stripper->SetInputConnection(cutter->GetOutputPort());
-
-        // Get segment bounding box
-        double bounds[6] = {0.0,0.0,0.0,0.0,0.0,0.0};
         transformPolyData->Update();
-        transformPolyData->GetOutput()->GetBounds(bounds);
-
-        // Containers to be passed to the writer
-        std::vector<int> sliceNumbers;
-        std::vector<std::string> sliceUIDs;
-        std::vector<vtkPolyData*> sliceContours;
-
-        // Create planar contours from closed surface based on each of the anatomical image slices
-        int imageExtent[6] = {0,-1,0,-1,0,-1};
-        imageOrientedImageData->GetExtent(imageExtent);
-        for (int slice=imageExtent[4]; slice<imageExtent[5]; ++slice)
-        {
-          // Calculate slice origin
-          double origin[3] = { imageToWorldMatrix->GetElement(0,3) + slice*normal[0],
-                               imageToWorldMatrix->GetElement(1,3) + slice*normal[1],
-                               imageToWorldMatrix->GetElement(2,3) + slice*normal[2] };
-          slicePlane->SetOrigin(origin);
-          if (origin[2] < bounds[4] || origin[2] > bounds[5])
-          {
-            // No contours outside surface bounds
-            continue;
-          }
-
-          // Cut closed surface at slice
-          cutter->SetCutFunction(slicePlane);
+        segmentContours[segmentIndex].ClosedSurface = vtkSmartPointer<vtkPolyData>::New();
+        segmentContours[segmentIndex].ClosedSurface->ShallowCopy(transformPolyData->GetOutput());
+      }
 
-          // Get instance UID of corresponding slice
-          int sliceNumber = slice-imageExtent[0];
-          sliceNumbers.push_back(sliceNumber);
-          std::string sliceInstanceUID = (imageSliceUIDs.size() > sliceNumber ? imageSliceUIDs[sliceNumber] : "");
-          sliceUIDs.push_back(sliceInstanceUID);
+      // Create planar contours from the closed surfaces based on each of the anatomical image slices.
+      // Segments are independent, so they are processed concurrently
+      CutClosedSurfacesFunctor cutFunctor(sliceGeometry, segmentContours);
+      SlicerRtCommon::SmpFor(0, static_cast<vtkIdType>(segmentContours.size()), 1, cutFunctor, this->NumberOfThreadsForExport);
 
-          // Save slice contour
-          stripper->Update();
-          vtkPolyData* sliceContour = vtkPolyData::New();
-          sliceContour->SetPoints(stripper->GetOutput()->GetPoints());
-          sliceContour->SetPolys(stripper->GetOutput()->GetLines());
-          sliceContours.push_back(sliceContour);
-        } // For each anatomical image slice
+      // Add contours to writer in the order of the segments
+      for (unsigned int segmentIndex=0; segmentIndex<segmentIDs.size(); ++segmentIndex)
+      {
+        vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentIDs[segmentIndex]);
+        SegmentExportContours& contours = segmentContours[segmentIndex];
 
         // Get segment properties
         std::string segmentName = segment->GetName();
         double* segmentColor = segment->GetColor();
 
-        // Add contours to writer
-        rtWriter->AddStructure(segmentName.c_str(), segmentColor, sliceNumbers, sliceUIDs, sliceContours);
-
-        // Clean up slice contours
-        for (std::vector<vtkPolyData*>::iterator contourIt=sliceContours.begin(); contourIt!=sliceContours.end(); ++contourIt)
+        std::vector<vtkPolyData*> sliceContours;
+        for (std::vector<vtkSmartPointer<vtkPolyData> >::iterator contourIt=contours.SliceContours.begin(); contourIt!=contours.SliceContours.end(); ++contourIt)
         {
-          (*contourIt)->Delete();
+          sliceContours.push_back(contourIt->GetPointer());
         }
+        rtWriter->AddStructure(segmentName.c_str(), segmentColor, contours.SliceNumbers, contours.SliceUIDs, sliceContours);
+
+        // Release slice contours and surface
+        contours = SegmentExportContours();
       } // For each segment
     }
     else
@@ -85,6 +85,16 @@ public:
   vtkGetMacro(BeamModelsInSeparateBranch, bool);
   vtkBooleanMacro(BeamModelsInSeparateBranch, bool);
 
+  vtkSetMacro(ExamineWithPartialRead, bool);
+  vtkGetMacro(ExamineWithPartialRead, bool);
+  vtkBooleanMacro(ExamineWithPartialRead, bool);
+
+  vtkSetMacro(NumberOfThreadsForExamine, int);
+  vtkGetMacro(NumberOfThreadsForExamine, int);
+
+  vtkSetMacro(NumberOfThreadsForExport, int);
+  vtkGetMacro(NumberOfThreadsForExport, int);
+
 protected:
   virtual void SetMRMLSceneInternal(vtkMRMLScene* newScene) VTK_OVERRIDE;
   virtual void OnMRMLSceneEndClose() VTK_OVERRIDE;
@@ -116,6 +126,22 @@ private:
   /// Flag determining whether the generated beam models are arranged in a separate subject hierarchy
   /// branch, or each beam model is added under its corresponding isocenter fiducial
   bool BeamModelsInSeparateBranch;
+
+  /// Flag determining whether ExamineForLoad only parses the files until the pixel data and skips
+  /// loading long values (on by default). The examination only needs a few attributes of each file.
+  bool ExamineWithPartialRead;
+
+  /// Number of threads used for examining the files in ExamineForLoad concurrently.
+  /// If 1, then the files are examined one after the other.
+  /// If 0 (default), then the current number of threads of the VTK SMP backend is used.
+  /// \sa SlicerRtCommon::SmpFor
+  int NumberOfThreadsForExamine;
+
+  /// Number of threads used for cutting the closed surfaces of the segments to planar contours in ExportDicomRTStudy.
+  /// If 1, then the segments are processed one after the other.
+  /// If 0 (default), then the current number of threads of the VTK SMP backend is used.
+  /// \sa SlicerRtCommon::SmpFor
+  int NumberOfThreadsForExport;
 };
 
 #endif
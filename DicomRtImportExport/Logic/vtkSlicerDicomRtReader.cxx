@@ -29,13 +29,18 @@
 
 // VTK includes
 #include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
+#include <vtkVariant.h>
 
 // STD includes
+#include <algorithm>
 #include <vector>
 #include <map>
 
@@ -44,6 +49,8 @@
 
 #include <dcmtk/ofstd/ofconapp.h>
 
+#include <dcmtk/dcmdata/dcxfer.h>
+
 #include <dcmtk/dcmrt/drtdose.h>
 #include <dcmtk/dcmrt/drtimage.h>
 #include <dcmtk/dcmrt/drtplan.h>
@@ -71,6 +78,20 @@ const std::string vtkSlicerDicomRtReader::DICOMRTREADER_DICOM_CONNECTION_NAME =
 
 vtkStandardNewMacro(vtkSlicerDicomRtReader);
 
+//----------------------------------------------------------------------------
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Convert stored dose values to float and multiply them by the dose grid scaling
+  template<class T> void ScaleStoredDoseValues(const T* storedValues, float* doseValues, vtkIdType numberOfValues, double doseGridScaling)
+  {
+    for (vtkIdType i=0; i<numberOfValues; ++i)
+    {
+      doseValues[i] = static_cast<float>(static_cast<float>(storedValues[i]) * doseGridScaling);
+    }
+  }
+}
+
 //----------------------------------------------------------------------------
 class vtkSlicerDicomRtReader::vtkInternal
 {
@@ -98,6 +119,12 @@ public:
     std::string ReferencedSeriesUID;
     std::string ReferencedFrameOfReferenceUID;
     std::map<int,std::string> ContourIndexToSOPInstanceUIDMap;
+    /// Number of contours and total number of contour points, known before the contours are loaded
+    vtkIdType NumberOfContours;
+    vtkIdType NumberOfContourPoints;
+    /// Contour sequence in \sa StructureSetObject from which the poly data is created when first requested.
+    /// NULL if the contours are already loaded (or if they are not loaded on demand)
+    DRTContourSequence* ContourSequence;
   };
 
   /// List of loaded contour ROIs from structure set
@@ -146,9 +173,20 @@ public:
   /// List of loaded contour ROIs from structure set
   std::vector<BeamEntry> BeamSequenceVector;
 
+  /// Structure set object kept for loading ROI contours on demand
+  DRTStructureSetIOD* StructureSetObject;
+
+  /// Dose volume decoded from the pixel data of the RT Dose dataset (scaled by dose grid scaling)
+  vtkSmartPointer<vtkImageData> DoseImageData;
+  /// Geometry of the decoded dose volume
+  vtkSmartPointer<vtkMatrix4x4> DoseIJKToRASMatrix;
+
 public:
   /// Load RT Dose
   void LoadRTDose(DcmDataset* dataset);
+  /// Decode dose volume from the pixel data of the already parsed RT Dose dataset.
+  /// \return Success flag. Unsupported encodings (e.g. compressed pixel data) are not decoded.
+  bool LoadRTDosePixelData(DcmDataset* dataset, double doseGridScaling);
 
   /// Load RT Plan 
   void LoadRTPlan(DcmDataset* dataset);
@@ -157,8 +195,12 @@ public:
   void LoadRTStructureSet(DcmDataset* dataset);
   /// Load contours from a structure sequence
   void LoadContoursFromRoiSequence(DRTStructureSetROISequence* roiSequence);
-  /// Load individual contour from RT Structure Set
+  /// Load individual contour from RT Structure Set. The contour poly data is only created if the contours are not loaded on demand
   vtkSlicerDicomRtReader::vtkInternal::RoiEntry* LoadContour(DRTROIContourSequence::Item &roiObject, DRTStructureSetIOD* rtStructureSetObject);
+  /// Create contour poly data of a ROI from its contour sequence
+  void LoadRoiPolyData(RoiEntry* roiEntry, DRTContourSequence &rtContourSequenceObject);
+  /// Create contour poly data of a ROI if it was deferred \sa vtkSlicerDicomRtReader::LoadRoiContoursOnDemand
+  void LoadPendingRoiPolyData(RoiEntry* roiEntry);
 
   /// Load RT Image
   void LoadRTImage(DcmDataset* dataset);
@@ -189,6 +231,7 @@ public:
 //----------------------------------------------------------------------------
 vtkSlicerDicomRtReader::vtkInternal::vtkInternal(vtkSlicerDicomRtReader* external)
   : External(external)
+  , StructureSetObject(NULL)
 {
   this->RoiSequenceVector.clear();
   this->BeamSequenceVector.clear();
@@ -199,6 +242,7 @@ vtkSlicerDicomRtReader::vtkInternal::~vtkInternal()
 {
   this->RoiSequenceVector.clear();
   this->BeamSequenceVector.clear();
+  delete this->StructureSetObject;
 }
 
 //----------------------------------------------------------------------------
@@ -209,6 +253,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry::RoiEntry()
   this->DisplayColor[1] = 0.0;
   this->DisplayColor[2] = 0.0;
   this->PolyData = NULL;
+  this->NumberOfContours = 0;
+  this->NumberOfContourPoints = 0;
+  this->ContourSequence = NULL;
 }
 
 vtkSlicerDicomRtReader::vtkInternal::RoiEntry::~RoiEntry()
@@ -229,6 +276,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry::RoiEntry(const RoiEntry& src)
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
+  this->NumberOfContours = src.NumberOfContours;
+  this->NumberOfContourPoints = src.NumberOfContourPoints;
+  this->ContourSequence = src.ContourSequence;
 }
 
 vtkSlicerDicomRtReader::vtkInternal::RoiEntry& vtkSlicerDicomRtReader::vtkInternal::RoiEntry::operator=(const RoiEntry &src)
@@ -243,6 +293,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry& vtkSlicerDicomRtReader::vtkIntern
   this->ReferencedSeriesUID = src.ReferencedSeriesUID;
   this->ReferencedFrameOfReferenceUID = src.ReferencedFrameOfReferenceUID;
   this->ContourIndexToSOPInstanceUIDMap = src.ContourIndexToSOPInstanceUIDMap;
+  this->NumberOfContours = src.NumberOfContours;
+  this->NumberOfContourPoints = src.NumberOfContourPoints;
+  this->ContourSequence = src.ContourSequence;
 
   return (*this);
 }
@@ -394,6 +447,8 @@ DRTContourImageSequence* vtkSlicerDicomRtReader::vtkInternal::GetReferencedFrame
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
 {
   this->External->LoadRTDoseSuccessful = false;
+  this->DoseImageData = NULL;
+  this->DoseIJKToRASMatrix = NULL;
 
   DRTDoseIOD rtDoseObject;
   if (rtDoseObject.read(*dataset).bad())
@@ -466,9 +521,173 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTDose(DcmDataset* dataset)
   // Get and store patient, study and series information
   this->External->GetAndStoreHierarchyInformation(&rtDoseObject);
 
+  // Decode the dose volume from the dataset, so that the file does not need to be read again
+  if (!this->LoadRTDosePixelData(dataset, vtkVariant(doseGridScaling.c_str()).ToDouble()))
+  {
+    vtkDebugWithObjectMacro(this->External, "LoadRTDose: Dose pixel data is not decoded, the dose volume needs to be read from the file");
+  }
+
   this->External->LoadRTDoseSuccessful = true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerDicomRtReader::vtkInternal::LoadRTDosePixelData(DcmDataset* dataset, double doseGridScaling)
+{
+  this->DoseImageData = NULL;
+  this->DoseIJKToRASMatrix = NULL;
+
+  // Only uncompressed little endian pixel data is decoded. Then DCMTK provides the pixel data as 16-bit words
+  // in host byte order, and for 32-bit pixels the low word comes first
+  DcmXfer transferSyntax(dataset->getOriginalXfer());
+  if (transferSyntax.isEncapsulated() || transferSyntax.getByteOrder() != EBO_LittleEndian)
+  {
+    return false;
+  }
+
+  Uint16 rows = 0;
+  Uint16 columns = 0;
+  Uint16 bitsAllocated = 0;
+  Uint16 bitsStored = 0;
+  Uint16 pixelRepresentation = 0;
+  Uint16 samplesPerPixel = 1;
+  Sint32 numberOfFrames = 1;
+  if ( dataset->findAndGetUint16(DCM_Rows, rows).bad()
+    || dataset->findAndGetUint16(DCM_Columns, columns).bad()
+    || dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated).bad()
+    || dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad()
+    || dataset->findAndGetUint16(DCM_PixelRepresentation, pixelRepresentation).bad() )
+  {
+    return false;
+  }
+  dataset->findAndGetUint16(DCM_SamplesPerPixel, samplesPerPixel);
+  dataset->findAndGetSint32(DCM_NumberOfFrames, numberOfFrames);
+  if ( rows == 0 || columns == 0 || numberOfFrames < 1 || samplesPerPixel != 1
+    || (bitsAllocated != 16 && bitsAllocated != 32) || bitsStored != bitsAllocated )
+  {
+    return false;
+  }
+  // Rescaling is handled by the generic volume reader
+  if (dataset->tagExists(DCM_RescaleSlope) || dataset->tagExists(DCM_RescaleIntercept))
+  {
+    return false;
+  }
+
+  // Geometry
+  double imagePositionPatient[3] = {0.0, 0.0, 0.0};
+  double imageOrientationPatient[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  double pixelSpacing[2] = {0.0, 0.0};
+  for (int i=0; i<3; ++i)
+  {
+    if (dataset->findAndGetFloat64(DCM_ImagePositionPatient, imagePositionPatient[i], i).bad())
+    {
+      return false;
+    }
+  }
+  for (int i=0; i<6; ++i)
+  {
+    if (dataset->findAndGetFloat64(DCM_ImageOrientationPatient, imageOrientationPatient[i], i).bad())
+    {
+      return false;
+    }
+  }
+  for (int i=0; i<2; ++i)
+  {
+    if (dataset->findAndGetFloat64(DCM_PixelSpacing, pixelSpacing[i], i).bad())
+    {
+      return false;
+    }
+  }
+
+  // Slice spacing from the grid frame offset vector. Only uniform spacing is supported
+  double sliceSpacing = 1.0;
+  if (numberOfFrames > 1)
+  {
+    std::vector<double> gridFrameOffsets(numberOfFrames, 0.0);
+    for (Sint32 frameIndex=0; frameIndex<numberOfFrames; ++frameIndex)
+    {
+      if (dataset->findAndGetFloat64(DCM_GridFrameOffsetVector, gridFrameOffsets[frameIndex], frameIndex).bad())
+      {
+        return false;
+      }
+    }
+    sliceSpacing = gridFrameOffsets[1] - gridFrameOffsets[0];
+    if (sliceSpacing == 0.0)
+    {
+      return false;
+    }
+    for (Sint32 frameIndex=2; frameIndex<numberOfFrames; ++frameIndex)
+    {
+      if (fabs(gridFrameOffsets[frameIndex] - gridFrameOffsets[frameIndex-1] - sliceSpacing) > 1.0e-3 * fabs(sliceSpacing))
+      {
+        return false;
+      }
+    }
+  }
+
+  // Pixel data
+  Uint16* pixelData = NULL;
+  DcmElement* pixelDataElement = NULL;
+  if ( dataset->findAndGetElement(DCM_PixelData, pixelDataElement).bad() || !pixelDataElement
+    || pixelDataElement->getUint16Array(pixelData).bad() || !pixelData )
+  {
+    return false;
+  }
+  unsigned long numberOfWords = pixelDataElement->getLength() / 2;
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(rows) * columns * numberOfFrames;
+  if (numberOfWords < static_cast<unsigned long>(numberOfVoxels * (bitsAllocated / 16)))
+  {
+    vtkErrorWithObjectMacro(this->External, "LoadRTDosePixelData: Pixel data is shorter than expected");
+    return false;
+  }
+
+  // Convert the stored values to float and apply dose grid scaling in one pass into the output image
+  vtkSmartPointer<vtkImageData> doseImageData = vtkSmartPointer<vtkImageData>::New();
+  doseImageData->SetExtent(0, columns-1, 0, rows-1, 0, numberOfFrames-1);
+  doseImageData->AllocateScalars(VTK_FLOAT, 1);
+  float* doseValues = static_cast<float*>(doseImageData->GetScalarPointer());
+  if (bitsAllocated == 16)
+  {
+    if (pixelRepresentation == 0)
+    {
+      ScaleStoredDoseValues(pixelData, doseValues, numberOfVoxels, doseGridScaling);
+    }
+    else
+    {
+      ScaleStoredDoseValues(reinterpret_cast<const Sint16*>(pixelData), doseValues, numberOfVoxels, doseGridScaling);
+    }
+  }
+  else
+  {
+    for (vtkIdType i=0; i<numberOfVoxels; ++i)
+    {
+      Uint32 storedValue = static_cast<Uint32>(pixelData[2*i]) | (static_cast<Uint32>(pixelData[2*i+1]) << 16);
+      float value = (pixelRepresentation == 0 ? static_cast<float>(storedValue) : static_cast<float>(static_cast<Sint32>(storedValue)));
+      doseValues[i] = static_cast<float>(value * doseGridScaling);
+    }
+  }
+
+  // IJK to RAS matrix: the column directions are the row, column and slice directions in LPS, converted to RAS.
+  // Pixel spacing is the row spacing (Y) followed by the column spacing (X)
+  double rowDirection[3] = { imageOrientationPatient[0], imageOrientationPatient[1], imageOrientationPatient[2] };
+  double columnDirection[3] = { imageOrientationPatient[3], imageOrientationPatient[4], imageOrientationPatient[5] };
+  double sliceDirection[3] = {0.0, 0.0, 0.0};
+  vtkMath::Cross(rowDirection, columnDirection, sliceDirection);
+  double spacing[3] = { pixelSpacing[1], pixelSpacing[0], sliceSpacing };
+  vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i=0; i<3; ++i)
+  {
+    double lpsToRas = (i < 2 ? -1.0 : 1.0);
+    ijkToRasMatrix->SetElement(i, 0, lpsToRas * rowDirection[i] * spacing[0]);
+    ijkToRasMatrix->SetElement(i, 1, lpsToRas * columnDirection[i] * spacing[1]);
+    ijkToRasMatrix->SetElement(i, 2, lpsToRas * sliceDirection[i] * spacing[2]);
+    ijkToRasMatrix->SetElement(i, 3, lpsToRas * imagePositionPatient[i]);
+  }
+
+  this->DoseImageData = doseImageData;
+  this->DoseIJKToRASMatrix = ijkToRasMatrix;
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTPlan(DcmDataset* dataset)
 {
@@ -676,7 +895,14 @@ void vtkSlicerDicomRtReader::vtkInternal::LoadRTStructureSet(DcmDataset* dataset
 {
   this->External->LoadRTStructureSetSuccessful = false;
 
-  DRTStructureSetIOD* rtStructureSetObject = new DRTStructureSetIOD();
+  // Load the pending contours of a previously read structure set before its object is deleted
+  for (std::vector<RoiEntry>::iterator roiIt = this->RoiSequenceVector.begin(); roiIt != this->RoiSequenceVector.end(); ++roiIt)
+  {
+    this->LoadPendingRoiPolyData(&(*roiIt));
+  }
+  delete this->StructureSetObject;
+  this->StructureSetObject = new DRTStructureSetIOD();
+  DRTStructureSetIOD* rtStructureSetObject = this->StructureSetObject;
   if (rtStructureSetObject->read(*dataset).bad())
   {
     vtkErrorWithObjectMacro(this->External, "LoadRTStructureSet: Could not load strucure set object from dataset");
@@ -801,12 +1027,9 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     return roiEntry;
   }
 
-  // Create containers for contour poly data
-  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
-  vtkIdType pointId = 0;
-
-  // Read contour data, iterate over contour sequence
+  // Index the contours (number of points and referenced slices), the contour data is read in LoadRoiPolyData
+  roiEntry->NumberOfContours = 0;
+  roiEntry->NumberOfContourPoints = 0;
   do
   {
     // Get contour
@@ -817,28 +1040,12 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     }
 
     // Get number of contour points
-    OFString numberOfPointsString("");
-    contourItem.getNumberOfContourPoints(numberOfPointsString);
-    std::stringstream ss;
-    ss << numberOfPointsString;
-    int numberOfPoints;
-    ss >> numberOfPoints;
-
-    // Get contour point data
-    OFVector<vtkTypeFloat64> contourData_LPS;
-    contourItem.getContourData(contourData_LPS);
-
-    unsigned int contourIndex = currentRoiContourCells->InsertNextCell(numberOfPoints+1);
-    for (int k=0; k<numberOfPoints; k++)
-    {
-      // Convert from DICOM LPS -> Slicer RAS
-      currentRoiContourPoints->InsertPoint(pointId, -contourData_LPS[3*k], -contourData_LPS[3*k+1], contourData_LPS[3*k+2]);
-      currentRoiContourCells->InsertCellPoint(pointId);
-      pointId++;
-    }
+    Sint32 numberOfPoints = 0;
+    contourItem.getNumberOfContourPoints(numberOfPoints);
+    roiEntry->NumberOfContourPoints += std::max<Sint32>(numberOfPoints, 0);
 
-    // Close the contour
-    currentRoiContourCells->InsertCellPoint(pointId-numberOfPoints);
+    // Contour index is the index of the cell in the contour poly data
+    int contourIndex = roiEntry->NumberOfContours++;
 
     // Add map to the referenced slice instance UID
     // This is not a mandatory field so no error logged if not found. The reason why
@@ -899,20 +1106,15 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
     }
   }
 
-  // Save just loaded contour data into ROI entry
-  vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
-  currentRoiPolyData->SetPoints(currentRoiContourPoints);
-  if (currentRoiContourPoints->GetNumberOfPoints() == 1)
+  // Create contour poly data now, or store the contour sequence to create it when first requested
+  if (this->External->LoadRoiContoursOnDemand)
   {
-    // Point ROI
-    currentRoiPolyData->SetVerts(currentRoiContourCells);
+    roiEntry->ContourSequence = &rtContourSequenceObject;
   }
-  else if (currentRoiContourPoints->GetNumberOfPoints() > 1)
+  else
   {
-    // Contour ROI
-    currentRoiPolyData->SetLines(currentRoiContourCells);
+    this->LoadRoiPolyData(roiEntry, rtContourSequenceObject);
   }
-  roiEntry->SetPolyData(currentRoiPolyData);
 
   // Get structure color
   Sint32 roiDisplayColor = -1;
@@ -940,6 +1142,107 @@ vtkSlicerDicomRtReader::vtkInternal::RoiEntry* vtkSlicerDicomRtReader::vtkIntern
   return roiEntry;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::LoadRoiPolyData(RoiEntry* roiEntry, DRTContourSequence &rtContourSequenceObject)
+{
+  // Allocate points and cells for all contours at once. The number of points is known from indexing the contours.
+  // Each cell contains the number of points, the point IDs, and the first point ID again to close the contour
+  vtkSmartPointer<vtkPoints> currentRoiContourPoints = vtkSmartPointer<vtkPoints>::New();
+  currentRoiContourPoints->SetDataTypeToFloat();
+  currentRoiContourPoints->SetNumberOfPoints(roiEntry->NumberOfContourPoints);
+  float* pointsPtr = static_cast<float*>(currentRoiContourPoints->GetVoidPointer(0));
+  vtkSmartPointer<vtkIdTypeArray> cellsArray = vtkSmartPointer<vtkIdTypeArray>::New();
+  cellsArray->SetNumberOfValues(2*roiEntry->NumberOfContours + roiEntry->NumberOfContourPoints);
+  vtkIdType* cellsPtr = cellsArray->GetPointer(0);
+  vtkIdType numberOfCells = 0;
+  vtkIdType pointId = 0;
+  vtkIdType cellsArrayIndex = 0;
+
+  // Read contour data, iterate over contour sequence
+  if (rtContourSequenceObject.gotoFirstItem().good())
+  {
+    do
+    {
+      // Get contour
+      DRTContourSequence::Item &contourItem = rtContourSequenceObject.getCurrentItem();
+      if (!contourItem.isValid() || numberOfCells >= roiEntry->NumberOfContours)
+      {
+        continue;
+      }
+
+      // Get number of contour points
+      Sint32 numberOfPoints = 0;
+      contourItem.getNumberOfContourPoints(numberOfPoints);
+
+      // Get contour point data
+      OFVector<vtkTypeFloat64> contourData_LPS;
+      contourItem.getContourData(contourData_LPS);
+      vtkIdType numberOfPointsInContour = std::max<vtkIdType>(numberOfPoints, 0);
+      numberOfPointsInContour = std::min<vtkIdType>(numberOfPointsInContour, contourData_LPS.size() / 3);
+      numberOfPointsInContour = std::min<vtkIdType>(numberOfPointsInContour, roiEntry->NumberOfContourPoints - pointId);
+      if (numberOfPointsInContour != numberOfPoints)
+      {
+        vtkWarningWithObjectMacro(this->External, "LoadRoiPolyData: Contour data in ROI " << roiEntry->Number << ": " << roiEntry->Name
+          << " contains " << numberOfPointsInContour << " points instead of the specified " << numberOfPoints);
+      }
+
+      cellsPtr[cellsArrayIndex++] = numberOfPointsInContour + 1;
+      for (vtkIdType k=0; k<numberOfPointsInContour; k++)
+      {
+        // Convert from DICOM LPS -> Slicer RAS
+        pointsPtr[3*pointId] = static_cast<float>(-contourData_LPS[3*k]);
+        pointsPtr[3*pointId+1] = static_cast<float>(-contourData_LPS[3*k+1]);
+        pointsPtr[3*pointId+2] = static_cast<float>(contourData_LPS[3*k+2]);
+        cellsPtr[cellsArrayIndex++] = pointId;
+        pointId++;
+      }
+
+      // Close the contour
+      cellsPtr[cellsArrayIndex++] = pointId-numberOfPointsInContour;
+      numberOfCells++;
+    }
+    while (rtContourSequenceObject.gotoNextItem().good());
+  }
+
+  // Shrink arrays if the contours contained less data than specified
+  if (pointId < currentRoiContourPoints->GetNumberOfPoints())
+  {
+    currentRoiContourPoints->SetNumberOfPoints(pointId);
+  }
+  if (cellsArrayIndex < cellsArray->GetNumberOfValues())
+  {
+    cellsArray->SetNumberOfValues(cellsArrayIndex);
+  }
+  vtkSmartPointer<vtkCellArray> currentRoiContourCells = vtkSmartPointer<vtkCellArray>::New();
+  currentRoiContourCells->SetCells(numberOfCells, cellsArray);
+
+  // Save just loaded contour data into ROI entry
+  vtkSmartPointer<vtkPolyData> currentRoiPolyData = vtkSmartPointer<vtkPolyData>::New();
+  currentRoiPolyData->SetPoints(currentRoiContourPoints);
+  if (currentRoiContourPoints->GetNumberOfPoints() == 1)
+  {
+    // Point ROI
+    currentRoiPolyData->SetVerts(currentRoiContourCells);
+  }
+  else if (currentRoiContourPoints->GetNumberOfPoints() > 1)
+  {
+    // Contour ROI
+    currentRoiPolyData->SetLines(currentRoiContourCells);
+  }
+  roiEntry->SetPolyData(currentRoiPolyData);
+  roiEntry->ContourSequence = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDicomRtReader::vtkInternal::LoadPendingRoiPolyData(RoiEntry* roiEntry)
+{
+  if (!roiEntry || !roiEntry->ContourSequence)
+  {
+    return;
+  }
+  this->LoadRoiPolyData(roiEntry, *roiEntry->ContourSequence);
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerDicomRtReader::vtkInternal::LoadRTImage(DcmDataset* dataset)
 {
@@ -1230,6 +1533,8 @@ vtkSlicerDicomRtReader::vtkSlicerDicomRtReader()
   this->LoadRTDoseSuccessful = false;
   this->LoadRTPlanSuccessful = false;
   this->LoadRTImageSuccessful = false;
+
+  this->LoadRoiContoursOnDemand = false;
 }
 
 //----------------------------------------------------------------------------
@@ -1358,9 +1663,38 @@ vtkPolyData* vtkSlicerDicomRtReader::GetRoiPolyData(unsigned int internalIndex)
     vtkErrorMacro("GetRoiPolyData: Cannot get ROI with internal index: " << internalIndex);
     return NULL;
   }
+  this->Internal->LoadPendingRoiPolyData(&this->Internal->RoiSequenceVector[internalIndex]);
   return this->Internal->RoiSequenceVector[internalIndex].PolyData;
 }
 
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerDicomRtReader::GetRoiNumberOfPoints(unsigned int internalIndex)
+{
+  if (internalIndex >= this->Internal->RoiSequenceVector.size())
+  {
+    vtkErrorMacro("GetRoiNumberOfPoints: Cannot get ROI with internal index: " << internalIndex);
+    return 0;
+  }
+  vtkInternal::RoiEntry& roiEntry = this->Internal->RoiSequenceVector[internalIndex];
+  if (roiEntry.PolyData && !roiEntry.ContourSequence)
+  {
+    return roiEntry.PolyData->GetNumberOfPoints();
+  }
+  return roiEntry.NumberOfContourPoints;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerDicomRtReader::GetDoseImageData()
+{
+  return this->Internal->DoseImageData.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkMatrix4x4* vtkSlicerDicomRtReader::GetDoseIJKToRASMatrix()
+{
+  return this->Internal->DoseIJKToRASMatrix.GetPointer();
+}
+
 //----------------------------------------------------------------------------
 const char* vtkSlicerDicomRtReader::GetRoiReferencedSeriesUid(unsigned int internalIndex)
 {
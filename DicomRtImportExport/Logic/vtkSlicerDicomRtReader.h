@@ -35,6 +35,8 @@
 // VTK includes
 #include <vtkObject.h>
 
+class vtkImageData;
+class vtkMatrix4x4;
 class vtkPolyData;
 
 // Due to some reason the Python wrapping of this class fails, therefore
@@ -69,10 +71,15 @@ public:
   /// \param internalIndex Internal index of ROI to get
   double* GetRoiDisplayColor(unsigned int internalIndex);
 
-  /// Get model of a certain ROI by internal index
+  /// Get model of a certain ROI by internal index.
+  /// If the contours are loaded on demand, then the model is created at the first call \sa LoadRoiContoursOnDemand
   /// \param internalIndex Internal index of ROI to get
   vtkPolyData* GetRoiPolyData(unsigned int internalIndex);
 
+  /// Get number of contour points of a certain ROI by internal index. Does not create the model of the ROI
+  /// \param internalIndex Internal index of ROI to get
+  vtkIdType GetRoiNumberOfPoints(unsigned int internalIndex);
+
   /// Get referenced series UID for a certain ROI by internal index
   /// \param internalIndex Internal index of ROI to get
   const char* GetRoiReferencedSeriesUid(unsigned int internalIndex);
@@ -108,6 +115,14 @@ public:
   /// Set input file name
   vtkSetStringMacro(FileName);
 
+  /// Set flag determining whether the contour models of the ROIs in a structure set are created
+  /// when they are first requested instead of when the file is read
+  vtkSetMacro(LoadRoiContoursOnDemand, bool);
+  /// Get flag determining whether the contour models of the ROIs are created on demand
+  vtkGetMacro(LoadRoiContoursOnDemand, bool);
+  /// Set flag determining whether the contour models of the ROIs are created on demand
+  vtkBooleanMacro(LoadRoiContoursOnDemand, bool);
+
   /// Get referenced SOP instance UID list for the loaded structure set
   vtkGetStringMacro(RTStructureSetReferencedSOPInstanceUIDs);
   /// Set referenced SOP instance UID list for the loaded structure set
@@ -116,6 +131,14 @@ public:
   /// Get pixel spacing for dose volume
   vtkGetVector2Macro(PixelSpacing, double); 
 
+  /// Get dose volume decoded from the pixel data of the loaded RT Dose, scaled by the dose grid scaling.
+  /// The image has unit spacing and zero origin, the geometry is given by \sa GetDoseIJKToRASMatrix.
+  /// \return NULL if the pixel data could not be decoded (e.g. compressed), then the dose needs to be read from the file
+  vtkImageData* GetDoseImageData();
+
+  /// Get IJK to RAS matrix of the decoded dose volume \sa GetDoseImageData
+  vtkMatrix4x4* GetDoseIJKToRASMatrix();
+
   /// Get dose units
   vtkGetStringMacro(DoseUnits); 
   /// Set dose units
@@ -412,6 +435,10 @@ protected:
   /// Flag indicating if RT Image has been successfully read from the input dataset
   bool LoadRTImageSuccessful;
 
+  /// Flag determining whether the contour models of the ROIs are only created when first requested.
+  /// Only the ROI metadata is read when the file is read. Off by default.
+  bool LoadRoiContoursOnDemand;
+
 protected:
   vtkSlicerDicomRtReader();
   virtual ~vtkSlicerDicomRtReader();
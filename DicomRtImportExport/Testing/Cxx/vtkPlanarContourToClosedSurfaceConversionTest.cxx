@@ -0,0 +1,235 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+#include "vtkPlanarContourToClosedSurfaceBaselineConversionRule.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMath.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkXMLMultiBlockDataReader.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+bool ConvertPlanarContours(vtkPolyData* planarContours, const std::string& numberOfThreads, vtkPolyData* closedSurface);
+bool ArePolyDataIdentical(vtkPolyData* polyData1, vtkPolyData* polyData2);
+void CreateBranchingContours(vtkPolyData* planarContours);
+
+//-----------------------------------------------------------------------------
+// Convert the planar contours of the structures of an RT structure set and of a synthetic branching structure
+// to closed surface with one and with all available threads
+// (\sa vtkPlanarContourToClosedSurfaceConversionRule::GetNumberOfThreadsParameterName), and check that the
+// resulting surfaces are identical, and have the same number of points and triangles as the surfaces created
+// by the baseline algorithm (\sa vtkPlanarContourToClosedSurfaceBaselineConversionRule)
+int vtkPlanarContourToClosedSurfaceConversionTest( int argc, char * argv[] )
+{
+  int argIndex = 1;
+
+  // InputSegmentationFile
+  const char *inputSegmentationFileName = NULL;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-InputSegmentationFile") == 0)
+    {
+      inputSegmentationFileName = argv[argIndex+1];
+      std::cout << "Input segmentation file: " << inputSegmentationFileName << std::endl;
+      argIndex += 2;
+    }
+    else
+    {
+      inputSegmentationFileName = "";
+    }
+  }
+  else
+  {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Read the planar contours of the structures (one block per segment)
+  vtkSmartPointer<vtkXMLMultiBlockDataReader> reader = vtkSmartPointer<vtkXMLMultiBlockDataReader>::New();
+  reader->SetFileName(inputSegmentationFileName);
+  reader->Update();
+  vtkMultiBlockDataSet* structures = vtkMultiBlockDataSet::SafeDownCast(reader->GetOutput());
+  if (!structures || structures->GetNumberOfBlocks() < 2)
+  {
+    std::cerr << "ERROR: Failed to read multiple structures from " << inputSegmentationFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<vtkSmartPointer<vtkPolyData> > structurePlanarContours;
+  for (unsigned int structureIndex=0; structureIndex<structures->GetNumberOfBlocks(); ++structureIndex)
+  {
+    vtkPolyData* planarContours = vtkPolyData::SafeDownCast(structures->GetBlock(structureIndex));
+    if (!planarContours || planarContours->GetNumberOfLines() == 0)
+    {
+      std::cerr << "ERROR: Structure " << structureIndex << " has no planar contours" << std::endl;
+      return EXIT_FAILURE;
+    }
+    structurePlanarContours.push_back(planarContours);
+  }
+  // Structure with multiple contours per plane that branch into each other
+  vtkSmartPointer<vtkPolyData> branchingPlanarContours = vtkSmartPointer<vtkPolyData>::New();
+  CreateBranchingContours(branchingPlanarContours);
+  structurePlanarContours.push_back(branchingPlanarContours);
+
+  for (unsigned int structureIndex=0; structureIndex<structurePlanarContours.size(); ++structureIndex)
+  {
+    vtkPolyData* planarContours = structurePlanarContours[structureIndex];
+
+    vtkSmartPointer<vtkPolyData> singleThreadSurface = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> multiThreadSurface = vtkSmartPointer<vtkPolyData>::New();
+    if ( !ConvertPlanarContours(planarContours, "1", singleThreadSurface)
+      || !ConvertPlanarContours(planarContours, "0", multiThreadSurface) )
+    {
+      std::cerr << "ERROR: Failed to convert structure " << structureIndex << " to closed surface" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (singleThreadSurface->GetNumberOfPolys() == 0)
+    {
+      std::cerr << "ERROR: Closed surface of structure " << structureIndex << " is empty" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!ArePolyDataIdentical(singleThreadSurface, multiThreadSurface))
+    {
+      std::cerr << "ERROR: Closed surface of structure " << structureIndex << " differs between one and multiple threads" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    vtkSmartPointer<vtkPlanarContourToClosedSurfaceBaselineConversionRule> baselineRule =
+      vtkSmartPointer<vtkPlanarContourToClosedSurfaceBaselineConversionRule>::New();
+    vtkSmartPointer<vtkPolyData> baselineSurface = vtkSmartPointer<vtkPolyData>::New();
+    if (!baselineRule->Convert(planarContours, baselineSurface))
+    {
+      std::cerr << "ERROR: Failed to convert structure " << structureIndex << " to closed surface with the baseline algorithm" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( singleThreadSurface->GetNumberOfPoints() != baselineSurface->GetNumberOfPoints()
+      || singleThreadSurface->GetNumberOfPolys() != baselineSurface->GetNumberOfPolys() )
+    {
+      std::cerr << "ERROR: Closed surface of structure " << structureIndex << " has " << singleThreadSurface->GetNumberOfPoints()
+        << " points and " << singleThreadSurface->GetNumberOfPolys() << " triangles instead of " << baselineSurface->GetNumberOfPoints()
+        << " points and " << baselineSurface->GetNumberOfPolys() << " triangles created by the baseline algorithm" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Structure " << structureIndex << ": " << planarContours->GetNumberOfLines() << " contours, "
+      << singleThreadSurface->GetNumberOfPoints() << " points, " << singleThreadSurface->GetNumberOfPolys() << " triangles" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+bool ConvertPlanarContours(vtkPolyData* planarContours, const std::string& numberOfThreads, vtkPolyData* closedSurface)
+{
+  vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule> rule = vtkSmartPointer<vtkPlanarContourToClosedSurfaceConversionRule>::New();
+  rule->SetConversionParameter(vtkPlanarContourToClosedSurfaceConversionRule::GetNumberOfThreadsParameterName(), numberOfThreads);
+  return rule->Convert(planarContours, closedSurface);
+}
+
+//-----------------------------------------------------------------------------
+void CreateBranchingContours(vtkPolyData* planarContours)
+{
+  // Circles on each plane (center X, center Y, radius). A single contour branches into two contours,
+  // an island without overlapping contours appears on one plane, then the two contours merge into one.
+  const int numberOfPlanes = 5;
+  const double planeSpacing = 3.0;
+  const int maximumNumberOfCirclesOnPlane = 3;
+  const int numberOfCirclesOnPlane[numberOfPlanes] = { 1, 2, 3, 1, 1 };
+  const double circles[numberOfPlanes][maximumNumberOfCirclesOnPlane][3] =
+  {
+    { {0.0, 0.0, 20.0} },
+    { {-10.0, 0.0, 8.0}, {10.0, 0.0, 8.0} },
+    { {-10.0, 0.0, 8.0}, {10.0, 0.0, 8.0}, {40.0, 40.0, 5.0} },
+    { {0.0, 0.0, 20.0} },
+    { {0.0, 0.0, 15.0} }
+  };
+  const int numberOfPointsInCircle = 48;
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  for (int planeIndex=0; planeIndex<numberOfPlanes; ++planeIndex)
+  {
+    for (int circleIndex=0; circleIndex<numberOfCirclesOnPlane[planeIndex]; ++circleIndex)
+    {
+      const double* circle = circles[planeIndex][circleIndex];
+      vtkIdType firstPointId = points->GetNumberOfPoints();
+      lines->InsertNextCell(numberOfPointsInCircle+1);
+      for (int pointIndex=0; pointIndex<numberOfPointsInCircle; ++pointIndex)
+      {
+        double angle = 2.0 * vtkMath::Pi() * pointIndex / numberOfPointsInCircle;
+        lines->InsertCellPoint(points->InsertNextPoint(
+          circle[0] + circle[2] * cos(angle), circle[1] + circle[2] * sin(angle), planeIndex * planeSpacing));
+      }
+      // Close the contour
+      lines->InsertCellPoint(firstPointId);
+    }
+  }
+  planarContours->SetPoints(points);
+  planarContours->SetLines(lines);
+}
+
+//-----------------------------------------------------------------------------
+bool ArePolyDataIdentical(vtkPolyData* polyData1, vtkPolyData* polyData2)
+{
+  if ( polyData1->GetNumberOfPoints() != polyData2->GetNumberOfPoints()
+    || polyData1->GetNumberOfPolys() != polyData2->GetNumberOfPolys() )
+  {
+    std::cerr << "Number of points or polygons differ: " << polyData1->GetNumberOfPoints() << " points, " << polyData1->GetNumberOfPolys()
+      << " polygons and " << polyData2->GetNumberOfPoints() << " points, " << polyData2->GetNumberOfPolys() << " polygons" << std::endl;
+    return false;
+  }
+  for (vtkIdType pointId=0; pointId<polyData1->GetNumberOfPoints(); ++pointId)
+  {
+    double point1[3] = {0.0, 0.0, 0.0};
+    polyData1->GetPoint(pointId, point1);
+    double point2[3] = {0.0, 0.0, 0.0};
+    polyData2->GetPoint(pointId, point2);
+    if (point1[0] != point2[0] || point1[1] != point2[1] || point1[2] != point2[2])
+    {
+      std::cerr << "Point " << pointId << " differs" << std::endl;
+      return false;
+    }
+  }
+  vtkCellArray* polys1 = polyData1->GetPolys();
+  vtkCellArray* polys2 = polyData2->GetPolys();
+  vtkIdType npts1 = 0;
+  vtkIdType* pts1 = NULL;
+  vtkIdType npts2 = 0;
+  vtkIdType* pts2 = NULL;
+  polys2->InitTraversal();
+  vtkIdType polyIndex = 0;
+  for (polys1->InitTraversal(); polys1->GetNextCell(npts1, pts1); ++polyIndex)
+  {
+    polys2->GetNextCell(npts2, pts2);
+    if (npts1 != npts2 || !std::equal(pts1, pts1 + npts1, pts2))
+    {
+      std::cerr << "Polygon " << polyIndex << " differs" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
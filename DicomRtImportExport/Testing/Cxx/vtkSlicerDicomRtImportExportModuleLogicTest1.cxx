@@ -0,0 +1,496 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  This file was originally developed by Csaba Pinter, PerkLab, Queen's University
+  and was supported through the Applied Cancer Research Unit program of Cancer Care
+  Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtImportExportModuleLogic.h"
+#include "vtkSlicerDicomRtReader.h"
+
+// Segmentations includes
+#include "vtkMRMLSegmentationNode.h"
+
+// SegmentationCore includes
+#include "vtkSegment.h"
+#include "vtkSegmentation.h"
+#include "vtkSegmentationConverter.h"
+
+// SubjectHierarchy includes
+#include "vtkMRMLSubjectHierarchyConstants.h"
+#include "vtkSlicerSubjectHierarchyModuleLogic.h"
+
+// DICOMLib includes
+#include "vtkSlicerDICOMExportable.h"
+#include "vtkSlicerDICOMLoadable.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSubjectHierarchyNode.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkCutter.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkStringArray.h>
+#include <vtkStripper.h>
+
+// VTKSYS includes
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+std::string ExportStudy(vtkSlicerDicomRtImportExportModuleLogic* logic, vtkCollection* exportables, int numberOfThreads, const std::string& outputDirectory);
+vtkSmartPointer<vtkSlicerDicomRtReader> ReadExportedStructureSet(const std::string& outputDirectory);
+void ExamineDirectory(vtkSlicerDicomRtImportExportModuleLogic* logic, const std::string& directoryPath, bool partialRead, int numberOfThreads, vtkCollection* loadables);
+bool AreLoadablesEqual(vtkCollection* loadables1, vtkCollection* loadables2);
+double GetMaximumDistanceFromCutterContours(vtkPolyData* closedSurface, vtkPolyData* exportedContours,
+  double firstSlicePosition, double sliceSpacing, int numberOfSlices);
+double GetMaximumDistanceToClosestPoint(vtkPoints* points, vtkPoints* targetPoints);
+
+//-----------------------------------------------------------------------------
+// Export a closed surface segmentation to an RT structure set with one and with multiple threads
+// (\sa vtkSlicerDicomRtImportExportModuleLogic::NumberOfThreadsForExport), and compare the exported contours
+// to each other and to the contours created by cutting the whole closed surfaces at each image slice.
+// Examine the exported files with full and partial read, and with one and with multiple threads
+// (\sa vtkSlicerDicomRtImportExportModuleLogic::ExamineWithPartialRead, NumberOfThreadsForExamine),
+// and compare the loadables.
+int vtkSlicerDicomRtImportExportModuleLogicTest1( int argc, char * argv[] )
+{
+  int argIndex = 1;
+
+  // TemporaryDirectory
+  const char *temporaryDirectoryName = NULL;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-TemporaryDirectory") == 0)
+    {
+      temporaryDirectoryName = argv[argIndex+1];
+      std::cout << "Temporary directory: " << temporaryDirectoryName << std::endl;
+      argIndex += 2;
+    }
+    else
+    {
+      temporaryDirectoryName = "";
+    }
+  }
+  else
+  {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string temporaryDirectory(temporaryDirectoryName);
+
+  // Create scene and logic
+  vtkSmartPointer<vtkMRMLScene> mrmlScene = vtkSmartPointer<vtkMRMLScene>::New();
+  vtkSmartPointer<vtkSlicerDicomRtImportExportModuleLogic> dicomRtLogic = vtkSmartPointer<vtkSlicerDicomRtImportExportModuleLogic>::New();
+  dicomRtLogic->SetMRMLScene(mrmlScene);
+  vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(mrmlScene);
+  if (!shNode)
+  {
+    std::cerr << "ERROR: Failed to access subject hierarchy node" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Anatomical image
+  vtkSmartPointer<vtkImageData> imageData = vtkSmartPointer<vtkImageData>::New();
+  imageData->SetExtent(0, 63, 0, 63, 0, 23);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  memset(imageData->GetScalarPointer(), 0, imageData->GetNumberOfPoints() * sizeof(short));
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> imageVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+  imageVolumeNode->SetName("Image");
+  imageVolumeNode->SetSpacing(2.0, 2.0, 2.5);
+  imageVolumeNode->SetOrigin(-64.0, -64.0, -30.0);
+  imageVolumeNode->SetAndObserveImageData(imageData);
+  mrmlScene->AddNode(imageVolumeNode);
+
+  // Segmentation with closed surface segments
+  vtkSmartPointer<vtkMRMLSegmentationNode> segmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  segmentationNode->SetName("Structures");
+  mrmlScene->AddNode(segmentationNode);
+  segmentationNode->GetSegmentation()->SetMasterRepresentationName(
+    vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName() );
+  const double sphereCenters[3][3] = { {0.0, 0.0, 0.0}, {30.0, 20.0, 5.0}, {-25.0, 15.0, -10.0} };
+  const double sphereRadii[3] = { 20.0, 10.0, 7.5 };
+  std::vector<vtkSmartPointer<vtkPolyData> > closedSurfaces;
+  for (int segmentIndex=0; segmentIndex<3; ++segmentIndex)
+  {
+    vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
+    sphereSource->SetCenter(sphereCenters[segmentIndex][0], sphereCenters[segmentIndex][1], sphereCenters[segmentIndex][2]);
+    sphereSource->SetRadius(sphereRadii[segmentIndex]);
+    sphereSource->SetThetaResolution(36);
+    sphereSource->SetPhiResolution(36);
+    sphereSource->Update();
+    closedSurfaces.push_back(sphereSource->GetOutput());
+    vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
+    std::ostringstream segmentNameStream;
+    segmentNameStream << "Sphere" << segmentIndex+1;
+    segment->SetName(segmentNameStream.str().c_str());
+    segment->SetColor(segmentIndex == 0 ? 1.0 : 0.0, segmentIndex == 1 ? 1.0 : 0.0, segmentIndex == 2 ? 1.0 : 0.0);
+    segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName(), sphereSource->GetOutput());
+    segmentationNode->GetSegmentation()->AddSegment(segment);
+  }
+
+  // Put the image and the segmentation in the same study
+  const char* patientId = "SlicerRtTestPatient";
+  const char* studyInstanceUid = "1.2.826.0.1.3680043.8.498.1";
+  vtkMRMLNode* exportedNodes[2] = { imageVolumeNode, segmentationNode };
+  const char* seriesInstanceUids[2] = { "1.2.826.0.1.3680043.8.498.1.1", "1.2.826.0.1.3680043.8.498.1.2" };
+  const char* modalities[2] = { "CT", "RTSTRUCT" };
+  vtkSmartPointer<vtkCollection> exportables = vtkSmartPointer<vtkCollection>::New();
+  for (int nodeIndex=0; nodeIndex<2; ++nodeIndex)
+  {
+    vtkIdType seriesItemID = shNode->GetItemByDataNode(exportedNodes[nodeIndex]);
+    if (seriesItemID == vtkMRMLSubjectHierarchyNode::INVALID_ITEM_ID)
+    {
+      seriesItemID = shNode->CreateItem(shNode->GetSceneItemID(), exportedNodes[nodeIndex]);
+    }
+    shNode->SetItemUID(seriesItemID, vtkMRMLSubjectHierarchyConstants::GetDICOMUIDName(), seriesInstanceUids[nodeIndex]);
+    vtkSlicerSubjectHierarchyModuleLogic::InsertDicomSeriesInHierarchy(shNode, patientId, studyInstanceUid, seriesInstanceUids[nodeIndex]);
+
+    vtkSmartPointer<vtkSlicerDICOMExportable> exportable = vtkSmartPointer<vtkSlicerDICOMExportable>::New();
+    exportable->SetSubjectHierarchyItemID(seriesItemID);
+    exportable->SetTag(vtkMRMLSubjectHierarchyConstants::GetDICOMPatientNameTagName().c_str(), "SlicerRT^Test");
+    exportable->SetTag(vtkMRMLSubjectHierarchyConstants::GetDICOMPatientIDTagName().c_str(), patientId);
+    exportable->SetTag("Modality", modalities[nodeIndex]);
+    exportable->SetTag("SeriesDescription", exportedNodes[nodeIndex]->GetName());
+    exportable->SetTag("SeriesNumber", nodeIndex == 0 ? "1" : "2");
+    exportables->AddItem(exportable);
+  }
+
+  // Export with one thread and with multiple threads
+  std::string singleThreadDirectory = temporaryDirectory + "/DicomRtExportSingleThread";
+  std::string error = ExportStudy(dicomRtLogic, exportables, 1, singleThreadDirectory);
+  if (!error.empty())
+  {
+    std::cerr << "ERROR: Single-threaded export failed: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string multiThreadDirectory = temporaryDirectory + "/DicomRtExportMultiThread";
+  error = ExportStudy(dicomRtLogic, exportables, 4, multiThreadDirectory);
+  if (!error.empty())
+  {
+    std::cerr << "ERROR: Multi-threaded export failed: " << error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compare the exported contours
+  vtkSmartPointer<vtkSlicerDicomRtReader> singleThreadReader = ReadExportedStructureSet(singleThreadDirectory);
+  vtkSmartPointer<vtkSlicerDicomRtReader> multiThreadReader = ReadExportedStructureSet(multiThreadDirectory);
+  if (!singleThreadReader || !multiThreadReader)
+  {
+    std::cerr << "ERROR: Failed to read exported RT structure set" << std::endl;
+    return EXIT_FAILURE;
+  }
+  int numberOfRois = segmentationNode->GetSegmentation()->GetNumberOfSegments();
+  if (singleThreadReader->GetNumberOfRois() != numberOfRois || multiThreadReader->GetNumberOfRois() != numberOfRois)
+  {
+    std::cerr << "ERROR: Number of exported ROIs is " << singleThreadReader->GetNumberOfRois() << " with one thread and "
+      << multiThreadReader->GetNumberOfRois() << " with multiple threads instead of " << numberOfRois << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int roiIndex=0; roiIndex<numberOfRois; ++roiIndex)
+  {
+    vtkPolyData* singleThreadRoiPolyData = singleThreadReader->GetRoiPolyData(roiIndex);
+    vtkPolyData* multiThreadRoiPolyData = multiThreadReader->GetRoiPolyData(roiIndex);
+    if ( !singleThreadRoiPolyData || !multiThreadRoiPolyData || singleThreadRoiPolyData->GetNumberOfPoints() == 0
+      || STRCASECMP(singleThreadReader->GetRoiName(roiIndex), multiThreadReader->GetRoiName(roiIndex)) != 0 )
+    {
+      std::cerr << "ERROR: Exported ROI " << roiIndex << " is missing, empty, or is not in the same order" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( singleThreadRoiPolyData->GetNumberOfPoints() != multiThreadRoiPolyData->GetNumberOfPoints()
+      || singleThreadRoiPolyData->GetNumberOfCells() != multiThreadRoiPolyData->GetNumberOfCells() )
+    {
+      std::cerr << "ERROR: Exported ROI " << singleThreadReader->GetRoiName(roiIndex) << " has " << singleThreadRoiPolyData->GetNumberOfPoints()
+        << " points in " << singleThreadRoiPolyData->GetNumberOfCells() << " contours with one thread, and " << multiThreadRoiPolyData->GetNumberOfPoints()
+        << " points in " << multiThreadRoiPolyData->GetNumberOfCells() << " contours with multiple threads" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (vtkIdType pointId=0; pointId<singleThreadRoiPolyData->GetNumberOfPoints(); ++pointId)
+    {
+      double singleThreadPoint[3] = {0.0, 0.0, 0.0};
+      singleThreadRoiPolyData->GetPoint(pointId, singleThreadPoint);
+      double multiThreadPoint[3] = {0.0, 0.0, 0.0};
+      multiThreadRoiPolyData->GetPoint(pointId, multiThreadPoint);
+      if ( singleThreadPoint[0] != multiThreadPoint[0] || singleThreadPoint[1] != multiThreadPoint[1]
+        || singleThreadPoint[2] != multiThreadPoint[2] )
+      {
+        std::cerr << "ERROR: Contour point " << pointId << " of exported ROI " << singleThreadReader->GetRoiName(roiIndex) << " is ("
+          << singleThreadPoint[0] << ", " << singleThreadPoint[1] << ", " << singleThreadPoint[2] << ") with one thread and ("
+          << multiThreadPoint[0] << ", " << multiThreadPoint[1] << ", " << multiThreadPoint[2] << ") with multiple threads" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // Compare to cutting the whole closed surface at the image slices (all slices but the last one are cut).
+    // The exported points are stored as decimal strings and read as float, so they are compared with a tolerance.
+    const double contourTolerance = 0.01; // mm
+    double maximumDistance = GetMaximumDistanceFromCutterContours(closedSurfaces[roiIndex], singleThreadRoiPolyData,
+      imageVolumeNode->GetOrigin()[2], imageVolumeNode->GetSpacing()[2], imageData->GetExtent()[5] - imageData->GetExtent()[4]);
+    if (maximumDistance > contourTolerance)
+    {
+      std::cerr << "ERROR: Exported ROI " << singleThreadReader->GetRoiName(roiIndex) << " differs from the contours cut from the whole "
+        << "closed surface by vtkCutter by up to " << maximumDistance << " mm (tolerance: " << contourTolerance << " mm)" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Exported ROI " << singleThreadReader->GetRoiName(roiIndex) << ": " << singleThreadRoiPolyData->GetNumberOfPoints()
+      << " points in " << singleThreadRoiPolyData->GetNumberOfCells() << " contours, maximum distance from vtkCutter contours: "
+      << maximumDistance << " mm" << std::endl;
+  }
+
+  // Examine the exported files with full read in one thread (reference), with partial read, and with multiple threads
+  vtkSmartPointer<vtkCollection> fullReadLoadables = vtkSmartPointer<vtkCollection>::New();
+  ExamineDirectory(dicomRtLogic, singleThreadDirectory, false, 1, fullReadLoadables);
+  vtkSmartPointer<vtkCollection> partialReadLoadables = vtkSmartPointer<vtkCollection>::New();
+  ExamineDirectory(dicomRtLogic, singleThreadDirectory, true, 1, partialReadLoadables);
+  vtkSmartPointer<vtkCollection> multiThreadLoadables = vtkSmartPointer<vtkCollection>::New();
+  ExamineDirectory(dicomRtLogic, singleThreadDirectory, true, 4, multiThreadLoadables);
+
+  // The exported RT structure set is loadable, and references the exported image slices in its contour image sequence
+  vtkSlicerDICOMLoadable* structureSetLoadable = NULL;
+  for (int loadableIndex=0; loadableIndex<fullReadLoadables->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable = vtkSlicerDICOMLoadable::SafeDownCast(fullReadLoadables->GetItemAsObject(loadableIndex));
+    if (loadable && loadable->GetReferencedInstanceUIDs() && loadable->GetReferencedInstanceUIDs()->GetNumberOfValues() > 0)
+    {
+      structureSetLoadable = loadable;
+    }
+  }
+  if (!structureSetLoadable)
+  {
+    std::cerr << "ERROR: No loadable referencing the image slices found when examining the exported files" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Examined structure set loadable " << structureSetLoadable->GetName() << " references "
+    << structureSetLoadable->GetReferencedInstanceUIDs()->GetNumberOfValues() << " instances" << std::endl;
+
+  if (!AreLoadablesEqual(fullReadLoadables, partialReadLoadables))
+  {
+    std::cerr << "ERROR: Loadables differ between full and partial read of the exported files" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!AreLoadablesEqual(partialReadLoadables, multiThreadLoadables))
+  {
+    std::cerr << "ERROR: Loadables differ between examining the exported files with one and with multiple threads" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+std::string ExportStudy(vtkSlicerDicomRtImportExportModuleLogic* logic, vtkCollection* exportables, int numberOfThreads, const std::string& outputDirectory)
+{
+  vtksys::SystemTools::RemoveADirectory(outputDirectory.c_str());
+  vtksys::SystemTools::MakeDirectory(outputDirectory.c_str());
+  for (int index=0; index<exportables->GetNumberOfItems(); ++index)
+  {
+    vtkSlicerDICOMExportable::SafeDownCast(exportables->GetItemAsObject(index))->SetDirectory(outputDirectory.c_str());
+  }
+  logic->SetNumberOfThreadsForExport(numberOfThreads);
+  return logic->ExportDicomRTStudy(exportables);
+}
+
+//-----------------------------------------------------------------------------
+double GetMaximumDistanceFromCutterContours(vtkPolyData* closedSurface, vtkPolyData* exportedContours,
+  double firstSlicePosition, double sliceSpacing, int numberOfSlices)
+{
+  double bounds[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  closedSurface->GetBounds(bounds);
+
+  vtkSmartPointer<vtkPlane> slicePlane = vtkSmartPointer<vtkPlane>::New();
+  slicePlane->SetNormal(0.0, 0.0, 1.0);
+  vtkSmartPointer<vtkCutter> cutter = vtkSmartPointer<vtkCutter>::New();
+  cutter->SetInputData(closedSurface);
+  cutter->SetCutFunction(slicePlane);
+  cutter->SetGenerateCutScalars(0);
+  vtkSmartPointer<vtkStripper> stripper = vtkSmartPointer<vtkStripper>::New();
+  stripper->SetInputConnection(cutter->GetOutputPort());
+
+  double maximumDistance = 0.0;
+  for (int slice=0; slice<numberOfSlices; ++slice)
+  {
+    double slicePosition = firstSlicePosition + slice * sliceSpacing;
+    if (slicePosition < bounds[4] || slicePosition > bounds[5])
+    {
+      continue;
+    }
+
+    // Contour of the whole closed surface at the slice
+    slicePlane->SetOrigin(0.0, 0.0, slicePosition);
+    stripper->Update();
+    vtkPoints* cutterPoints = stripper->GetOutput()->GetPoints();
+    if (!cutterPoints || cutterPoints->GetNumberOfPoints() == 0)
+    {
+      continue;
+    }
+
+    // Exported contour points on the slice
+    vtkSmartPointer<vtkPoints> slicePoints = vtkSmartPointer<vtkPoints>::New();
+    for (vtkIdType pointId=0; pointId<exportedContours->GetNumberOfPoints(); ++pointId)
+    {
+      double* point = exportedContours->GetPoint(pointId);
+      if (fabs(point[2] - slicePosition) < 0.5 * sliceSpacing)
+      {
+        slicePoints->InsertNextPoint(point);
+      }
+    }
+
+    maximumDistance = std::max(maximumDistance, GetMaximumDistanceToClosestPoint(cutterPoints, slicePoints));
+    maximumDistance = std::max(maximumDistance, GetMaximumDistanceToClosestPoint(slicePoints, cutterPoints));
+  }
+  return maximumDistance;
+}
+
+//-----------------------------------------------------------------------------
+double GetMaximumDistanceToClosestPoint(vtkPoints* points, vtkPoints* targetPoints)
+{
+  double maximumDistance2 = 0.0;
+  for (vtkIdType pointId=0; pointId<points->GetNumberOfPoints(); ++pointId)
+  {
+    double point[3] = {0.0, 0.0, 0.0};
+    points->GetPoint(pointId, point);
+    double closestDistance2 = VTK_DOUBLE_MAX;
+    for (vtkIdType targetPointId=0; targetPointId<targetPoints->GetNumberOfPoints(); ++targetPointId)
+    {
+      double targetPoint[3] = {0.0, 0.0, 0.0};
+      targetPoints->GetPoint(targetPointId, targetPoint);
+      closestDistance2 = std::min(closestDistance2, vtkMath::Distance2BetweenPoints(point, targetPoint));
+    }
+    maximumDistance2 = std::max(maximumDistance2, closestDistance2);
+  }
+  return (maximumDistance2 == VTK_DOUBLE_MAX ? VTK_DOUBLE_MAX : sqrt(maximumDistance2));
+}
+
+//-----------------------------------------------------------------------------
+void ExamineDirectory(vtkSlicerDicomRtImportExportModuleLogic* logic, const std::string& directoryPath, bool partialRead, int numberOfThreads, vtkCollection* loadables)
+{
+  // Files are examined in alphabetical order, so that the order of the loadables is the same in all cases
+  std::vector<std::string> filePaths;
+  vtksys::Directory directory;
+  if (directory.Load(directoryPath.c_str()))
+  {
+    for (unsigned long fileIndex=0; fileIndex<directory.GetNumberOfFiles(); ++fileIndex)
+    {
+      std::string filePath = directoryPath + "/" + directory.GetFile(fileIndex);
+      if (!vtksys::SystemTools::FileIsDirectory(filePath))
+      {
+        filePaths.push_back(filePath);
+      }
+    }
+  }
+  std::sort(filePaths.begin(), filePaths.end());
+  vtkSmartPointer<vtkStringArray> fileList = vtkSmartPointer<vtkStringArray>::New();
+  for (std::vector<std::string>::iterator filePathIt = filePaths.begin(); filePathIt != filePaths.end(); ++filePathIt)
+  {
+    fileList->InsertNextValue(*filePathIt);
+  }
+
+  logic->SetExamineWithPartialRead(partialRead);
+  logic->SetNumberOfThreadsForExamine(numberOfThreads);
+  logic->ExamineForLoad(fileList, loadables);
+}
+
+//-----------------------------------------------------------------------------
+bool AreLoadablesEqual(vtkCollection* loadables1, vtkCollection* loadables2)
+{
+  if (loadables1->GetNumberOfItems() != loadables2->GetNumberOfItems())
+  {
+    std::cerr << "Number of loadables differ: " << loadables1->GetNumberOfItems() << " != " << loadables2->GetNumberOfItems() << std::endl;
+    return false;
+  }
+  for (int loadableIndex=0; loadableIndex<loadables1->GetNumberOfItems(); ++loadableIndex)
+  {
+    vtkSlicerDICOMLoadable* loadable1 = vtkSlicerDICOMLoadable::SafeDownCast(loadables1->GetItemAsObject(loadableIndex));
+    vtkSlicerDICOMLoadable* loadable2 = vtkSlicerDICOMLoadable::SafeDownCast(loadables2->GetItemAsObject(loadableIndex));
+    if (!loadable1 || !loadable2)
+    {
+      std::cerr << "Invalid loadable " << loadableIndex << std::endl;
+      return false;
+    }
+    if ( STRCASECMP(loadable1->GetName() ? loadable1->GetName() : "", loadable2->GetName() ? loadable2->GetName() : "") != 0
+      || loadable1->GetFiles()->GetNumberOfValues() != loadable2->GetFiles()->GetNumberOfValues()
+      || loadable1->GetFiles()->GetValue(0) != loadable2->GetFiles()->GetValue(0) )
+    {
+      std::cerr << "Name or files of loadable " << loadableIndex << " differ" << std::endl;
+      return false;
+    }
+    vtkStringArray* referencedUids1 = loadable1->GetReferencedInstanceUIDs();
+    vtkStringArray* referencedUids2 = loadable2->GetReferencedInstanceUIDs();
+    vtkIdType numberOfReferencedUids1 = (referencedUids1 ? referencedUids1->GetNumberOfValues() : 0);
+    vtkIdType numberOfReferencedUids2 = (referencedUids2 ? referencedUids2->GetNumberOfValues() : 0);
+    if (numberOfReferencedUids1 != numberOfReferencedUids2)
+    {
+      std::cerr << "Number of referenced instance UIDs of loadable " << loadable1->GetName() << " differ: "
+        << numberOfReferencedUids1 << " != " << numberOfReferencedUids2 << std::endl;
+      return false;
+    }
+    for (vtkIdType uidIndex=0; uidIndex<numberOfReferencedUids1; ++uidIndex)
+    {
+      if (referencedUids1->GetValue(uidIndex) != referencedUids2->GetValue(uidIndex))
+      {
+        std::cerr << "Referenced instance UID " << uidIndex << " of loadable " << loadable1->GetName() << " differs: "
+          << referencedUids1->GetValue(uidIndex) << " != " << referencedUids2->GetValue(uidIndex) << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerDicomRtReader> ReadExportedStructureSet(const std::string& outputDirectory)
+{
+  vtksys::Directory directory;
+  if (!directory.Load(outputDirectory.c_str()))
+  {
+    return NULL;
+  }
+  for (unsigned long fileIndex=0; fileIndex<directory.GetNumberOfFiles(); ++fileIndex)
+  {
+    std::string filePath = outputDirectory + "/" + directory.GetFile(fileIndex);
+    if (vtksys::SystemTools::FileIsDirectory(filePath))
+    {
+      continue;
+    }
+    vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
+    rtReader->SetFileName(filePath.c_str());
+    rtReader->Update();
+    if (rtReader->GetLoadRTStructureSetSuccessful())
+    {
+      return rtReader;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,504 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  This file was originally developed by Csaba Pinter, PerkLab, Queen's University
+  and was supported through the Applied Cancer Research Unit program of Cancer Care
+  Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
+
+==============================================================================*/
+
+// DicomRtImportExport includes
+#include "vtkSlicerDicomRtReader.h"
+
+// MRML includes
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// ITK includes
+#include "itkFactoryRegistration.h"
+
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+// DCMTK includes
+#include <dcmtk/config/osconfig.h>    /* make sure OS specific configuration is included first */
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcuid.h>
+
+int TestRtDosePixelData(const char* baselineDoseFileName, const std::string& temporaryDirectory);
+bool WriteRtDoseFile(vtkImageData* doseImageData, vtkMatrix4x4* ijkToRasMatrix, double doseGridScaling, const std::string& fileName);
+int TestRoiContoursOnDemand(const std::string& temporaryDirectory);
+bool WriteRtStructureSetFile(const std::string& fileName, std::vector<vtkIdType>& roiNumberOfPoints);
+
+//-----------------------------------------------------------------------------
+int vtkSlicerDicomRtReaderTest1( int argc, char * argv[] )
+{
+  int argIndex = 1;
+
+  // BaselineDoseFile
+  const char *baselineDoseFileName = NULL;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-BaselineDoseFile") == 0)
+    {
+      baselineDoseFileName = argv[argIndex+1];
+      std::cout << "Baseline dose file name: " << baselineDoseFileName << std::endl;
+      argIndex += 2;
+    }
+    else
+    {
+      baselineDoseFileName = "";
+    }
+  }
+  else
+  {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  // TemporaryDirectory
+  const char *temporaryDirectoryName = NULL;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-TemporaryDirectory") == 0)
+    {
+      temporaryDirectoryName = argv[argIndex+1];
+      std::cout << "Temporary directory: " << temporaryDirectoryName << std::endl;
+      argIndex += 2;
+    }
+    else
+    {
+      temporaryDirectoryName = "";
+    }
+  }
+  else
+  {
+    std::cerr << "Invalid arguments!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::string temporaryDirectory(temporaryDirectoryName);
+  vtksys::SystemTools::MakeDirectory(temporaryDirectory.c_str());
+
+  // Make sure NRRD reading works
+  itk::itkFactoryRegistration();
+
+  if (TestRtDosePixelData(baselineDoseFileName, temporaryDirectory) != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  if (TestRoiContoursOnDemand(temporaryDirectory) != EXIT_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+// Write the baseline dose into an RT Dose file as 32-bit stored values, read it with the RT reader,
+// and compare the decoded and scaled dose (\sa vtkSlicerDicomRtReader::GetDoseImageData) with the baseline
+int TestRtDosePixelData(const char* baselineDoseFileName, const std::string& temporaryDirectory)
+{
+  // Load baseline dose volume
+  vtkNew<vtkMRMLScene> mrmlScene;
+  vtkNew<vtkMRMLScalarVolumeNode> baselineDoseVolumeNode;
+  mrmlScene->AddNode(baselineDoseVolumeNode.GetPointer());
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> baselineDoseStorageNode;
+  baselineDoseStorageNode->SetFileName(baselineDoseFileName);
+  mrmlScene->AddNode(baselineDoseStorageNode.GetPointer());
+  baselineDoseVolumeNode->SetAndObserveStorageNodeID(baselineDoseStorageNode->GetID());
+  if (!baselineDoseStorageNode->ReadData(baselineDoseVolumeNode.GetPointer()) || !baselineDoseVolumeNode->GetImageData())
+  {
+    std::cerr << "ERROR: Failed to read baseline dose volume from file " << baselineDoseFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkImageData* baselineDoseImageData = baselineDoseVolumeNode->GetImageData();
+  vtkSmartPointer<vtkMatrix4x4> baselineIjkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  baselineDoseVolumeNode->GetIJKToRASMatrix(baselineIjkToRasMatrix);
+
+  // Write RT Dose file. The dose grid scaling is chosen so that the maximum dose is stored at about 1e9
+  double doseRange[2] = {0.0, 0.0};
+  baselineDoseImageData->GetScalarRange(doseRange);
+  double doseGridScaling = (doseRange[1] > 0.0 ? doseRange[1] / 1.0e9 : 1.0e-9);
+  std::string rtDoseFileName = temporaryDirectory + "/TestRtDose.dcm";
+  if (!WriteRtDoseFile(baselineDoseImageData, baselineIjkToRasMatrix, doseGridScaling, rtDoseFileName))
+  {
+    std::cerr << "ERROR: Failed to write RT Dose file " << rtDoseFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Read RT Dose file
+  vtkSmartPointer<vtkSlicerDicomRtReader> rtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
+  rtReader->SetFileName(rtDoseFileName.c_str());
+  rtReader->Update();
+  if (!rtReader->GetLoadRTDoseSuccessful())
+  {
+    std::cerr << "ERROR: Failed to load RT Dose file " << rtDoseFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkImageData* doseImageData = rtReader->GetDoseImageData();
+  vtkMatrix4x4* ijkToRasMatrix = rtReader->GetDoseIJKToRASMatrix();
+  if (!doseImageData || !ijkToRasMatrix)
+  {
+    std::cerr << "ERROR: Pixel data of RT Dose file " << rtDoseFileName << " has not been decoded" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Compare geometry
+  int baselineDimensions[3] = {0, 0, 0};
+  baselineDoseImageData->GetDimensions(baselineDimensions);
+  int dimensions[3] = {0, 0, 0};
+  doseImageData->GetDimensions(dimensions);
+  if ( dimensions[0] != baselineDimensions[0] || dimensions[1] != baselineDimensions[1]
+    || dimensions[2] != baselineDimensions[2] || doseImageData->GetScalarType() != VTK_FLOAT )
+  {
+    std::cerr << "ERROR: Decoded dose dimensions (" << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2]
+      << ") or scalar type do not match the baseline (" << baselineDimensions[0] << ", " << baselineDimensions[1] << ", " << baselineDimensions[2] << ")" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (int row=0; row<3; ++row)
+  {
+    for (int column=0; column<4; ++column)
+    {
+      if (fabs(ijkToRasMatrix->GetElement(row, column) - baselineIjkToRasMatrix->GetElement(row, column)) > 1.0e-4)
+      {
+        std::cerr << "ERROR: Decoded dose IJK to RAS matrix element (" << row << ", " << column << ") is "
+          << ijkToRasMatrix->GetElement(row, column) << " instead of " << baselineIjkToRasMatrix->GetElement(row, column) << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Compare dose values voxel by voxel. The difference is at most half of the dose grid scaling from
+  // storing the values as integers, plus the float precision of the values
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  const float* doseValues = static_cast<const float*>(doseImageData->GetScalarPointer());
+  for (vtkIdType voxelIndex=0; voxelIndex<numberOfVoxels; ++voxelIndex)
+  {
+    double baselineValue = baselineDoseImageData->GetPointData()->GetScalars()->GetComponent(voxelIndex, 0);
+    double tolerance = 0.5 * doseGridScaling + 1.0e-6 * fabs(baselineValue);
+    if (fabs(doseValues[voxelIndex] - std::max(baselineValue, 0.0)) > tolerance)
+    {
+      std::cerr << "ERROR: Decoded dose value at voxel " << voxelIndex << " is " << doseValues[voxelIndex]
+        << " instead of " << baselineValue << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << "Decoded RT Dose matches the baseline in " << numberOfVoxels << " voxels" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+bool WriteRtDoseFile(vtkImageData* doseImageData, vtkMatrix4x4* ijkToRasMatrix, double doseGridScaling, const std::string& fileName)
+{
+  int dimensions[3] = {0, 0, 0};
+  doseImageData->GetDimensions(dimensions);
+
+  // Geometry in LPS: the row, column and slice directions are the IJK axes
+  double spacing[3] = {0.0, 0.0, 0.0};
+  double directions[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+  double positionLps[3] = {0.0, 0.0, 0.0};
+  for (int axis=0; axis<3; ++axis)
+  {
+    spacing[axis] = sqrt( ijkToRasMatrix->GetElement(0,axis)*ijkToRasMatrix->GetElement(0,axis)
+      + ijkToRasMatrix->GetElement(1,axis)*ijkToRasMatrix->GetElement(1,axis)
+      + ijkToRasMatrix->GetElement(2,axis)*ijkToRasMatrix->GetElement(2,axis) );
+    for (int i=0; i<3; ++i)
+    {
+      double rasToLps = (i < 2 ? -1.0 : 1.0);
+      directions[axis][i] = rasToLps * ijkToRasMatrix->GetElement(i,axis) / spacing[axis];
+    }
+    positionLps[axis] = (axis < 2 ? -1.0 : 1.0) * ijkToRasMatrix->GetElement(axis,3);
+  }
+  // The grid frame offsets are along the normal of the image plane
+  double normal[3] = {
+    directions[0][1]*directions[1][2] - directions[0][2]*directions[1][1],
+    directions[0][2]*directions[1][0] - directions[0][0]*directions[1][2],
+    directions[0][0]*directions[1][1] - directions[0][1]*directions[1][0] };
+  double sliceSign = (normal[0]*directions[2][0] + normal[1]*directions[2][1] + normal[2]*directions[2][2] < 0.0 ? -1.0 : 1.0);
+
+  std::ostringstream pixelSpacingStream;
+  pixelSpacingStream.precision(10);
+  pixelSpacingStream << spacing[1] << "\\" << spacing[0];
+  std::ostringstream positionStream;
+  positionStream.precision(10);
+  positionStream << positionLps[0] << "\\" << positionLps[1] << "\\" << positionLps[2];
+  std::ostringstream orientationStream;
+  orientationStream.precision(10);
+  orientationStream << directions[0][0] << "\\" << directions[0][1] << "\\" << directions[0][2] << "\\"
+    << directions[1][0] << "\\" << directions[1][1] << "\\" << directions[1][2];
+  std::ostringstream gridFrameOffsetStream;
+  gridFrameOffsetStream.precision(10);
+  for (int slice=0; slice<dimensions[2]; ++slice)
+  {
+    gridFrameOffsetStream << (slice > 0 ? "\\" : "") << sliceSign * slice * spacing[2];
+  }
+  std::ostringstream doseGridScalingStream;
+  doseGridScalingStream.precision(10);
+  doseGridScalingStream << doseGridScaling;
+  std::ostringstream numberOfFramesStream;
+  numberOfFramesStream << dimensions[2];
+
+  // Stored values as 32-bit unsigned integers, written as 16-bit words with the low word first
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  std::vector<Uint16> pixelData(2*numberOfVoxels, 0);
+  for (vtkIdType voxelIndex=0; voxelIndex<numberOfVoxels; ++voxelIndex)
+  {
+    double dose = doseImageData->GetPointData()->GetScalars()->GetComponent(voxelIndex, 0);
+    Uint32 storedValue = static_cast<Uint32>(floor(std::max(dose, 0.0) / doseGridScaling + 0.5));
+    pixelData[2*voxelIndex] = static_cast<Uint16>(storedValue & 0xFFFF);
+    pixelData[2*voxelIndex+1] = static_cast<Uint16>(storedValue >> 16);
+  }
+
+  char sopInstanceUid[100];
+  dcmGenerateUniqueIdentifier(sopInstanceUid, SITE_INSTANCE_UID_ROOT);
+  DcmFileFormat fileFormat;
+  DcmDataset* dataset = fileFormat.getDataset();
+  dataset->putAndInsertString(DCM_SOPClassUID, UID_RTDoseStorage);
+  dataset->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUid);
+  dataset->putAndInsertString(DCM_Modality, "RTDOSE");
+  dataset->putAndInsertString(DCM_DoseUnits, "GY");
+  dataset->putAndInsertString(DCM_DoseType, "PHYSICAL");
+  dataset->putAndInsertString(DCM_DoseSummationType, "PLAN");
+  dataset->putAndInsertString(DCM_DoseGridScaling, doseGridScalingStream.str().c_str());
+  dataset->putAndInsertString(DCM_ImagePositionPatient, positionStream.str().c_str());
+  dataset->putAndInsertString(DCM_ImageOrientationPatient, orientationStream.str().c_str());
+  dataset->putAndInsertString(DCM_PixelSpacing, pixelSpacingStream.str().c_str());
+  dataset->putAndInsertString(DCM_GridFrameOffsetVector, gridFrameOffsetStream.str().c_str());
+  dataset->putAndInsertString(DCM_NumberOfFrames, numberOfFramesStream.str().c_str());
+  dataset->putAndInsertUint16(DCM_Rows, static_cast<Uint16>(dimensions[1]));
+  dataset->putAndInsertUint16(DCM_Columns, static_cast<Uint16>(dimensions[0]));
+  dataset->putAndInsertUint16(DCM_SamplesPerPixel, 1);
+  dataset->putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2");
+  dataset->putAndInsertUint16(DCM_BitsAllocated, 32);
+  dataset->putAndInsertUint16(DCM_BitsStored, 32);
+  dataset->putAndInsertUint16(DCM_HighBit, 31);
+  dataset->putAndInsertUint16(DCM_PixelRepresentation, 0);
+  dataset->putAndInsertUint16Array(DCM_PixelData, &pixelData[0], static_cast<unsigned long>(pixelData.size()));
+
+  return fileFormat.saveFile(fileName.c_str(), EXS_LittleEndianExplicit).good();
+}
+
+//-----------------------------------------------------------------------------
+// Read the same structure set with the ROI contour models created when reading and on demand
+// (\sa vtkSlicerDicomRtReader::LoadRoiContoursOnDemand), and compare the contours of the ROIs
+int TestRoiContoursOnDemand(const std::string& temporaryDirectory)
+{
+  std::string rtStructureSetFileName = temporaryDirectory + "/TestRtStructureSet.dcm";
+  std::vector<vtkIdType> expectedRoiNumberOfPoints;
+  if (!WriteRtStructureSetFile(rtStructureSetFileName, expectedRoiNumberOfPoints))
+  {
+    std::cerr << "ERROR: Failed to write RT Structure Set file " << rtStructureSetFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkSlicerDicomRtReader> eagerRtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
+  eagerRtReader->SetFileName(rtStructureSetFileName.c_str());
+  eagerRtReader->LoadRoiContoursOnDemandOff();
+  eagerRtReader->Update();
+  vtkSmartPointer<vtkSlicerDicomRtReader> onDemandRtReader = vtkSmartPointer<vtkSlicerDicomRtReader>::New();
+  onDemandRtReader->SetFileName(rtStructureSetFileName.c_str());
+  onDemandRtReader->LoadRoiContoursOnDemandOn();
+  onDemandRtReader->Update();
+  if (!eagerRtReader->GetLoadRTStructureSetSuccessful() || !onDemandRtReader->GetLoadRTStructureSetSuccessful())
+  {
+    std::cerr << "ERROR: Failed to load RT Structure Set file " << rtStructureSetFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+  int numberOfRois = static_cast<int>(expectedRoiNumberOfPoints.size());
+  if (eagerRtReader->GetNumberOfRois() != numberOfRois || onDemandRtReader->GetNumberOfRois() != numberOfRois)
+  {
+    std::cerr << "ERROR: Number of ROIs is " << eagerRtReader->GetNumberOfRois() << " when loaded at reading and "
+      << onDemandRtReader->GetNumberOfRois() << " when loaded on demand instead of " << numberOfRois << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The number of points is known before the contour models are created
+  for (int roiIndex=0; roiIndex<numberOfRois; ++roiIndex)
+  {
+    if ( eagerRtReader->GetRoiNumberOfPoints(roiIndex) != expectedRoiNumberOfPoints[roiIndex]
+      || onDemandRtReader->GetRoiNumberOfPoints(roiIndex) != expectedRoiNumberOfPoints[roiIndex] )
+    {
+      std::cerr << "ERROR: Number of points in ROI " << roiIndex << " is " << eagerRtReader->GetRoiNumberOfPoints(roiIndex)
+        << " when loaded at reading and " << onDemandRtReader->GetRoiNumberOfPoints(roiIndex)
+        << " when loaded on demand instead of " << expectedRoiNumberOfPoints[roiIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Request the contour models in reverse order, so that they are not created in the order of the file
+  for (int roiIndex=numberOfRois-1; roiIndex>=0; --roiIndex)
+  {
+    vtkPolyData* eagerRoiPolyData = eagerRtReader->GetRoiPolyData(roiIndex);
+    vtkPolyData* onDemandRoiPolyData = onDemandRtReader->GetRoiPolyData(roiIndex);
+    if (!eagerRoiPolyData || !onDemandRoiPolyData)
+    {
+      std::cerr << "ERROR: Failed to get contour model of ROI " << roiIndex << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( eagerRoiPolyData->GetNumberOfPoints() != expectedRoiNumberOfPoints[roiIndex]
+      || onDemandRoiPolyData->GetNumberOfPoints() != expectedRoiNumberOfPoints[roiIndex]
+      || eagerRoiPolyData->GetNumberOfCells() != onDemandRoiPolyData->GetNumberOfCells() )
+    {
+      std::cerr << "ERROR: Contour model of ROI " << roiIndex << " has " << eagerRoiPolyData->GetNumberOfPoints() << " points and "
+        << eagerRoiPolyData->GetNumberOfCells() << " cells when loaded at reading, and " << onDemandRoiPolyData->GetNumberOfPoints()
+        << " points and " << onDemandRoiPolyData->GetNumberOfCells() << " cells when loaded on demand. Expected number of points: "
+        << expectedRoiNumberOfPoints[roiIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (vtkIdType pointId=0; pointId<eagerRoiPolyData->GetNumberOfPoints(); ++pointId)
+    {
+      double eagerPoint[3] = {0.0, 0.0, 0.0};
+      eagerRoiPolyData->GetPoint(pointId, eagerPoint);
+      double onDemandPoint[3] = {0.0, 0.0, 0.0};
+      onDemandRoiPolyData->GetPoint(pointId, onDemandPoint);
+      if (eagerPoint[0] != onDemandPoint[0] || eagerPoint[1] != onDemandPoint[1] || eagerPoint[2] != onDemandPoint[2])
+      {
+        std::cerr << "ERROR: Point " << pointId << " of ROI " << roiIndex << " is (" << eagerPoint[0] << ", " << eagerPoint[1] << ", " << eagerPoint[2]
+          << ") when loaded at reading and (" << onDemandPoint[0] << ", " << onDemandPoint[1] << ", " << onDemandPoint[2] << ") when loaded on demand" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  std::cout << "ROI contours loaded on demand match the contours loaded at reading in " << numberOfRois << " ROIs" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+bool WriteRtStructureSetFile(const std::string& fileName, std::vector<vtkIdType>& roiNumberOfPoints)
+{
+  // Slices of the referenced image series, 5mm apart
+  const int numberOfSlices = 9;
+  const double firstSliceZ = -20.0;
+  const double sliceSpacing = 5.0;
+  char studyInstanceUid[100];
+  dcmGenerateUniqueIdentifier(studyInstanceUid, SITE_STUDY_UID_ROOT);
+  char seriesInstanceUid[100];
+  dcmGenerateUniqueIdentifier(seriesInstanceUid, SITE_SERIES_UID_ROOT);
+  char frameOfReferenceUid[100];
+  dcmGenerateUniqueIdentifier(frameOfReferenceUid, SITE_INSTANCE_UID_ROOT);
+  char sopInstanceUid[100];
+  dcmGenerateUniqueIdentifier(sopInstanceUid, SITE_INSTANCE_UID_ROOT);
+  std::vector<std::string> sliceInstanceUids;
+  for (int slice=0; slice<numberOfSlices; ++slice)
+  {
+    char sliceInstanceUid[100];
+    dcmGenerateUniqueIdentifier(sliceInstanceUid, SITE_INSTANCE_UID_ROOT);
+    sliceInstanceUids.push_back(sliceInstanceUid);
+  }
+
+  DcmFileFormat fileFormat;
+  DcmDataset* dataset = fileFormat.getDataset();
+  dataset->putAndInsertString(DCM_SOPClassUID, UID_RTStructureSetStorage);
+  dataset->putAndInsertString(DCM_SOPInstanceUID, sopInstanceUid);
+  dataset->putAndInsertString(DCM_Modality, "RTSTRUCT");
+  dataset->putAndInsertString(DCM_StudyInstanceUID, studyInstanceUid);
+  dataset->putAndInsertString(DCM_StructureSetLabel, "Test");
+
+  // Referenced image series
+  DcmItem* referencedFrameOfReferenceItem = NULL;
+  DcmItem* referencedStudyItem = NULL;
+  DcmItem* referencedSeriesItem = NULL;
+  dataset->findOrCreateSequenceItem(DCM_ReferencedFrameOfReferenceSequence, referencedFrameOfReferenceItem, -2);
+  referencedFrameOfReferenceItem->putAndInsertString(DCM_FrameOfReferenceUID, frameOfReferenceUid);
+  referencedFrameOfReferenceItem->findOrCreateSequenceItem(DCM_RTReferencedStudySequence, referencedStudyItem, -2);
+  referencedStudyItem->putAndInsertString(DCM_ReferencedSOPClassUID, "1.2.840.10008.3.1.2.3.2"); // Study Component Management SOP class
+  referencedStudyItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, studyInstanceUid);
+  referencedStudyItem->findOrCreateSequenceItem(DCM_RTReferencedSeriesSequence, referencedSeriesItem, -2);
+  referencedSeriesItem->putAndInsertString(DCM_SeriesInstanceUID, seriesInstanceUid);
+  for (int slice=0; slice<numberOfSlices; ++slice)
+  {
+    DcmItem* contourImageItem = NULL;
+    referencedSeriesItem->findOrCreateSequenceItem(DCM_ContourImageSequence, contourImageItem, -2);
+    contourImageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+    contourImageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, sliceInstanceUids[slice].c_str());
+  }
+
+  // ROIs: a sphere contoured on all slices, a cylinder on the middle five slices, and a point
+  const char* roiNames[3] = { "Sphere", "Cylinder", "Point" };
+  const char* roiColors[3] = { "255\\0\\0", "0\\255\\0", "0\\0\\255" };
+  const int roiFirstSlice[3] = { 0, 2, 4 };
+  const int roiNumberOfContours[3] = { numberOfSlices, 5, 1 };
+  const int roiNumberOfContourPoints[3] = { 36, 24, 1 };
+  roiNumberOfPoints.clear();
+  for (int roiIndex=0; roiIndex<3; ++roiIndex)
+  {
+    std::ostringstream roiNumberStream;
+    roiNumberStream << roiIndex+1;
+
+    DcmItem* structureSetRoiItem = NULL;
+    dataset->findOrCreateSequenceItem(DCM_StructureSetROISequence, structureSetRoiItem, -2);
+    structureSetRoiItem->putAndInsertString(DCM_ROINumber, roiNumberStream.str().c_str());
+    structureSetRoiItem->putAndInsertString(DCM_ReferencedFrameOfReferenceUID, frameOfReferenceUid);
+    structureSetRoiItem->putAndInsertString(DCM_ROIName, roiNames[roiIndex]);
+    structureSetRoiItem->putAndInsertString(DCM_ROIGenerationAlgorithm, "MANUAL");
+
+    DcmItem* roiContourItem = NULL;
+    dataset->findOrCreateSequenceItem(DCM_ROIContourSequence, roiContourItem, -2);
+    roiContourItem->putAndInsertString(DCM_ROIDisplayColor, roiColors[roiIndex]);
+    roiContourItem->putAndInsertString(DCM_ReferencedROINumber, roiNumberStream.str().c_str());
+    for (int contourIndex=0; contourIndex<roiNumberOfContours[roiIndex]; ++contourIndex)
+    {
+      int slice = roiFirstSlice[roiIndex] + contourIndex;
+      double z = firstSliceZ + slice * sliceSpacing;
+      int numberOfPoints = roiNumberOfContourPoints[roiIndex];
+      double radius = (roiIndex == 0 ? sqrt(25.0*25.0 - z*z) : 10.0);
+      double centerX = (roiIndex == 1 ? 40.0 : 0.0);
+
+      std::ostringstream contourDataStream;
+      contourDataStream.precision(10);
+      for (int pointIndex=0; pointIndex<numberOfPoints; ++pointIndex)
+      {
+        double angle = 2.0 * vtkMath::Pi() * pointIndex / numberOfPoints;
+        double x = (numberOfPoints > 1 ? centerX + radius * cos(angle) : centerX);
+        double y = (numberOfPoints > 1 ? radius * sin(angle) : 0.0);
+        contourDataStream << (pointIndex > 0 ? "\\" : "") << x << "\\" << y << "\\" << z;
+      }
+      std::ostringstream numberOfPointsStream;
+      numberOfPointsStream << numberOfPoints;
+
+      DcmItem* contourItem = NULL;
+      roiContourItem->findOrCreateSequenceItem(DCM_ContourSequence, contourItem, -2);
+      DcmItem* contourImageItem = NULL;
+      contourItem->findOrCreateSequenceItem(DCM_ContourImageSequence, contourImageItem, -2);
+      contourImageItem->putAndInsertString(DCM_ReferencedSOPClassUID, UID_CTImageStorage);
+      contourImageItem->putAndInsertString(DCM_ReferencedSOPInstanceUID, sliceInstanceUids[slice].c_str());
+      contourItem->putAndInsertString(DCM_ContourGeometricType, (numberOfPoints > 1 ? "CLOSED_PLANAR" : "POINT"));
+      contourItem->putAndInsertString(DCM_NumberOfContourPoints, numberOfPointsStream.str().c_str());
+      contourItem->putAndInsertString(DCM_ContourData, contourDataStream.str().c_str());
+    }
+    roiNumberOfPoints.push_back(roiNumberOfContours[roiIndex] * roiNumberOfContourPoints[roiIndex]);
+  }
+
+  return fileFormat.saveFile(fileName.c_str(), EXS_LittleEndianExplicit).good();
+}
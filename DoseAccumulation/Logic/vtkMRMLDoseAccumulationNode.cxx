@@ -44,6 +44,8 @@ vtkMRMLNodeNewMacro(vtkMRMLDoseAccumulationNode);
 vtkMRMLDoseAccumulationNode::vtkMRMLDoseAccumulationNode()
 {
   this->ShowDoseVolumesOnly = true;
+  this->NumberOfThreads = 0;
+  this->UseDoublePrecision = false;
   this->VolumeNodeIdsToWeightsMap.clear();
 
   this->HideFromEditors = false;
@@ -62,6 +64,8 @@ void vtkMRMLDoseAccumulationNode::WriteXML(ostream& of, int nIndent)
 
   // Write all MRML node attributes into output stream
   of << " ShowDoseVolumesOnly=\"" << (this->ShowDoseVolumesOnly ? "true" : "false") << "\"";
+  of << " NumberOfThreads=\"" << this->NumberOfThreads << "\"";
+  of << " UseDoublePrecision=\"" << (this->UseDoublePrecision ? "true" : "false") << "\"";
 
   {
     of << " VolumeNodeIdsToWeightsMap=\"";
@@ -90,6 +94,15 @@ void vtkMRMLDoseAccumulationNode::ReadXMLAttributes(const char** atts)
       this->ShowDoseVolumesOnly = 
         (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "NumberOfThreads")) 
+      {
+      this->NumberOfThreads = vtkVariant(attValue).ToInt();
+      }
+    else if (!strcmp(attName, "UseDoublePrecision")) 
+      {
+      this->UseDoublePrecision = 
+        (strcmp(attValue,"true") ? false : true);
+      }
     else if (!strcmp(attName, "VolumeNodeIdsToWeightsMap")) 
       {
       std::string valueStr(attValue);
@@ -135,6 +148,8 @@ void vtkMRMLDoseAccumulationNode::Copy(vtkMRMLNode *anode)
   vtkMRMLDoseAccumulationNode *node = (vtkMRMLDoseAccumulationNode *) anode;
 
   this->SetShowDoseVolumesOnly(node->ShowDoseVolumesOnly);
+  this->SetNumberOfThreads(node->NumberOfThreads);
+  this->SetUseDoublePrecision(node->UseDoublePrecision);
 
   this->VolumeNodeIdsToWeightsMap = node->VolumeNodeIdsToWeightsMap;
 
@@ -148,6 +163,8 @@ void vtkMRMLDoseAccumulationNode::PrintSelf(ostream& os, vtkIndent indent)
   Superclass::PrintSelf(os,indent);
 
   os << indent << "ShowDoseVolumesOnly:   " << (this->ShowDoseVolumesOnly ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads:   " << this->NumberOfThreads << "\n";
+  os << indent << "UseDoublePrecision:   " << (this->UseDoublePrecision ? "true" : "false") << "\n";
 
   {
     os << indent << "VolumeNodeIdsToWeightsMap:   ";
@@ -61,6 +61,18 @@ public:
   vtkGetMacro(ShowDoseVolumesOnly, bool);
   vtkSetMacro(ShowDoseVolumesOnly, bool);
 
+  /// Get number of threads used for adding the weighted input doses
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used for adding the weighted input doses. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+
+  /// Get double precision accumulation flag. If off, then the accumulated dose is stored as float
+  vtkGetMacro(UseDoublePrecision, bool);
+  /// Set double precision accumulation flag. If off, then the accumulated dose is stored as float
+  vtkSetMacro(UseDoublePrecision, bool);
+  /// Set double precision accumulation flag. If off, then the accumulated dose is stored as float
+  vtkBooleanMacro(UseDoublePrecision, bool);
+
   /// Get input reference dose volume node
   vtkMRMLScalarVolumeNode* GetReferenceDoseVolumeNode();
   /// Set and observe input reference dose volume node
@@ -101,6 +113,12 @@ protected:
   /// State of Show dose volumes only checkbox
   bool ShowDoseVolumesOnly;
 
+  /// Number of threads used for adding the weighted input doses
+  int NumberOfThreads;
+
+  /// Flag indicating whether the accumulated dose is computed and stored in double precision
+  bool UseDoublePrecision;
+
   /// Map assigning a weight to the available input volume nodes
   /// (as the user set it on the module GUI)
   std::map<std::string, double> VolumeNodeIdsToWeightsMap;
@@ -46,18 +46,200 @@
 
 // VTK includes
 #include <vtkNew.h>
-#include <vtkImageMathematics.h>
 #include <vtkImageData.h>
 #include <vtkSmartPointer.h>
-#include <vtkImageReslice.h>
-#include <vtkGeneralTransform.h>
+#include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 //----------------------------------------------------------------------------
 const std::string vtkSlicerDoseAccumulationModuleLogic::DOSEACCUMULATION_ATTRIBUTE_PREFIX = "DoseAccumulation.";
 const std::string vtkSlicerDoseAccumulationModuleLogic::DOSEACCUMULATION_DOSE_VOLUME_NODE_NAME_ATTRIBUTE_NAME = vtkSlicerDoseAccumulationModuleLogic::DOSEACCUMULATION_ATTRIBUTE_PREFIX + "DoseVolumeNodeName";
 const std::string vtkSlicerDoseAccumulationModuleLogic::DOSEACCUMULATION_OUTPUT_BASE_NAME_PREFIX = "Accumulated_";
 
+//----------------------------------------------------------------------------
+namespace
+{
+  //---------------------------------------------------------------------------
+  /// Add an input dose volume multiplied by its weight to the accumulated dose, in place.
+  /// The input is resampled on the fly with trilinear interpolation at the voxel positions of the
+  /// accumulator, the accumulated dose of voxels falling outside the input is not changed.
+  /// The accumulator is processed in slabs of slices so that the slabs can be computed concurrently.
+  template<typename AccumulatorType, typename InputType> class AccumulateWeightedDoseFunctor
+  {
+  public:
+    AccumulateWeightedDoseFunctor(vtkImageData* accumulatorImage, vtkImageData* inputImage, vtkMatrix4x4* accumulatorIjkToInputIjk, double weight)
+      : AccumulatorImage(accumulatorImage)
+      , InputImage(inputImage)
+      , Weight(weight)
+    {
+      for (int row=0; row<3; ++row)
+      {
+        for (int col=0; col<4; ++col)
+        {
+          this->AccumulatorIjkToInputIjk[row][col] = accumulatorIjkToInputIjk->GetElement(row, col);
+        }
+      }
+      accumulatorImage->GetExtent(this->AccumulatorExtent);
+      inputImage->GetExtent(this->InputExtent);
+
+      // The input can be read directly if it has the same voxel grid as the accumulator
+      this->SameGrid = true;
+      for (int row=0; row<3; ++row)
+      {
+        for (int col=0; col<4; ++col)
+        {
+          double identityElement = (row == col ? 1.0 : 0.0);
+          if (fabs(this->AccumulatorIjkToInputIjk[row][col] - identityElement) > 1e-6)
+          {
+            this->SameGrid = false;
+          }
+        }
+      }
+      for (int i=0; i<6; ++i)
+      {
+        if (this->AccumulatorExtent[i] != this->InputExtent[i])
+        {
+          this->SameGrid = false;
+        }
+      }
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      int accumulatorDimensions[3] = { this->AccumulatorExtent[1] - this->AccumulatorExtent[0] + 1,
+        this->AccumulatorExtent[3] - this->AccumulatorExtent[2] + 1, this->AccumulatorExtent[5] - this->AccumulatorExtent[4] + 1 };
+      vtkIdType sliceSize = (vtkIdType)accumulatorDimensions[0] * accumulatorDimensions[1];
+      AccumulatorType* accumulatorPtr = static_cast<AccumulatorType*>(this->AccumulatorImage->GetScalarPointer()) + beginSlice * sliceSize;
+      const InputType* inputPtr = static_cast<const InputType*>(this->InputImage->GetScalarPointer());
+      const AccumulatorType weight = static_cast<AccumulatorType>(this->Weight);
+
+      if (this->SameGrid)
+      {
+        inputPtr += beginSlice * sliceSize;
+        for (vtkIdType voxelIndex = 0; voxelIndex < (endSlice - beginSlice) * sliceSize; ++voxelIndex)
+        {
+          accumulatorPtr[voxelIndex] += weight * static_cast<AccumulatorType>(inputPtr[voxelIndex]);
+        }
+        return;
+      }
+
+      // Position of the input voxel changes by the first column of the matrix along a row of the accumulator
+      const double (&m)[3][4] = this->AccumulatorIjkToInputIjk;
+      for (vtkIdType slice = beginSlice; slice < endSlice; ++slice)
+      {
+        double k = this->AccumulatorExtent[4] + slice;
+        for (int j = this->AccumulatorExtent[2]; j <= this->AccumulatorExtent[3]; ++j)
+        {
+          double i = this->AccumulatorExtent[0];
+          double inputPosition[3] = {
+            m[0][0]*i + m[0][1]*j + m[0][2]*k + m[0][3],
+            m[1][0]*i + m[1][1]*j + m[1][2]*k + m[1][3],
+            m[2][0]*i + m[2][1]*j + m[2][2]*k + m[2][3] };
+          for (int column = 0; column < accumulatorDimensions[0]; ++column)
+          {
+            double inputValue = 0.0;
+            if (this->InterpolateInput(inputPtr, inputPosition, inputValue))
+            {
+              *accumulatorPtr += weight * static_cast<AccumulatorType>(inputValue);
+            }
+            ++accumulatorPtr;
+            inputPosition[0] += m[0][0];
+            inputPosition[1] += m[1][0];
+            inputPosition[2] += m[2][0];
+          }
+        }
+      }
+    }
+
+  private:
+    /// Trilinear interpolation of the input at the given IJK position
+    /// \return False if the position is outside the input image
+    bool InterpolateInput(const InputType* inputPtr, const double inputPosition[3], double& value)
+    {
+      const double tolerance = 1e-3;
+      int baseIndex[3] = { 0, 0, 0 };
+      int increment[3] = { 0, 0, 0 };
+      double fraction[3] = { 0.0, 0.0, 0.0 };
+      vtkIdType stride = 1;
+      vtkIdType offset = 0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        int dimension = this->InputExtent[2*axis+1] - this->InputExtent[2*axis] + 1;
+        double position = inputPosition[axis] - this->InputExtent[2*axis];
+        if (position < -tolerance || position > dimension - 1 + tolerance)
+        {
+          return false;
+        }
+        baseIndex[axis] = (int)floor(position);
+        if (baseIndex[axis] < 0)
+        {
+          baseIndex[axis] = 0;
+        }
+        else if (baseIndex[axis] > dimension - 2)
+        {
+          baseIndex[axis] = (dimension > 1 ? dimension - 2 : 0);
+        }
+        fraction[axis] = std::min(1.0, std::max(0.0, position - baseIndex[axis]));
+        increment[axis] = (baseIndex[axis] + 1 < dimension ? (int)stride : 0);
+        offset += baseIndex[axis] * stride;
+        stride *= dimension;
+      }
+
+      const InputType* p = inputPtr + offset;
+      double c00 = p[0] + fraction[0] * (p[increment[0]] - (double)p[0]);
+      double c10 = p[increment[1]] + fraction[0] * (p[increment[1] + increment[0]] - (double)p[increment[1]]);
+      double c01 = p[increment[2]] + fraction[0] * (p[increment[2] + increment[0]] - (double)p[increment[2]]);
+      double c11 = p[increment[2] + increment[1]]
+        + fraction[0] * (p[increment[2] + increment[1] + increment[0]] - (double)p[increment[2] + increment[1]]);
+      double c0 = c00 + fraction[1] * (c10 - c00);
+      double c1 = c01 + fraction[1] * (c11 - c01);
+      value = c0 + fraction[2] * (c1 - c0);
+      return true;
+    }
+
+    vtkImageData* AccumulatorImage;
+    vtkImageData* InputImage;
+    double AccumulatorIjkToInputIjk[3][4];
+    double Weight;
+    int AccumulatorExtent[6];
+    int InputExtent[6];
+    bool SameGrid;
+  };
+
+  //---------------------------------------------------------------------------
+  template<typename AccumulatorType, typename InputType> void AccumulateWeightedDoseOfInputType(
+    vtkImageData* accumulatorImage, vtkImageData* inputImage, vtkMatrix4x4* accumulatorIjkToInputIjk, double weight,
+    int numberOfThreads, InputType* vtkNotUsed(inputTypePtr))
+  {
+    AccumulateWeightedDoseFunctor<AccumulatorType, InputType> functor(accumulatorImage, inputImage, accumulatorIjkToInputIjk, weight);
+    int* extent = accumulatorImage->GetExtent();
+    vtkIdType numberOfSlices = extent[5] - extent[4] + 1;
+    SlicerRtCommon::SmpFor(0, numberOfSlices, 0, functor, numberOfThreads);
+  }
+
+  //---------------------------------------------------------------------------
+  /// Add weighted input dose to the accumulator image of type AccumulatorType
+  /// \return False if the input has an unsupported scalar type
+  template<typename AccumulatorType> bool AccumulateWeightedDose(
+    vtkImageData* accumulatorImage, vtkImageData* inputImage, vtkMatrix4x4* accumulatorIjkToInputIjk, double weight,
+    int numberOfThreads)
+  {
+    switch (inputImage->GetScalarType())
+    {
+      vtkTemplateMacro(AccumulateWeightedDoseOfInputType<AccumulatorType>(accumulatorImage, inputImage, accumulatorIjkToInputIjk,
+        weight, numberOfThreads, static_cast<VTK_TT*>(NULL)));
+      default:
+        return false;
+    }
+    return true;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDoseAccumulationModuleLogic);
 
@@ -203,12 +385,24 @@ std::string vtkSlicerDoseAccumulationModuleLogic::AccumulateDoseVolumes(vtkMRMLD
     return errorMessage;
   }
 
-  // Get reference image info
-  int referenceDimensions[3] = {0, 0, 0};
-  referenceDoseVolumeNode->GetImageData()->GetDimensions(referenceDimensions);
+  if (referenceDoseVolumeNode->GetImageData() == NULL)
+  {
+    std::string errorMessage("No image data in reference volume");
+    vtkErrorMacro("AccumulateDoseVolumes: " << errorMessage);
+    return errorMessage;
+  }
 
-  // Apply weight and accumulate input dose volumes
+  // Allocate accumulated dose on the reference grid. Weighted input doses are added to it in place.
   vtkSmartPointer<vtkImageData> accumulatedImageData = vtkSmartPointer<vtkImageData>::New();
+  accumulatedImageData->SetExtent(referenceDoseVolumeNode->GetImageData()->GetExtent());
+  accumulatedImageData->AllocateScalars(parameterNode->GetUseDoublePrecision() ? VTK_DOUBLE : VTK_FLOAT, 1);
+  memset(accumulatedImageData->GetScalarPointer(), 0,
+    accumulatedImageData->GetNumberOfPoints() * accumulatedImageData->GetScalarSize());
+
+  vtkSmartPointer<vtkMatrix4x4> referenceIjkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  referenceDoseVolumeNode->GetIJKToRASMatrix(referenceIjkToRasMatrix);
+
+  // Apply weight and accumulate input dose volumes
   for (int inputVolumeIndex = 0; inputVolumeIndex<numberOfInputDoseVolumes; inputVolumeIndex++)
   {
     vtkMRMLScalarVolumeNode* currentInputDoseVolumeNode = parameterNode->GetNthSelectedInputVolumeNode(inputVolumeIndex);
@@ -222,36 +416,54 @@ std::string vtkSlicerDoseAccumulationModuleLogic::AccumulateDoseVolumes(vtkMRMLD
     std::map<std::string,double>* volumeNodeIdsToWeightsMap = parameterNode->GetVolumeNodeIdsToWeightsMap();
     double currentWeight = (*volumeNodeIdsToWeightsMap)[currentInputDoseVolumeNode->GetID()];
 
-    vtkMRMLScalarVolumeNode* resampledInputDoseVolumeNode = 
-      vtkSlicerVolumesLogic::ResampleVolumeToReferenceVolume(currentInputDoseVolumeNode, referenceDoseVolumeNode);
-
-    // Apply weight
-    vtkSmartPointer<vtkImageMathematics> multiplyFilter = vtkSmartPointer<vtkImageMathematics>::New();
-    multiplyFilter->SetInputConnection(resampledInputDoseVolumeNode->GetImageDataConnection());
-    multiplyFilter->SetConstantK(currentWeight);
-    multiplyFilter->SetOperationToMultiplyByK();
-    multiplyFilter->Update();
-
-    // Add (accumulate) current input volume to the intermediate accumulated volume
-    if (inputVolumeIndex > 0)
+    // Get mapping from the reference voxels to the input voxels. If the transform between the two volumes
+    // is linear then the input is resampled while accumulating, otherwise it is resampled beforehand.
+    vtkMRMLScalarVolumeNode* resampledInputDoseVolumeNode = NULL;
+    vtkMRMLScalarVolumeNode* accumulatedInputDoseVolumeNode = currentInputDoseVolumeNode;
+    vtkSmartPointer<vtkMatrix4x4> referenceIjkToInputIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> referenceToInputTransformMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (vtkMRMLTransformNode::GetMatrixTransformBetweenNodes(referenceDoseVolumeNode->GetParentTransformNode(),
+      currentInputDoseVolumeNode->GetParentTransformNode(), referenceToInputTransformMatrix))
+    {
+      vtkSmartPointer<vtkMatrix4x4> inputRasToIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      currentInputDoseVolumeNode->GetRASToIJKMatrix(inputRasToIjkMatrix);
+      vtkSmartPointer<vtkMatrix4x4> referenceIjkToInputRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      vtkMatrix4x4::Multiply4x4(referenceToInputTransformMatrix, referenceIjkToRasMatrix, referenceIjkToInputRasMatrix);
+      vtkMatrix4x4::Multiply4x4(inputRasToIjkMatrix, referenceIjkToInputRasMatrix, referenceIjkToInputIjkMatrix);
+    }
+    else
     {
-      vtkSmartPointer<vtkImageMathematics> addFilter = vtkSmartPointer<vtkImageMathematics>::New(); 
-      addFilter->SetInput1Data(accumulatedImageData);
-      addFilter->SetInput2Data(multiplyFilter->GetOutput());
-      addFilter->SetOperationToAdd();
-      addFilter->Update();
+      resampledInputDoseVolumeNode = vtkSlicerVolumesLogic::ResampleVolumeToReferenceVolume(currentInputDoseVolumeNode, referenceDoseVolumeNode);
+      accumulatedInputDoseVolumeNode = resampledInputDoseVolumeNode;
+      referenceIjkToInputIjkMatrix->Identity();
+    }
 
-      accumulatedImageData->DeepCopy(addFilter->GetOutput());
+    // Add weighted input dose to the accumulated dose
+    bool success = false;
+    if (accumulatedImageData->GetScalarType() == VTK_DOUBLE)
+    {
+      success = AccumulateWeightedDose<double>(accumulatedImageData, accumulatedInputDoseVolumeNode->GetImageData(),
+        referenceIjkToInputIjkMatrix, currentWeight, parameterNode->GetNumberOfThreads());
     }
-    // If intermediate accumulated volume is empty (first iteration)
-    // then just copy the weighted input dose volume in it
     else
     {
-      accumulatedImageData->DeepCopy(multiplyFilter->GetOutput());
+      success = AccumulateWeightedDose<float>(accumulatedImageData, accumulatedInputDoseVolumeNode->GetImageData(),
+        referenceIjkToInputIjkMatrix, currentWeight, parameterNode->GetNumberOfThreads());
     }
 
     // Remove the resample dose currentNode from scene and release the memory
-    this->GetMRMLScene()->RemoveNode(resampledInputDoseVolumeNode);
+    if (resampledInputDoseVolumeNode)
+    {
+      this->GetMRMLScene()->RemoveNode(resampledInputDoseVolumeNode);
+    }
+
+    if (!success)
+    {
+      std::stringstream errorMessage;
+      errorMessage << "Unsupported scalar type in input volume #" << inputVolumeIndex;
+      vtkErrorMacro("AccumulateDoseVolumes: " << errorMessage.str());
+      return errorMessage.str();
+    }
   }
 
   // Create display currentNode for the accumulated volume
@@ -50,7 +50,9 @@ public:
   vtkTypeMacro(vtkSlicerDoseAccumulationModuleLogic,vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
 
-  /// Accumulates dose volumes with the given IDs and corresponding weights
+  /// Accumulates dose volumes with the given IDs and corresponding weights.
+  /// The inputs are resampled to the reference dose volume geometry while adding them to a single
+  /// float (or double, \sa vtkMRMLDoseAccumulationNode::UseDoublePrecision) accumulator volume.
   /// \return Error message on failure, NULL otherwise
   std::string AccumulateDoseVolumes(vtkMRMLDoseAccumulationNode* parameterNode);
 
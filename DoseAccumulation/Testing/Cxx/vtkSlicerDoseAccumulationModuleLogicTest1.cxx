@@ -43,6 +43,8 @@
 #include <vtkImageAccumulate.h>
 #include <vtkMatrix4x4.h>
 #include <vtkImageMathematics.h>
+#include <vtkImageCast.h>
+#include <vtkVariant.h>
 
 // ITK includes
 #if ITK_VERSION_MAJOR > 3
@@ -118,6 +120,29 @@ int vtkSlicerDoseAccumulationModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  // NumberOfThreads (optional)
+  int numberOfThreads = 0;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-NumberOfThreads") == 0)
+    {
+      numberOfThreads = vtkVariant(argv[argIndex+1]).ToInt();
+      std::cout << "Number of threads: " << numberOfThreads << std::endl;
+      argIndex += 2;
+    }
+  }
+  // UseDoublePrecision (optional)
+  bool useDoublePrecision = false;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-UseDoublePrecision") == 0)
+    {
+      useDoublePrecision = (vtkVariant(argv[argIndex+1]).ToInt() != 0);
+      std::cout << "Use double precision: " << (useDoublePrecision ? "true" : "false") << std::endl;
+      argIndex += 2;
+    }
+  }
+
   // Constraint the criteria to be greater than zero
   if (doseDifferenceCriterion == 0.0)
   {
@@ -174,6 +199,8 @@ int vtkSlicerDoseAccumulationModuleLogicTest1( int argc, char * argv[] )
   paramNode->AddSelectedInputVolumeNode(doseScalarVolumeNode2, 0.5);
   paramNode->SetAndObserveAccumulatedDoseVolumeNode(outputVolumeNode);
   paramNode->SetAndObserveReferenceDoseVolumeNode(doseScalarVolumeNode);
+  paramNode->SetNumberOfThreads(numberOfThreads);
+  paramNode->SetUseDoublePrecision(useDoublePrecision);
 
   // Create and set up logic
   vtkSmartPointer<vtkSlicerDoseAccumulationModuleLogic> doseAccumulationLogic = vtkSmartPointer<vtkSlicerDoseAccumulationModuleLogic>::New();
@@ -215,9 +242,22 @@ int vtkSlicerDoseAccumulationModuleLogicTest1( int argc, char * argv[] )
 
   // Subtract the dose volume from the accumulated volume and check if we get back the original dose volume
   // TODO: Add test that dose the same thing using different weights
+  // (the accumulated dose is float or double, so it is cast to the type of the dose volume first)
+  int expectedScalarType = (useDoublePrecision ? VTK_DOUBLE : VTK_FLOAT);
+  if (accumulatedDoseVolumeNode->GetImageData()->GetScalarType() != expectedScalarType)
+  {
+    std::cerr << "ERROR: Accumulated volume has scalar type " << accumulatedDoseVolumeNode->GetImageData()->GetScalarTypeAsString()
+      << " instead of " << (useDoublePrecision ? "double" : "float") << std::endl;
+    return EXIT_FAILURE;
+  }
+  vtkSmartPointer<vtkImageCast> cast = vtkSmartPointer<vtkImageCast>::New();
+  cast->SetInputData(accumulatedDoseVolumeNode->GetImageData());
+  cast->SetOutputScalarType(doseScalarVolumeNode->GetImageData()->GetScalarType());
+  cast->Update();
+
   vtkSmartPointer<vtkImageMathematics> math = vtkSmartPointer<vtkImageMathematics>::New();
   math->SetInput1Data(doseScalarVolumeNode->GetImageData());
-  math->SetInput2Data(accumulatedDoseVolumeNode->GetImageData());
+  math->SetInput2Data(cast->GetOutput());
   math->SetOperationToSubtract();
   math->Update();
 
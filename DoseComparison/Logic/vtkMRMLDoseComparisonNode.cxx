@@ -58,6 +58,8 @@ vtkMRMLDoseComparisonNode::vtkMRMLDoseComparisonNode()
   this->ResultsValid = false;
   this->ReportString = NULL;
   this->LocalDoseDifference = false;
+  this->GammaBackend = vtkMRMLDoseComparisonNode::PlastimatchGammaBackend;
+  this->NumberOfThreads = 0;
 
   this->HideFromEditors = false;
 }
@@ -84,6 +86,8 @@ void vtkMRMLDoseComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " UseLinearInterpolation=\"" << (this->UseLinearInterpolation ? "true" : "false") << "\"";
   of << " LocalDoseDifference=\"" << (this->LocalDoseDifference ? "true" : "false") << "\"";
   of << " DoseThresholdOnReferenceOnly=\"" << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\"";
+  of << " GammaBackend=\"" << (int)(this->GammaBackend) << "\"";
+  of << " NumberOfThreads=\"" << this->NumberOfThreads << "\"";
   of << " PassFractionPercent=\"" << this->PassFractionPercent << "\"";
   of << " ResultsValid=\"" << (this->ResultsValid ? "true" : "false") << "\"";
   of << " ReportString=\"" << (this->ReportString ? this->ReportString : "") << "\"";
@@ -143,6 +147,14 @@ void vtkMRMLDoseComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->DoseThresholdOnReferenceOnly = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "GammaBackend")) 
+      {
+      this->GammaBackend = (GammaBackendType)(vtkVariant(attValue).ToInt());
+      }
+    else if (!strcmp(attName, "NumberOfThreads")) 
+      {
+      this->NumberOfThreads = vtkVariant(attValue).ToInt();
+      }
     else if (!strcmp(attName, "PassFractionPercent")) 
       {
       this->PassFractionPercent = vtkVariant(attValue).ToDouble();
@@ -177,6 +189,8 @@ void vtkMRMLDoseComparisonNode::Copy(vtkMRMLNode *anode)
   this->UseLinearInterpolation = node->UseLinearInterpolation;
   this->LocalDoseDifference = node->LocalDoseDifference;
   this->DoseThresholdOnReferenceOnly = node->DoseThresholdOnReferenceOnly;
+  this->GammaBackend = node->GammaBackend;
+  this->NumberOfThreads = node->NumberOfThreads;
   this->ResultsValid = node->ResultsValid;
   this->ReportString = node->ReportString;
 
@@ -198,6 +212,8 @@ void vtkMRMLDoseComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "UseMaximumDose:   " << (this->UseMaximumDose ? "true" : "false") << "\n";
   os << indent << "UseLinearInterpolation:   " << (this->UseLinearInterpolation ? "true" : "false") << "\n";
   os << indent << "LocalDoseDifference:   " << (this->LocalDoseDifference ? "true" : "false") << "\n";
+  os << indent << "GammaBackend:   " << (int)(this->GammaBackend) << "\n";
+  os << indent << "NumberOfThreads:   " << this->NumberOfThreads << "\n";
   os << indent << "DoseThresholdOnReferenceOnly:   " << (this->DoseThresholdOnReferenceOnly ? "true" : "false") << "\n";
   os << indent << "PassFractionPercent:   " << this->PassFractionPercent << "\n";
   os << indent << "ResultsValid:   " << (this->ResultsValid ? "true" : "false") << "\n";
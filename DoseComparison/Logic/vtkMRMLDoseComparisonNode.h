@@ -37,6 +37,16 @@ class vtkMRMLSegmentationNode;
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkMRMLDoseComparisonNode : public vtkMRMLNode
 {
+public:
+  /// Implementation used for computing the gamma volume
+  enum GammaBackendType
+  {
+    /// Gamma dose comparison of Plastimatch
+    PlastimatchGammaBackend = 0,
+    /// Multi-threaded gamma computation of the DoseComparison logic
+    NativeGammaBackend
+  };
+
 public:
   static vtkMRMLDoseComparisonNode *New();
   vtkTypeMacro(vtkMRMLDoseComparisonNode,vtkMRMLNode);
@@ -129,6 +139,16 @@ public:
   /// Set dose threshold on reference flag
   vtkBooleanMacro(DoseThresholdOnReferenceOnly, bool);
 
+  /// Get gamma computation backend
+  vtkGetMacro(GammaBackend, vtkMRMLDoseComparisonNode::GammaBackendType);
+  /// Set gamma computation backend
+  vtkSetMacro(GammaBackend, vtkMRMLDoseComparisonNode::GammaBackendType);
+
+  /// Get number of threads used by the native gamma computation
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used by the native gamma computation. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+
   /// Get local dose difference flag
   vtkGetMacro(LocalDoseDifference, bool);
   /// Set local dose difference flag
@@ -197,6 +217,12 @@ protected:
   /// Flag determining whether dose thresholding should be performed using only the reference image
   /// Default value is false, meaning that both images will be used
   bool DoseThresholdOnReferenceOnly;
+
+  /// Implementation used for computing the gamma volume. Plastimatch by default
+  GammaBackendType GammaBackend;
+
+  /// Number of threads used by the native gamma computation
+  int NumberOfThreads;
   
   /// Percentage of voxels that passed (output)
   double PassFractionPercent;
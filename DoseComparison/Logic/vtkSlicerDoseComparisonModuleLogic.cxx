@@ -51,13 +51,24 @@
 #include <vtkSlicerSubjectHierarchyModuleLogic.h>
 
 // VTK includes
+#include <vtkAtomic.h>
 #include <vtkNew.h>
 #include <vtkTimerLog.h>
 #include <vtkLookupTable.h>
 #include <vtkImageConstantPad.h>
+#include <vtkImageCast.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
 // SlicerBase includes
 #include "vtkSlicerApplicationLogic.h"
 
@@ -78,6 +89,278 @@ void GammaProgressCallback(float progress)
   }
 }
 
+//---------------------------------------------------------------------------
+namespace
+{
+  //---------------------------------------------------------------------------
+  /// Offset of a candidate compare dose position from a reference voxel in the gamma search
+  struct GammaSearchOffset
+  {
+    /// Offset in compare dose IJK coordinates
+    double CompareIjkOffset[3];
+    /// Squared distance of the offset normalized by the distance to agreement criterion
+    double NormalizedDistanceSquared;
+
+    bool operator<(const GammaSearchOffset& other) const
+    {
+      return this->NormalizedDistanceSquared < other.NormalizedDistanceSquared;
+    }
+  };
+
+  //---------------------------------------------------------------------------
+  /// Compute gamma for a range of reference dose voxels.
+  /// Candidate positions of the compare dose are visited in order of increasing distance from the reference voxel,
+  /// so the search stops as soon as the distance term alone exceeds the smallest gamma found so far. For passing
+  /// voxels this means that the search never leaves the neighborhood given by the distance to agreement criterion.
+  /// Progress is reported from the main thread after each processed slice of reference voxels.
+  class ComputeGammaFunctor
+  {
+  public:
+    ComputeGammaFunctor(vtkImageData* referenceDose, vtkMatrix4x4* referenceIjkToCompareIjk, vtkImageData* compareDose,
+      vtkImageData* mask, vtkMatrix4x4* referenceIjkToMaskIjk, const std::vector<GammaSearchOffset>& searchOffsets,
+      double doseDifferenceTolerance, bool localDoseDifference, double analysisThresholdDose, bool thresholdOnReferenceOnly,
+      double maximumGamma, bool useLinearInterpolation, vtkImageData* gammaVolume, std::vector<unsigned char>& analyzedVoxels,
+      vtkSlicerDoseComparisonModuleLogic* progressLogic)
+      : ReferencePtr(static_cast<const float*>(referenceDose->GetScalarPointer()))
+      , ComparePtr(static_cast<const float*>(compareDose->GetScalarPointer()))
+      , MaskPtr(mask ? static_cast<const unsigned char*>(mask->GetScalarPointer()) : NULL)
+      , SearchOffsets(searchOffsets)
+      , DoseDifferenceTolerance(doseDifferenceTolerance)
+      , LocalDoseDifference(localDoseDifference)
+      , AnalysisThresholdDose(analysisThresholdDose)
+      , ThresholdOnReferenceOnly(thresholdOnReferenceOnly)
+      , MaximumGamma(maximumGamma)
+      , UseLinearInterpolation(useLinearInterpolation)
+      , GammaPtr(static_cast<float*>(gammaVolume->GetScalarPointer()))
+      , AnalyzedVoxels(analyzedVoxels)
+      , ProgressLogic(progressLogic)
+      , MainThreadID(vtkMultiThreader::GetCurrentThreadID())
+      , NumberOfProcessedVoxels(0)
+    {
+      for (int row=0; row<3; ++row)
+      {
+        for (int col=0; col<4; ++col)
+        {
+          this->ReferenceIjkToCompareIjk[row][col] = referenceIjkToCompareIjk->GetElement(row, col);
+          this->ReferenceIjkToMaskIjk[row][col] = (referenceIjkToMaskIjk ? referenceIjkToMaskIjk->GetElement(row, col) : 0.0);
+        }
+      }
+      referenceDose->GetExtent(this->ReferenceExtent);
+      compareDose->GetExtent(this->CompareExtent);
+      if (mask)
+      {
+        mask->GetExtent(this->MaskExtent);
+      }
+      this->NumberOfVoxels = referenceDose->GetNumberOfPoints();
+      this->NumberOfVoxelsPerProgressStep = std::max<vtkIdType>(1,
+        (vtkIdType)(this->ReferenceExtent[1] - this->ReferenceExtent[0] + 1) * (this->ReferenceExtent[3] - this->ReferenceExtent[2] + 1));
+    }
+
+    void operator()(vtkIdType beginVoxel, vtkIdType endVoxel)
+    {
+      for (vtkIdType beginStepVoxel = beginVoxel; beginStepVoxel < endVoxel; beginStepVoxel += this->NumberOfVoxelsPerProgressStep)
+      {
+        vtkIdType endStepVoxel = std::min(endVoxel, beginStepVoxel + this->NumberOfVoxelsPerProgressStep);
+        this->ComputeGamma(beginStepVoxel, endStepVoxel);
+
+        vtkIdType numberOfProcessedVoxels = (this->NumberOfProcessedVoxels += endStepVoxel - beginStepVoxel);
+        if (this->ProgressLogic && vtkMultiThreader::ThreadsEqual(this->MainThreadID, vtkMultiThreader::GetCurrentThreadID()))
+        {
+          this->ProgressLogic->GammaProgressUpdated((double)numberOfProcessedVoxels / (double)this->NumberOfVoxels);
+        }
+      }
+    }
+
+  private:
+    /// Compute gamma for the reference voxels in the given index range
+    void ComputeGamma(vtkIdType beginVoxel, vtkIdType endVoxel)
+    {
+      int referenceDimensions[3] = { this->ReferenceExtent[1] - this->ReferenceExtent[0] + 1,
+        this->ReferenceExtent[3] - this->ReferenceExtent[2] + 1, this->ReferenceExtent[5] - this->ReferenceExtent[4] + 1 };
+      const float* referencePtr = this->ReferencePtr;
+      float* gammaPtr = this->GammaPtr;
+      const double maximumGammaSquared = this->MaximumGamma * this->MaximumGamma;
+
+      for (vtkIdType voxelIndex = beginVoxel; voxelIndex < endVoxel; ++voxelIndex)
+      {
+        gammaPtr[voxelIndex] = 0.0f;
+        this->AnalyzedVoxels[voxelIndex] = 0;
+
+        double referenceIjk[3] = {
+          static_cast<double>(this->ReferenceExtent[0] + voxelIndex % referenceDimensions[0]),
+          static_cast<double>(this->ReferenceExtent[2] + (voxelIndex / referenceDimensions[0]) % referenceDimensions[1]),
+          static_cast<double>(this->ReferenceExtent[4] + voxelIndex / ((vtkIdType)referenceDimensions[0] * referenceDimensions[1])) };
+        if (this->MaskPtr && !this->IsInsideMask(referenceIjk))
+        {
+          continue;
+        }
+
+        double compareIjk[3] = { 0.0, 0.0, 0.0 };
+        for (int row=0; row<3; ++row)
+        {
+          const double (&m)[4] = this->ReferenceIjkToCompareIjk[row];
+          compareIjk[row] = m[0]*referenceIjk[0] + m[1]*referenceIjk[1] + m[2]*referenceIjk[2] + m[3];
+        }
+
+        // Skip voxels below the analysis threshold
+        double referenceDose = referencePtr[voxelIndex];
+        if (referenceDose < this->AnalysisThresholdDose)
+        {
+          double compareDose = 0.0;
+          if ( this->ThresholdOnReferenceOnly || !this->SampleCompareDose(compareIjk, compareDose)
+            || compareDose < this->AnalysisThresholdDose )
+          {
+            continue;
+          }
+        }
+        this->AnalyzedVoxels[voxelIndex] = 1;
+
+        double doseDifferenceTolerance = (this->LocalDoseDifference ? this->DoseDifferenceTolerance * referenceDose : this->DoseDifferenceTolerance);
+        double inverseDoseDifferenceToleranceSquared = 1.0 / std::max(doseDifferenceTolerance * doseDifferenceTolerance, 1e-12);
+
+        double minimumGammaSquared = maximumGammaSquared;
+        for (std::vector<GammaSearchOffset>::const_iterator offsetIt = this->SearchOffsets.begin(); offsetIt != this->SearchOffsets.end(); ++offsetIt)
+        {
+          if (offsetIt->NormalizedDistanceSquared >= minimumGammaSquared)
+          {
+            // All remaining candidates are farther away than the gamma found so far
+            break;
+          }
+          double candidateIjk[3] = { compareIjk[0] + offsetIt->CompareIjkOffset[0],
+            compareIjk[1] + offsetIt->CompareIjkOffset[1], compareIjk[2] + offsetIt->CompareIjkOffset[2] };
+          double compareDose = 0.0;
+          if (!this->SampleCompareDose(candidateIjk, compareDose))
+          {
+            continue;
+          }
+          double doseDifference = compareDose - referenceDose;
+          double gammaSquared = offsetIt->NormalizedDistanceSquared + doseDifference * doseDifference * inverseDoseDifferenceToleranceSquared;
+          if (gammaSquared < minimumGammaSquared)
+          {
+            minimumGammaSquared = gammaSquared;
+          }
+        }
+        gammaPtr[voxelIndex] = static_cast<float>(sqrt(minimumGammaSquared));
+      }
+    }
+
+    /// Get compare dose at the given IJK position with trilinear or nearest neighbor interpolation
+    /// \return False if the position is outside the compare dose volume
+    bool SampleCompareDose(const double compareIjk[3], double& dose)
+    {
+      const double tolerance = 1e-3;
+      int baseIndex[3] = { 0, 0, 0 };
+      vtkIdType increment[3] = { 0, 0, 0 };
+      double fraction[3] = { 0.0, 0.0, 0.0 };
+      vtkIdType stride = 1;
+      vtkIdType offset = 0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        int dimension = this->CompareExtent[2*axis+1] - this->CompareExtent[2*axis] + 1;
+        double position = compareIjk[axis] - this->CompareExtent[2*axis];
+        if (position < -tolerance || position > dimension - 1 + tolerance)
+        {
+          return false;
+        }
+        if (this->UseLinearInterpolation)
+        {
+          baseIndex[axis] = std::max(0, std::min(dimension - 2, (int)floor(position)));
+          fraction[axis] = std::min(1.0, std::max(0.0, position - baseIndex[axis]));
+          increment[axis] = (baseIndex[axis] + 1 < dimension ? stride : 0);
+        }
+        else
+        {
+          baseIndex[axis] = std::max(0, std::min(dimension - 1, (int)floor(position + 0.5)));
+        }
+        offset += baseIndex[axis] * stride;
+        stride *= dimension;
+      }
+
+      const float* p = this->ComparePtr + offset;
+      if (!this->UseLinearInterpolation)
+      {
+        dose = *p;
+        return true;
+      }
+      double c00 = p[0] + fraction[0] * (p[increment[0]] - (double)p[0]);
+      double c10 = p[increment[1]] + fraction[0] * (p[increment[1] + increment[0]] - (double)p[increment[1]]);
+      double c01 = p[increment[2]] + fraction[0] * (p[increment[2] + increment[0]] - (double)p[increment[2]]);
+      double c11 = p[increment[2] + increment[1]]
+        + fraction[0] * (p[increment[2] + increment[1] + increment[0]] - (double)p[increment[2] + increment[1]]);
+      double c0 = c00 + fraction[1] * (c10 - c00);
+      double c1 = c01 + fraction[1] * (c11 - c01);
+      dose = c0 + fraction[2] * (c1 - c0);
+      return true;
+    }
+
+    /// Determine if the reference voxel is inside the mask (nearest neighbor lookup)
+    bool IsInsideMask(const double referenceIjk[3])
+    {
+      int maskIjk[3] = { 0, 0, 0 };
+      for (int row=0; row<3; ++row)
+      {
+        const double (&m)[4] = this->ReferenceIjkToMaskIjk[row];
+        maskIjk[row] = (int)floor(m[0]*referenceIjk[0] + m[1]*referenceIjk[1] + m[2]*referenceIjk[2] + m[3] + 0.5);
+        if (maskIjk[row] < this->MaskExtent[2*row] || maskIjk[row] > this->MaskExtent[2*row+1])
+        {
+          return false;
+        }
+      }
+      vtkIdType maskDimensions[2] = { this->MaskExtent[1] - this->MaskExtent[0] + 1, this->MaskExtent[3] - this->MaskExtent[2] + 1 };
+      vtkIdType maskVoxelIndex = (maskIjk[0] - this->MaskExtent[0])
+        + ((maskIjk[1] - this->MaskExtent[2]) + (maskIjk[2] - this->MaskExtent[4]) * maskDimensions[1]) * maskDimensions[0];
+      return this->MaskPtr[maskVoxelIndex] != 0;
+    }
+
+    /// Scalar pointers are cached because GetScalarPointer is too expensive to call for each sample
+    const float* ReferencePtr;
+    const float* ComparePtr;
+    const unsigned char* MaskPtr;
+    double ReferenceIjkToCompareIjk[3][4];
+    double ReferenceIjkToMaskIjk[3][4];
+    int ReferenceExtent[6];
+    int CompareExtent[6];
+    int MaskExtent[6];
+    const std::vector<GammaSearchOffset>& SearchOffsets;
+    double DoseDifferenceTolerance;
+    bool LocalDoseDifference;
+    double AnalysisThresholdDose;
+    bool ThresholdOnReferenceOnly;
+    double MaximumGamma;
+    bool UseLinearInterpolation;
+    float* GammaPtr;
+    std::vector<unsigned char>& AnalyzedVoxels;
+    vtkSlicerDoseComparisonModuleLogic* ProgressLogic;
+    vtkMultiThreaderIDType MainThreadID;
+    vtkIdType NumberOfVoxels;
+    vtkIdType NumberOfVoxelsPerProgressStep;
+    vtkAtomic<vtkIdType> NumberOfProcessedVoxels;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Convert volume node to float oriented image data in world coordinate system
+  bool GetFloatImageInWorld(vtkMRMLScalarVolumeNode* volumeNode, vtkOrientedImageData* floatImage)
+  {
+    vtkSmartPointer<vtkOrientedImageData> image = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(volumeNode, image))
+    {
+      return false;
+    }
+    if (image->GetScalarType() == VTK_FLOAT && image->GetNumberOfScalarComponents() == 1)
+    {
+      floatImage->ShallowCopy(image);
+      return true;
+    }
+    vtkSmartPointer<vtkImageCast> cast = vtkSmartPointer<vtkImageCast>::New();
+    cast->SetInputData(image);
+    cast->SetOutputScalarTypeToFloat();
+    cast->Update();
+    floatImage->vtkImageData::ShallowCopy(cast->GetOutput());
+    floatImage->CopyDirections(image);
+    return true;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDoseComparisonModuleLogic);
 
@@ -189,13 +472,55 @@ void vtkSlicerDoseComparisonModuleLogic::GammaProgressUpdated(float progress)
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMRMLDoseComparisonNode* parameterNode)
+std::string vtkSlicerDoseComparisonModuleLogic::GetMaskSegmentLabelmap(vtkMRMLDoseComparisonNode* parameterNode, vtkOrientedImageData* maskLabelmap)
+{
+  vtkMRMLSegmentationNode* maskSegmentationNode = parameterNode->GetMaskSegmentationNode();
+  const char* maskSegmentID = parameterNode->GetMaskSegmentID();
+
+  // Extract a labelmap for the dose comparison to use it as a mask
+  vtkSegmentation* maskSegmentation = maskSegmentationNode->GetSegmentation();
+  vtkSegment* maskSegment = maskSegmentation->GetSegment(maskSegmentID);
+  if (!maskSegment)
+  {
+    std::string errorMessage("Failed to get mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to dose volume)
+  vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
+  segmentationCopy->SetMasterRepresentationName(maskSegmentation->GetMasterRepresentationName());
+  segmentationCopy->CopyConversionParameters(maskSegmentation);
+  segmentationCopy->CopySegmentFromSegmentation(maskSegmentation, maskSegmentID);
+  if (!segmentationCopy->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+  {
+    std::string errorMessage("Failed to create binary labelmap representation for mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+  // Get segment binary labelmap
+  vtkOrientedImageData* maskSegmentLabelmap = vtkOrientedImageData::SafeDownCast( segmentationCopy->GetSegment(maskSegmentID)->GetRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+
+  // Apply parent transformation nodes if necessary
+  if ( maskSegmentationNode->GetParentTransformNode()
+    && (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(maskSegmentationNode, maskSegmentLabelmap)) )
+  {
+    std::string errorMessage("Failed to apply parent transform on mask segment");
+    vtkErrorMacro("GetMaskSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  maskLabelmap->DeepCopy(maskSegmentLabelmap);
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaWithPlastimatch(vtkMRMLDoseComparisonNode* parameterNode, vtkMRMLScalarVolumeNode* gammaVolumeNode)
 {
   vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
   double checkpointStart = timer->GetUniversalTime();
 
-  parameterNode->ResultsValidOff();
-
   double checkpointConvertStart = timer->GetUniversalTime();
   vtkMRMLScalarVolumeNode* referenceDoseVolumeNode = parameterNode->GetReferenceDoseVolumeNode();
   Plm_image::Pointer referenceDose = PlmCommon::ConvertVolumeNodeToPlmImage(referenceDoseVolumeNode);
@@ -206,37 +531,10 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   const char* maskSegmentID = parameterNode->GetMaskSegmentID();
   if (maskSegmentationNode && maskSegmentID)
   {
-    // Extract a labelmap for the dose comparison to use it as a mask
-    vtkSegmentation* maskSegmentation = maskSegmentationNode->GetSegmentation();
-    vtkSegment* maskSegment = maskSegmentation->GetSegment(maskSegmentID);
-    if (!maskSegment)
-    {
-      std::string errorMessage("Failed to get mask segment");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
-      return errorMessage;
-    }
-
-    // Temporarily duplicate selected segments to contain binary labelmap of a different geometry (tied to dose volume)
-    vtkSmartPointer<vtkSegmentation> segmentationCopy = vtkSmartPointer<vtkSegmentation>::New();
-    segmentationCopy->SetMasterRepresentationName(maskSegmentation->GetMasterRepresentationName());
-    segmentationCopy->CopyConversionParameters(maskSegmentation);
-    segmentationCopy->CopySegmentFromSegmentation(maskSegmentation, maskSegmentID);
-    if (!segmentationCopy->CreateRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    vtkSmartPointer<vtkOrientedImageData> maskSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->GetMaskSegmentLabelmap(parameterNode, maskSegmentLabelmap);
+    if (!errorMessage.empty())
     {
-      std::string errorMessage("Failed to create binary labelmap representation for mask segment");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
-      return errorMessage;
-    }
-    // Get segment binary labelmap
-    vtkOrientedImageData* maskSegmentLabelmap = vtkOrientedImageData::SafeDownCast( segmentationCopy->GetSegment(maskSegmentID)->GetRepresentation(
-      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
-
-    // Apply parent transformation nodes if necessary
-    if ( maskSegmentationNode->GetParentTransformNode()
-      && (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(maskSegmentationNode, maskSegmentLabelmap)) )
-    {
-      std::string errorMessage("Failed to apply parent transform on mask segment");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
       return errorMessage;
     }
 
@@ -245,7 +543,7 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
     if (!maskVolume)
     {
       std::string errorMessage("Failed to convert mask segment labelmap into Plm_image");
-      vtkErrorMacro("ComputeGammaDoseDifference: " << errorMessage);
+      vtkErrorMacro("ComputeGammaWithPlastimatch: " << errorMessage);
       return errorMessage;
     }
   }
@@ -281,6 +579,202 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
   // Convert output to VTK
   double checkpointVtkConvertStart = timer->GetUniversalTime();
 
+  // The gamma image is not used after the computation, so the volume node can take over its buffer
+  SlicerRtCommon::ConvertItkImageToVolumeNode<float>(gammaVolumeItk, gammaVolumeNode, VTK_FLOAT, true, true);
+
+  if (this->LogSpeedMeasurements)
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    std::cout << "Total gamma computation time: " << checkpointEnd-checkpointStart << " s" << std::endl
+              << "\tApplying transforms: " << checkpointConvertStart-checkpointStart << " s" << std::endl
+              << "\tConverting from VTK to ITK: " << checkpointGammaStart-checkpointConvertStart << " s" << std::endl
+              << "\tGamma computation: " << checkpointVtkConvertStart-checkpointGammaStart << " s" << std::endl
+              << "\tConverting back from ITK to VTK: " << checkpointEnd-checkpointVtkConvertStart << " s" << std::endl;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaNative(vtkMRMLDoseComparisonNode* parameterNode, vtkMRMLScalarVolumeNode* gammaVolumeNode)
+{
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  this->GammaProgressUpdated(0.0);
+
+  double dtaDistanceToleranceMm = parameterNode->GetDtaDistanceToleranceMm();
+  double maximumGamma = parameterNode->GetMaximumGamma();
+  if (dtaDistanceToleranceMm <= 0.0 || parameterNode->GetDoseDifferenceTolerancePercent() <= 0.0 || maximumGamma <= 0.0)
+  {
+    std::string errorMessage("Distance to agreement, dose difference tolerance and maximum gamma must be positive");
+    vtkErrorMacro("ComputeGammaNative: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Get input doses and mask in the world coordinate system
+  vtkSmartPointer<vtkOrientedImageData> referenceDose = vtkSmartPointer<vtkOrientedImageData>::New();
+  vtkSmartPointer<vtkOrientedImageData> compareDose = vtkSmartPointer<vtkOrientedImageData>::New();
+  if ( !GetFloatImageInWorld(parameterNode->GetReferenceDoseVolumeNode(), referenceDose)
+    || !GetFloatImageInWorld(parameterNode->GetCompareDoseVolumeNode(), compareDose) )
+  {
+    std::string errorMessage("Failed to get input dose volumes");
+    vtkErrorMacro("ComputeGammaNative: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkMatrix4x4> referenceIjkToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  referenceDose->GetImageToWorldMatrix(referenceIjkToWorldMatrix);
+
+  vtkSmartPointer<vtkImageData> mask;
+  vtkSmartPointer<vtkMatrix4x4> referenceIjkToMaskIjkMatrix;
+  if (parameterNode->GetMaskSegmentationNode() && parameterNode->GetMaskSegmentID())
+  {
+    vtkSmartPointer<vtkOrientedImageData> maskSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->GetMaskSegmentLabelmap(parameterNode, maskSegmentLabelmap);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    vtkSmartPointer<vtkImageCast> maskCast = vtkSmartPointer<vtkImageCast>::New();
+    maskCast->SetInputData(maskSegmentLabelmap);
+    maskCast->SetOutputScalarTypeToUnsignedChar();
+    maskCast->Update();
+    mask = maskCast->GetOutput();
+
+    vtkSmartPointer<vtkMatrix4x4> worldToMaskIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    maskSegmentLabelmap->GetImageToWorldMatrix(worldToMaskIjkMatrix);
+    worldToMaskIjkMatrix->Invert();
+    referenceIjkToMaskIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkMatrix4x4::Multiply4x4(worldToMaskIjkMatrix, referenceIjkToWorldMatrix, referenceIjkToMaskIjkMatrix);
+  }
+
+  double checkpointGammaStart = timer->GetUniversalTime();
+
+  // Mapping from reference voxels to compare voxels
+  vtkSmartPointer<vtkMatrix4x4> worldToCompareIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  compareDose->GetImageToWorldMatrix(worldToCompareIjkMatrix);
+  worldToCompareIjkMatrix->Invert();
+  vtkSmartPointer<vtkMatrix4x4> referenceIjkToCompareIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkMatrix4x4::Multiply4x4(worldToCompareIjkMatrix, referenceIjkToWorldMatrix, referenceIjkToCompareIjkMatrix);
+
+  // Dose criteria
+  double referenceDoseGy = parameterNode->GetReferenceDoseGy();
+  if (parameterNode->GetUseMaximumDose())
+  {
+    referenceDoseGy = referenceDose->GetScalarRange()[1];
+  }
+  double doseDifferenceTolerance = parameterNode->GetDoseDifferenceTolerancePercent() / 100.0;
+  if (!parameterNode->GetLocalDoseDifference())
+  {
+    doseDifferenceTolerance *= referenceDoseGy;
+  }
+  double analysisThresholdDose = parameterNode->GetAnalysisThresholdPercent() / 100.0 * referenceDoseGy;
+
+  // Collect the candidate offsets within the search radius (maximum gamma times the distance to agreement).
+  // The offsets are on the reference grid, subdivided to half voxels when the compare dose is interpolated.
+  int subdivision = (parameterNode->GetUseLinearInterpolation() ? 2 : 1);
+  double searchRadiusMm = maximumGamma * dtaDistanceToleranceMm;
+  int searchRange[3] = { 0, 0, 0 };
+  for (int axis=0; axis<3; ++axis)
+  {
+    double spacing = sqrt( referenceIjkToWorldMatrix->GetElement(0, axis) * referenceIjkToWorldMatrix->GetElement(0, axis)
+      + referenceIjkToWorldMatrix->GetElement(1, axis) * referenceIjkToWorldMatrix->GetElement(1, axis)
+      + referenceIjkToWorldMatrix->GetElement(2, axis) * referenceIjkToWorldMatrix->GetElement(2, axis) );
+    searchRange[axis] = (spacing > 0.0 ? (int)ceil(searchRadiusMm / spacing * subdivision) : 0);
+  }
+  std::vector<GammaSearchOffset> searchOffsets;
+  for (int k = -searchRange[2]; k <= searchRange[2]; ++k)
+  {
+    for (int j = -searchRange[1]; j <= searchRange[1]; ++j)
+    {
+      for (int i = -searchRange[0]; i <= searchRange[0]; ++i)
+      {
+        double referenceIjkOffset[4] = { (double)i / subdivision, (double)j / subdivision, (double)k / subdivision, 0.0 };
+        double worldOffset[4] = { 0.0, 0.0, 0.0, 0.0 };
+        referenceIjkToWorldMatrix->MultiplyPoint(referenceIjkOffset, worldOffset);
+        GammaSearchOffset offset;
+        offset.NormalizedDistanceSquared = vtkMath::Dot(worldOffset, worldOffset) / (dtaDistanceToleranceMm * dtaDistanceToleranceMm);
+        if (offset.NormalizedDistanceSquared >= maximumGamma * maximumGamma)
+        {
+          continue;
+        }
+        double compareIjkOffset[4] = { 0.0, 0.0, 0.0, 0.0 };
+        referenceIjkToCompareIjkMatrix->MultiplyPoint(referenceIjkOffset, compareIjkOffset);
+        offset.CompareIjkOffset[0] = compareIjkOffset[0];
+        offset.CompareIjkOffset[1] = compareIjkOffset[1];
+        offset.CompareIjkOffset[2] = compareIjkOffset[2];
+        searchOffsets.push_back(offset);
+      }
+    }
+  }
+  std::sort(searchOffsets.begin(), searchOffsets.end());
+
+  // Compute gamma for each reference voxel
+  vtkSmartPointer<vtkImageData> gammaImage = vtkSmartPointer<vtkImageData>::New();
+  gammaImage->SetExtent(referenceDose->GetExtent());
+  gammaImage->AllocateScalars(VTK_FLOAT, 1);
+  vtkIdType numberOfVoxels = gammaImage->GetNumberOfPoints();
+  std::vector<unsigned char> analyzedVoxels(numberOfVoxels, 0);
+
+  ComputeGammaFunctor computeGammaFunctor(referenceDose, referenceIjkToCompareIjkMatrix, compareDose,
+    mask, referenceIjkToMaskIjkMatrix, searchOffsets, doseDifferenceTolerance, parameterNode->GetLocalDoseDifference(),
+    analysisThresholdDose, parameterNode->GetDoseThresholdOnReferenceOnly(), maximumGamma,
+    parameterNode->GetUseLinearInterpolation(), gammaImage, analyzedVoxels, this);
+  SlicerRtCommon::SmpFor(0, numberOfVoxels, 0, computeGammaFunctor, parameterNode->GetNumberOfThreads());
+
+  // Compute pass fraction
+  const float* gammaPtr = static_cast<const float*>(gammaImage->GetScalarPointer());
+  vtkIdType numberOfAnalyzedVoxels = 0;
+  vtkIdType numberOfPassingVoxels = 0;
+  for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; ++voxelIndex)
+  {
+    if (analyzedVoxels[voxelIndex])
+    {
+      ++numberOfAnalyzedVoxels;
+      if (gammaPtr[voxelIndex] <= 1.0f)
+      {
+        ++numberOfPassingVoxels;
+      }
+    }
+  }
+  double passFraction = (numberOfAnalyzedVoxels > 0 ? (double)numberOfPassingVoxels / numberOfAnalyzedVoxels : 0.0);
+  parameterNode->SetPassFractionPercent(passFraction * 100.0);
+
+  std::stringstream reportStream;
+  reportStream << "Gamma computation backend: native" << std::endl
+    << "Reference dose: " << referenceDoseGy << " Gy" << std::endl
+    << "Dose difference tolerance: " << parameterNode->GetDoseDifferenceTolerancePercent() << " %"
+    << (parameterNode->GetLocalDoseDifference() ? " (local)" : " (global)") << std::endl
+    << "Distance to agreement: " << dtaDistanceToleranceMm << " mm" << std::endl
+    << "Analysis threshold: " << analysisThresholdDose << " Gy" << std::endl
+    << "Number of search positions: " << searchOffsets.size() << std::endl
+    << "Number of analyzed voxels: " << numberOfAnalyzedVoxels << std::endl
+    << "Number of passing voxels: " << numberOfPassingVoxels << std::endl
+    << "Pass rate: " << passFraction * 100.0 << " %" << std::endl;
+  parameterNode->SetReportString(reportStream.str().c_str());
+
+  // Set gamma volume to the output node with the geometry of the reference dose
+  gammaVolumeNode->SetIJKToRASMatrix(referenceIjkToWorldMatrix);
+  gammaVolumeNode->SetAndObserveImageData(gammaImage);
+
+  this->GammaProgressUpdated(1.0);
+
+  if (this->LogSpeedMeasurements)
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    std::cout << "Total native gamma computation time: " << checkpointEnd-checkpointStart << " s" << std::endl
+              << "\tGetting input volumes: " << checkpointGammaStart-checkpointStart << " s" << std::endl
+              << "\tGamma computation: " << checkpointEnd-checkpointGammaStart << " s" << std::endl;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMRMLDoseComparisonNode* parameterNode)
+{
+  parameterNode->ResultsValidOff();
+
   vtkMRMLScalarVolumeNode* gammaVolumeNode = parameterNode->GetGammaVolumeNode();
   if (gammaVolumeNode == NULL)
   {
@@ -289,7 +783,21 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
     return errorMessage;
   }
 
-  SlicerRtCommon::ConvertItkImageToVolumeNode<float>(gammaVolumeItk, gammaVolumeNode, VTK_FLOAT);
+  // Compute gamma volume using the selected backend
+  std::string errorMessage;
+  if (parameterNode->GetGammaBackend() == vtkMRMLDoseComparisonNode::NativeGammaBackend)
+  {
+    errorMessage = this->ComputeGammaNative(parameterNode, gammaVolumeNode);
+  }
+  else
+  {
+    errorMessage = this->ComputeGammaWithPlastimatch(parameterNode, gammaVolumeNode);
+  }
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+
   gammaVolumeNode->SetAttribute(vtkSlicerDoseComparisonModuleLogic::DOSECOMPARISON_GAMMA_VOLUME_IDENTIFIER_ATTRIBUTE_NAME, "1");
 
   // Set default colormap to red
@@ -358,16 +866,6 @@ std::string vtkSlicerDoseComparisonModuleLogic::ComputeGammaDoseDifference(vtkMR
 
   parameterNode->ResultsValidOn();
 
-  if (this->LogSpeedMeasurements)
-  {
-    double checkpointEnd = timer->GetUniversalTime();
-    std::cout << "Total gamma computation time: " << checkpointEnd-checkpointStart << " s" << std::endl
-              << "\tApplying transforms: " << checkpointConvertStart-checkpointStart << " s" << std::endl
-              << "\tConverting from VTK to ITK: " << checkpointGammaStart-checkpointConvertStart << " s" << std::endl
-              << "\tGamma computation: " << checkpointVtkConvertStart-checkpointGammaStart << " s" << std::endl
-              << "\tConverting back from ITK to VTK: " << checkpointEnd-checkpointVtkConvertStart << " s" << std::endl;
-  }
-
   return "";
 }
 
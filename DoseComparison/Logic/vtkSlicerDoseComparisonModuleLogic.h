@@ -33,6 +33,8 @@
 #include "vtkSlicerDoseComparisonModuleLogicExport.h"
 
 class vtkMRMLDoseComparisonNode;
+class vtkMRMLScalarVolumeNode;
+class vtkOrientedImageData;
 
 /// \ingroup SlicerRt_QtModules_DoseComparison
 class VTK_SLICER_DOSECOMPARISON_LOGIC_EXPORT vtkSlicerDoseComparisonModuleLogic :
@@ -66,6 +68,20 @@ protected:
   /// Loads default gamma color table from the supplied color table file
   void LoadDefaultGammaColorTable();
 
+  /// Compute gamma volume using Plastimatch
+  /// \return Error message, empty string if no error
+  std::string ComputeGammaWithPlastimatch(vtkMRMLDoseComparisonNode* parameterNode, vtkMRMLScalarVolumeNode* gammaVolumeNode);
+
+  /// Compute gamma volume using the native multi-threaded implementation.
+  /// Gamma is computed on the reference dose grid, the compare dose is searched within maximum gamma times
+  /// the distance to agreement, and the search of a voxel stops when no closer candidate can lower its gamma.
+  /// \return Error message, empty string if no error
+  std::string ComputeGammaNative(vtkMRMLDoseComparisonNode* parameterNode, vtkMRMLScalarVolumeNode* gammaVolumeNode);
+
+  /// Get the binary labelmap of the mask segment selected in the parameter node, with parent transforms applied
+  /// \return Error message, empty string if no error
+  std::string GetMaskSegmentLabelmap(vtkMRMLDoseComparisonNode* parameterNode, vtkOrientedImageData* maskLabelmap);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
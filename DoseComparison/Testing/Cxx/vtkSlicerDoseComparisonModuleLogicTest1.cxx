@@ -37,12 +37,128 @@
 #include <vtkMatrix4x4.h>
 #include <vtkImageMathematics.h>
 
+// STD includes
+#include <cmath>
+
 // ITK includes
 #include "itkFactoryRegistration.h"
 
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+namespace
+{
+  //-----------------------------------------------------------------------------
+  /// Create a uniform dose volume with a different dose in the slab of voxels where i >= slabStartI
+  vtkSmartPointer<vtkMRMLScalarVolumeNode> CreateSlabDoseVolume(vtkMRMLScene* scene, const char* name, int dimension,
+    float doseGy, int slabStartI, float slabDoseGy)
+  {
+    vtkSmartPointer<vtkImageData> doseImage = vtkSmartPointer<vtkImageData>::New();
+    doseImage->SetDimensions(dimension, dimension, dimension);
+    doseImage->AllocateScalars(VTK_FLOAT, 1);
+    float* dosePtr = static_cast<float*>(doseImage->GetScalarPointer());
+    for (int k = 0; k < dimension; ++k)
+    {
+      for (int j = 0; j < dimension; ++j)
+      {
+        for (int i = 0; i < dimension; ++i)
+        {
+          *(dosePtr++) = (i >= slabStartI ? slabDoseGy : doseGy);
+        }
+      }
+    }
+
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> doseVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    doseVolumeNode->SetName(name);
+    doseVolumeNode->SetSpacing(1.0, 1.0, 1.0);
+    doseVolumeNode->SetOrigin(0.0, 0.0, 0.0);
+    doseVolumeNode->SetAndObserveImageData(doseImage);
+    scene->AddNode(doseVolumeNode);
+
+    vtkMRMLSubjectHierarchyNode* shNode = vtkMRMLSubjectHierarchyNode::GetSubjectHierarchyNode(scene);
+    shNode->CreateItem(shNode->GetSceneItemID(), doseVolumeNode);
+    return doseVolumeNode;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Compute native gamma on synthetic doses where it is known analytically, and check it voxel by voxel.
+  /// The reference dose is 2 Gy everywhere, the compare dose is 2.03 Gy (half of the 3% dose difference
+  /// tolerance) for i >= 6 and 2 Gy elsewhere. With 3 mm distance to agreement and nearest neighbor
+  /// interpolation gamma is 0 for i <= 5, 1/3 at i = 6 (matching dose one voxel away), and 0.5 for i >= 7.
+  int TestSyntheticGamma(vtkMRMLScene* mrmlScene, vtkSlicerDoseComparisonModuleLogic* doseComparisonLogic)
+  {
+    const int dimension = 11;
+    const int slabStartI = 6;
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> referenceDoseVolumeNode = CreateSlabDoseVolume(
+      mrmlScene, "SyntheticReferenceDose", dimension, 2.0f, slabStartI, 2.0f);
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> compareDoseVolumeNode = CreateSlabDoseVolume(
+      mrmlScene, "SyntheticCompareDose", dimension, 2.0f, slabStartI, 2.03f);
+
+    vtkSmartPointer<vtkMRMLScalarVolumeNode> gammaVolumeNode = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New();
+    gammaVolumeNode->SetName("SyntheticGamma");
+    mrmlScene->AddNode(gammaVolumeNode);
+
+    vtkSmartPointer<vtkMRMLDoseComparisonNode> paramNode = vtkSmartPointer<vtkMRMLDoseComparisonNode>::New();
+    mrmlScene->AddNode(paramNode);
+    paramNode->SetAndObserveReferenceDoseVolumeNode(referenceDoseVolumeNode);
+    paramNode->SetAndObserveCompareDoseVolumeNode(compareDoseVolumeNode);
+    paramNode->SetAndObserveGammaVolumeNode(gammaVolumeNode);
+    paramNode->SetGammaBackend(vtkMRMLDoseComparisonNode::NativeGammaBackend);
+    paramNode->SetDtaDistanceToleranceMm(3.0);
+    paramNode->SetDoseDifferenceTolerancePercent(3.0);
+    paramNode->UseMaximumDoseOn();
+    paramNode->LocalDoseDifferenceOff();
+    paramNode->UseLinearInterpolationOff();
+    paramNode->SetMaximumGamma(2.0);
+
+    std::string errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+    if (!errorMessage.empty())
+    {
+      std::cerr << "ERROR: Synthetic gamma computation failed: " << errorMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    vtkImageData* gammaImage = gammaVolumeNode->GetImageData();
+    int gammaDimensions[3] = { 0, 0, 0 };
+    if (gammaImage)
+    {
+      gammaImage->GetDimensions(gammaDimensions);
+    }
+    if (gammaDimensions[0] != dimension || gammaDimensions[1] != dimension || gammaDimensions[2] != dimension)
+    {
+      std::cerr << "ERROR: Synthetic gamma volume dimensions do not match the reference dose!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    const float* gammaPtr = static_cast<const float*>(gammaImage->GetScalarPointer());
+    for (int k = 0; k < dimension; ++k)
+    {
+      for (int j = 0; j < dimension; ++j)
+      {
+        for (int i = 0; i < dimension; ++i)
+        {
+          double expectedGamma = (i < slabStartI ? 0.0 : (i == slabStartI ? 1.0 / 3.0 : 0.5));
+          double gamma = *(gammaPtr++);
+          if (fabs(gamma - expectedGamma) > 1e-4)
+          {
+            std::cerr << "ERROR: Synthetic gamma mismatch at voxel (" << i << ", " << j << ", " << k << "): "
+              << gamma << " != " << expectedGamma << std::endl;
+            return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+    if (fabs(paramNode->GetPassFractionPercent() - 100.0) > 1e-6)
+    {
+      std::cerr << "ERROR: Synthetic gamma pass rate is " << paramNode->GetPassFractionPercent() << " % instead of 100 %!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+}
+
 //-----------------------------------------------------------------------------
 int vtkSlicerDoseComparisonModuleLogicTest1( int argc, char * argv[] )
 {
@@ -90,6 +206,17 @@ int vtkSlicerDoseComparisonModuleLogicTest1( int argc, char * argv[] )
     errorStream << "Invalid arguments!" << std::endl;
     return EXIT_FAILURE;
   }
+  // GammaBackend (optional)
+  bool useNativeGammaBackend = false;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-GammaBackend") == 0)
+    {
+      useNativeGammaBackend = (STRCASECMP(argv[argIndex+1], "Native") == 0);
+      outputStream << "Gamma backend: " << argv[argIndex+1] << std::endl;
+      argIndex += 2;
+    }
+  }
 
   // Make sure NRRD reading works
   itk::itkFactoryRegistration();
@@ -182,5 +309,42 @@ int vtkSlicerDoseComparisonModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  if (useNativeGammaBackend)
+  {
+    // The native backend does not reproduce the Plastimatch gamma volume voxel by voxel (candidate positions
+    // outside the compare dose are not considered), so only the pass rates are compared
+    double plastimatchPassFractionPercent = paramNode->GetPassFractionPercent();
+    paramNode->SetGammaBackend(vtkMRMLDoseComparisonNode::NativeGammaBackend);
+    std::string errorMessage = doseComparisonLogic->ComputeGammaDoseDifference(paramNode);
+    if (!errorMessage.empty())
+    {
+      errorStream << "ERROR: Native gamma computation failed: " << errorMessage << std::endl;
+      return EXIT_FAILURE;
+    }
+    int outputDimensions[3] = { 0, 0, 0 };
+    int baselineDimensions[3] = { 0, 0, 0 };
+    outputGammaVolumeNode->GetImageData()->GetDimensions(outputDimensions);
+    baselineGammaVolumeNode->GetImageData()->GetDimensions(baselineDimensions);
+    if ( outputDimensions[0] != baselineDimensions[0] || outputDimensions[1] != baselineDimensions[1]
+      || outputDimensions[2] != baselineDimensions[2] )
+    {
+      errorStream << "ERROR: Native gamma volume geometry does not match the baseline!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    double nativePassFractionPercent = paramNode->GetPassFractionPercent();
+    outputStream << "Pass rate: " << nativePassFractionPercent << " % (native), "
+      << plastimatchPassFractionPercent << " % (Plastimatch)" << std::endl;
+    if (fabs(nativePassFractionPercent - plastimatchPassFractionPercent) > 1.0)
+    {
+      errorStream << "ERROR: Native gamma pass rate differs from the Plastimatch pass rate by more than 1%!" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (TestSyntheticGamma(mrmlScene, doseComparisonLogic) != EXIT_SUCCESS)
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
   return EXIT_SUCCESS;
 }
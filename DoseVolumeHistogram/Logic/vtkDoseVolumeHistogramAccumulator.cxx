@@ -0,0 +1,1121 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  This file was originally developed by Csaba Pinter, PerkLab, Queen's University
+  and was supported through the Applied Cancer Research Unit program of Cancer Care
+  Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
+
+==============================================================================*/
+
+// DoseVolumeHistogram includes
+#include "vtkDoseVolumeHistogramAccumulator.h"
+
+// SlicerRT includes
+#include "SlicerRtCommon.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkDoseVolumeHistogramAccumulator);
+
+//----------------------------------------------------------------------------
+// Accumulation functions
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Number of labels stored in one word of the packed label mask used in multi-label traversal
+  const int LABEL_MASK_WORD_SIZE = 64;
+
+  /// Sum of floating point values using Neumaier's compensated summation.
+  /// The rounding error of each addition is collected in a separate term, so that adding a large number of
+  /// small values (such as voxel fractions) to a large sum does not lose precision.
+  struct CompensatedSum
+  {
+    CompensatedSum()
+      : Sum(0.0)
+      , Compensation(0.0)
+    {
+    }
+
+    void Add(double value)
+    {
+      double sum = this->Sum + value;
+      if (fabs(this->Sum) >= fabs(value))
+      {
+        this->Compensation += (this->Sum - sum) + value;
+      }
+      else
+      {
+        this->Compensation += (value - sum) + this->Sum;
+      }
+      this->Sum = sum;
+    }
+
+    /// Add a sum computed separately (e.g. by another thread)
+    void Add(const CompensatedSum& other)
+    {
+      this->Add(other.Sum);
+      this->Add(other.Compensation);
+    }
+
+    double GetValue() const
+    {
+      return this->Sum + this->Compensation;
+    }
+
+    double Sum;
+    double Compensation;
+  };
+
+  /// Statistics computed for one structure
+  struct LabelmapStatistics
+  {
+    LabelmapStatistics()
+    {
+      this->Reset();
+    }
+
+    void Reset()
+    {
+      this->VoxelCount = 0;
+      this->FractionalVoxelCount = CompensatedSum();
+      this->Sum = CompensatedSum();
+      this->Minimum = VTK_DOUBLE_MAX;
+      this->Maximum = VTK_DOUBLE_MIN;
+      this->VoxelCountBelowStartValue = CompensatedSum();
+      this->HistogramStartValue = 0.0;
+      this->HistogramStepSize = 0.0;
+    }
+
+    vtkIdType VoxelCount;
+    CompensatedSum FractionalVoxelCount;
+    CompensatedSum Sum;
+    double Minimum;
+    double Maximum;
+    CompensatedSum VoxelCountBelowStartValue;
+    double HistogramStartValue;
+    double HistogramStepSize;
+  };
+
+  /// Settings of one traversal of the dose volume within a labelmap
+  struct AccumulatePassParameters
+  {
+    bool ComputeStatistics;
+    bool ComputeHistogram;
+    bool UseFractionalLabelmap;
+    bool UseFastPath;
+    /// Voxels with labelmap value greater or equal than this are in the structure
+    double InsideThreshold;
+    double LabelmapMinimumValue;
+    double LabelmapMaximumValue;
+    double StartValue;
+    double StepSize;
+    int NumberOfBins;
+    /// Extent to traverse (intersection of the dose and labelmap extents)
+    int Extent[6];
+  };
+
+  /// Structure evaluated in a multi-label traversal
+  struct MultiLabelEntry
+  {
+    vtkImageData* Labelmap;
+    const AccumulatePassParameters* Parameters;
+    LabelmapStatistics* Statistics;
+    CompensatedSum* Histogram;
+  };
+
+  //----------------------------------------------------------------------------
+  inline void AccumulateVoxelStatistics(double dose, double fraction, LabelmapStatistics& statistics)
+  {
+    statistics.Sum.Add(dose * fraction);
+    if (dose > statistics.Maximum)
+    {
+      statistics.Maximum = dose;
+    }
+    if (dose < statistics.Minimum)
+    {
+      statistics.Minimum = dose;
+    }
+    ++statistics.VoxelCount;
+    statistics.FractionalVoxelCount.Add(fraction);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Add statistics computed on a part of the dose volume to the statistics of the structure
+  inline void AddStatistics(const LabelmapStatistics& partialStatistics, LabelmapStatistics& statistics)
+  {
+    statistics.VoxelCount += partialStatistics.VoxelCount;
+    statistics.FractionalVoxelCount.Add(partialStatistics.FractionalVoxelCount);
+    statistics.Sum.Add(partialStatistics.Sum);
+    statistics.Minimum = std::min(statistics.Minimum, partialStatistics.Minimum);
+    statistics.Maximum = std::max(statistics.Maximum, partialStatistics.Maximum);
+    statistics.VoxelCountBelowStartValue.Add(partialStatistics.VoxelCountBelowStartValue);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get histogram bin of a dose value. The returned index may be outside the valid bin range.
+  inline int GetHistogramBinIndex(double dose, double startValue, double stepSize)
+  {
+    if (stepSize == 0.0)
+    {
+      return 0;
+    }
+    return vtkMath::Floor((dose - startValue) / stepSize);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine whether a dose value is in the range [0, start value)
+  inline bool IsBelowStartValue(double dose, double startValue)
+  {
+    return (startValue != 0.0 && vtkMath::Floor(dose / startValue) == 0);
+  }
+
+  //----------------------------------------------------------------------------
+  inline int GetLowestSetBitIndex(vtkTypeUInt64 word)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int index = 0;
+    while (!(word & 1))
+    {
+      word >>= 1;
+      ++index;
+    }
+    return index;
+#endif
+  }
+
+  //----------------------------------------------------------------------------
+  /// Optimized version of AccumulateDoseInLabelmap2 for single-component dose volumes and labelmaps (the common case).
+  /// The parameters are read once instead of for each voxel, the division by the labelmap range is replaced by a
+  /// multiplication with its reciprocal, and each row is processed in blocks: the doses, fractions and bin indices of
+  /// a block are computed in simple loops without branches that the compiler can vectorize, then the statistics and
+  /// the histogram are updated in a scalar loop. The bin index is still computed by division with the step size, so
+  /// that the voxels are put into the same bins as by the generic implementation.
+  template <class DoseScalarType, class LabelmapScalarType>
+  void AccumulateDoseInLabelmapSingleComponent( vtkImageData* doseVolume, vtkImageData* labelmap,
+    const AccumulatePassParameters& parameters, LabelmapStatistics& statistics, CompensatedSum* histogram )
+  {
+    const int* extent = parameters.Extent;
+    const bool useFractionalLabelmap = parameters.UseFractionalLabelmap;
+    const bool computeStatistics = parameters.ComputeStatistics;
+    const bool computeHistogram = parameters.ComputeHistogram;
+    const double insideThreshold = parameters.InsideThreshold;
+    const double labelmapMinimumValue = parameters.LabelmapMinimumValue;
+    const double fractionScale = 1.0 / (parameters.LabelmapMaximumValue - parameters.LabelmapMinimumValue);
+    const double startValue = parameters.StartValue;
+    const double stepSize = parameters.StepSize;
+    const int numberOfBins = parameters.NumberOfBins;
+    const int rowLength = extent[1] - extent[0] + 1;
+
+    // Doses, fractions, inside flags and bins of a block of voxels
+    const int blockSize = 256;
+    double doses[blockSize];
+    double fractions[blockSize];
+    unsigned char inside[blockSize];
+    int bins[blockSize];
+
+    for (int z=extent[4]; z<=extent[5]; ++z)
+    {
+      for (int y=extent[2]; y<=extent[3]; ++y)
+      {
+        const DoseScalarType* dosePtr = static_cast<DoseScalarType*>(doseVolume->GetScalarPointer(extent[0], y, z));
+        const LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(extent[0], y, z));
+        for (int blockStart=0; blockStart<rowLength; blockStart+=blockSize)
+        {
+          int blockLength = std::min(blockSize, rowLength - blockStart);
+
+          // Vectorizable part: convert values, compute inside flags, fractions and bin indices
+          for (int i=0; i<blockLength; ++i)
+          {
+            doses[i] = static_cast<double>(dosePtr[i]);
+          }
+          for (int i=0; i<blockLength; ++i)
+          {
+            inside[i] = (static_cast<double>(labelmapPtr[i]) >= insideThreshold);
+          }
+          if (useFractionalLabelmap)
+          {
+            for (int i=0; i<blockLength; ++i)
+            {
+              fractions[i] = (static_cast<double>(labelmapPtr[i]) - labelmapMinimumValue) * fractionScale;
+            }
+          }
+          else
+          {
+            for (int i=0; i<blockLength; ++i)
+            {
+              fractions[i] = 1.0;
+            }
+          }
+          if (computeHistogram && stepSize != 0.0)
+          {
+            for (int i=0; i<blockLength; ++i)
+            {
+              // Same as vtkMath::Floor
+              double binPosition = (doses[i] - startValue) / stepSize;
+              int binIndex = static_cast<int>(binPosition);
+              bins[i] = binIndex - (binIndex > binPosition);
+            }
+          }
+          else
+          {
+            for (int i=0; i<blockLength; ++i)
+            {
+              bins[i] = 0;
+            }
+          }
+          dosePtr += blockLength;
+          labelmapPtr += blockLength;
+
+          // Update statistics and histogram with the voxels in the structure
+          for (int i=0; i<blockLength; ++i)
+          {
+            if (!inside[i])
+            {
+              continue;
+            }
+            double dose = doses[i];
+            double fraction = fractions[i];
+            if (computeStatistics)
+            {
+              AccumulateVoxelStatistics(dose, fraction, statistics);
+            }
+            if (computeHistogram)
+            {
+              if (IsBelowStartValue(dose, startValue))
+              {
+                statistics.VoxelCountBelowStartValue.Add(fraction);
+              }
+              if (bins[i] >= 0 && bins[i] < numberOfBins)
+              {
+                histogram[bins[i]].Add(fraction);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template <class DoseScalarType, class LabelmapScalarType>
+  void AccumulateDoseInLabelmap2( DoseScalarType* vtkNotUsed(doseTypePtr), LabelmapScalarType* vtkNotUsed(labelmapTypePtr),
+    vtkImageData* doseVolume, vtkImageData* labelmap, const AccumulatePassParameters& parameters,
+    LabelmapStatistics& statistics, CompensatedSum* histogram )
+  {
+    const int* extent = parameters.Extent;
+    int doseNumberOfComponents = doseVolume->GetNumberOfScalarComponents();
+    int labelmapNumberOfComponents = labelmap->GetNumberOfScalarComponents();
+    if (parameters.UseFastPath && doseNumberOfComponents == 1 && labelmapNumberOfComponents == 1)
+    {
+      AccumulateDoseInLabelmapSingleComponent<DoseScalarType, LabelmapScalarType>(doseVolume, labelmap, parameters, statistics, histogram);
+      return;
+    }
+    double labelmapRange = parameters.LabelmapMaximumValue - parameters.LabelmapMinimumValue;
+
+    for (int z=extent[4]; z<=extent[5]; ++z)
+    {
+      for (int y=extent[2]; y<=extent[3]; ++y)
+      {
+        DoseScalarType* dosePtr = static_cast<DoseScalarType*>(doseVolume->GetScalarPointer(extent[0], y, z));
+        LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(extent[0], y, z));
+        for (int x=extent[0]; x<=extent[1]; ++x, dosePtr+=doseNumberOfComponents, labelmapPtr+=labelmapNumberOfComponents)
+        {
+          double labelmapValue = static_cast<double>(*labelmapPtr);
+          if (labelmapValue < parameters.InsideThreshold)
+          {
+            continue;
+          }
+
+          double dose = static_cast<double>(*dosePtr);
+          double fraction = 1.0;
+          if (parameters.UseFractionalLabelmap)
+          {
+            fraction = (labelmapValue - parameters.LabelmapMinimumValue) / labelmapRange;
+          }
+
+          if (parameters.ComputeStatistics)
+          {
+            AccumulateVoxelStatistics(dose, fraction, statistics);
+          }
+
+          if (parameters.ComputeHistogram)
+          {
+            if (IsBelowStartValue(dose, parameters.StartValue))
+            {
+              statistics.VoxelCountBelowStartValue.Add(fraction);
+            }
+            int binIndex = GetHistogramBinIndex(dose, parameters.StartValue, parameters.StepSize);
+            if (binIndex >= 0 && binIndex < parameters.NumberOfBins)
+            {
+              histogram[binIndex].Add(fraction);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  template <class DoseScalarType>
+  bool AccumulateDoseInLabelmap1( DoseScalarType* vtkNotUsed(doseTypePtr),
+    vtkImageData* doseVolume, vtkImageData* labelmap, const AccumulatePassParameters& parameters,
+    LabelmapStatistics& statistics, CompensatedSum* histogram )
+  {
+    switch (labelmap->GetScalarType())
+    {
+      vtkTemplateMacro( AccumulateDoseInLabelmap2( (DoseScalarType*)NULL, (VTK_TT*)NULL,
+        doseVolume, labelmap, parameters, statistics, histogram ) );
+      default:
+        return false;
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool AccumulateDoseInLabelmap( vtkImageData* doseVolume, vtkImageData* labelmap, const AccumulatePassParameters& parameters,
+    LabelmapStatistics& statistics, CompensatedSum* histogram )
+  {
+    bool success = false;
+    switch (doseVolume->GetScalarType())
+    {
+      vtkTemplateMacro( success = AccumulateDoseInLabelmap1( (VTK_TT*)NULL,
+        doseVolume, labelmap, parameters, statistics, histogram ) );
+      default:
+        break;
+    }
+    return success;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Set the bit of a structure in the packed label mask for the voxels of one row that are in the structure,
+  /// and store the fraction of these voxels in the fraction row of the structure
+  template <class LabelmapScalarType>
+  void FillLabelMaskRow( LabelmapScalarType* vtkNotUsed(labelmapTypePtr),
+    vtkImageData* labelmap, const AccumulatePassParameters& parameters, int y, int z, int rowStartX,
+    int labelIndex, int numberOfMaskWords, vtkTypeUInt64* maskRow, double* fractionRow )
+  {
+    int labelmapNumberOfComponents = labelmap->GetNumberOfScalarComponents();
+    double labelmapRange = parameters.LabelmapMaximumValue - parameters.LabelmapMinimumValue;
+    int wordIndex = labelIndex / LABEL_MASK_WORD_SIZE;
+    vtkTypeUInt64 labelBit = vtkTypeUInt64(1) << (labelIndex % LABEL_MASK_WORD_SIZE);
+
+    LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(parameters.Extent[0], y, z));
+    for (int x=parameters.Extent[0]; x<=parameters.Extent[1]; ++x, labelmapPtr+=labelmapNumberOfComponents)
+    {
+      double labelmapValue = static_cast<double>(*labelmapPtr);
+      if (labelmapValue < parameters.InsideThreshold)
+      {
+        continue;
+      }
+      int rowIndex = x - rowStartX;
+      maskRow[rowIndex * numberOfMaskWords + wordIndex] |= labelBit;
+      fractionRow[rowIndex] = (parameters.UseFractionalLabelmap ? (labelmapValue - parameters.LabelmapMinimumValue) / labelmapRange : 1.0);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Traverse the dose volume once and accumulate the dose into all the structures containing each voxel.
+  /// The structures are processed row by row: first the structures covering the current row are marked in a
+  /// packed bit mask (one bit per structure for each voxel of the row, so overlapping structures are supported),
+  /// then the dose values of the row are read once and added to the statistics and histograms of the marked structures.
+  template <class DoseScalarType>
+  bool AccumulateDoseInLabelmaps1( DoseScalarType* vtkNotUsed(doseTypePtr),
+    vtkImageData* doseVolume, std::vector<MultiLabelEntry>& entries, const int extent[6],
+    bool computeStatistics, bool computeHistogram, bool sharedHistogramRange )
+  {
+    int doseNumberOfComponents = doseVolume->GetNumberOfScalarComponents();
+    int numberOfLabels = (int)entries.size();
+    int numberOfMaskWords = (numberOfLabels + LABEL_MASK_WORD_SIZE - 1) / LABEL_MASK_WORD_SIZE;
+    int rowLength = extent[1] - extent[0] + 1;
+
+    std::vector<vtkTypeUInt64> maskRow(rowLength * numberOfMaskWords);
+    std::vector<double> fractionRows(rowLength * numberOfLabels);
+
+    for (int z=extent[4]; z<=extent[5]; ++z)
+    {
+      for (int y=extent[2]; y<=extent[3]; ++y)
+      {
+        // Mark the voxels of the structures in the packed label mask
+        bool rowContainsLabels = false;
+        std::fill(maskRow.begin(), maskRow.end(), 0);
+        for (int labelIndex=0; labelIndex<numberOfLabels; ++labelIndex)
+        {
+          MultiLabelEntry& entry = entries[labelIndex];
+          const int* labelExtent = entry.Parameters->Extent;
+          if (y < labelExtent[2] || y > labelExtent[3] || z < labelExtent[4] || z > labelExtent[5])
+          {
+            continue;
+          }
+          switch (entry.Labelmap->GetScalarType())
+          {
+            vtkTemplateMacro( FillLabelMaskRow( (VTK_TT*)NULL, entry.Labelmap, *entry.Parameters, y, z, extent[0],
+              labelIndex, numberOfMaskWords, &(maskRow[0]), &(fractionRows[labelIndex * rowLength]) ) );
+            default:
+              return false;
+          }
+          rowContainsLabels = true;
+        }
+        if (!rowContainsLabels)
+        {
+          continue;
+        }
+
+        // Accumulate dose into the marked structures
+        DoseScalarType* dosePtr = static_cast<DoseScalarType*>(doseVolume->GetScalarPointer(extent[0], y, z));
+        for (int rowIndex=0; rowIndex<rowLength; ++rowIndex, dosePtr+=doseNumberOfComponents)
+        {
+          const vtkTypeUInt64* voxelMask = &(maskRow[rowIndex * numberOfMaskWords]);
+          bool voxelContainsLabels = false;
+          for (int wordIndex=0; wordIndex<numberOfMaskWords; ++wordIndex)
+          {
+            if (voxelMask[wordIndex])
+            {
+              voxelContainsLabels = true;
+              break;
+            }
+          }
+          if (!voxelContainsLabels)
+          {
+            continue;
+          }
+
+          double dose = static_cast<double>(*dosePtr);
+
+          // If the histogram range is the same for all structures then the bin is only computed once
+          int sharedBinIndex = 0;
+          bool sharedBelowStartValue = false;
+          if (computeHistogram && sharedHistogramRange)
+          {
+            const AccumulatePassParameters& parameters = *(entries[0].Parameters);
+            sharedBinIndex = GetHistogramBinIndex(dose, parameters.StartValue, parameters.StepSize);
+            sharedBelowStartValue = IsBelowStartValue(dose, parameters.StartValue);
+          }
+
+          for (int wordIndex=0; wordIndex<numberOfMaskWords; ++wordIndex)
+          {
+            vtkTypeUInt64 word = voxelMask[wordIndex];
+            while (word)
+            {
+              int labelIndex = wordIndex * LABEL_MASK_WORD_SIZE + GetLowestSetBitIndex(word);
+              word &= word - 1; // Clear lowest set bit
+
+              MultiLabelEntry& entry = entries[labelIndex];
+              double fraction = fractionRows[labelIndex * rowLength + rowIndex];
+              if (computeStatistics)
+              {
+                AccumulateVoxelStatistics(dose, fraction, *entry.Statistics);
+              }
+              if (computeHistogram)
+              {
+                const AccumulatePassParameters& parameters = *entry.Parameters;
+                int binIndex = sharedBinIndex;
+                bool belowStartValue = sharedBelowStartValue;
+                if (!sharedHistogramRange)
+                {
+                  binIndex = GetHistogramBinIndex(dose, parameters.StartValue, parameters.StepSize);
+                  belowStartValue = IsBelowStartValue(dose, parameters.StartValue);
+                }
+                if (belowStartValue)
+                {
+                  entry.Statistics->VoxelCountBelowStartValue.Add(fraction);
+                }
+                if (binIndex >= 0 && binIndex < parameters.NumberOfBins)
+                {
+                  entry.Histogram[binIndex].Add(fraction);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  bool AccumulateDoseInLabelmaps( vtkImageData* doseVolume, std::vector<MultiLabelEntry>& entries, const int extent[6],
+    bool computeStatistics, bool computeHistogram, bool sharedHistogramRange )
+  {
+    bool success = false;
+    switch (doseVolume->GetScalarType())
+    {
+      vtkTemplateMacro( success = AccumulateDoseInLabelmaps1( (VTK_TT*)NULL,
+        doseVolume, entries, extent, computeStatistics, computeHistogram, sharedHistogramRange ) );
+      default:
+        break;
+    }
+    return success;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Statistics and histograms of the structures accumulated by one thread
+  struct PartialResults
+  {
+    std::vector<LabelmapStatistics> Statistics;
+    std::vector<CompensatedSum> Histograms;
+    bool Success;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Functor accumulating the dose of a range of slices of the traversal extent, used with vtkSMPTools.
+  /// Each thread accumulates into its own statistics and histograms, which are added to the results
+  /// of the structures in Reduce. The structures are evaluated either one by one (only one entry is given)
+  /// or all together in a multi-label traversal.
+  class AccumulateSlicesFunctor
+  {
+  public:
+    AccumulateSlicesFunctor(vtkImageData* doseVolume, std::vector<MultiLabelEntry>& entries, const int extent[6],
+      bool multiLabelTraversal, bool computeStatistics, bool computeHistogram, bool sharedHistogramRange)
+      : DoseVolume(doseVolume)
+      , Entries(entries)
+      , MultiLabelTraversal(multiLabelTraversal)
+      , ComputeStatistics(computeStatistics)
+      , ComputeHistogram(computeHistogram)
+      , SharedHistogramRange(sharedHistogramRange)
+      , Success(true)
+    {
+      std::copy(extent, extent+6, this->Extent);
+    }
+
+    /// Number of slices in the traversal extent. The slices are the units of work distributed between the threads.
+    vtkIdType GetNumberOfSlices()
+    {
+      return this->Extent[5] - this->Extent[4] + 1;
+    }
+
+    void Initialize()
+    {
+      PartialResults& partialResults = this->ThreadResults.Local();
+      int numberOfBins = this->Entries[0].Parameters->NumberOfBins;
+      partialResults.Statistics.assign(this->Entries.size(), LabelmapStatistics());
+      partialResults.Histograms.assign(this->Entries.size() * numberOfBins, CompensatedSum());
+      partialResults.Success = true;
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      PartialResults& partialResults = this->ThreadResults.Local();
+      int numberOfBins = this->Entries[0].Parameters->NumberOfBins;
+      int extent[6] = { this->Extent[0], this->Extent[1], this->Extent[2], this->Extent[3],
+        this->Extent[4] + static_cast<int>(beginSlice), this->Extent[4] + static_cast<int>(endSlice) - 1 };
+
+      if (!this->MultiLabelTraversal)
+      {
+        MultiLabelEntry& entry = this->Entries[0];
+        AccumulatePassParameters parameters = *entry.Parameters;
+        std::copy(extent, extent+6, parameters.Extent);
+        if (!AccumulateDoseInLabelmap(this->DoseVolume, entry.Labelmap, parameters, partialResults.Statistics[0], &(partialResults.Histograms[0])))
+        {
+          partialResults.Success = false;
+        }
+        return;
+      }
+
+      std::vector<MultiLabelEntry> threadEntries(this->Entries);
+      for (unsigned int entryIndex=0; entryIndex<threadEntries.size(); ++entryIndex)
+      {
+        threadEntries[entryIndex].Statistics = &(partialResults.Statistics[entryIndex]);
+        threadEntries[entryIndex].Histogram = &(partialResults.Histograms[entryIndex * numberOfBins]);
+      }
+      if (!AccumulateDoseInLabelmaps(this->DoseVolume, threadEntries, extent,
+        this->ComputeStatistics, this->ComputeHistogram, this->SharedHistogramRange))
+      {
+        partialResults.Success = false;
+      }
+    }
+
+    void Reduce()
+    {
+      int numberOfBins = this->Entries[0].Parameters->NumberOfBins;
+      for (vtkSMPThreadLocal<PartialResults>::iterator resultsIt = this->ThreadResults.begin(); resultsIt != this->ThreadResults.end(); ++resultsIt)
+      {
+        PartialResults& partialResults = (*resultsIt);
+        this->Success = this->Success && partialResults.Success;
+        for (unsigned int entryIndex=0; entryIndex<this->Entries.size(); ++entryIndex)
+        {
+          MultiLabelEntry& entry = this->Entries[entryIndex];
+          AddStatistics(partialResults.Statistics[entryIndex], *entry.Statistics);
+          const CompensatedSum* partialHistogram = &(partialResults.Histograms[entryIndex * numberOfBins]);
+          for (int binIndex=0; binIndex<numberOfBins; ++binIndex)
+          {
+            entry.Histogram[binIndex].Add(partialHistogram[binIndex]);
+          }
+        }
+      }
+    }
+
+    bool GetSuccess()
+    {
+      return this->Success;
+    }
+
+  private:
+    vtkImageData* DoseVolume;
+    std::vector<MultiLabelEntry>& Entries;
+    int Extent[6];
+    bool MultiLabelTraversal;
+    bool ComputeStatistics;
+    bool ComputeHistogram;
+    bool SharedHistogramRange;
+    bool Success;
+    vtkSMPThreadLocal<PartialResults> ThreadResults;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Accumulate dose into the given structures, splitting the slices of the traversal extent between threads
+  bool AccumulateDoseInParallel( vtkImageData* doseVolume, std::vector<MultiLabelEntry>& entries, const int extent[6],
+    bool multiLabelTraversal, bool computeStatistics, bool computeHistogram, bool sharedHistogramRange, int numberOfThreads )
+  {
+    AccumulateSlicesFunctor functor(doseVolume, entries, extent, multiLabelTraversal, computeStatistics, computeHistogram, sharedHistogramRange);
+    SlicerRtCommon::SmpFor(0, functor.GetNumberOfSlices(), 1, functor, numberOfThreads);
+    return functor.GetSuccess();
+  }
+}
+
+//----------------------------------------------------------------------------
+class vtkDoseVolumeHistogramAccumulator::vtkInternal
+{
+public:
+  /// Input labelmap and computed results for one structure
+  struct LabelmapEntry
+  {
+    LabelmapEntry()
+      : MinimumValue(0.0)
+      , MaximumValue(1.0)
+      , EmptyExtent(true)
+    {
+    }
+
+    vtkSmartPointer<vtkImageData> Labelmap;
+    double MinimumValue;
+    double MaximumValue;
+
+    /// Traversal parameters, set up at the beginning of each update
+    AccumulatePassParameters Parameters;
+    /// Flag indicating that the labelmap does not overlap with the dose volume
+    bool EmptyExtent;
+
+    LabelmapStatistics Statistics;
+    /// Histogram bins accumulated with compensated summation, copied to Histogram after the update
+    std::vector<CompensatedSum> CompensatedHistogram;
+    vtkSmartPointer<vtkDoubleArray> Histogram;
+  };
+
+public:
+  /// Get labelmap entry with index check
+  LabelmapEntry* GetEntry(int labelmapIndex)
+  {
+    if (labelmapIndex < 0 || labelmapIndex >= (int)this->Labelmaps.size())
+    {
+      return NULL;
+    }
+    return &(this->Labelmaps[labelmapIndex]);
+  }
+
+public:
+  vtkSmartPointer<vtkImageData> DoseVolume;
+  std::vector<LabelmapEntry> Labelmaps;
+};
+
+//----------------------------------------------------------------------------
+vtkDoseVolumeHistogramAccumulator::vtkDoseVolumeHistogramAccumulator()
+{
+  this->UseFractionalLabelmap = false;
+  this->AutomaticHistogramRange = false;
+  this->StartValue = 0.0;
+  this->StepSize = 1.0;
+  this->NumberOfBins = 1;
+  this->MultiLabelTraversal = false;
+  this->UseFastPath = true;
+  this->NumberOfThreads = 0;
+
+  this->Internal = new vtkInternal();
+}
+
+//----------------------------------------------------------------------------
+vtkDoseVolumeHistogramAccumulator::~vtkDoseVolumeHistogramAccumulator()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkDoseVolumeHistogramAccumulator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "UseFractionalLabelmap: " << (this->UseFractionalLabelmap ? "true" : "false") << "\n";
+  os << indent << "AutomaticHistogramRange: " << (this->AutomaticHistogramRange ? "true" : "false") << "\n";
+  os << indent << "StartValue: " << this->StartValue << "\n";
+  os << indent << "StepSize: " << this->StepSize << "\n";
+  os << indent << "NumberOfBins: " << this->NumberOfBins << "\n";
+  os << indent << "MultiLabelTraversal: " << (this->MultiLabelTraversal ? "true" : "false") << "\n";
+  os << indent << "UseFastPath: " << (this->UseFastPath ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfLabelmaps: " << this->Internal->Labelmaps.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkDoseVolumeHistogramAccumulator::SetDoseVolume(vtkImageData* doseVolume)
+{
+  if (this->Internal->DoseVolume.GetPointer() == doseVolume)
+  {
+    return;
+  }
+  this->Internal->DoseVolume = doseVolume;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkDoseVolumeHistogramAccumulator::GetDoseVolume()
+{
+  return this->Internal->DoseVolume;
+}
+
+//----------------------------------------------------------------------------
+int vtkDoseVolumeHistogramAccumulator::AddLabelmap(vtkImageData* labelmap, double minimumValue/*=0.0*/, double maximumValue/*=1.0*/)
+{
+  if (!labelmap)
+  {
+    vtkErrorMacro("AddLabelmap: Invalid labelmap");
+    return -1;
+  }
+
+  vtkInternal::LabelmapEntry entry;
+  entry.Labelmap = labelmap;
+  entry.MinimumValue = minimumValue;
+  entry.MaximumValue = maximumValue;
+  this->Internal->Labelmaps.push_back(entry);
+  this->Modified();
+
+  return (int)this->Internal->Labelmaps.size() - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkDoseVolumeHistogramAccumulator::RemoveAllLabelmaps()
+{
+  this->Internal->Labelmaps.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkDoseVolumeHistogramAccumulator::GetNumberOfLabelmaps()
+{
+  return (int)this->Internal->Labelmaps.size();
+}
+
+//----------------------------------------------------------------------------
+bool vtkDoseVolumeHistogramAccumulator::Update()
+{
+  vtkImageData* doseVolume = this->Internal->DoseVolume;
+  if (!doseVolume || !doseVolume->GetPointData() || !doseVolume->GetPointData()->GetScalars())
+  {
+    vtkErrorMacro("Update: Invalid dose volume");
+    return false;
+  }
+  if (this->NumberOfBins < 1)
+  {
+    vtkErrorMacro("Update: Invalid number of bins " << this->NumberOfBins);
+    return false;
+  }
+
+  int doseExtent[6] = {0,-1,0,-1,0,-1};
+  doseVolume->GetExtent(doseExtent);
+
+  // Reset results and set up traversal parameters
+  for (std::vector<vtkInternal::LabelmapEntry>::iterator entryIt = this->Internal->Labelmaps.begin();
+    entryIt != this->Internal->Labelmaps.end(); ++entryIt)
+  {
+    vtkInternal::LabelmapEntry& entry = (*entryIt);
+    LabelmapStatistics& statistics = entry.Statistics;
+    statistics.Reset();
+    statistics.HistogramStartValue = this->StartValue;
+    statistics.HistogramStepSize = this->StepSize;
+    entry.Histogram = vtkSmartPointer<vtkDoubleArray>::New();
+    entry.Histogram->SetNumberOfTuples(this->NumberOfBins);
+    entry.Histogram->FillComponent(0, 0.0);
+    entry.CompensatedHistogram.assign(this->NumberOfBins, CompensatedSum());
+
+    vtkImageData* labelmap = entry.Labelmap;
+    if (!labelmap->GetPointData() || !labelmap->GetPointData()->GetScalars())
+    {
+      vtkErrorMacro("Update: Invalid labelmap");
+      return false;
+    }
+
+    AccumulatePassParameters& parameters = entry.Parameters;
+    parameters.ComputeStatistics = true;
+    parameters.ComputeHistogram = !this->AutomaticHistogramRange;
+    parameters.UseFractionalLabelmap = this->UseFractionalLabelmap;
+    parameters.UseFastPath = this->UseFastPath;
+    parameters.LabelmapMinimumValue = entry.MinimumValue;
+    parameters.LabelmapMaximumValue = entry.MaximumValue;
+    // Foreground voxels are all those with an intensity >0 (or above the minimum value for fractional labelmaps).
+    // Use >=epsilon to be consistent with the previously used vtkImageToImageStencil thresholding.
+    parameters.InsideThreshold = (this->UseFractionalLabelmap ? entry.MinimumValue + 1e-10 : 1e-10);
+    parameters.NumberOfBins = this->NumberOfBins;
+    parameters.StartValue = this->StartValue;
+    parameters.StepSize = this->StepSize;
+
+    // Only the intersection of the dose and labelmap extent is evaluated
+    int labelmapExtent[6] = {0,-1,0,-1,0,-1};
+    labelmap->GetExtent(labelmapExtent);
+    entry.EmptyExtent = false;
+    for (int axis=0; axis<3; ++axis)
+    {
+      parameters.Extent[axis*2] = std::max(doseExtent[axis*2], labelmapExtent[axis*2]);
+      parameters.Extent[axis*2+1] = std::min(doseExtent[axis*2+1], labelmapExtent[axis*2+1]);
+      if (parameters.Extent[axis*2] > parameters.Extent[axis*2+1])
+      {
+        // The structure and the dose volume do not overlap, results are empty
+        entry.EmptyExtent = true;
+      }
+    }
+  }
+
+  bool success = true;
+  if (this->MultiLabelTraversal && this->Internal->Labelmaps.size() > 1)
+  {
+    success = this->AccumulateAllLabelmaps();
+  }
+  else
+  {
+    for (int labelmapIndex=0; labelmapIndex<(int)this->Internal->Labelmaps.size(); ++labelmapIndex)
+    {
+      if (!this->AccumulateLabelmap(labelmapIndex))
+      {
+        success = false;
+        break;
+      }
+    }
+  }
+
+  // Store the accumulated histograms in the output arrays
+  for (std::vector<vtkInternal::LabelmapEntry>::iterator entryIt = this->Internal->Labelmaps.begin();
+    entryIt != this->Internal->Labelmaps.end(); ++entryIt)
+  {
+    vtkInternal::LabelmapEntry& entry = (*entryIt);
+    for (int binIndex=0; binIndex<this->NumberOfBins; ++binIndex)
+    {
+      entry.Histogram->SetValue(binIndex, entry.CompensatedHistogram[binIndex].GetValue());
+    }
+  }
+
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool vtkDoseVolumeHistogramAccumulator::AccumulateLabelmap(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry& entry = this->Internal->Labelmaps[labelmapIndex];
+  if (entry.EmptyExtent)
+  {
+    return true;
+  }
+
+  vtkImageData* doseVolume = this->Internal->DoseVolume;
+  AccumulatePassParameters& parameters = entry.Parameters;
+  LabelmapStatistics& statistics = entry.Statistics;
+
+  std::vector<MultiLabelEntry> entries(1);
+  entries[0].Labelmap = entry.Labelmap;
+  entries[0].Parameters = &parameters;
+  entries[0].Statistics = &statistics;
+  entries[0].Histogram = &(entry.CompensatedHistogram[0]);
+
+  // Compute everything in one traversal, unless the histogram range is automatic
+  if (!AccumulateDoseInParallel(doseVolume, entries, parameters.Extent, false,
+    parameters.ComputeStatistics, parameters.ComputeHistogram, true, this->NumberOfThreads))
+  {
+    vtkErrorMacro("AccumulateLabelmap: Unsupported scalar type in dose volume or labelmap");
+    return false;
+  }
+
+  if (this->AutomaticHistogramRange && statistics.VoxelCount > 0)
+  {
+    // The histogram range is determined by the values in the structure, so the statistics needed to be computed first
+    parameters.ComputeStatistics = false;
+    parameters.ComputeHistogram = true;
+    parameters.StartValue = statistics.Minimum;
+    parameters.StepSize = (this->NumberOfBins > 1 ? (statistics.Maximum - statistics.Minimum) / (double)(this->NumberOfBins-1) : 0.0);
+    statistics.HistogramStartValue = parameters.StartValue;
+    statistics.HistogramStepSize = parameters.StepSize;
+    AccumulateDoseInParallel(doseVolume, entries, parameters.Extent, false,
+      parameters.ComputeStatistics, parameters.ComputeHistogram, true, this->NumberOfThreads);
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkDoseVolumeHistogramAccumulator::AccumulateAllLabelmaps()
+{
+  // Collect structures overlapping with the dose volume, and the union of their extents
+  std::vector<MultiLabelEntry> entries;
+  int traversalExtent[6] = {VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN};
+  for (std::vector<vtkInternal::LabelmapEntry>::iterator entryIt = this->Internal->Labelmaps.begin();
+    entryIt != this->Internal->Labelmaps.end(); ++entryIt)
+  {
+    vtkInternal::LabelmapEntry& labelmapEntry = (*entryIt);
+    if (labelmapEntry.EmptyExtent)
+    {
+      continue;
+    }
+    MultiLabelEntry entry;
+    entry.Labelmap = labelmapEntry.Labelmap;
+    entry.Parameters = &(labelmapEntry.Parameters);
+    entry.Statistics = &(labelmapEntry.Statistics);
+    entry.Histogram = &(labelmapEntry.CompensatedHistogram[0]);
+    entries.push_back(entry);
+
+    for (int axis=0; axis<3; ++axis)
+    {
+      traversalExtent[axis*2] = std::min(traversalExtent[axis*2], labelmapEntry.Parameters.Extent[axis*2]);
+      traversalExtent[axis*2+1] = std::max(traversalExtent[axis*2+1], labelmapEntry.Parameters.Extent[axis*2+1]);
+    }
+  }
+  if (entries.empty())
+  {
+    return true;
+  }
+
+  vtkImageData* doseVolume = this->Internal->DoseVolume;
+  if (!this->AutomaticHistogramRange)
+  {
+    // Compute everything in one traversal
+    if (!AccumulateDoseInParallel(doseVolume, entries, traversalExtent, true, true, true, true, this->NumberOfThreads))
+    {
+      vtkErrorMacro("AccumulateAllLabelmaps: Unsupported scalar type in dose volume or labelmap");
+      return false;
+    }
+    return true;
+  }
+
+  // The histogram range is determined by the values in each structure, so the statistics need to be computed first
+  if (!AccumulateDoseInParallel(doseVolume, entries, traversalExtent, true, true, false, false, this->NumberOfThreads))
+  {
+    vtkErrorMacro("AccumulateAllLabelmaps: Unsupported scalar type in dose volume or labelmap");
+    return false;
+  }
+  std::vector<MultiLabelEntry> nonEmptyEntries;
+  for (std::vector<vtkInternal::LabelmapEntry>::iterator entryIt = this->Internal->Labelmaps.begin();
+    entryIt != this->Internal->Labelmaps.end(); ++entryIt)
+  {
+    vtkInternal::LabelmapEntry& labelmapEntry = (*entryIt);
+    LabelmapStatistics& statistics = labelmapEntry.Statistics;
+    if (labelmapEntry.EmptyExtent || statistics.VoxelCount < 1)
+    {
+      continue;
+    }
+    AccumulatePassParameters& parameters = labelmapEntry.Parameters;
+    parameters.StartValue = statistics.Minimum;
+    parameters.StepSize = (this->NumberOfBins > 1 ? (statistics.Maximum - statistics.Minimum) / (double)(this->NumberOfBins-1) : 0.0);
+    statistics.HistogramStartValue = parameters.StartValue;
+    statistics.HistogramStepSize = parameters.StepSize;
+
+    MultiLabelEntry entry;
+    entry.Labelmap = labelmapEntry.Labelmap;
+    entry.Parameters = &parameters;
+    entry.Statistics = &statistics;
+    entry.Histogram = &(labelmapEntry.CompensatedHistogram[0]);
+    nonEmptyEntries.push_back(entry);
+  }
+  if (!nonEmptyEntries.empty())
+  {
+    AccumulateDoseInParallel(doseVolume, nonEmptyEntries, traversalExtent, true, false, true, false, this->NumberOfThreads);
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkDoseVolumeHistogramAccumulator::GetVoxelCount(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.VoxelCount : 0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetFractionalVoxelCount(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.FractionalVoxelCount.GetValue() : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetMinimum(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.Minimum : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetMaximum(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.Maximum : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetMean(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  if (!entry || entry->Statistics.FractionalVoxelCount.GetValue() == 0.0)
+  {
+    return 0.0;
+  }
+  return entry->Statistics.Sum.GetValue() / entry->Statistics.FractionalVoxelCount.GetValue();
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetVoxelCountBelowStartValue(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.VoxelCountBelowStartValue.GetValue() : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetHistogramStartValue(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.HistogramStartValue : 0.0);
+}
+
+//----------------------------------------------------------------------------
+double vtkDoseVolumeHistogramAccumulator::GetHistogramStepSize(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Statistics.HistogramStepSize : 0.0);
+}
+
+//----------------------------------------------------------------------------
+vtkDoubleArray* vtkDoseVolumeHistogramAccumulator::GetHistogram(int labelmapIndex)
+{
+  vtkInternal::LabelmapEntry* entry = this->Internal->GetEntry(labelmapIndex);
+  return (entry ? entry->Histogram.GetPointer() : NULL);
+}
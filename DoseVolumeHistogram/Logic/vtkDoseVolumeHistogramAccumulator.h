@@ -0,0 +1,201 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  This file was originally developed by Csaba Pinter, PerkLab, Queen's University
+  and was supported through the Applied Cancer Research Unit program of Cancer Care
+  Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
+
+==============================================================================*/
+
+#ifndef __vtkDoseVolumeHistogramAccumulator_h
+#define __vtkDoseVolumeHistogramAccumulator_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerDoseVolumeHistogramModuleLogicExport.h"
+
+class vtkImageData;
+class vtkDoubleArray;
+
+/// \ingroup SlicerRt_QtModules_DoseVolumeHistogram
+/// \brief Compute the statistics and histogram of a dose volume within one or more structure labelmaps.
+///
+/// For each added labelmap the dose volume is traversed only once, and the voxel count, the (fractional) volume,
+/// the minimum, maximum and mean dose, the number of voxels below the histogram start value, and the dose
+/// histogram are computed together. This replaces building a stencil from the labelmap and updating
+/// vtkImageAccumulate several times with different bin settings.
+///
+/// The labelmaps need to have the same lattice (origin, spacing, directions) as the dose volume, but
+/// their extents may differ: only the intersection of the two extents is evaluated, the rest of the
+/// labelmap is considered to be outside the structure. A voxel is inside the structure if its labelmap
+/// value is at least the minimum labelmap value plus a small epsilon (zero in case of binary labelmaps).
+/// In fractional mode the voxels are weighted by their fraction between the minimum and maximum labelmap value.
+///
+/// If the histogram range is automatic (e.g. for intensity volume histograms), then the histogram starts at
+/// the minimum value in the structure, and the range up to the maximum is divided to the given number of bins.
+/// As the range is only known after evaluating the statistics, two traversals are needed in this case.
+///
+/// The slices of the dose volume can be traversed by multiple threads, see \sa NumberOfThreads.
+class VTK_SLICER_DOSEVOLUMEHISTOGRAM_LOGIC_EXPORT vtkDoseVolumeHistogramAccumulator : public vtkObject
+{
+public:
+  static vtkDoseVolumeHistogramAccumulator *New();
+  vtkTypeMacro(vtkDoseVolumeHistogramAccumulator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+public:
+  /// Set dose volume to compute the histograms on
+  void SetDoseVolume(vtkImageData* doseVolume);
+  /// Get dose volume to compute the histograms on
+  vtkImageData* GetDoseVolume();
+
+  /// Add structure labelmap. Its lattice needs to be the same as the dose volume's.
+  /// \param labelmap Binary or fractional labelmap of the structure
+  /// \param minimumValue Labelmap value meaning no coverage (only used for fractional labelmaps)
+  /// \param maximumValue Labelmap value meaning full coverage (only used for fractional labelmaps)
+  /// \return Index of the added labelmap
+  int AddLabelmap(vtkImageData* labelmap, double minimumValue=0.0, double maximumValue=1.0);
+
+  /// Remove all labelmaps and results
+  void RemoveAllLabelmaps();
+
+  /// Get number of added labelmaps
+  int GetNumberOfLabelmaps();
+
+  /// Compute statistics and histograms for all added labelmaps
+  /// \return Success flag
+  bool Update();
+
+  /// Get number of voxels in the structure
+  vtkIdType GetVoxelCount(int labelmapIndex);
+  /// Get volume of the structure in voxels. Equals the voxel count for binary labelmaps,
+  /// and the sum of the voxel fractions for fractional labelmaps.
+  double GetFractionalVoxelCount(int labelmapIndex);
+  /// Get minimum dose in the structure
+  double GetMinimum(int labelmapIndex);
+  /// Get maximum dose in the structure
+  double GetMaximum(int labelmapIndex);
+  /// Get mean dose in the structure (weighted by the voxel fractions for fractional labelmaps)
+  double GetMean(int labelmapIndex);
+  /// Get (fractional) number of voxels below the histogram start value, i.e. with a dose in the
+  /// range [0, start value) (same as the first bin of a histogram starting at 0 with the start value as bin width)
+  double GetVoxelCountBelowStartValue(int labelmapIndex);
+  /// Get histogram start value for a labelmap (differs from \sa StartValue in case of automatic histogram range)
+  double GetHistogramStartValue(int labelmapIndex);
+  /// Get histogram bin width for a labelmap (differs from \sa StepSize in case of automatic histogram range)
+  double GetHistogramStepSize(int labelmapIndex);
+  /// Get (fractional) number of voxels in each histogram bin. The array has \sa NumberOfBins values.
+  vtkDoubleArray* GetHistogram(int labelmapIndex);
+
+public:
+  /// Get flag telling whether the labelmaps are fractional
+  vtkGetMacro(UseFractionalLabelmap, bool);
+  /// Set flag telling whether the labelmaps are fractional
+  vtkSetMacro(UseFractionalLabelmap, bool);
+  /// Set flag telling whether the labelmaps are fractional
+  vtkBooleanMacro(UseFractionalLabelmap, bool);
+
+  /// Get flag telling whether the histogram range is determined from the value range within each structure
+  vtkGetMacro(AutomaticHistogramRange, bool);
+  /// Set flag telling whether the histogram range is determined from the value range within each structure
+  vtkSetMacro(AutomaticHistogramRange, bool);
+  /// Set flag telling whether the histogram range is determined from the value range within each structure
+  vtkBooleanMacro(AutomaticHistogramRange, bool);
+
+  /// Get start value (lower bound of the first bin) of the histogram
+  vtkGetMacro(StartValue, double);
+  /// Set start value (lower bound of the first bin) of the histogram
+  vtkSetMacro(StartValue, double);
+
+  /// Get width of the histogram bins
+  vtkGetMacro(StepSize, double);
+  /// Set width of the histogram bins
+  vtkSetMacro(StepSize, double);
+
+  /// Get number of histogram bins
+  vtkGetMacro(NumberOfBins, int);
+  /// Set number of histogram bins
+  vtkSetMacro(NumberOfBins, int);
+
+  /// Get flag telling whether all labelmaps are evaluated in one traversal of the dose volume
+  vtkGetMacro(MultiLabelTraversal, bool);
+  /// Set flag telling whether all labelmaps are evaluated in one traversal of the dose volume
+  vtkSetMacro(MultiLabelTraversal, bool);
+  /// Set flag telling whether all labelmaps are evaluated in one traversal of the dose volume
+  vtkBooleanMacro(MultiLabelTraversal, bool);
+
+  /// Get flag telling whether the optimized implementation is used for single-component images
+  vtkGetMacro(UseFastPath, bool);
+  /// Set flag telling whether the optimized implementation is used for single-component images
+  vtkSetMacro(UseFastPath, bool);
+  /// Set flag telling whether the optimized implementation is used for single-component images
+  vtkBooleanMacro(UseFastPath, bool);
+
+  /// Get number of threads used for traversing the dose volume
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used for traversing the dose volume. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+
+protected:
+  /// Flag telling whether the labelmaps are fractional
+  bool UseFractionalLabelmap;
+
+  /// Flag telling whether the histogram range is determined from the value range within each structure.
+  /// If on, then \sa StartValue and \sa StepSize are ignored.
+  bool AutomaticHistogramRange;
+
+  /// Start value (lower bound of the first bin) of the histogram
+  double StartValue;
+
+  /// Width of the histogram bins
+  double StepSize;
+
+  /// Number of histogram bins
+  int NumberOfBins;
+
+  /// Flag telling whether all labelmaps are evaluated in one traversal of the dose volume.
+  /// If on, then for each row of the dose volume the structures containing each voxel are marked in a packed
+  /// bit mask (so overlapping structures are supported), and the dose of each voxel is read and binned once
+  /// for all the structures. If off (default), then the dose volume is traversed separately for each labelmap.
+  bool MultiLabelTraversal;
+
+  /// Flag telling whether the optimized implementation is used for single-component images (on by default).
+  /// The generic implementation is kept for multi-component images and for comparison.
+  bool UseFastPath;
+
+  /// Number of threads used for traversing the dose volume. The slices are split between the threads, each
+  /// thread accumulates into its own statistics and histograms, which are added up at the end.
+  /// 0 (default) uses the current vtkSMPTools setting, 1 traverses the dose volume in the calling thread.
+  int NumberOfThreads;
+
+protected:
+  /// Accumulate dose in one labelmap
+  bool AccumulateLabelmap(int labelmapIndex);
+  /// Accumulate dose in all labelmaps in one traversal of the dose volume
+  bool AccumulateAllLabelmaps();
+
+protected:
+  vtkDoseVolumeHistogramAccumulator();
+  virtual ~vtkDoseVolumeHistogramAccumulator();
+
+private:
+  vtkDoseVolumeHistogramAccumulator(const vtkDoseVolumeHistogramAccumulator&); // Not implemented
+  void operator=(const vtkDoseVolumeHistogramAccumulator&); // Not implemented
+
+  class vtkInternal;
+  vtkInternal* Internal;
+};
+
+#endif
@@ -21,10 +21,10 @@
 // DoseVolumeHistogram includes
 #include "vtkMRMLDoseVolumeHistogramNode.h"
 #include "vtkSlicerDoseVolumeHistogramModuleLogic.h"
+#include "vtkDoseVolumeHistogramAccumulator.h"
 
 // SlicerRT includes
 #include "SlicerRtCommon.h"
-#include "vtkFractionalImageAccumulate.h"
 
 // Segmentations includes
 #include "vtkMRMLSegmentationNode.h"
@@ -52,15 +52,12 @@
 
 // VTK includes
 #include <vtkImageAccumulate.h>
-#include <vtkImageStencilData.h>
-#include <vtkImageToImageStencil.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPiecewiseFunction.h>
 #include <vtkDoubleArray.h>
 #include <vtkStringArray.h>
 #include <vtkBitArray.h>
-#include <vtkImageConstantPad.h>
 #include <vtkMath.h>
 #include <vtkTable.h>
 #include <vtkTimerLog.h>
@@ -68,12 +65,24 @@
 #include <vtkDelimitedTextWriter.h>
 #include <vtkWeakPointer.h>
 #include <vtkFieldData.h>
+#include <vtkImageClip.h>
+#include <vtkMatrix4x4.h>
+#include <vtkAtomic.h>
+#include <vtkMultiThreader.h>
+
+// MRML includes
+#include <vtkMRMLTransformNode.h>
 
 // VTKSYS includes
+#include <vtksys/SystemInformation.hxx>
 #include <vtksys/SystemTools.hxx>
 
 // STD includes
+#include <algorithm>
+#include <iomanip>
+#include <map>
 #include <set>
+#include <vector>
 
 //----------------------------------------------------------------------------
 const std::string vtkSlicerDoseVolumeHistogramModuleLogic::DVH_DVH_IDENTIFIER_ATTRIBUTE_NAME = vtkMRMLDoseVolumeHistogramNode::DVH_ATTRIBUTE_PREFIX + "DVH"; // Identifier
@@ -99,6 +108,703 @@ const std::string vtkSlicerDoseVolumeHistogramModuleLogic::DVH_CSV_HEADER_VOLUME
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDoseVolumeHistogramModuleLogic);
 
+//---------------------------------------------------------------------------
+// Helper classes for computing the DVH of multiple segments
+//---------------------------------------------------------------------------
+namespace
+{
+  //---------------------------------------------------------------------------
+  // Settings that are shared by the DVH computation of all the segments
+  struct DvhComputationSettings
+  {
+    bool UseFractionalLabelmap;
+    bool AutomaticOversampling;
+    bool IsDoseVolume;
+    double MaxDose;
+    double StartValue;
+    double StepSize;
+    int NumberOfSamplesForNonDoseVolumes;
+    /// Number of threads used by the accumulator for traversing the dose volume.
+    /// It is 1 if the segments themselves are processed concurrently.
+    int AccumulatorNumberOfThreads;
+  };
+
+  //---------------------------------------------------------------------------
+  // Input and output of the DVH computation of one segment.
+  // The computation does not access MRML, so the segments can be processed concurrently.
+  struct SegmentDvhComputation
+  {
+    SegmentDvhComputation()
+      : LabelmapMinimumValue(0.0)
+      , LabelmapMaximumValue(1.0)
+      , ResamplingRequired(false)
+      , LabelmapResamplingExtentValid(false)
+      , KeepOversampledDoseVolume(false)
+      , OversampledDoseVolumeCached(false)
+      , VolumeCc(0.0)
+      , MeanDose(0.0)
+      , MinDose(0.0)
+      , MaxDose(0.0)
+      , ComputationTime(0.0)
+    {
+    }
+
+    // Input
+    std::string SegmentID;
+    vtkSmartPointer<vtkOrientedImageData> SegmentLabelmap;
+    double LabelmapMinimumValue;
+    double LabelmapMaximumValue;
+    bool ResamplingRequired;
+    /// Flag indicating whether the labelmap needs to be resampled only to \sa LabelmapResamplingExtent
+    /// of the oversampled dose lattice instead of its full extent
+    bool LabelmapResamplingExtentValid;
+    /// Part of the oversampled dose lattice covering the segment (with a margin)
+    int LabelmapResamplingExtent[6];
+    /// Dose volume in its original geometry (used for automatic oversampling)
+    vtkSmartPointer<vtkOrientedImageData> DoseVolume;
+    /// Dose volume resampled using the fixed oversampling factor (NULL if automatic oversampling is used)
+    vtkSmartPointer<vtkOrientedImageData> FixedOversampledDoseVolume;
+    /// Flag telling whether the dose volume resampled to the segment geometry (automatic oversampling)
+    /// is kept in \sa OversampledDoseVolume after the computation, so that it can be cached
+    bool KeepOversampledDoseVolume;
+    /// Key of the dose volume resampled to the segment geometry in the dose cache
+    std::string DoseCacheKey;
+
+    // Input and output
+    /// Dose volume resampled to the segment geometry in case of automatic oversampling.
+    /// If set before the computation (from the cache), then the dose is not resampled again.
+    vtkSmartPointer<vtkOrientedImageData> OversampledDoseVolume;
+    /// Flag telling whether \sa OversampledDoseVolume was taken from the cache
+    bool OversampledDoseVolumeCached;
+
+    // Output
+    std::string ErrorMessage;
+    double VolumeCc;
+    double MeanDose;
+    double MinDose;
+    double MaxDose;
+    vtkSmartPointer<vtkDoubleArray> DvhValues;
+    double ComputationTime;
+  };
+
+  //---------------------------------------------------------------------------
+  // Get size of an image with the given extent in megabytes
+  double GetImageSizeMB(const int extent[6], int bytesPerVoxel)
+  {
+    double numberOfVoxels = 1.0;
+    for (int axis=0; axis<3; ++axis)
+    {
+      numberOfVoxels *= std::max(0, extent[axis*2+1] - extent[axis*2] + 1);
+    }
+    return numberOfVoxels * bytesPerVoxel / (1024.0 * 1024.0);
+  }
+
+  //---------------------------------------------------------------------------
+  // Get the extent of the reference image lattice that covers the given extent of an image,
+  // expanded by a margin (in reference voxels) and clipped to the extent of the reference image.
+  // Returns false if the resulting extent is empty.
+  bool GetExtentInReferenceLattice(vtkOrientedImageData* image, const int imageExtent[6],
+    vtkOrientedImageData* reference, int marginVoxels, int referenceExtent[6])
+  {
+    vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    image->GetImageToWorldMatrix(imageToWorldMatrix);
+    vtkSmartPointer<vtkMatrix4x4> worldToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    reference->GetImageToWorldMatrix(worldToReferenceMatrix);
+    worldToReferenceMatrix->Invert();
+    vtkSmartPointer<vtkMatrix4x4> imageToReferenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkMatrix4x4::Multiply4x4(worldToReferenceMatrix, imageToWorldMatrix, imageToReferenceMatrix);
+
+    // Transform the corner voxels of the extent to the reference lattice
+    double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+    for (int cornerIndex=0; cornerIndex<8; ++cornerIndex)
+    {
+      double cornerPoint[4] = {
+        (double)imageExtent[(cornerIndex & 1) ? 1 : 0],
+        (double)imageExtent[(cornerIndex & 2) ? 3 : 2],
+        (double)imageExtent[(cornerIndex & 4) ? 5 : 4],
+        1.0 };
+      imageToReferenceMatrix->MultiplyPoint(cornerPoint, cornerPoint);
+      for (int axis=0; axis<3; ++axis)
+      {
+        bounds[axis*2] = std::min(bounds[axis*2], cornerPoint[axis]);
+        bounds[axis*2+1] = std::max(bounds[axis*2+1], cornerPoint[axis]);
+      }
+    }
+
+    int fullReferenceExtent[6] = {0,-1,0,-1,0,-1};
+    reference->GetExtent(fullReferenceExtent);
+    for (int axis=0; axis<3; ++axis)
+    {
+      referenceExtent[axis*2] = std::max(fullReferenceExtent[axis*2], vtkMath::Floor(bounds[axis*2]) - marginVoxels);
+      referenceExtent[axis*2+1] = std::min(fullReferenceExtent[axis*2+1], vtkMath::Ceil(bounds[axis*2+1]) + marginVoxels);
+      if (referenceExtent[axis*2] > referenceExtent[axis*2+1])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  // Copy the region within the given extent of an oriented image
+  void CropOrientedImage(vtkOrientedImageData* image, const int extent[6], vtkOrientedImageData* croppedImage)
+  {
+    vtkSmartPointer<vtkImageClip> clipper = vtkSmartPointer<vtkImageClip>::New();
+    clipper->SetInputData(image);
+    clipper->SetOutputWholeExtent(const_cast<int*>(extent));
+    clipper->ClipDataOn();
+    clipper->Update();
+    croppedImage->ShallowCopy(clipper->GetOutput());
+    croppedImage->CopyDirections(image);
+  }
+
+  //---------------------------------------------------------------------------
+  // Resample labelmap if necessary (if it was master, and could not be re-converted using the oversampled geometry, or if there was a parent transform)
+  // Returns error message, empty string if no error.
+  std::string ResampleSegmentLabelmap(SegmentDvhComputation& segment, const DvhComputationSettings& settings)
+  {
+    vtkOrientedImageData* segmentLabelmap = segment.SegmentLabelmap;
+    if (!segmentLabelmap)
+    {
+      return "Invalid segment labelmap";
+    }
+    if (segment.ResamplingRequired)
+    {
+      // Resample only to the part of the oversampled dose lattice that contains the segment if possible
+      vtkSmartPointer<vtkOrientedImageData> referenceGeometry = segment.FixedOversampledDoseVolume;
+      if (segment.LabelmapResamplingExtentValid && segment.FixedOversampledDoseVolume)
+      {
+        referenceGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+        referenceGeometry->SetOrigin(segment.FixedOversampledDoseVolume->GetOrigin());
+        referenceGeometry->SetSpacing(segment.FixedOversampledDoseVolume->GetSpacing());
+        referenceGeometry->CopyDirections(segment.FixedOversampledDoseVolume);
+        referenceGeometry->SetExtent(segment.LabelmapResamplingExtent);
+      }
+      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        segmentLabelmap, referenceGeometry, segmentLabelmap, settings.UseFractionalLabelmap, false, NULL, segment.LabelmapMinimumValue ) )
+      {
+        return "Failed to resample segment binary labelmap";
+      }
+    }
+    return "";
+  }
+
+  //---------------------------------------------------------------------------
+  // Set histogram range and number of bins of the accumulator based on the settings
+  void SetAccumulatorHistogramRange(vtkDoseVolumeHistogramAccumulator* accumulator, const DvhComputationSettings& settings)
+  {
+    int numSamples = 0;
+    accumulator->SetUseFractionalLabelmap(settings.UseFractionalLabelmap);
+    if (settings.IsDoseVolume)
+    {
+      numSamples = (int)ceil( (settings.MaxDose-settings.StartValue)/settings.StepSize ) + 1;
+      accumulator->SetStartValue(settings.StartValue);
+      accumulator->SetStepSize(settings.StepSize);
+    }
+    else
+    {
+      // Intensity volume histogram: the range is determined by the values within the segment
+      numSamples = settings.NumberOfSamplesForNonDoseVolumes;
+      accumulator->AutomaticHistogramRangeOn();
+    }
+    accumulator->SetNumberOfBins(numSamples);
+  }
+
+  //---------------------------------------------------------------------------
+  // Get statistics of the segment from the accumulator and compute the cumulative DVH values from the histogram.
+  // Returns error message, empty string if no error.
+  std::string GetSegmentDvhFromAccumulator(SegmentDvhComputation& segment, const DvhComputationSettings& settings,
+    vtkDoseVolumeHistogramAccumulator* accumulator, int labelmapIndex)
+  {
+    vtkOrientedImageData* segmentLabelmap = segment.SegmentLabelmap;
+    int numSamples = accumulator->GetNumberOfBins();
+
+    // Report error if there are no voxels in the stenciled dose volume (no non-zero voxels in the resampled labelmap)
+    if (accumulator->GetVoxelCount(labelmapIndex) < 1)
+    {
+      return "Dose volume and the structure do not overlap"; // User-friendly error to help troubleshooting
+    }
+
+    // Get spacing and voxel volume
+    double* segmentLabelmapSpacing = segmentLabelmap->GetSpacing();
+    double cubicMMPerVoxel = segmentLabelmapSpacing[0] * segmentLabelmapSpacing[1] * segmentLabelmapSpacing[2];
+    double ccPerCubicMM = 0.001;
+
+    // Volume (cc)
+    double totalVoxels = accumulator->GetFractionalVoxelCount(labelmapIndex);
+    segment.VolumeCc = totalVoxels * cubicMMPerVoxel * ccPerCubicMM;
+    segment.MeanDose = accumulator->GetMean(labelmapIndex);
+    segment.MinDose = accumulator->GetMinimum(labelmapIndex);
+    segment.MaxDose = accumulator->GetMaximum(labelmapIndex);
+    if (settings.IsDoseVolume && segment.MinDose<0)
+    {
+      return "The dose volume contains negative dose values";
+    }
+
+    // Create DVH plot values
+    double startValue = accumulator->GetHistogramStartValue(labelmapIndex);
+    double stepSize = accumulator->GetHistogramStepSize(labelmapIndex);
+
+    // Get the number of voxels with smaller dose than at the start value
+    double voxelBelowDose = accumulator->GetVoxelCountBelowStartValue(labelmapIndex);
+
+    // We put a fixed point at (0.0, 100%), but only if there are only positive values in the histogram
+    // Negative values can occur when the user requests histogram for an image, such as s CT volume (in this case Intensity Volume Histogram is computed),
+    // or the startValue became negative for the dose volume because the range minimum was smaller than the original start value.
+    bool insertPointAtOrigin=true;
+    if (startValue<0)
+    {
+      insertPointAtOrigin=false;
+    }
+
+    segment.DvhValues = vtkSmartPointer<vtkDoubleArray>::New();
+    vtkDoubleArray* doubleArray = segment.DvhValues;
+    doubleArray->SetNumberOfComponents(3);
+    doubleArray->SetNumberOfTuples(numSamples + (insertPointAtOrigin?1:0));
+
+    int outputArrayIndex=0;
+
+    if (insertPointAtOrigin)
+    {
+      // Add first fixed point at (0.0, 100%)
+      doubleArray->SetComponent(outputArrayIndex, 0, 0.0);
+      doubleArray->SetComponent(outputArrayIndex, 1, 100.0);
+      doubleArray->SetComponent(outputArrayIndex, 2, 0);
+      ++outputArrayIndex;
+    }
+
+    vtkDoubleArray* histogram = accumulator->GetHistogram(labelmapIndex);
+    for (int sampleIndex=0; sampleIndex<numSamples; ++sampleIndex)
+    {
+      double voxelsInBin = histogram->GetValue(sampleIndex);
+      doubleArray->SetComponent( outputArrayIndex, 0, startValue + sampleIndex * stepSize );
+      if (settings.UseFractionalLabelmap)
+      {
+        doubleArray->SetComponent( outputArrayIndex, 1, std::max(0.0, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0) );
+      }
+      else
+      {
+        doubleArray->SetComponent( outputArrayIndex, 1, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0 );
+      }
+      doubleArray->SetComponent( outputArrayIndex, 2, 0 );
+      ++outputArrayIndex;
+      voxelBelowDose += voxelsInBin;
+    }
+
+    // Set the start of the first bin to 0 if the volume contains dose and the start value was negative
+    if (settings.IsDoseVolume && !insertPointAtOrigin)
+    {
+      doubleArray->SetComponent(0,0,0);
+    }
+
+    return "";
+  }
+
+  //---------------------------------------------------------------------------
+  // Compute DVH for the given structure segment: resample the labelmap and/or dose if needed, and accumulate
+  // the dose statistics and histogram within the segment in one traversal.
+  // Thread-safe as long as the image data objects in the segment computation are not shared.
+  // Returns error message, empty string if no error.
+  std::string ComputeSegmentDvh(SegmentDvhComputation& segment, const DvhComputationSettings& settings)
+  {
+    vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+    double checkpointStart = timer->GetUniversalTime();
+
+    std::string errorMessage = ResampleSegmentLabelmap(segment, settings);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    vtkOrientedImageData* segmentLabelmap = segment.SegmentLabelmap;
+
+    // Get oversampled dose volume
+    vtkSmartPointer<vtkOrientedImageData> oversampledDoseVolume;
+    // Use the same resampled dose volume if oversampling is fixed
+    if (!settings.AutomaticOversampling)
+    {
+      oversampledDoseVolume = segment.FixedOversampledDoseVolume;
+    }
+    // Use dose volume resampled to the segment geometry in a previous computation
+    else if (segment.OversampledDoseVolume.GetPointer())
+    {
+      oversampledDoseVolume = segment.OversampledDoseVolume;
+    }
+    // Resample dose volume to match automatically oversampled segment labelmap geometry
+    else
+    {
+      oversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
+      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        segment.DoseVolume, segmentLabelmap, oversampledDoseVolume, true ) )
+      {
+        return "Failed to resample dose volume";
+      }
+      if (segment.KeepOversampledDoseVolume)
+      {
+        segment.OversampledDoseVolume = oversampledDoseVolume;
+      }
+    }
+    if (!oversampledDoseVolume)
+    {
+      return "Invalid oversampled dose volume";
+    }
+
+    // Compute statistics and histogram in one traversal of the dose volume within the segment
+    // (there is no need to pad the labelmap to the dose extent, only the overlapping region is evaluated)
+    vtkSmartPointer<vtkDoseVolumeHistogramAccumulator> accumulator = vtkSmartPointer<vtkDoseVolumeHistogramAccumulator>::New();
+    accumulator->SetDoseVolume(oversampledDoseVolume);
+    accumulator->SetNumberOfThreads(settings.AccumulatorNumberOfThreads);
+    accumulator->AddLabelmap(segmentLabelmap, segment.LabelmapMinimumValue, segment.LabelmapMaximumValue);
+    SetAccumulatorHistogramRange(accumulator, settings);
+    if (!accumulator->Update())
+    {
+      return "Failed to compute dose statistics";
+    }
+
+    errorMessage = GetSegmentDvhFromAccumulator(segment, settings, accumulator, 0);
+    segment.ComputationTime = timer->GetUniversalTime() - checkpointStart;
+    return errorMessage;
+  }
+
+  //---------------------------------------------------------------------------
+  // Functor resampling the labelmaps of a range of segments, used with vtkSMPTools.
+  // The error of each segment is stored in the segment computation.
+  class ResampleSegmentLabelmapsFunctor
+  {
+  public:
+    ResampleSegmentLabelmapsFunctor(std::vector<SegmentDvhComputation>& segments, const DvhComputationSettings& settings)
+      : Segments(segments)
+      , Settings(settings)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType index=begin; index<end; ++index)
+      {
+        SegmentDvhComputation& segment = this->Segments[index];
+        segment.ErrorMessage = ResampleSegmentLabelmap(segment, this->Settings);
+      }
+    }
+
+  private:
+    std::vector<SegmentDvhComputation>& Segments;
+    const DvhComputationSettings& Settings;
+  };
+
+  //---------------------------------------------------------------------------
+  // Compute DVH for all the segments in one traversal of the dose volume. Only applicable if all the segment
+  // labelmaps have the geometry of the same oversampled dose volume (i.e. with fixed oversampling).
+  // The segment labelmaps are resampled concurrently, then the slices of the dose volume are split between
+  // the threads in the traversal.
+  // The error of each segment is stored in the segment computation.
+  // Returns error message of the common computation, empty string if no error.
+  std::string ComputeMultiLabelDvh(std::vector<SegmentDvhComputation>& segments, const DvhComputationSettings& settings, int numberOfThreads)
+  {
+    if (segments.empty())
+    {
+      return "";
+    }
+    if (settings.AutomaticOversampling || !segments[0].FixedOversampledDoseVolume)
+    {
+      return "Multi-label DVH computation requires fixed oversampling";
+    }
+
+    vtkSmartPointer<vtkDoseVolumeHistogramAccumulator> accumulator = vtkSmartPointer<vtkDoseVolumeHistogramAccumulator>::New();
+    accumulator->SetDoseVolume(segments[0].FixedOversampledDoseVolume);
+    accumulator->MultiLabelTraversalOn();
+    accumulator->SetNumberOfThreads(numberOfThreads);
+    SetAccumulatorHistogramRange(accumulator, settings);
+
+    ResampleSegmentLabelmapsFunctor resampleFunctor(segments, settings);
+    SlicerRtCommon::SmpFor(0, static_cast<vtkIdType>(segments.size()), 1, resampleFunctor, numberOfThreads);
+
+    std::vector<int> labelmapIndices(segments.size(), -1);
+    for (unsigned int segmentIndex=0; segmentIndex<segments.size(); ++segmentIndex)
+    {
+      SegmentDvhComputation& segment = segments[segmentIndex];
+      if (segment.ErrorMessage.empty())
+      {
+        labelmapIndices[segmentIndex] = accumulator->AddLabelmap(segment.SegmentLabelmap, segment.LabelmapMinimumValue, segment.LabelmapMaximumValue);
+      }
+    }
+
+    if (!accumulator->Update())
+    {
+      return "Failed to compute dose statistics";
+    }
+
+    for (unsigned int segmentIndex=0; segmentIndex<segments.size(); ++segmentIndex)
+    {
+      SegmentDvhComputation& segment = segments[segmentIndex];
+      if (labelmapIndices[segmentIndex] >= 0)
+      {
+        segment.ErrorMessage = GetSegmentDvhFromAccumulator(segment, settings, accumulator, labelmapIndices[segmentIndex]);
+      }
+    }
+    return "";
+  }
+
+  //---------------------------------------------------------------------------
+  // Functor computing the DVH of a range of segments, used with vtkSMPTools.
+  // Progress is reported as the segments finish, but only from the thread that started the computation,
+  // as the observers of the progress event update the user interface.
+  class ComputeSegmentDvhFunctor
+  {
+  public:
+    ComputeSegmentDvhFunctor(std::vector<SegmentDvhComputation>& segments, const DvhComputationSettings& settings,
+      vtkObject* progressEventSource, int progressStepCount)
+      : Segments(segments)
+      , Settings(settings)
+      , ProgressEventSource(progressEventSource)
+      , ProgressStepCount(progressStepCount)
+      , MainThreadID(vtkMultiThreader::GetCurrentThreadID())
+      , NumberOfFinishedSegments(0)
+    {
+    }
+
+    void operator()(vtkIdType begin, vtkIdType end)
+    {
+      for (vtkIdType index=begin; index<end; ++index)
+      {
+        SegmentDvhComputation& segment = this->Segments[index];
+        segment.ErrorMessage = ComputeSegmentDvh(segment, this->Settings);
+
+        int numberOfFinishedSegments = ++this->NumberOfFinishedSegments;
+        if (this->ProgressEventSource && vtkMultiThreader::ThreadsEqual(this->MainThreadID, vtkMultiThreader::GetCurrentThreadID()))
+        {
+          double progress = (double)numberOfFinishedSegments / (double)this->ProgressStepCount;
+          this->ProgressEventSource->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
+        }
+      }
+    }
+
+  private:
+    std::vector<SegmentDvhComputation>& Segments;
+    const DvhComputationSettings& Settings;
+    vtkObject* ProgressEventSource;
+    int ProgressStepCount;
+    vtkMultiThreaderIDType MainThreadID;
+    vtkAtomic<int> NumberOfFinishedSegments;
+  };
+}
+
+//---------------------------------------------------------------------------
+// Cache of data derived from dose volumes (maximum dose, oriented and resampled dose volumes), so that
+// repeated DVH computations on the same dose volume (e.g. with a different segment selection) reuse them.
+// The entries are identified by the dose volume node ID, the modification time of its image data and its
+// geometry (so they are not used after the dose volume changes), and the serialized geometry of the target image.
+// The modification time of the node itself is not used, as it changes with every computation (e.g. when
+// node references are added to it).
+//---------------------------------------------------------------------------
+class vtkSlicerDoseVolumeHistogramModuleLogic::vtkInternal
+{
+public:
+  struct CachedImage
+  {
+    CachedImage()
+      : SizeMB(0.0)
+      , LastUsed(0)
+    {
+    }
+    vtkSmartPointer<vtkOrientedImageData> Image;
+    double SizeMB;
+    unsigned long LastUsed;
+  };
+
+public:
+  vtkInternal()
+    : UseCounter(0)
+    , HitCount(0)
+  {
+  }
+
+  /// Get identifier of the current state of a dose volume node. Changes if the image data, the IJK to RAS
+  /// matrix, or the transform to world of the node changes.
+  std::string GetDoseIdentifier(vtkMRMLScalarVolumeNode* doseVolumeNode)
+  {
+    std::stringstream identifierStream;
+    identifierStream << std::setprecision(17) << doseVolumeNode->GetID();
+    if (doseVolumeNode->GetImageData())
+    {
+      identifierStream << "|" << doseVolumeNode->GetImageData()->GetMTime();
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    doseVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
+    identifierStream << "|";
+    AppendMatrix(ijkToRasMatrix, identifierStream);
+
+    vtkMRMLTransformNode* parentTransformNode = doseVolumeNode->GetParentTransformNode();
+    if (parentTransformNode)
+    {
+      identifierStream << "|";
+      if (parentTransformNode->IsTransformToWorldLinear())
+      {
+        vtkSmartPointer<vtkMatrix4x4> transformToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        parentTransformNode->GetMatrixTransformToWorld(transformToWorldMatrix);
+        AppendMatrix(transformToWorldMatrix, identifierStream);
+      }
+      else
+      {
+        // Non-linear transforms cannot be serialized cheaply, so the cache is not used after they are modified
+        identifierStream << parentTransformNode->GetID() << ":" << parentTransformNode->GetMTime();
+      }
+    }
+    return identifierStream.str();
+  }
+
+  /// Append the elements of a matrix to a stream
+  void AppendMatrix(vtkMatrix4x4* matrix, std::stringstream& stream)
+  {
+    for (int row=0; row<3; ++row)
+    {
+      for (int column=0; column<4; ++column)
+      {
+        stream << (row+column > 0 ? " " : "") << matrix->GetElement(row, column);
+      }
+    }
+  }
+
+  /// Get cached maximum dose. Returns false if not found.
+  bool GetMaximumDose(const std::string& doseIdentifier, double& maximumDose)
+  {
+    std::map<std::string, double>::iterator maximumDoseIt = this->MaximumDoses.find(doseIdentifier);
+    if (maximumDoseIt == this->MaximumDoses.end())
+    {
+      return false;
+    }
+    maximumDose = maximumDoseIt->second;
+    ++this->HitCount;
+    return true;
+  }
+
+  /// Store maximum dose. Entries of previous states of the same dose volume node are removed.
+  void SetMaximumDose(const std::string& doseNodeID, const std::string& doseIdentifier, double maximumDose)
+  {
+    std::string nodePrefix = doseNodeID + "|";
+    for (std::map<std::string, double>::iterator maximumDoseIt = this->MaximumDoses.begin(); maximumDoseIt != this->MaximumDoses.end(); )
+    {
+      if (maximumDoseIt->first.compare(0, nodePrefix.size(), nodePrefix) == 0)
+      {
+        this->MaximumDoses.erase(maximumDoseIt++);
+      }
+      else
+      {
+        ++maximumDoseIt;
+      }
+    }
+    this->MaximumDoses[doseIdentifier] = maximumDose;
+  }
+
+  /// Get cached image. If extent is given, then the image is only returned if it covers that extent.
+  /// The returned image must not be modified. Returns NULL if not found.
+  vtkOrientedImageData* GetImage(const std::string& key, const int* extent=NULL)
+  {
+    std::map<std::string, CachedImage>::iterator imageIt = this->Images.find(key);
+    if (imageIt == this->Images.end())
+    {
+      return NULL;
+    }
+    if (extent)
+    {
+      int cachedExtent[6] = {0,-1,0,-1,0,-1};
+      imageIt->second.Image->GetExtent(cachedExtent);
+      for (int axis=0; axis<3; ++axis)
+      {
+        if (extent[axis*2] < cachedExtent[axis*2] || extent[axis*2+1] > cachedExtent[axis*2+1])
+        {
+          return NULL;
+        }
+      }
+    }
+    imageIt->second.LastUsed = ++this->UseCounter;
+    ++this->HitCount;
+    return imageIt->second.Image;
+  }
+
+  /// Add image to the cache (replacing the one with the same key), then evict the least recently used
+  /// images until the size of the cached images is within the limit. Images of previous states of the
+  /// same dose volume node are removed.
+  void AddImage(const std::string& doseNodeID, const std::string& doseIdentifier, const std::string& key,
+    vtkOrientedImageData* image, double sizeMB, double sizeLimitMB)
+  {
+    if (sizeMB > sizeLimitMB)
+    {
+      return;
+    }
+
+    std::string nodePrefix = doseNodeID + "|";
+    std::string identifierPrefix = doseIdentifier + "|";
+    for (std::map<std::string, CachedImage>::iterator imageIt = this->Images.begin(); imageIt != this->Images.end(); )
+    {
+      if ( imageIt->first.compare(0, nodePrefix.size(), nodePrefix) == 0
+        && imageIt->first.compare(0, identifierPrefix.size(), identifierPrefix) != 0 )
+      {
+        this->Images.erase(imageIt++);
+      }
+      else
+      {
+        ++imageIt;
+      }
+    }
+
+    CachedImage& cachedImage = this->Images[key];
+    cachedImage.Image = image;
+    cachedImage.SizeMB = sizeMB;
+    cachedImage.LastUsed = ++this->UseCounter;
+
+    this->EvictImages(sizeLimitMB);
+  }
+
+  /// Get total size of the cached images
+  double GetImagesSizeMB()
+  {
+    double totalSizeMB = 0.0;
+    for (std::map<std::string, CachedImage>::iterator imageIt = this->Images.begin(); imageIt != this->Images.end(); ++imageIt)
+    {
+      totalSizeMB += imageIt->second.SizeMB;
+    }
+    return totalSizeMB;
+  }
+
+  /// Remove least recently used images until the size of the cached images is within the limit
+  void EvictImages(double sizeLimitMB)
+  {
+    double totalSizeMB = this->GetImagesSizeMB();
+    while (totalSizeMB > sizeLimitMB && !this->Images.empty())
+    {
+      std::map<std::string, CachedImage>::iterator leastRecentlyUsedIt = this->Images.begin();
+      for (std::map<std::string, CachedImage>::iterator imageIt = this->Images.begin(); imageIt != this->Images.end(); ++imageIt)
+      {
+        if (imageIt->second.LastUsed < leastRecentlyUsedIt->second.LastUsed)
+        {
+          leastRecentlyUsedIt = imageIt;
+        }
+      }
+      totalSizeMB -= leastRecentlyUsedIt->second.SizeMB;
+      this->Images.erase(leastRecentlyUsedIt);
+    }
+  }
+
+  /// Remove all cached data
+  void Clear()
+  {
+    this->MaximumDoses.clear();
+    this->Images.clear();
+    this->HitCount = 0;
+  }
+
+public:
+  /// Maximum dose for dose identifiers
+  std::map<std::string, double> MaximumDoses;
+  /// Images for keys composed of the dose identifier and the target geometry
+  std::map<std::string, CachedImage> Images;
+  /// Counter for determining the least recently used images
+  unsigned long UseCounter;
+  /// Number of cached maximum doses and images found since the cache was last cleared
+  int HitCount;
+};
+
 //---------------------------------------------------------------------------
 class vtkDoseVolumeHistogramEventCallbackCommand : public vtkCallbackCommand
 {
@@ -121,11 +827,66 @@ vtkSlicerDoseVolumeHistogramModuleLogic::vtkSlicerDoseVolumeHistogramModuleLogic
   this->DefaultDoseVolumeOversamplingFactor = 2.0;
 
   this->LogSpeedMeasurements = false;
+  // Keep the cache small compared to the physical memory, as the dose volumes are also in the scene
+  this->DoseCacheSizeLimitMB = 256.0;
+  vtksys::SystemInformation systemInformation;
+  systemInformation.RunMemoryCheck();
+  double totalPhysicalMemoryMB = static_cast<double>(systemInformation.GetTotalPhysicalMemory());
+  if (totalPhysicalMemoryMB > 0.0)
+  {
+    this->DoseCacheSizeLimitMB = std::min(totalPhysicalMemoryMB / 32.0, 512.0);
+  }
+
+  this->Internal = new vtkInternal();
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerDoseVolumeHistogramModuleLogic::~vtkSlicerDoseVolumeHistogramModuleLogic()
 {
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDoseVolumeHistogramModuleLogic::ClearDoseCache()
+{
+  this->Internal->Clear();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDoseVolumeHistogramModuleLogic::GetDoseCacheHitCount()
+{
+  return this->Internal->HitCount;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerDoseVolumeHistogramModuleLogic::GetNumberOfCachedDoseImages()
+{
+  return static_cast<int>(this->Internal->Images.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerDoseVolumeHistogramModuleLogic::GetDoseCacheSizeMB()
+{
+  return this->Internal->GetImagesSizeMB();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerDoseVolumeHistogramModuleLogic::SetDoseCacheSizeLimitMB(double sizeLimitMB)
+{
+  if (this->DoseCacheSizeLimitMB == sizeLimitMB)
+  {
+    return;
+  }
+  this->DoseCacheSizeLimitMB = sizeLimitMB;
+  if (sizeLimitMB <= 0.0)
+  {
+    this->Internal->Clear();
+  }
+  else
+  {
+    this->Internal->EvictImages(sizeLimitMB);
+  }
+  this->Modified();
 }
 
 //---------------------------------------------------------------------------
@@ -158,6 +919,7 @@ void vtkSlicerDoseVolumeHistogramModuleLogic::OnMRMLSceneEndClose()
     return;
   }
 
+  this->ClearDoseCache();
   this->Modified();
 }
 
@@ -185,11 +947,22 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   this->SetDisableModifiedEvent(1);
   int disabledNodeModify = parameterNode->StartModify();
 
-  // Get maximum dose from dose volume for number of DVH bins
-  vtkNew<vtkImageAccumulate> doseStat;
-  doseStat->SetInputData(doseVolumeNode->GetImageData());
-  doseStat->Update();
-  double maxDose = doseStat->GetMax()[0];
+  // Get maximum dose from dose volume for number of DVH bins (use cached value if the dose volume has not changed)
+  std::string doseNodeID = doseVolumeNode->GetID();
+  std::string doseIdentifier = this->Internal->GetDoseIdentifier(doseVolumeNode);
+  bool useDoseCache = (this->DoseCacheSizeLimitMB > 0.0);
+  double maxDose = 0.0;
+  if (!useDoseCache || !this->Internal->GetMaximumDose(doseIdentifier, maxDose))
+  {
+    vtkNew<vtkImageAccumulate> doseStat;
+    doseStat->SetInputData(doseVolumeNode->GetImageData());
+    doseStat->Update();
+    maxDose = doseStat->GetMax()[0];
+    if (useDoseCache)
+    {
+      this->Internal->SetMaximumDose(doseNodeID, doseIdentifier, maxDose);
+    }
+  }
 
   // Get selected segmentation
   vtkSegmentation* selectedSegmentation = segmentationNode->GetSegmentation();
@@ -283,53 +1056,83 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
     }
   }
 
-  // Create oriented image data from dose volume
-  vtkSmartPointer<vtkOrientedImageData> doseImageData = vtkSmartPointer<vtkOrientedImageData>::Take(
-    vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(doseVolumeNode) );
-  if (!doseImageData.GetPointer())
+  // Create oriented image data from dose volume (use cached image if the dose volume has not changed)
+  std::string doseImageCacheKey = doseIdentifier + "|Original";
+  vtkSmartPointer<vtkOrientedImageData> doseImageData;
+  if (useDoseCache)
   {
-    std::string errorMessage("Failed to get image data from dose volume");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
+    doseImageData = this->Internal->GetImage(doseImageCacheKey);
   }
-  // Apply parent transform on dose volume if necessary
-  if (doseVolumeNode->GetParentTransformNode())
+  if (!doseImageData.GetPointer())
   {
-    if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(doseVolumeNode, doseImageData))
+    doseImageData = vtkSmartPointer<vtkOrientedImageData>::Take(
+      vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(doseVolumeNode) );
+    if (!doseImageData.GetPointer())
     {
-      std::string errorMessage("Failed to apply parent transformation to dose");
+      std::string errorMessage("Failed to get image data from dose volume");
       vtkErrorMacro("ComputeDvh: " << errorMessage);
       return errorMessage;
     }
+    // Apply parent transform on dose volume if necessary
+    double doseImageSizeMB = 0.0; // The image shares the voxels of the dose volume node unless transformed
+    if (doseVolumeNode->GetParentTransformNode())
+    {
+      if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(doseVolumeNode, doseImageData))
+      {
+        std::string errorMessage("Failed to apply parent transformation to dose");
+        vtkErrorMacro("ComputeDvh: " << errorMessage);
+        return errorMessage;
+      }
+      doseImageSizeMB = doseImageData->GetActualMemorySize() / 1024.0;
+    }
+    if (useDoseCache)
+    {
+      this->Internal->AddImage(doseNodeID, doseIdentifier, doseImageCacheKey, doseImageData, doseImageSizeMB, this->DoseCacheSizeLimitMB);
+    }
   }
 
   // Use the same resampled dose volume if oversampling is fixed
   vtkSmartPointer<vtkOrientedImageData> fixedOversampledDoseVolume;
+  std::string fixedOversampledDoseCacheKey;
   if (!parameterNode->GetAutomaticOversampling())
   {
-    // Get geometry of oversampled dose volume
+    // Get geometry of oversampled dose volume (it is resampled after the region of the segments is known)
     fixedOversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
     fixedOversampledDoseVolume->ShallowCopy(doseImageData);
     vtkCalculateOversamplingFactor::ApplyOversamplingOnImageGeometry(fixedOversampledDoseVolume, this->DefaultDoseVolumeOversamplingFactor);
 
-    // Resample dose volume using linear interpolation
-    if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-      doseImageData, fixedOversampledDoseVolume, fixedOversampledDoseVolume, true ) )
-    {
-      std::string errorMessage("Failed to resample dose volume");
-      vtkErrorMacro("ComputeDvh: " << errorMessage);
-      return errorMessage;
-    }
-  }
+    vtkSmartPointer<vtkMatrix4x4> oversampledDoseImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    fixedOversampledDoseVolume->GetImageToWorldMatrix(oversampledDoseImageToWorldMatrix);
+    fixedOversampledDoseCacheKey = doseIdentifier + "|" + vtkSegmentationConverter::SerializeImageGeometry(
+      oversampledDoseImageToWorldMatrix, fixedOversampledDoseVolume );
+  }
+
+  // Estimated memory needed for the resampled images with and without cropping to the segments, for reporting purposes
+  int doseBytesPerVoxel = doseImageData->GetScalarSize() * doseImageData->GetNumberOfScalarComponents();
+  double uncroppedMemoryMB = 0.0;
+  double croppedMemoryMB = 0.0;
+  // Region of the oversampled dose lattice containing all the segments (only used with fixed oversampling)
+  int segmentsExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  bool segmentsExtentValid = false;
+
+  // Collect inputs for the DVH computation of each selected segment
+  DvhComputationSettings settings;
+  settings.UseFractionalLabelmap = useFractionalLabelmap;
+  settings.AutomaticOversampling = parameterNode->GetAutomaticOversampling();
+  settings.IsDoseVolume = SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode);
+  settings.MaxDose = maxDose;
+  settings.StartValue = this->StartValue;
+  settings.StepSize = this->StepSize;
+  settings.NumberOfSamplesForNonDoseVolumes = this->NumberOfSamplesForNonDoseVolumes;
+  settings.AccumulatorNumberOfThreads = (segmentIDs.size() > 1 ? 1 : parameterNode->GetNumberOfThreads());
+
+  std::vector<SegmentDvhComputation> segmentComputations(segmentIDs.size());
+  for (unsigned int segmentIndex=0; segmentIndex<segmentIDs.size(); ++segmentIndex)
+  {
+    SegmentDvhComputation& segmentComputation = segmentComputations[segmentIndex];
+    std::string segmentID = segmentIDs[segmentIndex];
+    vtkSegment* segment = segmentationCopy->GetSegment(segmentID);
 
-  // Compute DVH for each selected segment
-  int counter = 1; // Start at one so that progress can reach 100%
-  int numberOfSelectedSegments = segmentationCopy->GetNumberOfSegments();
-  for (std::vector< std::string >::const_iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt, ++counter)
-  {
-    std::string segmentID = *segmentIdIt;
-    vtkSegment* segment = segmentationCopy->GetSegment(*segmentIdIt);
-  
     // Get segment labelmap
     vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast( segment->GetRepresentation(
       representationName ) );
@@ -350,7 +1153,8 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
       maximumValue = scalarRange->GetValue(1);
     }
 
-    // Apply parent transformation nodes if necessary
+    // Apply parent transformation nodes if necessary (accesses MRML, so it is done before the concurrent computation)
+    bool segmentResamplingRequired = resamplingRequired;
     if (segmentationNode->GetParentTransformNode())
     {
       double backgroundValue[4] = {minimumValue, minimumValue, minimumValue, 0.0};
@@ -360,62 +1164,221 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
         vtkErrorMacro("ComputeDvh: " << errorMessage);
         return errorMessage;
       }
-      resamplingRequired = true;
+      segmentResamplingRequired = true;
+    }
+
+    segmentComputation.SegmentID = segmentID;
+    segmentComputation.SegmentLabelmap = segmentLabelmap;
+    segmentComputation.LabelmapMinimumValue = minimumValue;
+    segmentComputation.LabelmapMaximumValue = maximumValue;
+    segmentComputation.ResamplingRequired = segmentResamplingRequired;
+
+    // Crop to the effective extent of the segment, so that small segments do not need resampling
+    // and histogram computation on the whole dose grid. A margin of one voxel is kept for interpolation.
+    int effectiveExtent[6] = {0,-1,0,-1,0,-1};
+    if ( !vtkOrientedImageDataResample::CalculateEffectiveExtent(
+      segmentLabelmap, effectiveExtent, (useFractionalLabelmap ? minimumValue : 0.0) ) )
+    {
+      // Empty segment, it will be reported when computing its DVH
+      continue;
+    }
+    int labelmapBytesPerVoxel = segmentLabelmap->GetScalarSize() * segmentLabelmap->GetNumberOfScalarComponents();
+    std::string labelmapGeometryString;
+    if (useDoseCache && !fixedOversampledDoseVolume.GetPointer())
+    {
+      // Geometry of the labelmap before cropping identifies the resampled dose in the cache
+      vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      segmentLabelmap->GetImageToWorldMatrix(labelmapImageToWorldMatrix);
+      labelmapGeometryString = vtkSegmentationConverter::SerializeImageGeometry(labelmapImageToWorldMatrix, segmentLabelmap);
+    }
+    if (fixedOversampledDoseVolume.GetPointer())
+    {
+      // The dose is resampled only in the region containing the segments, and the segment labelmaps
+      // that need resampling are resampled only to their own region of the oversampled dose lattice
+      int segmentExtent[6] = {0,-1,0,-1,0,-1};
+      if (!GetExtentInReferenceLattice(segmentLabelmap, effectiveExtent, fixedOversampledDoseVolume, 1, segmentExtent))
+      {
+        continue;
+      }
+      for (int axis=0; axis<3; ++axis)
+      {
+        segmentsExtent[axis*2] = std::min(segmentsExtent[axis*2], segmentExtent[axis*2]);
+        segmentsExtent[axis*2+1] = std::max(segmentsExtent[axis*2+1], segmentExtent[axis*2+1]);
+      }
+      segmentsExtentValid = true;
+      if (segmentResamplingRequired)
+      {
+        segmentComputation.LabelmapResamplingExtentValid = true;
+        std::copy(segmentExtent, segmentExtent+6, segmentComputation.LabelmapResamplingExtent);
+        uncroppedMemoryMB += GetImageSizeMB(fixedOversampledDoseVolume->GetExtent(), labelmapBytesPerVoxel);
+        croppedMemoryMB += GetImageSizeMB(segmentExtent, labelmapBytesPerVoxel);
+      }
     }
-    // Resample labelmap if necessary (if it was master, and could not be re-converted using the oversampled geometry, or if there was a parent transform)
-    if (resamplingRequired)
+    else
     {
+      // With automatic oversampling the dose is resampled to the labelmap geometry, so cropping
+      // the labelmap also crops the resampled dose
+      int labelmapExtent[6] = {0,-1,0,-1,0,-1};
+      segmentLabelmap->GetExtent(labelmapExtent);
+      int croppedExtent[6] = {0,-1,0,-1,0,-1};
+      bool croppingNeeded = false;
+      for (int axis=0; axis<3; ++axis)
+      {
+        croppedExtent[axis*2] = std::max(labelmapExtent[axis*2], effectiveExtent[axis*2] - 1);
+        croppedExtent[axis*2+1] = std::min(labelmapExtent[axis*2+1], effectiveExtent[axis*2+1] + 1);
+        if (croppedExtent[axis*2] != labelmapExtent[axis*2] || croppedExtent[axis*2+1] != labelmapExtent[axis*2+1])
+        {
+          croppingNeeded = true;
+        }
+      }
+      uncroppedMemoryMB += GetImageSizeMB(labelmapExtent, doseBytesPerVoxel);
+      if (croppingNeeded)
+      {
+        vtkSmartPointer<vtkOrientedImageData> croppedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+        CropOrientedImage(segmentLabelmap, croppedExtent, croppedLabelmap);
+        segmentComputation.SegmentLabelmap = croppedLabelmap;
+        croppedMemoryMB += GetImageSizeMB(croppedExtent, doseBytesPerVoxel + labelmapBytesPerVoxel);
+      }
+      else
+      {
+        croppedMemoryMB += GetImageSizeMB(labelmapExtent, doseBytesPerVoxel);
+      }
 
-      // Resample segmentation labelmap volume
-      if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-        segmentLabelmap, fixedOversampledDoseVolume, segmentLabelmap, useFractionalLabelmap, false, NULL, minimumValue ) )
+      // Use dose resampled to the segment geometry in a previous computation if available
+      if (useDoseCache)
       {
-        std::string errorMessage("Failed to resample segment binary labelmap");
-        vtkErrorMacro("ComputeDvh: " << errorMessage);
-        return errorMessage;
+        segmentComputation.DoseCacheKey = doseIdentifier + "|" + labelmapGeometryString;
+        segmentComputation.KeepOversampledDoseVolume = true;
+        vtkOrientedImageData* cachedDoseVolume = this->Internal->GetImage(
+          segmentComputation.DoseCacheKey, segmentComputation.SegmentLabelmap->GetExtent() );
+        if (cachedDoseVolume)
+        {
+          segmentComputation.OversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
+          segmentComputation.OversampledDoseVolume->ShallowCopy(cachedDoseVolume);
+          segmentComputation.OversampledDoseVolumeCached = true;
+        }
       }
     }
+  }
 
-    // Get oversampled dose volume
-    vtkSmartPointer<vtkOrientedImageData> oversampledDoseVolume;
-    // Use the same resampled dose volume if oversampling is fixed
-    if (!parameterNode->GetAutomaticOversampling())
+  if (fixedOversampledDoseVolume.GetPointer())
+  {
+    // Resample dose volume using linear interpolation, only in the region containing the segments
+    uncroppedMemoryMB += GetImageSizeMB(fixedOversampledDoseVolume->GetExtent(), doseBytesPerVoxel);
+    if (segmentsExtentValid)
     {
-      oversampledDoseVolume = fixedOversampledDoseVolume;
+      fixedOversampledDoseVolume->SetExtent(segmentsExtent);
+    }
+    croppedMemoryMB += GetImageSizeMB(fixedOversampledDoseVolume->GetExtent(), doseBytesPerVoxel);
+
+    // Use dose resampled in a previous computation if it covers the region of the segments
+    vtkOrientedImageData* cachedDoseVolume = NULL;
+    if (useDoseCache)
+    {
+      cachedDoseVolume = this->Internal->GetImage(fixedOversampledDoseCacheKey, fixedOversampledDoseVolume->GetExtent());
+    }
+    if (cachedDoseVolume)
+    {
+      fixedOversampledDoseVolume = cachedDoseVolume;
     }
-    // Resample dose volume to match automatically oversampled segment labelmap geometry
     else
     {
-      oversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
       if ( !vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
-        doseImageData, segmentLabelmap, oversampledDoseVolume, true ) )
+        doseImageData, fixedOversampledDoseVolume, fixedOversampledDoseVolume, true ) )
       {
         std::string errorMessage("Failed to resample dose volume");
         vtkErrorMacro("ComputeDvh: " << errorMessage);
         return errorMessage;
       }
+      if (useDoseCache)
+      {
+        this->Internal->AddImage(doseNodeID, doseIdentifier, fixedOversampledDoseCacheKey, fixedOversampledDoseVolume,
+          fixedOversampledDoseVolume->GetActualMemorySize() / 1024.0, this->DoseCacheSizeLimitMB);
+      }
     }
+  }
+  if (this->LogSpeedMeasurements)
+  {
+    vtkDebugMacro("ComputeDvh: Cropping to the segment regions reduced the estimated peak memory of resampled images from "
+      << uncroppedMemoryMB << " MB to " << croppedMemoryMB << " MB (saved " << uncroppedMemoryMB - croppedMemoryMB << " MB)");
+  }
 
-    // Make sure the segment labelmap is the same dimension as the dose volume
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(segmentLabelmap);
-    padder->SetConstant(minimumValue);
-    int extent[6] = {0,-1,0,-1,0,-1};
-    oversampledDoseVolume->GetExtent(extent);
-    padder->SetOutputWholeExtent(extent);
-    padder->Update();
-    segmentLabelmap->vtkImageData::DeepCopy(padder->GetOutput());
+  for (unsigned int segmentIndex=0; segmentIndex<segmentComputations.size(); ++segmentIndex)
+  {
+    // Each segment gets its own shallow copy of the dose volumes, as the VTK pipeline
+    // modifies the information of its input data objects, so they cannot be shared between threads
+    SegmentDvhComputation& segmentComputation = segmentComputations[segmentIndex];
+    segmentComputation.DoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
+    segmentComputation.DoseVolume->ShallowCopy(doseImageData);
+    if (fixedOversampledDoseVolume.GetPointer())
+    {
+      segmentComputation.FixedOversampledDoseVolume = vtkSmartPointer<vtkOrientedImageData>::New();
+      segmentComputation.FixedOversampledDoseVolume->ShallowCopy(fixedOversampledDoseVolume);
+    }
+  }
 
-    // Calculate DVH for current segment
-    std::string errorMessage = this->ComputeDvh(parameterNode, segmentLabelmap, oversampledDoseVolume, segmentID, maxDose);
+  // Compute DVH for each selected segment
+  int numberOfThreads = parameterNode->GetNumberOfThreads();
+  int numberOfSelectedSegments = (int)segmentComputations.size();
+  // Progress has one step for computing and one step for storing the DVH of each segment
+  int progressStepCount = 2 * numberOfSelectedSegments;
+  // Multi-label computation needs all segments to share the oversampled dose geometry
+  bool multiLabelComputation = parameterNode->GetUseMultiLabelComputation() && !settings.AutomaticOversampling && numberOfSelectedSegments > 1;
+  if (multiLabelComputation)
+  {
+    // Compute DVH of all segments in one traversal of the dose volume
+    vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+    double checkpointStart = timer->GetUniversalTime();
+    std::string errorMessage = ComputeMultiLabelDvh(segmentComputations, settings, numberOfThreads);
     if (!errorMessage.empty())
     {
       vtkErrorMacro("ComputeDvh: " << errorMessage);
       return errorMessage;
     }
+    if (this->LogSpeedMeasurements)
+    {
+      vtkDebugMacro("ComputeDvh: Multi-label DVH computation time for " << numberOfSelectedSegments << " structures: " << timer->GetUniversalTime() - checkpointStart << " s");
+    }
+  }
+  else
+  {
+    // Compute DVH of all segments concurrently, then store the results in MRML on the main thread
+    ComputeSegmentDvhFunctor computeFunctor(segmentComputations, settings, this, progressStepCount);
+    SlicerRtCommon::SmpFor(0, numberOfSelectedSegments, 1, computeFunctor, numberOfThreads);
+  }
+  for (int segmentIndex=0; segmentIndex<numberOfSelectedSegments; ++segmentIndex)
+  {
+    SegmentDvhComputation& segmentComputation = segmentComputations[segmentIndex];
+    if (!segmentComputation.ErrorMessage.empty())
+    {
+      vtkErrorMacro("ComputeDvh: " << segmentComputation.ErrorMessage);
+      return segmentComputation.ErrorMessage;
+    }
+
+    // Store DVH for current segment
+    std::string errorMessage = this->StoreDvh( parameterNode, segmentComputation.SegmentID,
+      segmentComputation.VolumeCc, segmentComputation.MeanDose, segmentComputation.MinDose, segmentComputation.MaxDose,
+      segmentComputation.DvhValues );
+    if (!errorMessage.empty())
+    {
+      vtkErrorMacro("ComputeDvh: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Cache dose resampled to the segment geometry for subsequent computations
+    if (segmentComputation.OversampledDoseVolume.GetPointer() && !segmentComputation.OversampledDoseVolumeCached)
+    {
+      this->Internal->AddImage(doseNodeID, doseIdentifier, segmentComputation.DoseCacheKey, segmentComputation.OversampledDoseVolume,
+        segmentComputation.OversampledDoseVolume->GetActualMemorySize() / 1024.0, this->DoseCacheSizeLimitMB);
+    }
+    segmentComputation.OversampledDoseVolume = NULL;
+    if (this->LogSpeedMeasurements && !multiLabelComputation)
+    {
+      vtkDebugMacro("ComputeDvh: DVH computation time for structure '" << segmentComputation.SegmentID << "': " << segmentComputation.ComputationTime << " s");
+    }
 
-    // Update progress bar
-    double progress = (double)counter / (double)numberOfSelectedSegments;
+    // Update progress bar (start at one so that progress can reach 100%)
+    double progress = (double)(numberOfSelectedSegments+segmentIndex+1) / (double)progressStepCount;
     this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
   } // For each segment
 
@@ -433,24 +1396,19 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume, std::string segmentID, double maxDoseGy)
+std::string vtkSlicerDoseVolumeHistogramModuleLogic::StoreDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID,
+  double volumeCc, double meanDose, double minDose, double maxDose, vtkDoubleArray* dvhValues)
 {
   if (!this->GetMRMLScene() || !parameterNode)
   {
     std::string errorMessage("Invalid MRML scene or parameter set node");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
-  }
-  if (!segmentLabelmap)
-  {
-    std::string errorMessage("Invalid segment labelmap");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
+    vtkErrorMacro("StoreDvh: " << errorMessage);
     return errorMessage;
   }
-  if (!oversampledDoseVolume)
+  if (!dvhValues)
   {
-    std::string errorMessage("Invalid oversampled dose volume");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
+    std::string errorMessage("Invalid DVH values");
+    vtkErrorMacro("StoreDvh: " << errorMessage);
     return errorMessage;
   }
   vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetSegmentationNode();
@@ -458,84 +1416,11 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   if ( !segmentationNode || !doseVolumeNode )
   {
     std::string errorMessage("Both segmentation node and dose volume node need to be set");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
+    vtkErrorMacro("StoreDvh: " << errorMessage);
     return errorMessage;
   }
   std::string segmentName = parameterNode->GetSegmentationNode()->GetSegmentation()->GetSegment(segmentID)->GetName();
 
-  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
-  double checkpointStart = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
-
-  // Create stencil for structure
-  vtkNew<vtkImageToImageStencil> stencil;
-  stencil->SetInputData(segmentLabelmap);
-  // Foreground voxels are all those with an intensity >0.
-  // Unfortunately, vtkImageToImageStencil only have options for < and >= comparison.
-  // So, we have to choose >=epsilon (epsilon is a very small positive number).
-  // How small the number is has a significance when the segmentLabelmap is a floating-point image,
-  // which is a rare scenario, but may still happen.
-  double minimumValue = 0.0;
-  double maximumValue = 1.0;
-  segmentLabelmap->GetFieldData();
-  vtkDoubleArray* scalarRange = vtkDoubleArray::SafeDownCast(
-    segmentLabelmap->GetFieldData()->GetAbstractArray( vtkSegmentationConverter::GetScalarRangeFieldName() )
-    );
-  if (scalarRange && scalarRange->GetNumberOfValues() == 2)
-  {
-    minimumValue = scalarRange->GetValue(0);
-    maximumValue = scalarRange->GetValue(1);
-  }
-
-  bool useFractionalLabelmap = parameterNode->GetUseFractionalLabelmap();
-  if (useFractionalLabelmap)
-  {
-    stencil->ThresholdByUpper(minimumValue + 1e-10);
-  }
-  else
-  {
-    stencil->ThresholdByUpper(1e-10);
-  }
-  stencil->Update();
-
-  vtkSmartPointer<vtkImageStencilData> structureStencil = vtkSmartPointer<vtkImageStencilData>::New();
-  structureStencil->DeepCopy(stencil->GetOutput());
-
-  int stencilExtent[6] = {0,-1,0,-1,0,-1};
-  structureStencil->GetExtent(stencilExtent);
-  if (stencilExtent[1]-stencilExtent[0] <= 0 || stencilExtent[3]-stencilExtent[2] <= 0 || stencilExtent[5]-stencilExtent[4] <= 0)
-  {
-    std::string errorMessage("Invalid stenciled dose volume");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
-  }
-
-  // Compute statistics
-  vtkSmartPointer<vtkImageAccumulate> structureStat;
-  if (useFractionalLabelmap)
-  {
-    structureStat = vtkSmartPointer<vtkFractionalImageAccumulate>::New();
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->UseFractionalLabelmapOn();
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetFractionalLabelmap(segmentLabelmap);
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetMinimumFractionalValue(minimumValue);
-    vtkFractionalImageAccumulate::SafeDownCast(structureStat)->SetMaximumFractionalValue(maximumValue);
-  }
-  else
-  {
-    structureStat = vtkSmartPointer<vtkImageAccumulate>::New();
-  }
-  structureStat->SetInputData(oversampledDoseVolume);
-  structureStat->SetStencilData(structureStencil);
-  structureStat->Update();
-
-  // Report error if there are no voxels in the stenciled dose volume (no non-zero voxels in the resampled labelmap)
-  if (structureStat->GetVoxelCount() < 1)
-  {
-    std::string errorMessage("Dose volume and the structure do not overlap"); // User-friendly error to help troubleshooting
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
-    return errorMessage;
-  }
-
   // Get metrics table for the parameter node; Create one if missing
   vtkMRMLTableNode* metricsTableNode = parameterNode->GetMetricsTableNode();
   vtkTable* metricsTable = metricsTableNode->GetTable();
@@ -578,7 +1463,7 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   else
   {
     std::string errorMessage("Failed to find metrics table row for structure " + segmentName);
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
+    vtkErrorMacro("StoreDvh: " << errorMessage);
     return errorMessage;
   }
 
@@ -590,11 +1475,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   oversamplingAttrValueStream << (parameterNode->GetAutomaticOversampling() ? (-1.0) : this->DefaultDoseVolumeOversamplingFactor);
   arrayNode->SetAttribute(DVH_DOSE_VOLUME_OVERSAMPLING_FACTOR_ATTRIBUTE_NAME.c_str(), oversamplingAttrValueStream.str().c_str());
 
-  // Get spacing and voxel volume
-  double* segmentLabelmapSpacing = segmentLabelmap->GetSpacing();
-  double cubicMMPerVoxel = segmentLabelmapSpacing[0] * segmentLabelmapSpacing[1] * segmentLabelmapSpacing[2];
-  double ccPerCubicMM = 0.001;
-
   // Set default column values
 
   // Structure name
@@ -602,15 +1482,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   // Volume name
   metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnDoseVolume, vtkVariant(doseVolumeNode->GetName()));
   // Volume (cc) - save as attribute too (the DVH contains percentages that often need to be converted to volume)
-  double volumeCc = 0;
-  if (useFractionalLabelmap)
-  {
-    volumeCc = vtkFractionalImageAccumulate::SafeDownCast(structureStat)->GetFractionalVoxelCount() * cubicMMPerVoxel * ccPerCubicMM;
-  }
-  else
-  {
-    volumeCc = structureStat->GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM;
-  }
   metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnVolumeCc, vtkVariant(volumeCc));
   std::ostringstream attributeNameStream;
   std::ostringstream attributeValueStream;
@@ -618,105 +1489,18 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   attributeValueStream << volumeCc;
   arrayNode->SetAttribute(attributeNameStream.str().c_str(), attributeValueStream.str().c_str());
   // Mean dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMeanDose, vtkVariant(structureStat->GetMean()[0]));
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMeanDose, vtkVariant(meanDose));
   // Min dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMinDose, vtkVariant(structureStat->GetMin()[0]));
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMinDose, vtkVariant(minDose));
   // Max dose
-  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMaxDose, vtkVariant(structureStat->GetMax()[0]));
-
-  // Create DVH plot values
-  int numSamples = 0;
-  double startValue;
-  double stepSize;
-  double rangeMin = structureStat->GetMin()[0];
-  double rangeMax = structureStat->GetMax()[0];
-  if (SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode))
-  {
-    if (rangeMin<0)
-    {
-      std::string errorMessage("The dose volume contains negative dose values");
-      vtkErrorMacro("ComputeDvh: " << errorMessage);
-      return errorMessage;
-    }
-
-    startValue = this->StartValue;
-    stepSize = this->StepSize;
-    numSamples = (int)ceil( (maxDoseGy-startValue)/stepSize ) + 1;
-  }
-  else
-  {
-    startValue = rangeMin;
-    numSamples = this->NumberOfSamplesForNonDoseVolumes;
-    stepSize = (rangeMax - rangeMin) / (double)(numSamples-1);
-  }
-
-  // Get the number of voxels with smaller dose than at the start value
-  structureStat->SetComponentExtent(0,1,0,0,0,0);
-  structureStat->SetComponentOrigin(0,0,0);
-  structureStat->SetComponentSpacing(startValue,1,1);
-  structureStat->Update();
-  double voxelBelowDose = structureStat->GetOutput()->GetScalarComponentAsDouble(0,0,0,0);
-
-  // We put a fixed point at (0.0, 100%), but only if there are only positive values in the histogram
-  // Negative values can occur when the user requests histogram for an image, such as s CT volume (in this case Intensity Volume Histogram is computed),
-  // or the startValue became negative for the dose volume because the range minimum was smaller than the original start value.
-  bool insertPointAtOrigin=true;
-  if (startValue<0)
-  {
-    insertPointAtOrigin=false;
-  }
-
-  structureStat->SetComponentExtent(0,numSamples-1,0,0,0,0);
-  structureStat->SetComponentOrigin(startValue,0,0);
-  structureStat->SetComponentSpacing(stepSize,1,1);
-  structureStat->Update();
+  metricsTable->SetValue(tableRow, vtkMRMLDoseVolumeHistogramNode::MetricColumnMaxDose, vtkVariant(maxDose));
 
+  // Copy DVH plot values
   vtkDoubleArray* doubleArray = arrayNode->GetArray();
-  doubleArray->SetNumberOfTuples(numSamples + (insertPointAtOrigin?1:0));
-
-  int outputArrayIndex=0;
-
-  if (insertPointAtOrigin)
-  {
-    // Add first fixed point at (0.0, 100%)
-    doubleArray->SetComponent(outputArrayIndex, 0, 0.0);
-    doubleArray->SetComponent(outputArrayIndex, 1, 100.0);
-    doubleArray->SetComponent(outputArrayIndex, 2, 0);
-    ++outputArrayIndex;
-  }
-
-  vtkImageData* statArray = structureStat->GetOutput();
-  double totalVoxels = 0;
-  if (useFractionalLabelmap)
-  {
-    totalVoxels = vtkFractionalImageAccumulate::SafeDownCast(structureStat)->GetFractionalVoxelCount();
-  }
-  else
-  {
-    totalVoxels = structureStat->GetVoxelCount();
-  }
-
-  for (int sampleIndex=0; sampleIndex<numSamples; ++sampleIndex)
-  {
-    double voxelsInBin = statArray->GetScalarComponentAsDouble(sampleIndex,0,0,0);
-    doubleArray->SetComponent( outputArrayIndex, 0, startValue + sampleIndex * stepSize );
-    if (useFractionalLabelmap)
-    {
-      doubleArray->SetComponent( outputArrayIndex, 1, std::max(0.0, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0) );
-    }
-    else
-    {
-      doubleArray->SetComponent( outputArrayIndex, 1, (1.0-(double)voxelBelowDose/(double)totalVoxels)*100.0 );
-    }
-    doubleArray->SetComponent( outputArrayIndex, 2, 0 );
-    ++outputArrayIndex;
-    voxelBelowDose += voxelsInBin;
-  }
-
-  // Set the start of the first bin to 0 if the volume contains dose and the start value was negative
-  if (SlicerRtCommon::IsDoseVolumeNode(doseVolumeNode) && !insertPointAtOrigin)
+  doubleArray->SetNumberOfTuples(dvhValues->GetNumberOfTuples());
+  for (vtkIdType tupleIndex=0; tupleIndex<dvhValues->GetNumberOfTuples(); ++tupleIndex)
   {
-    doubleArray->SetComponent(0,0,0);
+    doubleArray->SetTuple(tupleIndex, dvhValues->GetTuple(tupleIndex));
   }
 
   // Setup DVH subject hierarchy item
@@ -724,7 +1508,7 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   if (!shNode)
   {
     std::string errorMessage("Failed to access subject hierarchy node");
-    vtkErrorMacro("ComputeDvh: " << errorMessage);
+    vtkErrorMacro("StoreDvh: " << errorMessage);
     return errorMessage;
   }
   vtkIdType doseShItemID = shNode->GetItemByDataNode(doseVolumeNode);
@@ -744,14 +1528,6 @@ std::string vtkSlicerDoseVolumeHistogramModuleLogic::ComputeDvh(vtkMRMLDoseVolum
   segmentationNode->AddNodeReferenceID(DVH_CREATED_DVH_NODE_REFERENCE_ROLE.c_str(), arrayNode->GetID());
   doseVolumeNode->AddNodeReferenceID(DVH_CREATED_DVH_NODE_REFERENCE_ROLE.c_str(), arrayNode->GetID());
 
-  // Log measured time
-  double checkpointEnd = timer->GetUniversalTime();
-  UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
-  if (this->LogSpeedMeasurements)
-  {
-    vtkDebugMacro("ComputeDvh: DVH computation time for structure '" << segmentID << "': " << checkpointEnd-checkpointStart << " s");
-  }
-
   return "";
 }
 
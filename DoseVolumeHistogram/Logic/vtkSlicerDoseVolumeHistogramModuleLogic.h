@@ -34,6 +34,7 @@
 
 class vtkOrientedImageData;
 class vtkCallbackCommand;
+class vtkDoubleArray;
 class vtkMRMLDoubleArrayNode;
 class vtkMRMLScalarVolumeNode;
 class vtkMRMLChartNode;
@@ -128,16 +129,35 @@ public:
   vtkSetMacro(LogSpeedMeasurements, bool);
   vtkBooleanMacro(LogSpeedMeasurements, bool);
 
+  vtkGetMacro(DoseCacheSizeLimitMB, double);
+  /// Set the size limit of the dose cache. Cached images are removed immediately if they exceed the new limit.
+  void SetDoseCacheSizeLimitMB(double sizeLimitMB);
+
+  /// Remove all cached maximum dose values and oriented and resampled dose volumes
+  void ClearDoseCache();
+
+  /// Get number of times cached dose data (maximum dose or dose volume) was used since the cache was last cleared
+  int GetDoseCacheHitCount();
+  /// Get number of oriented and resampled dose volumes in the cache
+  int GetNumberOfCachedDoseImages();
+  /// Get total size of the dose volumes in the cache (in megabytes)
+  double GetDoseCacheSizeMB();
+
 protected:
-  /// Compute DVH for the given structure segment with the stenciled dose volume
-  /// (the labelmap representation of a segment but with dose values instead of the labels)
+  /// Store the computed DVH of a structure segment in the scene: create or update the DVH array node,
+  /// fill the corresponding row of the metrics table, and set up subject hierarchy and references.
+  /// The DVH values are computed in \sa ComputeDvh() without accessing MRML, so that segments can be
+  /// processed concurrently. This function must be called from the main thread.
   /// \param parameterNode Dose volume histogram parameter set node
-  /// \param segmentLabelmap Binary representation of the labelmap representation of the segment the DVH is calculated on
-  /// \param oversampledDoseVolume Dose volume resampled to match the geometry of the segment labelmap (to allow stenciling)
   /// \param segmentID ID of segment the DVH is calculated on
-  /// \param maxDoseGy Maximum dose determining the number of DVH bins (passed as argument so that it is only calculated once in \sa ComputeDvh() )
+  /// \param volumeCc Volume of the segment in cc
+  /// \param meanDose Mean dose in the segment
+  /// \param minDose Minimum dose in the segment
+  /// \param maxDose Maximum dose in the segment
+  /// \param dvhValues DVH table with (dose, volume percent, 0) tuples
   /// \return Error message, empty string if no error
-  std::string ComputeDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* oversampledDoseVolume, std::string segmentID, double maxDoseGy);
+  std::string StoreDvh(vtkMRMLDoseVolumeHistogramNode* parameterNode, std::string segmentID,
+    double volumeCc, double meanDose, double minDose, double maxDose, vtkDoubleArray* dvhValues);
 
   /// Return the chart view node object from the layout
   vtkMRMLChartViewNode* GetChartViewNode();
@@ -191,6 +211,17 @@ protected:
 
   /// Flag telling whether the speed measurements are logged on standard output
   bool LogSpeedMeasurements;
+
+  /// Maximum size of the dose volumes cached between DVH computations (in megabytes).
+  /// The maximum dose and the oriented and resampled dose volumes are cached for the current state of the
+  /// dose volume, so that they are not computed again if the DVH is recomputed (e.g. for a different segment
+  /// selection). If the limit is exceeded then the least recently used images are removed. 0 disables caching.
+  /// Default is 1/32 of the physical memory, at most 512 MB (256 MB if the physical memory cannot be determined).
+  double DoseCacheSizeLimitMB;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
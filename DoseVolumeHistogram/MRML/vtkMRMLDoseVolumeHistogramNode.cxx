@@ -64,6 +64,8 @@ vtkMRMLDoseVolumeHistogramNode::vtkMRMLDoseVolumeHistogramNode()
   this->AutomaticOversampling = false;
   this->AutomaticOversamplingFactors.clear();
   this->UseFractionalLabelmap = false;
+  this->NumberOfThreads = 0;
+  this->UseMultiLabelComputation = false;
 
   this->HideFromEditors = false;
 }
@@ -103,6 +105,8 @@ void vtkMRMLDoseVolumeHistogramNode::WriteXML(ostream& of, int nIndent)
 
   of << " ShowDoseVolumesOnly=\"" << (this->ShowDoseVolumesOnly ? "true" : "false") << "\"";
   of << " AutomaticOversampling=\"" << (this->AutomaticOversampling ? "true" : "false") << "\"";
+  of << " NumberOfThreads=\"" << this->NumberOfThreads << "\"";
+  of << " UseMultiLabelComputation=\"" << (this->UseMultiLabelComputation ? "true" : "false") << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -173,6 +177,14 @@ void vtkMRMLDoseVolumeHistogramNode::ReadXMLAttributes(const char** atts)
       {
       this->AutomaticOversampling = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "NumberOfThreads")) 
+      {
+      this->NumberOfThreads = vtkVariant(attValue).ToInt();
+      }
+    else if (!strcmp(attName, "UseMultiLabelComputation")) 
+      {
+      this->UseMultiLabelComputation = (strcmp(attValue,"true") ? false : true);
+      }
     }
 }
 
@@ -198,6 +210,8 @@ void vtkMRMLDoseVolumeHistogramNode::Copy(vtkMRMLNode *anode)
   this->ShowDMetrics = node->ShowDMetrics;
   this->ShowDoseVolumesOnly = node->ShowDoseVolumesOnly;
   this->AutomaticOversampling = node->AutomaticOversampling;
+  this->NumberOfThreads = node->NumberOfThreads;
+  this->UseMultiLabelComputation = node->UseMultiLabelComputation;
 
   this->DisableModifiedEventOff();
   this->InvokePendingModifiedEvent();
@@ -226,6 +240,8 @@ void vtkMRMLDoseVolumeHistogramNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ShowDMetrics:   " << (this->ShowDMetrics ? "true" : "false") << "\n";
   os << indent << "ShowDoseVolumesOnly:   " << (this->ShowDoseVolumesOnly ? "true" : "false") << "\n";
   os << indent << "AutomaticOversampling:   " << (this->AutomaticOversampling ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads:   " << this->NumberOfThreads << "\n";
+  os << indent << "UseMultiLabelComputation:   " << (this->UseMultiLabelComputation ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
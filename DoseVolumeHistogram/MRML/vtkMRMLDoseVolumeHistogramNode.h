@@ -199,6 +199,18 @@ public:
   /// Get fractional labelmap flag
   vtkBooleanMacro(UseFractionalLabelmap, bool);
 
+  /// Get number of threads used for computing the DVH of the segments
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used for computing the DVH of the segments
+  vtkSetMacro(NumberOfThreads, int);
+
+  /// Get multi-label computation flag
+  vtkGetMacro(UseMultiLabelComputation, bool);
+  /// Set multi-label computation flag
+  vtkSetMacro(UseMultiLabelComputation, bool);
+  /// Set multi-label computation flag
+  vtkBooleanMacro(UseMultiLabelComputation, bool);
+
 protected:
   /// Set and observe DVH metrics table node
   /// Metrics table node is unique and mandatory for each DVH node, so it is created within the node.
@@ -254,6 +266,18 @@ protected:
 
   /// Flag telling whether or not to use fractional labelmaps
   bool UseFractionalLabelmap;
+
+  /// Number of threads used for computing the DVH of the segments concurrently.
+  /// In multi-label computation the segment labelmaps are resampled concurrently and the slices
+  /// of the dose volume are split between the threads in the common traversal.
+  /// If 1, then the segments are processed one after the other.
+  /// If 0 (default), then the current number of threads of the VTK SMP backend is used.
+  /// \sa SlicerRtCommon::SmpFor
+  int NumberOfThreads;
+
+  /// Flag telling whether the DVH of all the segments are computed in one traversal of the dose volume.
+  /// Only used with fixed oversampling, as with automatic oversampling each segment has its own geometry.
+  bool UseMultiLabelComputation;
 };
 
 #endif
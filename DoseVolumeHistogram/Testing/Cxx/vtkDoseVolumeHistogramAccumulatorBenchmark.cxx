@@ -0,0 +1,212 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DoseVolumeHistogram includes
+#include "vtkDoseVolumeHistogramAccumulator.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+  //-----------------------------------------------------------------------------
+  /// Results of the accumulator for one labelmap
+  struct AccumulatorResults
+  {
+    vtkIdType VoxelCount;
+    double FractionalVoxelCount;
+    double Mean;
+    double Minimum;
+    double Maximum;
+    double VoxelCountBelowStartValue;
+    std::vector<double> Histogram;
+  };
+
+  //-----------------------------------------------------------------------------
+  /// Run the accumulator the given number of times and return the average computation time in seconds
+  double RunAccumulator(vtkDoseVolumeHistogramAccumulator* accumulator, bool useFastPath, int numberOfThreads,
+    int numberOfRepetitions, AccumulatorResults& results)
+  {
+    vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+    double totalTime = 0.0;
+    accumulator->SetUseFastPath(useFastPath);
+    accumulator->SetNumberOfThreads(numberOfThreads);
+    for (int i = 0; i < numberOfRepetitions; ++i)
+    {
+      timer->StartTimer();
+      accumulator->Update();
+      timer->StopTimer();
+      totalTime += timer->GetElapsedTime();
+    }
+
+    results.VoxelCount = accumulator->GetVoxelCount(0);
+    results.FractionalVoxelCount = accumulator->GetFractionalVoxelCount(0);
+    results.Mean = accumulator->GetMean(0);
+    results.Minimum = accumulator->GetMinimum(0);
+    results.Maximum = accumulator->GetMaximum(0);
+    results.VoxelCountBelowStartValue = accumulator->GetVoxelCountBelowStartValue(0);
+    vtkDoubleArray* histogram = accumulator->GetHistogram(0);
+    results.Histogram.assign(histogram->GetPointer(0), histogram->GetPointer(0) + histogram->GetNumberOfTuples());
+
+    return totalTime / numberOfRepetitions;
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Compare results to the reference results
+  bool CompareResults(const AccumulatorResults& results, const AccumulatorResults& referenceResults)
+  {
+    const double tolerance = 1e-6;
+    bool resultsMatch = true;
+    if (results.VoxelCount != referenceResults.VoxelCount)
+    {
+      std::cerr << "Voxel count mismatch: " << results.VoxelCount << " != " << referenceResults.VoxelCount << std::endl;
+      resultsMatch = false;
+    }
+    if (fabs(results.FractionalVoxelCount - referenceResults.FractionalVoxelCount) > tolerance * referenceResults.FractionalVoxelCount)
+    {
+      std::cerr << "Fractional voxel count mismatch: " << results.FractionalVoxelCount << " != " << referenceResults.FractionalVoxelCount << std::endl;
+      resultsMatch = false;
+    }
+    if (fabs(results.Mean - referenceResults.Mean) > tolerance * fabs(referenceResults.Mean))
+    {
+      std::cerr << "Mean mismatch: " << results.Mean << " != " << referenceResults.Mean << std::endl;
+      resultsMatch = false;
+    }
+    if (results.Minimum != referenceResults.Minimum || results.Maximum != referenceResults.Maximum)
+    {
+      std::cerr << "Range mismatch: [" << results.Minimum << ", " << results.Maximum
+        << "] != [" << referenceResults.Minimum << ", " << referenceResults.Maximum << "]" << std::endl;
+      resultsMatch = false;
+    }
+    if (fabs(results.VoxelCountBelowStartValue - referenceResults.VoxelCountBelowStartValue)
+      > tolerance * std::max(1.0, referenceResults.VoxelCountBelowStartValue))
+    {
+      std::cerr << "Voxel count below start value mismatch: " << results.VoxelCountBelowStartValue
+        << " != " << referenceResults.VoxelCountBelowStartValue << std::endl;
+      resultsMatch = false;
+    }
+    for (unsigned int binIndex = 0; binIndex < referenceResults.Histogram.size(); ++binIndex)
+    {
+      if (fabs(results.Histogram[binIndex] - referenceResults.Histogram[binIndex]) > tolerance * std::max(1.0, fabs(referenceResults.Histogram[binIndex])))
+      {
+        std::cerr << "Histogram mismatch in bin " << binIndex << ": " << results.Histogram[binIndex] << " != " << referenceResults.Histogram[binIndex] << std::endl;
+        resultsMatch = false;
+        break;
+      }
+    }
+    return resultsMatch;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Compare the results and the computation times of the optimized (single-component, single and
+/// multi-threaded) and the generic implementation of vtkDoseVolumeHistogramAccumulator on a synthetic dose volume
+int vtkDoseVolumeHistogramAccumulatorBenchmark(int argc, char* argv[])
+{
+  int numberOfRepetitions = 5;
+  if (argc > 2 && STRCASECMP(argv[1], "-NumberOfRepetitions") == 0)
+  {
+    numberOfRepetitions = atoi(argv[2]);
+    if (numberOfRepetitions < 1)
+    {
+      numberOfRepetitions = 1;
+    }
+  }
+
+  // Create synthetic dose volume (smooth dose distribution peaking in the center)
+  const int dimensions[3] = { 256, 256, 100 };
+  vtkSmartPointer<vtkImageData> doseVolume = vtkSmartPointer<vtkImageData>::New();
+  doseVolume->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  doseVolume->SetSpacing(1.0, 1.0, 2.5);
+  doseVolume->AllocateScalars(VTK_FLOAT, 1);
+
+  // Create fractional labelmap of a sphere with partial voxels on its boundary
+  vtkSmartPointer<vtkImageData> fractionalLabelmap = vtkSmartPointer<vtkImageData>::New();
+  fractionalLabelmap->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  fractionalLabelmap->SetSpacing(1.0, 1.0, 2.5);
+  fractionalLabelmap->AllocateScalars(VTK_CHAR, 1);
+
+  const double minimumFractionalValue = -108.0;
+  const double maximumFractionalValue = 108.0;
+  const double radius = 80.0;
+  float* dosePtr = static_cast<float*>(doseVolume->GetScalarPointer());
+  char* labelmapPtr = static_cast<char*>(fractionalLabelmap->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        double dx = i - dimensions[0] / 2.0;
+        double dy = j - dimensions[1] / 2.0;
+        double dz = (k - dimensions[2] / 2.0) * 2.5;
+        double distance = sqrt(dx*dx + dy*dy + dz*dz);
+        *(dosePtr++) = static_cast<float>(70.0 * exp(-distance*distance / 5000.0));
+        double fraction = std::min(1.0, std::max(0.0, radius + 0.5 - distance));
+        *(labelmapPtr++) = static_cast<char>(floor(minimumFractionalValue + fraction * (maximumFractionalValue - minimumFractionalValue) + 0.5));
+      }
+    }
+  }
+
+  vtkSmartPointer<vtkDoseVolumeHistogramAccumulator> accumulator = vtkSmartPointer<vtkDoseVolumeHistogramAccumulator>::New();
+  accumulator->SetDoseVolume(doseVolume);
+  accumulator->AddLabelmap(fractionalLabelmap, minimumFractionalValue, maximumFractionalValue);
+  accumulator->UseFractionalLabelmapOn();
+  accumulator->SetStartValue(0.1);
+  accumulator->SetStepSize(0.1);
+  accumulator->SetNumberOfBins(1000);
+
+  // Generic implementation
+  AccumulatorResults genericResults;
+  double genericTime = RunAccumulator(accumulator, false, 1, numberOfRepetitions, genericResults);
+
+  // Optimized implementation, single-threaded
+  AccumulatorResults fastResults;
+  double fastTime = RunAccumulator(accumulator, true, 1, numberOfRepetitions, fastResults);
+  bool resultsMatch = CompareResults(fastResults, genericResults);
+
+  // Optimized implementation, multi-threaded
+  AccumulatorResults multithreadedResults;
+  double multithreadedTime = RunAccumulator(accumulator, true, 0, numberOfRepetitions, multithreadedResults);
+  resultsMatch = CompareResults(multithreadedResults, genericResults) && resultsMatch;
+
+  std::cout << "Computation time of generic implementation: " << genericTime << " s" << std::endl;
+  std::cout << "Computation time of optimized implementation: " << fastTime << " s" << std::endl;
+  std::cout << "Computation time of optimized multi-threaded implementation: " << multithreadedTime << " s" << std::endl;
+  if (fastTime > 0.0 && multithreadedTime > 0.0)
+  {
+    std::cout << "Speedup: " << genericTime / fastTime << "x (single-threaded), "
+      << genericTime / multithreadedTime << "x (multi-threaded)" << std::endl;
+  }
+
+  if (!resultsMatch)
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Results of the optimized and generic implementations match" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// DoseVolumeHistogram includes
+#include "vtkDoseVolumeHistogramAccumulator.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+  const double MINIMUM_FRACTIONAL_VALUE = -108.0;
+  const double MAXIMUM_FRACTIONAL_VALUE = 108.0;
+  /// Dose of the first and last voxel of each row, with opposite signs
+  const double LARGE_DOSE = 1.0e9;
+  /// Dose of the other voxels. Power of two, so that the reference dose sum can be computed exactly.
+  const double SMALL_DOSE = 1.0 / 1024.0;
+
+  //-----------------------------------------------------------------------------
+  bool CheckValue(const char* name, double value, double referenceValue)
+  {
+    const double tolerance = 1e-12;
+    if (fabs(value - referenceValue) > tolerance * fabs(referenceValue))
+    {
+      std::cerr << name << " mismatch: " << value << " != " << referenceValue
+        << " (relative error: " << fabs(value - referenceValue) / fabs(referenceValue) << ")" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Accumulate a large fractional labelmap where the first and last voxels of each row have a large dose with
+/// opposite signs and the voxels between them have a small dose, so that the dose sum is badly conditioned.
+/// The totals computed by the accumulator in all traversal modes are compared to the exact reference totals.
+int vtkDoseVolumeHistogramAccumulatorTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int dimensions[3] = { 256, 256, 64 };
+  vtkSmartPointer<vtkImageData> doseVolume = vtkSmartPointer<vtkImageData>::New();
+  doseVolume->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  doseVolume->AllocateScalars(VTK_FLOAT, 1);
+  vtkSmartPointer<vtkImageData> fractionalLabelmap = vtkSmartPointer<vtkImageData>::New();
+  fractionalLabelmap->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  fractionalLabelmap->AllocateScalars(VTK_CHAR, 1);
+
+  // The sum of the labelmap values (offset by the minimum) is computed exactly with integers
+  vtkTypeInt64 innerLabelmapValueSum = 0;
+  vtkTypeInt64 numberOfRows = 0;
+  const int fractionalRange = static_cast<int>(MAXIMUM_FRACTIONAL_VALUE - MINIMUM_FRACTIONAL_VALUE);
+  float* dosePtr = static_cast<float*>(doseVolume->GetScalarPointer());
+  char* labelmapPtr = static_cast<char*>(fractionalLabelmap->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        if (i == 0 || i == dimensions[0] - 1)
+        {
+          // Fully inside voxels with large dose, which cancel each other out in the dose sum
+          *(dosePtr++) = static_cast<float>(i == 0 ? LARGE_DOSE : -LARGE_DOSE);
+          *(labelmapPtr++) = static_cast<char>(MAXIMUM_FRACTIONAL_VALUE);
+          continue;
+        }
+        int labelmapValue = (i * 7 + j * 13 + k * 31) % (fractionalRange + 1);
+        innerLabelmapValueSum += labelmapValue;
+        *(dosePtr++) = static_cast<float>(SMALL_DOSE);
+        *(labelmapPtr++) = static_cast<char>(MINIMUM_FRACTIONAL_VALUE + labelmapValue);
+      }
+      ++numberOfRows;
+    }
+  }
+
+  // Reference totals
+  double referenceInnerFractionalVoxelCount = static_cast<double>(innerLabelmapValueSum) / fractionalRange;
+  double referenceFractionalVoxelCount =
+    static_cast<double>(innerLabelmapValueSum + 2 * numberOfRows * fractionalRange) / fractionalRange;
+  double referenceMean = SMALL_DOSE * static_cast<double>(innerLabelmapValueSum)
+    / static_cast<double>(innerLabelmapValueSum + 2 * numberOfRows * fractionalRange);
+  double referenceVoxelCountBelowStartValue = static_cast<double>(numberOfRows);
+
+  bool resultsMatch = true;
+  for (int multiLabelTraversal = 0; multiLabelTraversal <= 1; ++multiLabelTraversal)
+  {
+    for (int useFastPath = 0; useFastPath <= 1; ++useFastPath)
+    {
+      for (int numberOfThreads = 0; numberOfThreads <= 1; ++numberOfThreads)
+      {
+        std::cout << "Accumulate with multi-label traversal: " << multiLabelTraversal << ", fast path: " << useFastPath
+          << ", number of threads: " << numberOfThreads << std::endl;
+        vtkSmartPointer<vtkDoseVolumeHistogramAccumulator> accumulator = vtkSmartPointer<vtkDoseVolumeHistogramAccumulator>::New();
+        accumulator->SetDoseVolume(doseVolume);
+        accumulator->AddLabelmap(fractionalLabelmap, MINIMUM_FRACTIONAL_VALUE, MAXIMUM_FRACTIONAL_VALUE);
+        if (multiLabelTraversal)
+        {
+          // The multi-label traversal is only used for multiple labelmaps
+          accumulator->AddLabelmap(fractionalLabelmap, MINIMUM_FRACTIONAL_VALUE, MAXIMUM_FRACTIONAL_VALUE);
+        }
+        accumulator->UseFractionalLabelmapOn();
+        accumulator->SetMultiLabelTraversal(multiLabelTraversal != 0);
+        accumulator->SetUseFastPath(useFastPath != 0);
+        accumulator->SetNumberOfThreads(numberOfThreads);
+        accumulator->SetStartValue(0.0);
+        accumulator->SetStepSize(1.0);
+        accumulator->SetNumberOfBins(4);
+        if (!accumulator->Update())
+        {
+          std::cerr << "Failed to accumulate dose" << std::endl;
+          return EXIT_FAILURE;
+        }
+
+        for (int labelmapIndex = 0; labelmapIndex < accumulator->GetNumberOfLabelmaps(); ++labelmapIndex)
+        {
+          resultsMatch = CheckValue("Fractional voxel count",
+            accumulator->GetFractionalVoxelCount(labelmapIndex), referenceFractionalVoxelCount) && resultsMatch;
+          resultsMatch = CheckValue("Mean",
+            accumulator->GetMean(labelmapIndex), referenceMean) && resultsMatch;
+          resultsMatch = CheckValue("Voxel count below start value",
+            accumulator->GetVoxelCountBelowStartValue(labelmapIndex), referenceVoxelCountBelowStartValue) && resultsMatch;
+          // Only the voxels with small dose are in the histogram range
+          resultsMatch = CheckValue("Histogram",
+            accumulator->GetHistogram(labelmapIndex)->GetValue(0), referenceInnerFractionalVoxelCount) && resultsMatch;
+        }
+      }
+    }
+  }
+
+  if (!resultsMatch)
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Accumulated totals match the reference totals" << std::endl;
+  return EXIT_SUCCESS;
+}
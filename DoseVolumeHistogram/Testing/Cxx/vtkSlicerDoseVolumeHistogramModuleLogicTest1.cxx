@@ -305,6 +305,28 @@ int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
     std::cerr << "Invalid arguments!" << std::endl;
     return EXIT_FAILURE;
   }
+  // NumberOfThreads (optional)
+  int numberOfThreads = 1;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-NumberOfThreads") == 0)
+    {
+      numberOfThreads = vtkVariant(argv[argIndex+1]).ToInt();
+      std::cout << "Number of threads: " << numberOfThreads << std::endl;
+      argIndex += 2;
+    }
+  }
+  // UseMultiLabelComputation (optional)
+  bool useMultiLabelComputation = false;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-UseMultiLabelComputation") == 0)
+    {
+      useMultiLabelComputation = (vtkVariant(argv[argIndex+1]).ToInt() != 0);
+      std::cout << "Use multi-label computation: " << (useMultiLabelComputation ? "true" : "false") << std::endl;
+      argIndex += 2;
+    }
+  }
 
   // Constraint the criteria to be greater than zero
   if (volumeDifferenceCriterion == 0.0)
@@ -393,6 +415,8 @@ int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
   paramNode->SetAndObserveDoseVolumeNode(doseScalarVolumeNode);
   paramNode->SetAndObserveSegmentationNode(segmentationNode);
   paramNode->SetAutomaticOversampling(automaticOversamplingCalculation);
+  paramNode->SetNumberOfThreads(numberOfThreads);
+  paramNode->SetUseMultiLabelComputation(useMultiLabelComputation);
 
   // Setup chart node
   vtkMRMLChartNode* chartNode = paramNode->GetChartNode();
@@ -443,6 +467,71 @@ int vtkSlicerDoseVolumeHistogramModuleLogicTest1( int argc, char * argv[] )
   UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
   std::cout << "DVH computation time (including rasterization): " << checkpointEnd-checkpointStart << " s" << std::endl;
 
+  // Compute DVH again. The dose volume has not changed, so the maximum dose and all cached dose volumes
+  // must be taken from the cache, and no new dose volume is added to it
+  int doseCacheHitCount = dvhLogic->GetDoseCacheHitCount();
+  int numberOfCachedDoseImages = dvhLogic->GetNumberOfCachedDoseImages();
+  if (numberOfCachedDoseImages < 1 || dvhLogic->GetDoseCacheSizeMB() > dvhLogic->GetDoseCacheSizeLimitMB())
+  {
+    std::cerr << "ERROR: Invalid dose cache after computing DVH: " << numberOfCachedDoseImages << " images, "
+      << dvhLogic->GetDoseCacheSizeMB() << " MB (limit: " << dvhLogic->GetDoseCacheSizeLimitMB() << " MB)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  errorMessage = dvhLogic->ComputeDvh(paramNode);
+  if (!errorMessage.empty())
+  {
+    std::cerr << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ( dvhLogic->GetDoseCacheHitCount() - doseCacheHitCount < 1 + numberOfCachedDoseImages
+    || dvhLogic->GetNumberOfCachedDoseImages() != numberOfCachedDoseImages )
+  {
+    std::cerr << "ERROR: Cached dose data was not used when computing DVH again on the same dose volume! Cache hits: "
+      << dvhLogic->GetDoseCacheHitCount() - doseCacheHitCount << ", expected at least " << 1 + numberOfCachedDoseImages
+      << ". Cached images: " << dvhLogic->GetNumberOfCachedDoseImages() << ", expected " << numberOfCachedDoseImages << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Lowering the size limit below the size of the cached dose volumes evicts images immediately, and the
+  // computation must stay within the limit
+  double doseCacheSizeLimitMB = dvhLogic->GetDoseCacheSizeLimitMB();
+  double reducedDoseCacheSizeLimitMB = dvhLogic->GetDoseCacheSizeMB() * 0.99;
+  dvhLogic->SetDoseCacheSizeLimitMB(reducedDoseCacheSizeLimitMB);
+  if ( dvhLogic->GetNumberOfCachedDoseImages() >= numberOfCachedDoseImages
+    || dvhLogic->GetDoseCacheSizeMB() > reducedDoseCacheSizeLimitMB )
+  {
+    std::cerr << "ERROR: Dose volumes were not evicted from the cache after reducing its size limit! Cached images: "
+      << dvhLogic->GetNumberOfCachedDoseImages() << ", size: " << dvhLogic->GetDoseCacheSizeMB() << " MB" << std::endl;
+    return EXIT_FAILURE;
+  }
+  errorMessage = dvhLogic->ComputeDvh(paramNode);
+  if (!errorMessage.empty())
+  {
+    std::cerr << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (dvhLogic->GetDoseCacheSizeMB() > reducedDoseCacheSizeLimitMB)
+  {
+    std::cerr << "ERROR: Dose cache size " << dvhLogic->GetDoseCacheSizeMB() << " MB exceeds the limit of " << reducedDoseCacheSizeLimitMB << " MB!" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Size limit of 0 disables the cache
+  dvhLogic->SetDoseCacheSizeLimitMB(0.0);
+  errorMessage = dvhLogic->ComputeDvh(paramNode);
+  if (!errorMessage.empty())
+  {
+    std::cerr << errorMessage << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (dvhLogic->GetNumberOfCachedDoseImages() != 0 || dvhLogic->GetDoseCacheHitCount() != 0)
+  {
+    std::cerr << "ERROR: Dose cache is used after disabling it! Cached images: " << dvhLogic->GetNumberOfCachedDoseImages()
+      << ", cache hits: " << dvhLogic->GetDoseCacheHitCount() << std::endl;
+    return EXIT_FAILURE;
+  }
+  dvhLogic->SetDoseCacheSizeLimitMB(doseCacheSizeLimitMB);
+
   std::vector<vtkMRMLDoubleArrayNode*> dvhNodes;
   paramNode->GetDvhArrayNodes(dvhNodes);
 
@@ -31,6 +31,7 @@
 // VTK includes
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkVariant.h>
 
 // STD includes
 #include <sstream>
@@ -49,6 +50,7 @@ vtkMRMLIsodoseNode::vtkMRMLIsodoseNode()
   this->ShowIsodoseSurfaces = true;
   this->ShowScalarBar = false;
   this->ShowDoseVolumesOnly = true;
+  this->NumberOfThreads = 0;
 
   this->HideFromEditors = false;
 }
@@ -67,6 +69,7 @@ void vtkMRMLIsodoseNode::WriteXML(ostream& of, int nIndent)
   of << " ShowIsodoseLines=\"" << (this->ShowIsodoseLines ? "true" : "false") << "\"";
   of << " ShowIsodoseSurfaces=\"" << (this->ShowIsodoseSurfaces ? "true" : "false") << "\"";
   of << " ShowScalarBar=\"" << (this->ShowScalarBar ? "true" : "false") << "\"";
+  of << " NumberOfThreads=\"" << this->NumberOfThreads << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -98,6 +101,10 @@ void vtkMRMLIsodoseNode::ReadXMLAttributes(const char** atts)
       this->ShowScalarBar = 
         (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "NumberOfThreads")) 
+      {
+      this->NumberOfThreads = vtkVariant(attValue).ToInt();
+      }
     }
 }
 
@@ -114,6 +121,7 @@ void vtkMRMLIsodoseNode::Copy(vtkMRMLNode *anode)
   this->ShowIsodoseLines = node->ShowIsodoseLines;
   this->ShowIsodoseSurfaces = node->ShowIsodoseSurfaces;
   this->ShowScalarBar = node->ShowScalarBar;
+  this->NumberOfThreads = node->NumberOfThreads;
 
   this->DisableModifiedEventOff();
   this->InvokePendingModifiedEvent();
@@ -127,6 +135,7 @@ void vtkMRMLIsodoseNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ShowIsodoseLines:   " << (this->ShowIsodoseLines ? "true" : "false") << "\n";
   os << indent << "ShowIsodoseSurfaces:   " << (this->ShowIsodoseSurfaces ? "true" : "false") << "\n";
   os << indent << "ShowScalarBar:   " << (this->ShowScalarBar ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads:   " << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -87,6 +87,12 @@ public:
   vtkSetMacro(ShowDoseVolumesOnly, bool);
   vtkBooleanMacro(ShowDoseVolumesOnly, bool);
 
+  /// Get number of threads used for generating the isodose surfaces of the levels concurrently
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used for generating the isodose surfaces of the levels concurrently.
+  /// 1 means the levels are processed one after the other. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+
 protected:
   vtkMRMLIsodoseNode();
   ~vtkMRMLIsodoseNode();
@@ -105,6 +111,9 @@ protected:
 
   /// State of Show dose volumes only checkbox
   bool ShowDoseVolumesOnly;
+
+  /// Number of threads used for generating the isodose surfaces
+  int NumberOfThreads;
 };
 
 #endif
@@ -48,6 +48,7 @@
 
 // VTK includes
 #include <vtkNew.h>
+#include <vtkAtomic.h>
 #include <vtkImageData.h>
 #include <vtkImageMarchingCubes.h>
 #include <vtkImageChangeInformation.h>
@@ -62,9 +63,13 @@
 #include <vtkColorTransferFunction.h>
 #include <vtkWindowedSincPolyDataFilter.h>
 #include <vtkTransformPolyDataFilter.h>
+#include <vtkMultiThreader.h>
 #include <vtkObjectFactory.h>
 #include "vtksys/SystemTools.hxx"
 
+// STD includes
+#include <vector>
+
 //----------------------------------------------------------------------------
 const char* vtkSlicerIsodoseModuleLogic::DEFAULT_ISODOSE_COLOR_TABLE_FILE_NAME = "Isodose_ColorTable.ctbl";
 const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX = "IsodoseLevel_";
@@ -74,6 +79,119 @@ const std::string vtkSlicerIsodoseModuleLogic::ISODOSE_ROOT_HIERARCHY_NAME_POSTF
 static const char* ISODOSE_ROOT_MODEL_HIERARCHY_REFERENCE_ROLE = "isodoseRootModelHierarchyRef";
 static const char* ISODOSE_ROOT_MODEL_HIERARCHY_DISPLAY_REFERENCE_ROLE = "isodoseRootModelHierarchyDisplayRef";
 
+//----------------------------------------------------------------------------
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Create isodose surface from the dose volume for one level
+  /// \return Isodose surface in RAS coordinate system, NULL if the level has no surface
+  vtkSmartPointer<vtkPolyData> CreateIsodoseSurface(vtkImageData* doseVolumeImage, double isoLevel, vtkMatrix4x4* inputIJK2RASMatrix)
+  {
+    vtkSmartPointer<vtkImageMarchingCubes> marchingCubes = vtkSmartPointer<vtkImageMarchingCubes>::New();
+    marchingCubes->SetInputData(doseVolumeImage);
+    marchingCubes->SetNumberOfContours(1); 
+    marchingCubes->SetValue(0, isoLevel);
+    marchingCubes->ComputeScalarsOff();
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff();
+    marchingCubes->Update();
+
+    vtkSmartPointer<vtkPolyData> isoPolyData= marchingCubes->GetOutput();
+    if (isoPolyData->GetNumberOfPoints() < 1)
+    {
+      return NULL;
+    }
+
+    vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
+    triangleFilter->SetInputData(marchingCubes->GetOutput());
+    triangleFilter->Update();
+
+    vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+    decimate->SetInputData(triangleFilter->GetOutput());
+    decimate->SetTargetReduction(0.6);
+    decimate->SetFeatureAngle(60);
+    decimate->SplittingOff();
+    decimate->PreserveTopologyOn();
+    decimate->SetMaximumError(1);
+    decimate->Update();
+
+    vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
+    smootherSinc->SetPassBand(0.1);
+    smootherSinc->SetInputData(decimate->GetOutput() );
+    smootherSinc->SetNumberOfIterations(2);
+    smootherSinc->FeatureEdgeSmoothingOff();
+    smootherSinc->BoundarySmoothingOff();
+    smootherSinc->Update();
+
+    vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+    normals->SetInputData(smootherSinc->GetOutput());
+    normals->ComputePointNormalsOn();
+    normals->SetFeatureAngle(60);
+    normals->Update();
+
+    vtkSmartPointer<vtkTransform> inputIJKToRASTransform = vtkSmartPointer<vtkTransform>::New();
+    inputIJKToRASTransform->Identity();
+    inputIJKToRASTransform->SetMatrix(inputIJK2RASMatrix);
+
+    vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+    transformPolyData->SetInputData(normals->GetOutput());
+    transformPolyData->SetTransform(inputIJKToRASTransform);
+    transformPolyData->Update();
+
+    return transformPolyData->GetOutput();
+  }
+
+  //----------------------------------------------------------------------------
+  /// Create isodose surfaces for a range of levels. Only VTK filters are used, so it can run
+  /// in worker threads. MRML nodes for the surfaces need to be created on the main thread.
+  /// Finished levels are counted by all threads, and whenever the thread that created the functor
+  /// finishes a level it reports the progress of all levels, so observers are only called on that thread.
+  class CreateIsodoseSurfacesFunctor
+  {
+  public:
+    CreateIsodoseSurfacesFunctor(const std::vector<vtkSmartPointer<vtkImageData> >& doseVolumeImages,
+      const std::vector<double>& isoLevels, vtkMatrix4x4* inputIJK2RASMatrix, std::vector<vtkSmartPointer<vtkPolyData> >& isodoseSurfaces,
+      vtkObject* progressEventSource, int firstProgressStep, int progressStepCount)
+      : DoseVolumeImages(doseVolumeImages)
+      , IsoLevels(isoLevels)
+      , InputIJK2RASMatrix(inputIJK2RASMatrix)
+      , IsodoseSurfaces(isodoseSurfaces)
+      , ProgressEventSource(progressEventSource)
+      , FirstProgressStep(firstProgressStep)
+      , ProgressStepCount(progressStepCount)
+      , MainThreadID(vtkMultiThreader::GetCurrentThreadID())
+      , NumberOfFinishedLevels(0)
+    {
+    }
+
+    void operator()(vtkIdType beginLevel, vtkIdType endLevel)
+    {
+      for (vtkIdType level = beginLevel; level < endLevel; ++level)
+      {
+        this->IsodoseSurfaces[level] = CreateIsodoseSurface(this->DoseVolumeImages[level], this->IsoLevels[level], this->InputIJK2RASMatrix);
+
+        int numberOfFinishedLevels = ++this->NumberOfFinishedLevels;
+        if (this->ProgressEventSource && vtkMultiThreader::ThreadsEqual(this->MainThreadID, vtkMultiThreader::GetCurrentThreadID()))
+        {
+          double progress = (double)(this->FirstProgressStep + numberOfFinishedLevels) / (double)this->ProgressStepCount;
+          this->ProgressEventSource->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
+        }
+      }
+    }
+
+  private:
+    const std::vector<vtkSmartPointer<vtkImageData> >& DoseVolumeImages;
+    const std::vector<double>& IsoLevels;
+    vtkMatrix4x4* InputIJK2RASMatrix;
+    std::vector<vtkSmartPointer<vtkPolyData> >& IsodoseSurfaces;
+    vtkObject* ProgressEventSource;
+    int FirstProgressStep;
+    int ProgressStepCount;
+    vtkMultiThreaderIDType MainThreadID;
+    vtkAtomic<int> NumberOfFinishedLevels;
+  };
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerIsodoseModuleLogic);
 
@@ -489,7 +607,7 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
   vtkMRMLColorTableNode* colorTableNode = parameterNode->GetColorTableNode();
 
   // Progress
-  int stepCount = 1 /* reslice step */ + colorTableNode->GetNumberOfColors();
+  int stepCount = 1 /* reslice step */ + 2 * colorTableNode->GetNumberOfColors() /* surface and model node steps */;
   int currentStep = 0;
 
   // Reslice dose volume
@@ -530,62 +648,36 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
   double progress = (double)(currentStep) / (double)stepCount;
   this->InvokeEvent(SlicerRtCommon::ProgressUpdated, (void*)&progress);
 
-  // Create isodose surfaces
-  for (int i = 0; i < colorTableNode->GetNumberOfColors(); i++)
+  // Collect isodose levels
+  int numberOfLevels = colorTableNode->GetNumberOfColors();
+  std::vector<double> isoLevels(numberOfLevels, 0.0);
+  std::vector<vtkSmartPointer<vtkImageData> > levelDoseVolumeImages(numberOfLevels);
+  for (int i = 0; i < numberOfLevels; i++)
+  {
+    isoLevels[i] = vtkVariant(colorTableNode->GetColorName(i)).ToDouble();
+
+    // Each level gets its own shallow copy of the resliced dose, so that the pipelines
+    // do not modify the shared image (e.g. by connecting it to a producer) concurrently
+    levelDoseVolumeImages[i] = vtkSmartPointer<vtkImageData>::New();
+    levelDoseVolumeImages[i]->ShallowCopy(reslicedDoseVolumeImage);
+  }
+
+  // Generate isodose surfaces. Levels are independent, so they are processed concurrently
+  std::vector<vtkSmartPointer<vtkPolyData> > isodoseSurfaces(numberOfLevels);
+  CreateIsodoseSurfacesFunctor createIsodoseSurfacesFunctor(levelDoseVolumeImages, isoLevels, inputIJK2RASMatrix, isodoseSurfaces,
+    this, currentStep, stepCount);
+  SlicerRtCommon::SmpFor(0, numberOfLevels, 1, createIsodoseSurfacesFunctor, parameterNode->GetNumberOfThreads());
+  currentStep += numberOfLevels;
+
+  // Create isodose model nodes
+  for (int i = 0; i < numberOfLevels; i++)
   {
     double val[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
     const char* strIsoLevel = colorTableNode->GetColorName(i);
-    double isoLevel = vtkVariant(strIsoLevel).ToDouble();
     colorTableNode->GetColor(i, val);
 
-    vtkSmartPointer<vtkImageMarchingCubes> marchingCubes = vtkSmartPointer<vtkImageMarchingCubes>::New();
-    marchingCubes->SetInputData(reslicedDoseVolumeImage);
-    marchingCubes->SetNumberOfContours(1); 
-    marchingCubes->SetValue(0, isoLevel);
-    marchingCubes->ComputeScalarsOff();
-    marchingCubes->ComputeGradientsOff();
-    marchingCubes->ComputeNormalsOff();
-    marchingCubes->Update();
-
-    vtkSmartPointer<vtkPolyData> isoPolyData= marchingCubes->GetOutput();
-    if (isoPolyData->GetNumberOfPoints() >= 1)
+    if (isodoseSurfaces[i].GetPointer() != NULL)
     {
-      vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
-      triangleFilter->SetInputData(marchingCubes->GetOutput());
-      triangleFilter->Update();
-
-      vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
-      decimate->SetInputData(triangleFilter->GetOutput());
-      decimate->SetTargetReduction(0.6);
-      decimate->SetFeatureAngle(60);
-      decimate->SplittingOff();
-      decimate->PreserveTopologyOn();
-      decimate->SetMaximumError(1);
-      decimate->Update();
-
-      vtkSmartPointer<vtkWindowedSincPolyDataFilter> smootherSinc = vtkSmartPointer<vtkWindowedSincPolyDataFilter>::New();
-      smootherSinc->SetPassBand(0.1);
-      smootherSinc->SetInputData(decimate->GetOutput() );
-      smootherSinc->SetNumberOfIterations(2);
-      smootherSinc->FeatureEdgeSmoothingOff();
-      smootherSinc->BoundarySmoothingOff();
-      smootherSinc->Update();
-
-      vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
-      normals->SetInputData(smootherSinc->GetOutput());
-      normals->ComputePointNormalsOn();
-      normals->SetFeatureAngle(60);
-      normals->Update();
-
-      vtkSmartPointer<vtkTransform> inputIJKToRASTransform = vtkSmartPointer<vtkTransform>::New();
-      inputIJKToRASTransform->Identity();
-      inputIJKToRASTransform->SetMatrix(inputIJK2RASMatrix);
-
-      vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyData = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-      transformPolyData->SetInputData(normals->GetOutput());
-      transformPolyData->SetTransform(inputIJKToRASTransform);
-      transformPolyData->Update();
-  
       vtkSmartPointer<vtkMRMLModelDisplayNode> displayNode = vtkSmartPointer<vtkMRMLModelDisplayNode>::New();
       displayNode = vtkMRMLModelDisplayNode::SafeDownCast(this->GetMRMLScene()->AddNode(displayNode));
       displayNode->SliceIntersectionVisibilityOn();  
@@ -605,7 +697,7 @@ void vtkSlicerIsodoseModuleLogic::CreateIsodoseSurfaces(vtkMRMLIsodoseNode* para
       std::string isodoseModelNodeName = vtkSlicerIsodoseModuleLogic::ISODOSE_MODEL_NODE_NAME_PREFIX + strIsoLevel + doseUnitName;
       isodoseModelNode->SetName(isodoseModelNodeName.c_str());
       isodoseModelNode->SetAndObserveDisplayNodeID(displayNode->GetID());
-      isodoseModelNode->SetAndObservePolyData(transformPolyData->GetOutput());
+      isodoseModelNode->SetAndObservePolyData(isodoseSurfaces[i]);
       isodoseModelNode->SetSelectable(1);
       isodoseModelNode->SetAttribute(SlicerRtCommon::DICOMRTIMPORT_ISODOSE_MODEL_IDENTIFIER_ATTRIBUTE_NAME.c_str(), "1");
       shNode->RequestOwnerPluginSearch(isodoseModelNode); // The attribute above distinguishes isodoses from regular models
@@ -131,6 +131,18 @@ int vtkSlicerIsodoseModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  // NumberOfThreads (optional)
+  int numberOfThreads = 0;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-NumberOfThreads") == 0)
+    {
+      numberOfThreads = vtkVariant(argv[argIndex+1]).ToInt();
+      std::cout << "Number of threads: " << numberOfThreads << std::endl;
+      argIndex += 2;
+    }
+  }
+
   // Constraint the criteria to be greater than zero
   if (volumeDifferenceToleranceCc == 0.0)
   {
@@ -187,6 +199,7 @@ int vtkSlicerIsodoseModuleLogicTest1( int argc, char * argv[] )
   mrmlScene->AddNode(paramNode);
   paramNode->SetAndObserveDoseVolumeNode(doseScalarVolumeNode);
   paramNode->SetAndObserveColorTableNode(isodoseColorNode);
+  paramNode->SetNumberOfThreads(numberOfThreads);
 
   // Compute isodose
   isodoseLogic->CreateIsodoseSurfaces(paramNode);
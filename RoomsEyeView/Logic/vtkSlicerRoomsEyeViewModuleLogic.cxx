@@ -25,7 +25,8 @@
 
 // SlicerRT includes
 #include "vtkMRMLRTBeamNode.h"
-#include "vtkCollisionDetectionFilter.h"
+#include "vtkCollisionProxyMeshFilter.h"
+#include "vtkCollisionScene.h"
 
 // MRML includes
 #include <vtkMRMLScene.h>
@@ -35,13 +36,17 @@
 #include <vtkMRMLViewNode.h>
 #include <vtkMRMLModelHierarchyNode.h>
 #include <vtkMRMLModelDisplayNode.h>
+#include <vtkMRMLSegmentationNode.h>
 
 // Slicer includes
+#include <vtkSlicerApplicationLogic.h>
 #include <vtkSlicerModelsLogic.h>
 #include <vtkSlicerSegmentationsModuleLogic.h>
 
 // vtkSegmentationCore includes
 #include <vtkSegmentationConverter.h>
+#include <vtkSegmentation.h>
+#include <vtkSegment.h>
 
 // VTK includes
 #include <vtkSmartPointer.h>
@@ -53,6 +58,19 @@
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkGeneralTransform.h>
 #include <vtkTransformFilter.h>
+#include <vtkPolyData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkTable.h>
+#include <vtkXMLPolyDataReader.h>
+#include <vtkXMLPolyDataWriter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 //----------------------------------------------------------------------------
 // Treatment machine component names
@@ -72,28 +90,58 @@ const char* vtkSlicerRoomsEyeViewModuleLogic::ORIENTATION_MARKER_MODEL_NODE_NAME
 //TODO: Add this dynamically to the IEC transform map
 static const char* ADDITIONALCOLLIMATORMOUNTEDDEVICES_TO_COLLIMATOR_TRANSFORM_NODE_NAME = "AdditionalCollimatorDevicesToCollimatorTransform";
 
+// Collision scene part names (also used in the collision status messages)
+static const char* GANTRY_COLLISION_PART_NAME = "gantry";
+static const char* COLLIMATOR_COLLISION_PART_NAME = "collimator";
+static const char* TABLETOP_COLLISION_PART_NAME = "table top";
+static const char* PATIENTSUPPORT_COLLISION_PART_NAME = "patient support";
+static const char* PATIENT_COLLISION_PART_NAME = "patient";
+
+//----------------------------------------------------------------------------
+// Rotations of the IEC coordinate systems relative to their parents. They are applied to (pre-multiplied with)
+// the given transform, so they can both set up the MRML transform nodes starting from identity, and build
+// the part to world transforms of the collision checks starting from the parent to world transform.
+namespace
+{
+  /// Rotate collimator relative to gantry
+  void RotateCollimatorToGantry(vtkTransform* transform, double collimatorAngle)
+  {
+    transform->RotateZ(collimatorAngle);
+  }
+
+  /// Rotate gantry relative to fixed reference
+  void RotateGantryToFixedReference(vtkTransform* transform, double gantryAngle)
+  {
+    transform->RotateY(gantryAngle * (-1.0));
+  }
+
+  /// Rotate patient support relative to fixed reference
+  void RotatePatientSupportRotationToFixedReference(vtkTransform* transform, double patientSupportRotationAngle)
+  {
+    transform->RotateZ(patientSupportRotationAngle);
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerRoomsEyeViewModuleLogic);
 
 //----------------------------------------------------------------------------
 vtkSlicerRoomsEyeViewModuleLogic::vtkSlicerRoomsEyeViewModuleLogic()
-  : GantryPatientCollisionDetection(NULL)
-  , GantryTableTopCollisionDetection(NULL)
-  , GantryPatientSupportCollisionDetection(NULL)
-  , CollimatorPatientCollisionDetection(NULL)
-  , CollimatorTableTopCollisionDetection(NULL)
-  , AdditionalModelsTableTopCollisionDetection(NULL)
-  , AdditionalModelsPatientSupportCollisionDetection(NULL)
+  : CollisionScene(NULL)
+  , PatientBodyPolyData(NULL)
+  , PatientBodyPolyDataSourceMTime(0)
+  , PatientBodyPolyDataValid(false)
+  , PatientBodyProxyPolyData(NULL)
+  , CollisionProxySafetyMargin(2.0)
+  , CollisionProxyReadOnlyDirectoryLogged(false)
 {
   this->IECLogic = vtkSlicerIECTransformLogic::New();
 
-  this->GantryPatientCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->GantryTableTopCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->GantryPatientSupportCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->CollimatorPatientCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->CollimatorTableTopCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->AdditionalModelsTableTopCollisionDetection = vtkCollisionDetectionFilter::New();
-  this->AdditionalModelsPatientSupportCollisionDetection = vtkCollisionDetectionFilter::New();
+  this->CollisionScene = vtkCollisionScene::New();
+  this->ContinuousCollisionDetection = false;
+
+  this->PatientBodyPolyData = vtkPolyData::New();
+  this->PatientBodyProxyPolyData = vtkPolyData::New();
 }
 
 //----------------------------------------------------------------------------
@@ -105,40 +153,20 @@ vtkSlicerRoomsEyeViewModuleLogic::~vtkSlicerRoomsEyeViewModuleLogic()
     this->IECLogic = NULL;
   }
 
-  if (this->GantryPatientCollisionDetection)
-  {
-    this->GantryPatientCollisionDetection->Delete();
-    this->GantryPatientCollisionDetection = NULL;
-  }
-  if (this->GantryTableTopCollisionDetection)
+  if (this->CollisionScene)
   {
-    this->GantryTableTopCollisionDetection->Delete();
-    this->GantryTableTopCollisionDetection = NULL;
+    this->CollisionScene->Delete();
+    this->CollisionScene = NULL;
   }
-  if (this->GantryPatientSupportCollisionDetection)
+  if (this->PatientBodyPolyData)
   {
-    this->GantryPatientSupportCollisionDetection->Delete();
-    this->GantryPatientSupportCollisionDetection = NULL;
+    this->PatientBodyPolyData->Delete();
+    this->PatientBodyPolyData = NULL;
   }
-  if (this->CollimatorPatientCollisionDetection)
+  if (this->PatientBodyProxyPolyData)
   {
-    this->CollimatorPatientCollisionDetection->Delete();
-    this->CollimatorPatientCollisionDetection = NULL;
-  }
-  if (this->CollimatorTableTopCollisionDetection)
-  {
-    this->CollimatorTableTopCollisionDetection->Delete();
-    this->CollimatorTableTopCollisionDetection = NULL;
-  }
-  if (this->AdditionalModelsTableTopCollisionDetection)
-  {
-    this->AdditionalModelsTableTopCollisionDetection->Delete();
-    this->AdditionalModelsTableTopCollisionDetection = NULL;
-  }
-  if (this->AdditionalModelsPatientSupportCollisionDetection)
-  {
-    this->AdditionalModelsPatientSupportCollisionDetection->Delete();
-    this->AdditionalModelsPatientSupportCollisionDetection = NULL;
+    this->PatientBodyProxyPolyData->Delete();
+    this->PatientBodyProxyPolyData = NULL;
   }
 }
 
@@ -522,30 +550,42 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupTreatmentMachineModels()
   tableTopModel->CreateDefaultDisplayNodes();
   tableTopModel->GetDisplayNode()->SetColor(0, 0, 0);
 
-  //
-  // Set up collision detection between components
-  this->GantryTableTopCollisionDetection->SetInput(0, gantryModel->GetPolyData());
-  this->GantryTableTopCollisionDetection->SetInput(1, tableTopModel->GetPolyData());
-
-  this->GantryPatientSupportCollisionDetection->SetInput(0, gantryModel->GetPolyData());
-  this->GantryPatientSupportCollisionDetection->SetInput(1, patientSupportModel->GetPolyData());
-
-  this->CollimatorTableTopCollisionDetection->SetInput(0, collimatorModel->GetPolyData());
-  this->CollimatorTableTopCollisionDetection->SetInput(1, tableTopModel->GetPolyData());
-
   //TODO: Whole patient (segmentation, CT) will need to be transformed when the table top is transformed
   //vtkMRMLLinearTransformNode* patientModelTransforms = vtkMRMLLinearTransformNode::SafeDownCast(
   //  this->GetMRMLScene()->GetFirstNodeByName("TableTopEccentricRotationToPatientSupportTransform"));
   //patientModel->SetAndObserveTransformNodeID(patientModelTransforms->GetID());
 
-  // Patient model is set when calculating collisions, as it can be changed dynamically
-  this->GantryPatientCollisionDetection->SetInput(0, gantryModel->GetPolyData());
-  this->CollimatorPatientCollisionDetection->SetInput(0, collimatorModel->GetPolyData());
-  // Set identity transform for patient (parent transform is taken into account when getting poly data from segmentation)
-  vtkSmartPointer<vtkTransform> identityTransform = vtkSmartPointer<vtkTransform>::New();
-  identityTransform->Identity();
-  this->GantryPatientCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(identityTransform));
-  this->CollimatorPatientCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(identityTransform));
+  // Register the treatment room parts and the part pairs to check in the collision scene, so that all pairs
+  // are checked in one call that shares the OBB tree of each part between the pairs
+  this->CollisionScene->RemoveAllParts();
+  int gantryPart = this->CollisionScene->AddPart(GANTRY_COLLISION_PART_NAME, gantryModel->GetPolyData());
+  int collimatorPart = this->CollisionScene->AddPart(COLLIMATOR_COLLISION_PART_NAME, collimatorModel->GetPolyData());
+  int tableTopPart = this->CollisionScene->AddPart(TABLETOP_COLLISION_PART_NAME, tableTopModel->GetPolyData());
+  int patientSupportPart = this->CollisionScene->AddPart(PATIENTSUPPORT_COLLISION_PART_NAME, patientSupportModel->GetPolyData());
+
+  // Simplified proxy meshes are checked first, so that the full meshes are only checked near contact
+  vtkMRMLModelNode* collisionModels[4] = { gantryModel, collimatorModel, tableTopModel, patientSupportModel };
+  const char* collisionModelNames[4] = { GANTRY_MODEL_NAME, COLLIMATOR_MODEL_NAME, TABLETOP_MODEL_NAME, PATIENTSUPPORT_MODEL_NAME };
+  int collisionModelParts[4] = { gantryPart, collimatorPart, tableTopPart, patientSupportPart };
+  for (int modelIndex = 0; modelIndex < 4; ++modelIndex)
+  {
+    vtkSmartPointer<vtkPolyData> proxyMesh = vtkSmartPointer<vtkPolyData>::New();
+    if (this->GetTreatmentMachineCollisionProxyMesh(collisionModels[modelIndex]->GetPolyData(), collisionModelNames[modelIndex], proxyMesh))
+    {
+      this->CollisionScene->SetPartProxyMesh(collisionModelParts[modelIndex], proxyMesh, this->GetCollisionProxyInflation(proxyMesh));
+    }
+  }
+  // Patient mesh is set when calculating collisions, as it can be changed dynamically
+  int patientPart = this->CollisionScene->AddPart(PATIENT_COLLISION_PART_NAME, NULL);
+  this->CollisionScene->AddPartPair(gantryPart, tableTopPart);
+  this->CollisionScene->AddPartPair(gantryPart, patientSupportPart);
+  this->CollisionScene->AddPartPair(collimatorPart, tableTopPart);
+  this->CollisionScene->AddPartPair(gantryPart, patientPart);
+  this->CollisionScene->AddPartPair(collimatorPart, patientPart);
+
+  // Build the OBB trees of the treatment machine parts now, so that the first collision check does not need to.
+  // Moving the parts only changes the transforms, so the trees are kept afterwards.
+  this->CollisionScene->BuildLocators();
 }
 
 //----------------------------------------------------------------------------
@@ -644,17 +684,9 @@ void vtkSlicerRoomsEyeViewModuleLogic::SetupBasicCollimatorMountedDeviceModels()
   //this->GetMRMLScene()->AddNode(outputModel);
   //outputModel->SetAndObservePolyData(output);
  
-  //this->AdditionalModelsTableTopCollisionDetection->SetInput(0, outputModel->GetPolyData());
-  //this->AdditionalModelsTableTopCollisionDetection->SetInput(1, tableTopModel->GetPolyData());
-  //this->AdditionalModelsTableTopCollisionDetection->SetMatrix(0, this->CollimatorToWorldTransformMatrix);
-  //this->AdditionalModelsTableTopCollisionDetection->SetMatrix(1, this->TableTopToWorldTransformMatrix);
-  //this->AdditionalModelsTableTopCollisionDetection->Update();
-
-  //this->AdditionalModelsPatientSupportCollisionDetection->SetInput(0, outputModel->GetPolyData());
-  //this->AdditionalModelsPatientSupportCollisionDetection->SetInput(1, patientSupportModel->GetPolyData());
-  //this->AdditionalModelsPatientSupportCollisionDetection->SetMatrix(0, this->CollimatorToWorldTransformMatrix);
-  //this->AdditionalModelsPatientSupportCollisionDetection->SetMatrix(1, this->TableTopToWorldTransformMatrix);
-  //this->AdditionalModelsPatientSupportCollisionDetection->Update();
+  //int additionalDevicesPart = this->CollisionScene->AddPart("AdditionalDevices", outputModel->GetPolyData());
+  //this->CollisionScene->AddPartPair(additionalDevicesPart, this->CollisionScene->GetPartIndex(TABLETOP_COLLISION_PART_NAME));
+  //this->CollisionScene->AddPartPair(additionalDevicesPart, this->CollisionScene->GetPartIndex(PATIENTSUPPORT_COLLISION_PART_NAME));
 }
 
 //-----------------------------------------------------------------------------
@@ -807,6 +839,186 @@ bool vtkSlicerRoomsEyeViewModuleLogic::GetPatientBodyPolyData(vtkMRMLRoomsEyeVie
     patientBodyPolyData );
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Get the latest modification time of the inputs the patient body poly data is computed from
+  vtkMTimeType GetPatientBodySourceMTime(vtkMRMLSegmentationNode* segmentationNode, const char* segmentID)
+  {
+    vtkMTimeType sourceMTime = std::max(segmentationNode->GetMTime(), segmentationNode->GetSegmentation()->GetMTime());
+    vtkSegment* segment = segmentationNode->GetSegmentation()->GetSegment(segmentID);
+    vtkDataObject* closedSurface = (segment ? segment->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName() ) : NULL);
+    if (closedSurface)
+    {
+      sourceMTime = std::max(sourceMTime, closedSurface->GetMTime());
+    }
+    if (segmentationNode->GetParentTransformNode())
+    {
+      sourceMTime = std::max(sourceMTime, segmentationNode->GetParentTransformNode()->GetMTime());
+    }
+    return sourceMTime;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::UpdatePatientBodyPolyData(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  if (!parameterNode)
+  {
+    vtkErrorMacro("UpdatePatientBodyPolyData: Invalid parameter set node");
+    return false;
+  }
+
+  vtkMRMLSegmentationNode* segmentationNode = parameterNode->GetPatientBodySegmentationNode();
+  const char* segmentID = parameterNode->GetPatientBodySegmentID();
+  if (!segmentationNode || !segmentationNode->GetSegmentation() || !segmentID)
+  {
+    this->PatientBodyPolyDataSource.clear();
+    this->PatientBodyPolyDataValid = false;
+    return false;
+  }
+
+  std::string source = std::string(segmentationNode->GetID() ? segmentationNode->GetID() : "") + "/" + segmentID;
+  if ( source == this->PatientBodyPolyDataSource
+    && GetPatientBodySourceMTime(segmentationNode, segmentID) == this->PatientBodyPolyDataSourceMTime )
+  {
+    return this->PatientBodyPolyDataValid;
+  }
+
+  this->PatientBodyPolyDataValid = this->GetPatientBodyPolyData(parameterNode, this->PatientBodyPolyData);
+  if (this->PatientBodyPolyDataValid)
+  {
+    // The patient body is not cached on disk, as it changes with the segmentation
+    vtkSmartPointer<vtkCollisionProxyMeshFilter> proxyMeshFilter = vtkSmartPointer<vtkCollisionProxyMeshFilter>::New();
+    proxyMeshFilter->SetInputData(this->PatientBodyPolyData);
+    proxyMeshFilter->Update();
+    this->PatientBodyProxyPolyData->DeepCopy(proxyMeshFilter->GetOutput());
+  }
+  else
+  {
+    this->PatientBodyProxyPolyData->Initialize();
+  }
+
+  // Getting the poly data may create the closed surface representation, so the modification time is
+  // only stored afterwards to prevent the next call from computing the poly data again
+  this->PatientBodyPolyDataSource = source;
+  this->PatientBodyPolyDataSourceMTime = GetPatientBodySourceMTime(segmentationNode, segmentID);
+
+  return this->PatientBodyPolyDataValid;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerRoomsEyeViewModuleLogic::UpdateCollisionScenePatientBody(vtkMRMLRoomsEyeViewNode* parameterNode)
+{
+  vtkCollisionScene* scene = this->CollisionScene;
+  int patientPart = scene->GetPartIndex(PATIENT_COLLISION_PART_NAME);
+  if (patientPart >= 0)
+  {
+    bool patientBodyValid = this->UpdatePatientBodyPolyData(parameterNode);
+    scene->SetPartMesh(patientPart, patientBodyValid ? this->PatientBodyPolyData : NULL);
+    bool patientBodyProxyValid = patientBodyValid && this->PatientBodyProxyPolyData->GetNumberOfCells() > 0;
+    scene->SetPartProxyMesh(patientPart, patientBodyProxyValid ? this->PatientBodyProxyPolyData : NULL, 0.0);
+  }
+
+  // Apply the current safety margin on all proxy meshes. Only the inflation changes, the OBB trees are kept.
+  for (int partIndex = 0; partIndex < scene->GetNumberOfParts(); ++partIndex)
+  {
+    vtkPolyData* proxyMesh = scene->GetPartProxyMesh(partIndex);
+    if (proxyMesh)
+    {
+      scene->SetPartProxyMesh(partIndex, proxyMesh, this->GetCollisionProxyInflation(proxyMesh));
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerRoomsEyeViewModuleLogic::GetTreatmentMachineCollisionProxyMesh(vtkPolyData* modelPolyData, const char* modelName, vtkPolyData* proxyMesh)
+{
+  if (!modelPolyData || !modelName || !proxyMesh)
+  {
+    vtkErrorMacro("GetTreatmentMachineCollisionProxyMesh: Invalid input or output");
+    return false;
+  }
+
+  // Varian TrueBeam STx is the only treatment machine that is loaded, see LoadTreatmentMachineModels
+  std::string treatmentMachineModelsDirectory = this->GetModuleShareDirectory() + "/VarianTrueBeamSTx";
+  std::string modelFilePath = treatmentMachineModelsDirectory + "/" + modelName + ".stl";
+  bool modelFileExists = vtksys::SystemTools::FileExists(modelFilePath.c_str(), true);
+
+  // Module share directory is read-only in installed applications, the proxy meshes are cached in the temporary directory then
+  std::string proxyMeshDirectory = treatmentMachineModelsDirectory;
+  if (!vtksys::SystemTools::TestFileAccess(proxyMeshDirectory, vtksys::TEST_FILE_WRITE))
+  {
+    if (!this->CollisionProxyReadOnlyDirectoryLogged)
+    {
+      vtkDebugMacro("GetTreatmentMachineCollisionProxyMesh: Directory " << treatmentMachineModelsDirectory
+        << " is read-only, collision proxy meshes are cached in the temporary directory");
+      this->CollisionProxyReadOnlyDirectoryLogged = true;
+    }
+    proxyMeshDirectory.clear();
+    if (this->GetApplicationLogic() && this->GetApplicationLogic()->GetTemporaryPath())
+    {
+      proxyMeshDirectory = std::string(this->GetApplicationLogic()->GetTemporaryPath()) + "/RoomsEyeView/VarianTrueBeamSTx";
+    }
+  }
+  bool cacheProxyMesh = modelFileExists && !proxyMeshDirectory.empty();
+  std::string proxyMeshFilePath = proxyMeshDirectory + "/" + modelName + "_CollisionProxy.vtp";
+
+  vtkSmartPointer<vtkCollisionProxyMeshFilter> proxyMeshFilter = vtkSmartPointer<vtkCollisionProxyMeshFilter>::New();
+
+  // Use cached proxy mesh if it was created from the current model file by the current version of the filter with the same settings
+  int fileTimeComparison = -1;
+  if ( cacheProxyMesh && vtksys::SystemTools::FileExists(proxyMeshFilePath.c_str(), true)
+    && vtksys::SystemTools::FileTimeCompare(proxyMeshFilePath, modelFilePath, &fileTimeComparison) && fileTimeComparison >= 0 )
+  {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->SetFileName(proxyMeshFilePath.c_str());
+    reader->Update();
+    if (reader->GetOutput()->GetNumberOfCells() > 0 && proxyMeshFilter->IsProxyMeshUpToDate(reader->GetOutput()))
+    {
+      proxyMesh->DeepCopy(reader->GetOutput());
+      return true;
+    }
+  }
+
+  // Create proxy mesh and cache it for the next time
+  proxyMeshFilter->SetInputData(modelPolyData);
+  proxyMeshFilter->Update();
+  if (proxyMeshFilter->GetOutput()->GetNumberOfCells() == 0)
+  {
+    // The full mesh is checked directly
+    vtkDebugMacro("GetTreatmentMachineCollisionProxyMesh: No collision proxy mesh is created for model " << modelName
+      << " with " << modelPolyData->GetNumberOfCells() << " cells");
+    return false;
+  }
+  proxyMesh->DeepCopy(proxyMeshFilter->GetOutput());
+  vtkDebugMacro("GetTreatmentMachineCollisionProxyMesh: Created collision proxy mesh for model " << modelName << " with "
+    << proxyMesh->GetNumberOfCells() << " triangles from " << modelPolyData->GetNumberOfCells() << ", maximum deviation: "
+    << proxyMeshFilter->GetMaximumDeviation() << " mm");
+
+  if (cacheProxyMesh)
+  {
+    vtkSmartPointer<vtkXMLPolyDataWriter> writer = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+    writer->SetFileName(proxyMeshFilePath.c_str());
+    writer->SetInputData(proxyMesh);
+    if (!vtksys::SystemTools::MakeDirectory(proxyMeshDirectory) || !writer->Write())
+    {
+      // The proxy mesh is then created every time the models are set up
+      vtkWarningMacro("GetTreatmentMachineCollisionProxyMesh: Failed to cache collision proxy mesh in file " << proxyMeshFilePath);
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerRoomsEyeViewModuleLogic::GetCollisionProxyInflation(vtkPolyData* proxyMesh)
+{
+  double maximumDeviation = 0.0;
+  vtkCollisionProxyMeshFilter::GetMaximumDeviation(proxyMesh, maximumDeviation);
+  return maximumDeviation + std::max(this->CollisionProxySafetyMargin, 0.0);
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerRoomsEyeViewModuleLogic::UpdateCollimatorToGantryTransform(vtkMRMLRoomsEyeViewNode* parameterNode)
 {
@@ -822,7 +1034,7 @@ void vtkSlicerRoomsEyeViewModuleLogic::UpdateCollimatorToGantryTransform(vtkMRML
     collimatorToGantryTransformNode->GetTransformToParent() );
 
   collimatorToGantryTransform->Identity();
-  collimatorToGantryTransform->RotateZ(parameterNode->GetCollimatorRotationAngle());
+  RotateCollimatorToGantry(collimatorToGantryTransform, parameterNode->GetCollimatorRotationAngle());
   collimatorToGantryTransform->Modified();
 }
 
@@ -841,7 +1053,7 @@ void vtkSlicerRoomsEyeViewModuleLogic::UpdateGantryToFixedReferenceTransform(vtk
     gantryToFixedReferenceTransformNode->GetTransformToParent() );
   
   gantryToFixedReferenceTransform->Identity();
-  gantryToFixedReferenceTransform->RotateY(parameterNode->GetGantryRotationAngle() * (-1.0));
+  RotateGantryToFixedReference(gantryToFixedReferenceTransform, parameterNode->GetGantryRotationAngle());
   gantryToFixedReferenceTransform->Modified();
 
   vtkMRMLLinearTransformNode* collimatorToGantryTransformNode =
@@ -1021,9 +1233,8 @@ void vtkSlicerRoomsEyeViewModuleLogic::UpdatePatientSupportRotationToFixedRefere
   vtkTransform* patientSupportToRotatedPatientSupportTransform = vtkTransform::SafeDownCast(
     patientSupportRotationToFixedReferenceTransformNode->GetTransformToParent() );
   
-  double rotationAngle = parameterNode->GetPatientSupportRotationAngle();
   patientSupportToRotatedPatientSupportTransform->Identity();
-  patientSupportToRotatedPatientSupportTransform->RotateZ(rotationAngle);
+  RotatePatientSupportRotationToFixedReference(patientSupportToRotatedPatientSupportTransform, parameterNode->GetPatientSupportRotationAngle());
   patientSupportToRotatedPatientSupportTransform->Modified();
 }
 
@@ -1227,65 +1438,331 @@ std::string vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisions(vtkMRMLRoomsEye
     return statusString;
   }
 
-  // If number of contacts between pieces of treatment room is greater than 0, the collision between which pieces
-  // will be set to the output string and returned by the function.
-  this->GantryTableTopCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-  this->GantryTableTopCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(tableTopToRasTransform));
-  this->GantryTableTopCollisionDetection->Update();
-  if (this->GantryTableTopCollisionDetection->GetNumberOfContacts() > 0)
+  // Move the parts of the collision scene to the current positions. The patient body poly data is only recomputed
+  // if the patient body segment changed, so that its OBB tree is not rebuilt when only the treatment machine parts move.
+  // Parent transform of the patient is taken into account when getting poly data from the segmentation.
+  vtkCollisionScene* scene = this->CollisionScene;
+  if (scene->GetNumberOfPartPairs() == 0)
+  {
+    statusString = "Treatment machine models are not set up";
+    vtkErrorMacro("CheckForCollisions: " + statusString);
+    return statusString;
+  }
+  scene->SetPartToWorldMatrix(scene->GetPartIndex(GANTRY_COLLISION_PART_NAME), gantryToRasTransform->GetMatrix());
+  scene->SetPartToWorldMatrix(scene->GetPartIndex(COLLIMATOR_COLLISION_PART_NAME), collimatorToRasTransform->GetMatrix());
+  scene->SetPartToWorldMatrix(scene->GetPartIndex(TABLETOP_COLLISION_PART_NAME), tableTopToRasTransform->GetMatrix());
+  scene->SetPartToWorldMatrix(scene->GetPartIndex(PATIENTSUPPORT_COLLISION_PART_NAME), patientSupportToRasTransform->GetMatrix());
+  this->UpdateCollisionScenePatientBody(parameterNode);
+
+  //TODO: Collision detection is disabled for additional devices, see SetupTreatmentMachineModels. When enabled, their
+  // part pairs are checked and reported together with the other part pairs of the collision scene.
+
+  // Check all part pairs at once. Only the presence of collision is reported, so each pair stops at the first contact.
+  // If a pair of treatment room pieces is in collision, it will be set to the output string and returned by the function.
+  scene->FirstContactOnlyOn();
+  scene->CheckCollisions();
+  for (int pairIndex = 0; pairIndex < scene->GetNumberOfPartPairs(); ++pairIndex)
+  {
+    if (scene->GetPartPairInCollision(pairIndex))
+    {
+      int partIndex1 = -1;
+      int partIndex2 = -1;
+      scene->GetPartPair(pairIndex, partIndex1, partIndex2);
+      statusString = statusString + "Collision between " + scene->GetPartName(partIndex1) + " and " + scene->GetPartName(partIndex2) + "\n";
+    }
+  }
+
+  vtkDebugMacro("CheckForCollisions: OBB tree build time: " << scene->GetLastBuildTime() << " s, collision query time: " << scene->GetLastQueryTime() << " s");
+
+  return statusString;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerRoomsEyeViewModuleLogic::GetGantryMotionAngles(double startGantryAngle, double endGantryAngle, vtkDoubleArray* motionGantryAngles)
+{
+  if (!motionGantryAngles)
   {
-    statusString = statusString + "Collision between gantry and table top\n";
+    return;
   }
 
-  this->GantryPatientSupportCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-  this->GantryPatientSupportCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(patientSupportToRasTransform));
-  this->GantryPatientSupportCollisionDetection->Update();
-  if (this->GantryPatientSupportCollisionDetection->GetNumberOfContacts() > 0)
+  const double maximumSubMotionAngle = 90.0;
+  double gantryRotationAngle = endGantryAngle - startGantryAngle;
+  int numberOfSubMotions = std::max(1, static_cast<int>(ceil(fabs(gantryRotationAngle) / maximumSubMotionAngle)));
+  motionGantryAngles->Initialize();
+  motionGantryAngles->SetNumberOfValues(numberOfSubMotions + 1);
+  for (int subMotionIndex = 0; subMotionIndex < numberOfSubMotions; ++subMotionIndex)
   {
-    statusString = statusString + "Collision between gantry and patient support\n";
+    motionGantryAngles->SetValue(subMotionIndex, startGantryAngle + gantryRotationAngle * subMotionIndex / numberOfSubMotions);
   }
+  motionGantryAngles->SetValue(numberOfSubMotions, endGantryAngle);
+}
 
-  this->CollimatorTableTopCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(collimatorToRasTransform));
-  this->CollimatorTableTopCollisionDetection->SetTransform(1, vtkLinearTransform::SafeDownCast(tableTopToRasTransform));
-  this->CollimatorTableTopCollisionDetection->Update();
-  if (this->CollimatorTableTopCollisionDetection->GetNumberOfContacts() > 0)
+//-----------------------------------------------------------------------------
+int vtkSlicerRoomsEyeViewModuleLogic::CheckForCollisionsInArc(vtkMRMLRoomsEyeViewNode* parameterNode, vtkDoubleArray* gantryAngles,
+  vtkDoubleArray* collimatorAngles, vtkDoubleArray* patientSupportRotationAngles, vtkTable* collisionTable)
+{
+  if (!parameterNode || !gantryAngles || !collisionTable)
   {
-    statusString = statusString + "Collision between collimator and table top\n";
+    vtkErrorMacro("CheckForCollisionsInArc: Invalid parameter set node, gantry angles, or output table");
+    return -1;
+  }
+  vtkCollisionScene* scene = this->CollisionScene;
+  if (scene->GetNumberOfPartPairs() == 0)
+  {
+    vtkErrorMacro("CheckForCollisionsInArc: Treatment machine models are not set up");
+    return -1;
+  }
+
+  // Get the transforms that do not change during the sweep
+  vtkMRMLLinearTransformNode* fixedReferenceToRasTransformNode =
+    this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::FixedReference, vtkSlicerIECTransformLogic::RAS);
+  vtkMRMLLinearTransformNode* patientSupportToPatientSupportRotationTransformNode =
+    this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::PatientSupport, vtkSlicerIECTransformLogic::PatientSupportRotation);
+  vtkMRMLLinearTransformNode* tableTopEccentricRotationToPatientSupportRotationTransformNode =
+    this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::TableTopEccentricRotation, vtkSlicerIECTransformLogic::PatientSupportRotation);
+  vtkMRMLLinearTransformNode* tableTopToTableTopEccentricRotationTransformNode =
+    this->IECLogic->GetTransformNodeBetween(vtkSlicerIECTransformLogic::TableTop, vtkSlicerIECTransformLogic::TableTopEccentricRotation);
+  if ( !fixedReferenceToRasTransformNode || !patientSupportToPatientSupportRotationTransformNode
+    || !tableTopEccentricRotationToPatientSupportRotationTransformNode || !tableTopToTableTopEccentricRotationTransformNode )
+  {
+    vtkErrorMacro("CheckForCollisionsInArc: Failed to access IEC transforms");
+    return -1;
+  }
+  if (!fixedReferenceToRasTransformNode->IsTransformToWorldLinear())
+  {
+    vtkErrorMacro("CheckForCollisionsInArc: Non-linear transform detected");
+    return -1;
+  }
+  vtkSmartPointer<vtkMatrix4x4> fixedReferenceToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  fixedReferenceToRasTransformNode->GetMatrixTransformToWorld(fixedReferenceToRasMatrix);
+  vtkSmartPointer<vtkMatrix4x4> patientSupportToPatientSupportRotationMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  patientSupportToPatientSupportRotationTransformNode->GetMatrixTransformToParent(patientSupportToPatientSupportRotationMatrix);
+  vtkSmartPointer<vtkMatrix4x4> tableTopEccentricRotationToPatientSupportRotationMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  tableTopEccentricRotationToPatientSupportRotationTransformNode->GetMatrixTransformToParent(tableTopEccentricRotationToPatientSupportRotationMatrix);
+  vtkSmartPointer<vtkMatrix4x4> tableTopToTableTopEccentricRotationMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  tableTopToTableTopEccentricRotationTransformNode->GetMatrixTransformToParent(tableTopToTableTopEccentricRotationMatrix);
+
+  // Patient body does not move with the treatment machine
+  this->UpdateCollisionScenePatientBody(parameterNode);
+
+  // Use the current angles for the angles that are not swept
+  vtkSmartPointer<vtkDoubleArray> currentCollimatorAngle = vtkSmartPointer<vtkDoubleArray>::New();
+  currentCollimatorAngle->InsertNextValue(parameterNode->GetCollimatorRotationAngle());
+  if (!collimatorAngles || collimatorAngles->GetNumberOfTuples() == 0)
+  {
+    collimatorAngles = currentCollimatorAngle;
+  }
+  vtkSmartPointer<vtkDoubleArray> currentPatientSupportRotationAngle = vtkSmartPointer<vtkDoubleArray>::New();
+  currentPatientSupportRotationAngle->InsertNextValue(parameterNode->GetPatientSupportRotationAngle());
+  if (!patientSupportRotationAngles || patientSupportRotationAngles->GetNumberOfTuples() == 0)
+  {
+    patientSupportRotationAngles = currentPatientSupportRotationAngle;
+  }
+
+  // Compute the part to world transforms of all poses with the same rotations as the Update...Transform methods, without touching MRML
+  int numberOfParts = scene->GetNumberOfParts();
+  int gantryPart = scene->GetPartIndex(GANTRY_COLLISION_PART_NAME);
+  int collimatorPart = scene->GetPartIndex(COLLIMATOR_COLLISION_PART_NAME);
+  int tableTopPart = scene->GetPartIndex(TABLETOP_COLLISION_PART_NAME);
+  int patientSupportPart = scene->GetPartIndex(PATIENTSUPPORT_COLLISION_PART_NAME);
+  if (gantryPart < 0 || collimatorPart < 0 || tableTopPart < 0 || patientSupportPart < 0)
+  {
+    vtkErrorMacro("CheckForCollisionsInArc: Treatment machine parts are missing from the collision scene");
+    return -1;
+  }
+  vtkIdType numberOfGantryAngles = gantryAngles->GetNumberOfTuples();
+  vtkIdType numberOfCollimatorAngles = collimatorAngles->GetNumberOfTuples();
+  vtkIdType numberOfPoses = numberOfGantryAngles * numberOfCollimatorAngles * patientSupportRotationAngles->GetNumberOfTuples();
+
+  vtkSmartPointer<vtkDoubleArray> poseGantryAngles = vtkSmartPointer<vtkDoubleArray>::New();
+  poseGantryAngles->SetName("GantryAngle");
+  poseGantryAngles->SetNumberOfTuples(numberOfPoses);
+  vtkSmartPointer<vtkDoubleArray> poseCollimatorAngles = vtkSmartPointer<vtkDoubleArray>::New();
+  poseCollimatorAngles->SetName("CollimatorAngle");
+  poseCollimatorAngles->SetNumberOfTuples(numberOfPoses);
+  vtkSmartPointer<vtkDoubleArray> posePatientSupportRotationAngles = vtkSmartPointer<vtkDoubleArray>::New();
+  posePatientSupportRotationAngles->SetName("PatientSupportRotationAngle");
+  posePatientSupportRotationAngles->SetNumberOfTuples(numberOfPoses);
+
+  vtkSmartPointer<vtkDoubleArray> partToWorldMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+  partToWorldMatrices->SetNumberOfComponents(numberOfParts * 16);
+  partToWorldMatrices->SetNumberOfTuples(numberOfPoses);
+  vtkSmartPointer<vtkMatrix4x4> identityMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (vtkIdType poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex)
+  {
+    double* poseElements = partToWorldMatrices->GetPointer(poseIndex * numberOfParts * 16);
+    for (int partIndex = 0; partIndex < numberOfParts; ++partIndex)
+    {
+      vtkMatrix4x4::DeepCopy(poseElements + partIndex * 16, identityMatrix);
+    }
   }
 
-  //TODO: Collision detection is disabled for additional devices, see SetupTreatmentMachineModels
-  //this->AdditionalModelsTableTopCollisionDetection->Update();
-  //if (this->AdditionalModelsTableTopCollisionDetection->GetNumberOfContacts() > 0)
-  //{
-  //  statusString = statusString + "Collision between additional devices and table top\n";
-  //}
+  vtkSmartPointer<vtkTransform> patientSupportRotationToRasTransform = vtkSmartPointer<vtkTransform>::New();
+  vtkSmartPointer<vtkTransform> patientSupportToRasTransform = vtkSmartPointer<vtkTransform>::New();
+  vtkSmartPointer<vtkTransform> tableTopToRasTransform = vtkSmartPointer<vtkTransform>::New();
+  vtkSmartPointer<vtkTransform> gantryToRasTransform = vtkSmartPointer<vtkTransform>::New();
+  vtkSmartPointer<vtkTransform> collimatorToRasTransform = vtkSmartPointer<vtkTransform>::New();
+  for (vtkIdType patientSupportIndex = 0; patientSupportIndex < patientSupportRotationAngles->GetNumberOfTuples(); ++patientSupportIndex)
+  {
+    double patientSupportRotationAngle = patientSupportRotationAngles->GetValue(patientSupportIndex);
+    patientSupportRotationToRasTransform->SetMatrix(fixedReferenceToRasMatrix);
+    RotatePatientSupportRotationToFixedReference(patientSupportRotationToRasTransform, patientSupportRotationAngle);
+    patientSupportToRasTransform->SetMatrix(patientSupportRotationToRasTransform->GetMatrix());
+    patientSupportToRasTransform->Concatenate(patientSupportToPatientSupportRotationMatrix);
+    tableTopToRasTransform->SetMatrix(patientSupportRotationToRasTransform->GetMatrix());
+    tableTopToRasTransform->Concatenate(tableTopEccentricRotationToPatientSupportRotationMatrix);
+    tableTopToRasTransform->Concatenate(tableTopToTableTopEccentricRotationMatrix);
+
+    for (vtkIdType collimatorIndex = 0; collimatorIndex < numberOfCollimatorAngles; ++collimatorIndex)
+    {
+      double collimatorAngle = collimatorAngles->GetValue(collimatorIndex);
+      for (vtkIdType gantryIndex = 0; gantryIndex < numberOfGantryAngles; ++gantryIndex)
+      {
+        // Gantry angles vary fastest, then collimator angles, then patient support rotation angles
+        vtkIdType poseIndex = (patientSupportIndex * numberOfCollimatorAngles + collimatorIndex) * numberOfGantryAngles + gantryIndex;
+        double gantryAngle = gantryAngles->GetValue(gantryIndex);
+        gantryToRasTransform->SetMatrix(fixedReferenceToRasMatrix);
+        RotateGantryToFixedReference(gantryToRasTransform, gantryAngle);
+        collimatorToRasTransform->SetMatrix(gantryToRasTransform->GetMatrix());
+        RotateCollimatorToGantry(collimatorToRasTransform, collimatorAngle);
+
+        double* poseElements = partToWorldMatrices->GetPointer(poseIndex * numberOfParts * 16);
+        vtkMatrix4x4::DeepCopy(poseElements + gantryPart * 16, gantryToRasTransform->GetMatrix());
+        vtkMatrix4x4::DeepCopy(poseElements + collimatorPart * 16, collimatorToRasTransform->GetMatrix());
+        vtkMatrix4x4::DeepCopy(poseElements + tableTopPart * 16, tableTopToRasTransform->GetMatrix());
+        vtkMatrix4x4::DeepCopy(poseElements + patientSupportPart * 16, patientSupportToRasTransform->GetMatrix());
+
+        poseGantryAngles->SetValue(poseIndex, gantryAngle);
+        poseCollimatorAngles->SetValue(poseIndex, collimatorAngle);
+        posePatientSupportRotationAngles->SetValue(poseIndex, patientSupportRotationAngle);
+      }
+    }
+  }
 
-  //this->AdditionalModelsPatientSupportCollisionDetection->Update();
-  //if (this->AdditionalModelsPatientSupportCollisionDetection->GetNumberOfContacts() > 0)
-  //{
-  //  statusString = statusString + "Collision between additional devices and patient support\n";
-  //}
+  // Check all poses at once
+  vtkSmartPointer<vtkUnsignedCharArray> pairCollisions = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  int numberOfPosesInCollision = scene->CheckCollisionsForPoses(partToWorldMatrices, pairCollisions);
+  if (numberOfPosesInCollision < 0)
+  {
+    vtkErrorMacro("CheckForCollisionsInArc: Failed to check poses for collision");
+    return -1;
+  }
+  vtkDebugMacro("CheckForCollisionsInArc: " << numberOfPoses << " poses checked, OBB tree build time: "
+    << scene->GetLastBuildTime() << " s, collision query time: " << scene->GetLastQueryTime() << " s");
 
-  // Get patient body poly data
-  vtkSmartPointer<vtkPolyData> patientBodyPolyData = vtkSmartPointer<vtkPolyData>::New();
-  if (this->GetPatientBodyPolyData(parameterNode, patientBodyPolyData))
+  // Check the gantry rotation between consecutive gantry angles, as a collision between the sampled angles would be missed
+  if (this->ContinuousCollisionDetection && numberOfGantryAngles > 1)
   {
-    this->GantryPatientCollisionDetection->SetInput(1, patientBodyPolyData);
-    this->GantryPatientCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(gantryToRasTransform));
-    this->GantryPatientCollisionDetection->Update();
-    if (this->GantryPatientCollisionDetection->GetNumberOfContacts() > 0)
+    vtkSmartPointer<vtkDoubleArray> startPartToWorldMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+    startPartToWorldMatrices->SetNumberOfComponents(numberOfParts * 16);
+    vtkSmartPointer<vtkDoubleArray> endPartToWorldMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+    endPartToWorldMatrices->SetNumberOfComponents(numberOfParts * 16);
+    std::vector<vtkIdType> motionStartPoseIndices;
+    vtkSmartPointer<vtkDoubleArray> motionGantryAngles = vtkSmartPointer<vtkDoubleArray>::New();
+    std::vector<double> subMotionEndElements(numberOfParts * 16);
+    for (vtkIdType poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex)
+    {
+      // Gantry angles vary fastest, the last gantry angle of a collimator and patient support angle does not start a motion
+      if (poseIndex % numberOfGantryAngles == numberOfGantryAngles - 1)
+      {
+        continue;
+      }
+
+      // Only the gantry and the collimator move during the motion, the other parts stay in the start pose
+      double* startPoseElements = partToWorldMatrices->GetPointer(poseIndex * numberOfParts * 16);
+      double* endPoseElements = partToWorldMatrices->GetPointer((poseIndex + 1) * numberOfParts * 16);
+      vtkSlicerRoomsEyeViewModuleLogic::GetGantryMotionAngles(
+        poseGantryAngles->GetValue(poseIndex), poseGantryAngles->GetValue(poseIndex + 1), motionGantryAngles);
+      vtkIdType numberOfSubMotions = motionGantryAngles->GetNumberOfTuples() - 1;
+      std::copy(startPoseElements, startPoseElements + numberOfParts * 16, subMotionEndElements.begin());
+      for (vtkIdType subMotionIndex = 0; subMotionIndex < numberOfSubMotions; ++subMotionIndex)
+      {
+        startPartToWorldMatrices->InsertNextTuple(&subMotionEndElements[0]);
+        if (subMotionIndex == numberOfSubMotions - 1)
+        {
+          endPartToWorldMatrices->InsertNextTuple(endPoseElements);
+        }
+        else
+        {
+          gantryToRasTransform->SetMatrix(fixedReferenceToRasMatrix);
+          RotateGantryToFixedReference(gantryToRasTransform, motionGantryAngles->GetValue(subMotionIndex + 1));
+          collimatorToRasTransform->SetMatrix(gantryToRasTransform->GetMatrix());
+          RotateCollimatorToGantry(collimatorToRasTransform, poseCollimatorAngles->GetValue(poseIndex));
+          vtkMatrix4x4::DeepCopy(&subMotionEndElements[0] + gantryPart * 16, gantryToRasTransform->GetMatrix());
+          vtkMatrix4x4::DeepCopy(&subMotionEndElements[0] + collimatorPart * 16, collimatorToRasTransform->GetMatrix());
+          endPartToWorldMatrices->InsertNextTuple(&subMotionEndElements[0]);
+        }
+        motionStartPoseIndices.push_back(poseIndex);
+      }
+    }
+    vtkIdType numberOfMotions = static_cast<vtkIdType>(motionStartPoseIndices.size());
+
+    vtkSmartPointer<vtkUnsignedCharArray> motionPairCollisions = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    if (scene->CheckCollisionsBetweenPoses(startPartToWorldMatrices, endPartToWorldMatrices, motionPairCollisions) < 0)
+    {
+      vtkErrorMacro("CheckForCollisionsInArc: Failed to check gantry motions for collision");
+      return -1;
+    }
+    vtkDebugMacro("CheckForCollisionsInArc: " << numberOfMotions << " gantry motions checked, collision query time: "
+      << scene->GetLastQueryTime() << " s");
+
+    int numberOfPairs = pairCollisions->GetNumberOfComponents();
+    for (vtkIdType motionIndex = 0; motionIndex < numberOfMotions; ++motionIndex)
     {
-      statusString = statusString + "Collision between gantry and patient\n";
+      vtkIdType poseIndex = motionStartPoseIndices[motionIndex];
+      for (int pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+      {
+        if (motionPairCollisions->GetValue(motionIndex * numberOfPairs + pairIndex))
+        {
+          pairCollisions->SetValue(poseIndex * numberOfPairs + pairIndex, 1);
+        }
+      }
     }
 
-    this->CollimatorPatientCollisionDetection->SetInput(1, patientBodyPolyData);
-    this->CollimatorPatientCollisionDetection->SetTransform(0, vtkLinearTransform::SafeDownCast(collimatorToRasTransform));
-    this->CollimatorPatientCollisionDetection->Update();
-    if (this->CollimatorPatientCollisionDetection->GetNumberOfContacts() > 0)
+    numberOfPosesInCollision = 0;
+    for (vtkIdType poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex)
     {
-      statusString = statusString + "Collision between collimator and patient\n";
+      for (int pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+      {
+        if (pairCollisions->GetValue(poseIndex * numberOfPairs + pairIndex))
+        {
+          numberOfPosesInCollision++;
+          break;
+        }
+      }
     }
   }
 
-  return statusString;
+  // Assemble collision table
+  collisionTable->Initialize();
+  collisionTable->AddColumn(poseGantryAngles);
+  collisionTable->AddColumn(poseCollimatorAngles);
+  collisionTable->AddColumn(posePatientSupportRotationAngles);
+  vtkSmartPointer<vtkIntArray> anyCollisionColumn = vtkSmartPointer<vtkIntArray>::New();
+  anyCollisionColumn->SetName("Collision");
+  anyCollisionColumn->SetNumberOfTuples(numberOfPoses);
+  anyCollisionColumn->FillComponent(0, 0);
+  for (int pairIndex = 0; pairIndex < scene->GetNumberOfPartPairs(); ++pairIndex)
+  {
+    int partIndex1 = -1;
+    int partIndex2 = -1;
+    scene->GetPartPair(pairIndex, partIndex1, partIndex2);
+    std::string columnName = std::string("Collision between ") + scene->GetPartName(partIndex1) + " and " + scene->GetPartName(partIndex2);
+    vtkSmartPointer<vtkIntArray> pairCollisionColumn = vtkSmartPointer<vtkIntArray>::New();
+    pairCollisionColumn->SetName(columnName.c_str());
+    pairCollisionColumn->SetNumberOfTuples(numberOfPoses);
+    for (vtkIdType rowIndex = 0; rowIndex < numberOfPoses; ++rowIndex)
+    {
+      int collision = pairCollisions->GetValue(rowIndex * pairCollisions->GetNumberOfComponents() + pairIndex);
+      pairCollisionColumn->SetValue(rowIndex, collision);
+      if (collision)
+      {
+        anyCollisionColumn->SetValue(rowIndex, 1);
+      }
+    }
+    collisionTable->AddColumn(pairCollisionColumn);
+  }
+  collisionTable->AddColumn(anyCollisionColumn);
+
+  return numberOfPosesInCollision;
 }
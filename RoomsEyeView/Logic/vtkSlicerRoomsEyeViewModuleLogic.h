@@ -31,7 +31,9 @@ Ontario with funds provided by the Ontario Ministry of Health and Long-Term Care
 // Slicer includes
 #include <vtkSlicerModuleLogic.h>
 
-class vtkCollisionDetectionFilter;
+class vtkCollisionScene;
+class vtkDoubleArray;
+class vtkTable;
 class vtkSlicerIECTransformLogic;
 class vtkMRMLRoomsEyeViewNode;
 class vtkMRMLModelNode;
@@ -94,10 +96,34 @@ public:
   /// Update orientation marker based on the current transforms
   vtkMRMLModelNode* UpdateTreatmentOrientationMarker();
 
-  /// Check for collisions between pieces of linac model using vtkCollisionDetectionFilter
+  /// Check for collisions between pieces of linac model. All pairs of pieces are checked in one call
+  /// using the collision scene set up in \sa SetupTreatmentMachineModels
   /// \return string indicating whether collision occurred
   std::string CheckForCollisions(vtkMRMLRoomsEyeViewNode* parameterNode);
 
+  /// Check for collisions in a series of treatment machine poses, for example to find the colliding gantry angles
+  /// of an arc at a given patient support angle. The poses are all combinations of the given gantry, collimator and
+  /// patient support rotation angles. The IEC transforms are read from the scene once and are not modified, the
+  /// transforms of the poses are computed from them and all poses are checked in parallel using the collision scene
+  /// set up in \sa SetupTreatmentMachineModels. Table top displacements are taken from the current state.
+  /// \param gantryAngles Gantry rotation angles (degrees)
+  /// \param collimatorAngles Collimator rotation angles (degrees). Current angle is used if NULL or empty
+  /// \param patientSupportRotationAngles Patient support rotation angles (degrees). Current angle is used if NULL or empty
+  /// \param collisionTable Output table with one row per pose. It contains the angles, one column per pair of
+  ///   treatment room pieces with 1 if they collide, and a column with 1 if any of the pieces collide.
+  /// If \sa ContinuousCollisionDetection is on, the motion between consecutive gantry angles is also checked, and a
+  /// collision during the motion is marked in the row of the pose the motion starts from. The gantry rotates in the
+  /// direction of the list, see \sa GetGantryMotionAngles.
+  /// \return Number of poses with collision, -1 on error
+  int CheckForCollisionsInArc(vtkMRMLRoomsEyeViewNode* parameterNode, vtkDoubleArray* gantryAngles,
+    vtkDoubleArray* collimatorAngles, vtkDoubleArray* patientSupportRotationAngles, vtkTable* collisionTable);
+
+  /// Split the gantry rotation between two consecutive gantry angles into sub-motions of at most 90 degrees, as the
+  /// collision scene always takes the shorter rotation between two poses. The gantry rotates from the start angle to
+  /// the end angle without wrapping around, so for example from 350 to 10 degrees it rotates -340 degrees.
+  /// \param motionGantryAngles Output array with the start angle, the angles between the sub-motions, and the end angle (degrees)
+  static void GetGantryMotionAngles(double startGantryAngle, double endGantryAngle, vtkDoubleArray* motionGantryAngles);
+
 // Additional device related methods
 public:
   /// Load basic additional devices (deployed with SlicerRT)
@@ -115,30 +141,73 @@ public:
 public:
   vtkGetObjectMacro(IECLogic, vtkSlicerIECTransformLogic);
 
-  vtkGetObjectMacro(GantryPatientCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(GantryTableTopCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(GantryPatientSupportCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(CollimatorPatientCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(CollimatorTableTopCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(AdditionalModelsTableTopCollisionDetection, vtkCollisionDetectionFilter);
-  vtkGetObjectMacro(AdditionalModelsPatientSupportCollisionDetection, vtkCollisionDetectionFilter);
+  vtkGetObjectMacro(CollisionScene, vtkCollisionScene);
+
+  /// If on, \sa CheckForCollisionsInArc also checks the rotation between consecutive gantry angles, so collisions
+  /// between the sampled angles are not missed. Rotations of more than 90 degrees are split into sub-motions of at most
+  /// 90 degrees, see \sa GetGantryMotionAngles.
+  /// The tolerance of the check can be set in the collision scene \sa vtkCollisionScene::SetSweepTolerance. Off by default.
+  vtkSetMacro(ContinuousCollisionDetection, bool);
+  vtkGetMacro(ContinuousCollisionDetection, bool);
+  vtkBooleanMacro(ContinuousCollisionDetection, bool);
+
+  /// Safety margin (mm) added to the bound of the simplification error of the collision proxy meshes. The simplified
+  /// proxy meshes of the treatment machine models and the patient body are used in the broad phase of collision
+  /// detection, and the full meshes are only checked where the proxies are within their inflation distance.
+  /// The margin covers numerical errors of the distance computations. Default is 2 mm
+  vtkSetMacro(CollisionProxySafetyMargin, double);
+  vtkGetMacro(CollisionProxySafetyMargin, double);
 
 protected:
   /// Get patient body closed surface poly data from segmentation node and segment selection in the parameter node
   bool GetPatientBodyPolyData(vtkMRMLRoomsEyeViewNode* parameterNode, vtkPolyData* patientBodyPolyData);
 
+  /// Update the patient body poly data used in collision detection only if the patient body segment changed,
+  /// so that the collision scene can keep the OBB tree of the patient body
+  /// \return True if patient body poly data is available
+  bool UpdatePatientBodyPolyData(vtkMRMLRoomsEyeViewNode* parameterNode);
+
+  /// Set the patient body mesh and its proxy mesh in the collision scene, and update the inflation of all
+  /// proxy meshes according to the current safety margin \sa CollisionProxySafetyMargin
+  void UpdateCollisionScenePatientBody(vtkMRMLRoomsEyeViewNode* parameterNode);
+
+  /// Get simplified collision proxy mesh of a treatment machine model. The proxy mesh is cached in a file next
+  /// to the model file in the module share directory, or in the temporary directory of the application if the
+  /// share directory is read-only. It is only created if the cached file is missing or older than the model file.
+  /// The proxy is created without caching if the model file is not found. Model files are looked up in the directory
+  /// of the Varian TrueBeam STx, as it is the only treatment machine loaded by \sa LoadTreatmentMachineModels.
+  /// \param modelPolyData Full resolution mesh of the model
+  /// \param modelName Name of the model, also used as file name
+  /// \param proxyMesh Output proxy mesh, see \sa vtkCollisionProxyMeshFilter
+  /// \return True if a proxy mesh is available. False if the model is too small to be simplified or on error,
+  ///   the full mesh of the model is checked directly then.
+  bool GetTreatmentMachineCollisionProxyMesh(vtkPolyData* modelPolyData, const char* modelName, vtkPolyData* proxyMesh);
+
+  /// Get the inflation distance of a collision proxy mesh: the bound of its simplification error plus the safety margin
+  double GetCollisionProxyInflation(vtkPolyData* proxyMesh);
+
 protected:
   vtkSlicerIECTransformLogic* IECLogic;
 
-  vtkCollisionDetectionFilter* GantryPatientCollisionDetection;
-  vtkCollisionDetectionFilter* GantryTableTopCollisionDetection;
-  vtkCollisionDetectionFilter* GantryPatientSupportCollisionDetection;
-
-  vtkCollisionDetectionFilter* CollimatorPatientCollisionDetection;
-  vtkCollisionDetectionFilter* CollimatorTableTopCollisionDetection;
-
-  vtkCollisionDetectionFilter* AdditionalModelsTableTopCollisionDetection;
-  vtkCollisionDetectionFilter* AdditionalModelsPatientSupportCollisionDetection;
+  /// Collision scene containing the treatment room parts and the patient body, used to check all part pairs at once
+  vtkCollisionScene* CollisionScene;
+  /// Flag determining whether the motion between sampled gantry angles is checked for collision
+  bool ContinuousCollisionDetection;
+
+  /// Patient body poly data used in collision detection
+  vtkPolyData* PatientBodyPolyData;
+  /// Segmentation node ID and segment ID the patient body poly data was last computed from
+  std::string PatientBodyPolyDataSource;
+  /// Modification time of the inputs when the patient body poly data was last computed
+  vtkMTimeType PatientBodyPolyDataSourceMTime;
+  /// Flag indicating whether the patient body poly data could be computed from the current source
+  bool PatientBodyPolyDataValid;
+  /// Simplified patient body mesh used in the broad phase of collision detection, updated with the patient body poly data
+  vtkPolyData* PatientBodyProxyPolyData;
+  /// Safety margin added to the simplification error of the collision proxy meshes (mm)
+  double CollisionProxySafetyMargin;
+  /// Flag indicating whether it has been logged that the proxy meshes cannot be cached in the module share directory
+  bool CollisionProxyReadOnlyDirectoryLogged;
 
 protected:
   vtkSlicerRoomsEyeViewModuleLogic();
@@ -34,6 +34,7 @@
 #include <vtkMRMLModelNode.h>
 
 // VTK includes
+#include <vtkDoubleArray.h>
 #include <vtkNew.h>
 #include <vtkTransform.h>
 #include <vtkMatrix4x4.h>
@@ -449,6 +450,36 @@ int vtkSlicerRoomsEyeViewLogicTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)
     return EXIT_FAILURE;
     }
 
+  // Gantry motions of more than 90 degrees are split into sub-motions of at most 90 degrees in the direction of the gantry angle list
+  const double motionStartAngles[3] = { 10.0, 0.0, 350.0 };
+  const double motionEndAngles[3] = { 20.0, 200.0, 10.0 };
+  const int expectedNumberOfSubMotions[3] = { 1, 3, 4 };
+  vtkSmartPointer<vtkDoubleArray> motionGantryAngles = vtkSmartPointer<vtkDoubleArray>::New();
+  for (int motionIndex=0; motionIndex<3; ++motionIndex)
+  {
+    vtkSlicerRoomsEyeViewModuleLogic::GetGantryMotionAngles(motionStartAngles[motionIndex], motionEndAngles[motionIndex], motionGantryAngles);
+    int numberOfSubMotions = motionGantryAngles->GetNumberOfTuples() - 1;
+    if ( numberOfSubMotions != expectedNumberOfSubMotions[motionIndex]
+      || motionGantryAngles->GetValue(0) != motionStartAngles[motionIndex]
+      || motionGantryAngles->GetValue(numberOfSubMotions) != motionEndAngles[motionIndex] )
+    {
+      std::cerr << __LINE__ << ": Gantry motion from " << motionStartAngles[motionIndex] << " to " << motionEndAngles[motionIndex]
+        << " degrees is split into " << numberOfSubMotions << " sub-motions instead of " << expectedNumberOfSubMotions[motionIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+    double subMotionAngle = (motionEndAngles[motionIndex] - motionStartAngles[motionIndex]) / numberOfSubMotions;
+    for (int subMotionIndex=0; subMotionIndex<numberOfSubMotions; ++subMotionIndex)
+    {
+      double angleStep = motionGantryAngles->GetValue(subMotionIndex + 1) - motionGantryAngles->GetValue(subMotionIndex);
+      if (!AreEqualWithTolerance(angleStep, subMotionAngle) || fabs(angleStep) > 90.0)
+      {
+        std::cerr << __LINE__ << ": Sub-motion " << subMotionIndex << " of the gantry motion from " << motionStartAngles[motionIndex]
+          << " to " << motionEndAngles[motionIndex] << " degrees rotates " << angleStep << " degrees" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
   //TODO: Test code to print all non-identity transforms (useful to add more test cases)
   //std::cout << "ZZZ after collimator angle 90:" << std::endl;
   //PrintLinearTransformNodeMatrices(mrmlScene, false, true);
@@ -71,6 +71,9 @@ vtkMRMLSegmentComparisonNode::vtkMRMLSegmentComparisonNode()
   this->Percent95HausdorffDistanceForBoundaryMm = -1.0;
   this->HausdorffResultsValidOff();
 
+  this->ComparisonBackend = vtkMRMLSegmentComparisonNode::PlastimatchComparisonBackend;
+  this->NumberOfThreads = 0;
+
   this->HideFromEditors = false;
 }
 
@@ -130,6 +133,9 @@ void vtkMRMLSegmentComparisonNode::WriteXML(ostream& of, int nIndent)
   of << " Percent95HausdorffDistanceForBoundaryMm=\"" << this->Percent95HausdorffDistanceForBoundaryMm << "\"";
 
   of << " HausdorffResultsValid=\"" << (this->HausdorffResultsValid ? "true" : "false") << "\"";
+
+  of << " ComparisonBackend=\"" << (int)(this->ComparisonBackend) << "\"";
+  of << " NumberOfThreads=\"" << this->NumberOfThreads << "\"";
 }
 
 //----------------------------------------------------------------------------
@@ -246,6 +252,14 @@ void vtkMRMLSegmentComparisonNode::ReadXMLAttributes(const char** atts)
       {
       this->HausdorffResultsValid = (strcmp(attValue,"true") ? false : true);
       }
+    else if (!strcmp(attName, "ComparisonBackend")) 
+      {
+      this->ComparisonBackend = (ComparisonBackendType)(vtkVariant(attValue).ToInt());
+      }
+    else if (!strcmp(attName, "NumberOfThreads")) 
+      {
+      this->NumberOfThreads = vtkVariant(attValue).ToInt();
+      }
     }
 }
 
@@ -278,6 +292,8 @@ void vtkMRMLSegmentComparisonNode::Copy(vtkMRMLNode *anode)
   this->Percent95HausdorffDistanceForVolumeMm = node->Percent95HausdorffDistanceForVolumeMm;
   this->Percent95HausdorffDistanceForBoundaryMm = node->Percent95HausdorffDistanceForBoundaryMm;
   this->HausdorffResultsValid = node->HausdorffResultsValid;
+  this->ComparisonBackend = node->ComparisonBackend;
+  this->NumberOfThreads = node->NumberOfThreads;
 
   this->DisableModifiedEventOff();
   this->InvokePendingModifiedEvent();
@@ -331,6 +347,9 @@ void vtkMRMLSegmentComparisonNode::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << " Percent95HausdorffDistanceForBoundaryMm:   " << this->Percent95HausdorffDistanceForBoundaryMm << "\n";
 
   os << indent << " HausdorffResultsValid:   " << (this->HausdorffResultsValid ? "true" : "false") << "\n";
+
+  os << indent << " ComparisonBackend:   " << (int)(this->ComparisonBackend) << "\n";
+  os << indent << " NumberOfThreads:   " << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
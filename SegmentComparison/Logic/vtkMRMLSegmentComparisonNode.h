@@ -54,6 +54,16 @@ public:
   /// Get unique node XML tag name (like Volume, Model) 
   virtual const char* GetNodeTagName() VTK_OVERRIDE { return "SegmentComparison"; };
 
+public:
+  /// Implementation used for computing the Dice and Hausdorff metrics
+  enum ComparisonBackendType
+  {
+    /// Dice statistics and Hausdorff distance filters of Plastimatch
+    PlastimatchComparisonBackend = 0,
+    /// Multi-threaded computation of the SegmentComparison logic restricted to the bounding box of the segments
+    NativeComparisonBackend
+  };
+
 public:
   /// Get reference segmentation node
   vtkMRMLSegmentationNode* GetReferenceSegmentationNode();
@@ -175,6 +185,16 @@ public:
   vtkSetMacro(HausdorffResultsValid, bool);
   vtkBooleanMacro(HausdorffResultsValid, bool);
 
+  /// Get comparison backend
+  vtkGetMacro(ComparisonBackend, vtkMRMLSegmentComparisonNode::ComparisonBackendType);
+  /// Set comparison backend
+  vtkSetMacro(ComparisonBackend, vtkMRMLSegmentComparisonNode::ComparisonBackendType);
+
+  /// Get number of threads used by the native comparison
+  vtkGetMacro(NumberOfThreads, int);
+  /// Set number of threads used by the native comparison. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+
 protected:
   vtkMRMLSegmentComparisonNode();
   ~vtkMRMLSegmentComparisonNode();
@@ -238,6 +258,12 @@ protected:
 
   /// Flag telling whether the Hausdorff results are valid
   bool HausdorffResultsValid;
+
+  /// Implementation used for computing the Dice and Hausdorff metrics. Plastimatch by default
+  ComparisonBackendType ComparisonBackend;
+
+  /// Number of threads used by the native comparison
+  int NumberOfThreads;
 };
 
 #endif
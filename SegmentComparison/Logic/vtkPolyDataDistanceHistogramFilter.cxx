@@ -1,5 +1,8 @@
 #include "vtkPolyDataDistanceHistogramFilter.h"
 
+// SlicerRT includes
+#include "SlicerRtCommon.h"
+
 // vtk includes
 #include <vtkDataObject.h>
 #include <vtkImageAccumulate.h>
@@ -11,10 +14,66 @@
 #include <vtkMath.h>
 #include <vtkObjectFactory.h>
 #include <vtkPolyDataPointSampler.h>
+#include <vtkSimpleCriticalSection.h>
 #include <vtkSmartPointer.h>
-#include <vtkSortDataArray.h>
+#include <vtkSMPThreadLocal.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
+// STD includes
+#include <algorithm>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Compute the distances from a range of sample points to the reference polydata.
+  /// vtkImplicitPolyDataDistance is not thread-safe (its locator and the polydata keep state between queries),
+  /// so each thread evaluates the distances with its own instance built on a shallow copy of the reference.
+  class ComputeDistancesFunctor
+  {
+  public:
+    ComputeDistancesFunctor(vtkPolyData* referencePolyData, vtkPoints* samplingPoints, double* distances)
+      : ReferencePolyData(referencePolyData)
+      , SamplingPoints(samplingPoints)
+      , Distances(distances)
+    {
+    }
+
+    void Initialize()
+    {
+      vtkSmartPointer<vtkPolyData> referencePolyDataCopy = vtkSmartPointer<vtkPolyData>::New();
+      this->CopyLock.Lock();
+      referencePolyDataCopy->ShallowCopy(this->ReferencePolyData);
+      this->CopyLock.Unlock();
+
+      vtkSmartPointer<vtkImplicitPolyDataDistance>& distanceField = this->DistanceField.Local();
+      distanceField = vtkSmartPointer<vtkImplicitPolyDataDistance>::New();
+      distanceField->SetInput(referencePolyDataCopy);
+    }
+
+    void operator()(vtkIdType beginPoint, vtkIdType endPoint)
+    {
+      vtkImplicitPolyDataDistance* distanceField = this->DistanceField.Local();
+      double samplePoint[3] = { 0.0, 0.0, 0.0 };
+      for (vtkIdType pointIndex = beginPoint; pointIndex < endPoint; ++pointIndex)
+      {
+        this->SamplingPoints->GetPoint(pointIndex, samplePoint);
+        this->Distances[pointIndex] = distanceField->EvaluateFunction(samplePoint);
+      }
+    }
+
+    void Reduce()
+    {
+    }
+
+  private:
+    vtkPolyData* ReferencePolyData;
+    vtkPoints* SamplingPoints;
+    double* Distances;
+    vtkSimpleCriticalSection CopyLock;
+    vtkSMPThreadLocal<vtkSmartPointer<vtkImplicitPolyDataDistance> > DistanceField;
+  };
+}
+
 vtkStandardNewMacro(vtkPolyDataDistanceHistogramFilter);
 
 //----------------------------------------------------------------------------
@@ -33,6 +92,9 @@ vtkPolyDataDistanceHistogramFilter::vtkPolyDataDistanceHistogramFilter()
   , HistogramMinimum(-10.0)
   , HistogramMaximum(10.0)
   , HistogramSpacing(0.2)
+  , SymmetricDistances(0)
+  , NumberOfThreads(0)
+  , PercentileDistancesValid(false)
 {
   this->InputComparePolyData = vtkPolyData::New();
   this->InputReferencePolyData = vtkPolyData::New();
@@ -172,15 +234,25 @@ double vtkPolyDataDistanceHistogramFilter::GetNthPercentileHausdorffDistance(dou
     return 0.0;
   }
 
-  vtkSmartPointer<vtkDoubleArray> sortedDistances = vtkSmartPointer<vtkDoubleArray>::New();
-  sortedDistances->DeepCopy(this->OutputDistances);
+  vtkIdType numberOfValues = this->OutputDistances->GetNumberOfValues();
+  if (numberOfValues == 0)
+  {
+    vtkErrorMacro("GetPercentNthHausdorffDistance: There are no output distances. Returning 0.0.");
+    return 0.0;
+  }
 
-  vtkSmartPointer<vtkSortDataArray> sortDataArray = vtkSmartPointer<vtkSortDataArray>::New();
-  sortDataArray->Sort(sortedDistances);
+  // Copy the distances only once after each update. Selecting the Nth element only partially
+  // reorders the copy, so the same copy can be used for any number of percentiles
+  if (!this->PercentileDistancesValid)
+  {
+    const double* distancesPtr = this->OutputDistances->GetPointer(0);
+    this->PercentileDistances.assign(distancesPtr, distancesPtr + numberOfValues);
+    this->PercentileDistancesValid = true;
+  }
 
-  int nthPercentileIndex = vtkMath::Round( (n/ 100) * (sortedDistances->GetNumberOfValues() - 1) );
-  double percentileNthDistance = sortedDistances->GetValue( nthPercentileIndex );
-  return percentileNthDistance;
+  vtkIdType nthPercentileIndex = vtkMath::Round( (n/ 100) * (numberOfValues - 1) );
+  std::nth_element(this->PercentileDistances.begin(), this->PercentileDistances.begin() + nthPercentileIndex, this->PercentileDistances.end());
+  return this->PercentileDistances[nthPercentileIndex];
 }
 
 //----------------------------------------------------------------------------
@@ -227,18 +299,20 @@ void vtkPolyDataDistanceHistogramFilter::ComputeDistances(vtkPolyData* reference
   pointSampler->Update();  
   vtkPoints* samplingPoints = pointSampler->GetOutput()->GetPoints();
   
-  // generate the distance field
-  vtkSmartPointer<vtkImplicitPolyDataDistance> distanceField = vtkSmartPointer<vtkImplicitPolyDataDistance>::New();
-  distanceField->SetInput(referencePolyData);
-  
-  int numPoints = samplingPoints->GetNumberOfPoints();
-  for (int i = 0; i < numPoints; i++)
+  if (!samplingPoints)
   {
-    double samplePoint[3];
-    samplingPoints->GetPoint(i,samplePoint);
-    double newDistance = distanceField->EvaluateFunction(samplePoint);
-    distanceArray->InsertNextTuple1(newDistance);
+    return;
   }
+
+  // allocate the distances after the existing values, so that each sample point writes its own value
+  vtkIdType numPoints = samplingPoints->GetNumberOfPoints();
+  vtkIdType firstValueIndex = distanceArray->GetNumberOfValues();
+  distanceArray->SetNumberOfValues(firstValueIndex + numPoints);
+  double* distancesPtr = distanceArray->GetPointer(firstValueIndex);
+
+  // evaluate the distance field at the sample points
+  ComputeDistancesFunctor computeDistancesFunctor(referencePolyData, samplingPoints, distancesPtr);
+  SlicerRtCommon::SmpFor(0, numPoints, 0, computeDistancesFunctor, this->NumberOfThreads);
 }
 
 
@@ -256,6 +330,11 @@ void vtkPolyDataDistanceHistogramFilter::Update()
   vtkSmartPointer<vtkDoubleArray> distances = vtkSmartPointer<vtkDoubleArray>::New(); // hold the distances in this array until we copy to the output
   distances->SetName("Distances");
   this->ComputeDistances(inputPolyDataReference, inputPolyDataCompare, distances);
+  if (this->SymmetricDistances)
+  {
+    this->ComputeDistances(inputPolyDataCompare, inputPolyDataReference, distances);
+  }
+  this->PercentileDistancesValid = false;
   
   // copy the distances into a dummy image
   vtkSmartPointer<vtkImageData> dummyImage = vtkSmartPointer<vtkImageData>::New();
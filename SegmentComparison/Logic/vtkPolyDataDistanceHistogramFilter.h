@@ -7,6 +7,9 @@
 
 #include "vtkSlicerSegmentComparisonModuleLogicExport.h"
 
+// STD includes
+#include <vector>
+
 
 /// \class vtkPolyDataDistanceHistogramFilter
 /// \brief Compute a histogram of distances from one poly data to another.
@@ -55,7 +58,9 @@ public:
   vtkTable* GetOutputHistogram();
 
   /// Get the minimum of the distances from each point of the compare mesh to the reference mesh
-  /// Contains as many distance values as there are samples (points, etc.) in the compare mesh
+  /// Contains as many distance values as there are samples (points, etc.) in the compare mesh.
+  /// If \sa SymmetricDistances is on, then the distances from the samples of the reference mesh
+  /// to the compare mesh follow the distances of the compare mesh samples.
   vtkDoubleArray* GetOutputDistances();
   
   /// Get maximum of the absolute of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
@@ -68,7 +73,8 @@ public:
   /// Get 95th percentile of the absolute of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
   double GetPercent95HausdorffDistance();
 
-  // Get the Nth percentile of the absolute of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
+  /// Get the Nth percentile of the absolute of the minimum distances \sa GetOutputDistances from the compare mesh to the reference mesh.
+  /// The percentile is selected from a copy of the distances that is made once after each \sa Update
   double GetNthPercentileHausdorffDistance(double n);
   
   /// Set whether the filter should sample on the vertices of the input vtkPolyData objects.
@@ -111,6 +117,18 @@ public:
   vtkSetMacro(HistogramSpacing, double);
   /// Get the histogram spacing (width of the bins).
   vtkGetMacro(HistogramSpacing, double);
+
+  /// Set whether the distances are computed in both directions (compare to reference and reference to compare).
+  vtkSetMacro(SymmetricDistances, int);
+  /// Get whether the distances are computed in both directions (compare to reference and reference to compare).
+  vtkGetMacro(SymmetricDistances, int);
+  /// Set whether the distances are computed in both directions (compare to reference and reference to compare).
+  vtkBooleanMacro(SymmetricDistances, int);
+
+  /// Set the number of threads used for computing the distances. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+  /// Get the number of threads used for computing the distances
+  vtkGetMacro(NumberOfThreads, int);
   
   /// Compute distances an histogram
   void Update();
@@ -130,7 +148,7 @@ private:
   /// This method measures the raw distances from points on comparePolyData to referencePolyData, and stores them in distanceArray.
   /// \param referencePolyData The reference vtkPolyData on which to compute the distances. Distances are measured from points on the comparePolyData to the referencePolyData.
   /// \param comparePolyData The compare vtkPolyData on which to compute the distances. Distances are measured from points on the comparePolyData to the referencePolyData.
-  /// \param distanceArray The array in which to store the raw distances.
+  /// \param distanceArray The array in which to store the raw distances. The distances are appended to the existing values.
   void ComputeDistances(vtkPolyData* referencePolyData, vtkPolyData* comparePolyData, vtkDoubleArray* distanceArray);
   
 protected:
@@ -169,6 +187,19 @@ protected:
   /// Histogram spacing (width of the bins).
   /// Default is 0.1.
   double HistogramSpacing;
+
+  /// Flag determining whether the distances from the reference to the compare polydata are computed as well,
+  /// which makes all the output metrics symmetric.
+  /// Default is 0 (off).
+  int SymmetricDistances;
+  /// Number of threads used for computing the distances. 1 means the distances are computed in the calling thread.
+  /// Default is 0 (current vtkSMPTools setting).
+  int NumberOfThreads;
+
+  /// Copy of the output distances used for selecting percentiles. Partially reordered by each selection.
+  std::vector<double> PercentileDistances;
+  /// Flag indicating whether \sa PercentileDistances contains the distances of the last update
+  bool PercentileDistancesValid;
   
 private:
   vtkPolyDataDistanceHistogramFilter(const vtkPolyDataDistanceHistogramFilter&);  // Not implemented.
@@ -51,6 +51,444 @@
 #include <vtkTimerLog.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkTable.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSMPThreadLocal.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace
+{
+  /// Value of the squared distance map for voxels from which no target voxel is reachable
+  const float DISTANCE_MAP_INFINITY = VTK_FLOAT_MAX;
+
+  //---------------------------------------------------------------------------
+  /// Results of the comparison of a reference and a compare segment labelmap
+  struct SegmentComparisonResults
+  {
+    double DiceCoefficient;
+    double TruePositivesPercent;
+    double TrueNegativesPercent;
+    double FalsePositivesPercent;
+    double FalseNegativesPercent;
+    double ReferenceCenter[3];
+    double CompareCenter[3];
+    double ReferenceVolumeCc;
+    double CompareVolumeCc;
+
+    double MaximumHausdorffDistanceForVolumeMm;
+    double MaximumHausdorffDistanceForBoundaryMm;
+    double AverageHausdorffDistanceForVolumeMm;
+    double AverageHausdorffDistanceForBoundaryMm;
+    double Percent95HausdorffDistanceForVolumeMm;
+    double Percent95HausdorffDistanceForBoundaryMm;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Statistics of the distances from the voxels of a source mask to the nearest voxel of a target mask
+  struct DirectedDistanceStatistics
+  {
+    double Maximum;
+    double Average;
+    double Percent95;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Run functor for the given number of items in parallel, or in the calling thread if one thread is requested
+  template<class FunctorType>
+  void RunFunctor(FunctorType& functor, vtkIdType numberOfItems, int numberOfThreads)
+  {
+    SlicerRtCommon::SmpFor(0, numberOfItems, 0, functor, numberOfThreads);
+  }
+
+  //---------------------------------------------------------------------------
+  /// Copy a region of an image into a compact mask containing 1 for non-zero voxels and 0 otherwise
+  template<class ScalarType>
+  class ExtractBinaryMaskFunctor
+  {
+  public:
+    ExtractBinaryMaskFunctor(vtkImageData* image, const int regionExtent[6], unsigned char* mask)
+      : Mask(mask)
+    {
+      int imageExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      image->GetExtent(imageExtent);
+      image->GetIncrements(this->Increments);
+      for (int i=0; i<6; ++i)
+      {
+        this->RegionExtent[i] = regionExtent[i];
+      }
+      this->RegionOriginPtr = static_cast<const ScalarType*>(image->GetScalarPointer())
+        + (regionExtent[0] - imageExtent[0]) * this->Increments[0]
+        + (regionExtent[2] - imageExtent[2]) * this->Increments[1]
+        + (regionExtent[4] - imageExtent[4]) * this->Increments[2];
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      int dimensions[2] = { this->RegionExtent[1] - this->RegionExtent[0] + 1, this->RegionExtent[3] - this->RegionExtent[2] + 1 };
+      for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+        unsigned char* maskPtr = this->Mask + k * dimensions[0] * dimensions[1];
+        for (int j = 0; j < dimensions[1]; ++j)
+        {
+          const ScalarType* imagePtr = this->RegionOriginPtr + k * this->Increments[2] + j * this->Increments[1];
+          for (int i = 0; i < dimensions[0]; ++i, imagePtr += this->Increments[0])
+          {
+            *(maskPtr++) = (*imagePtr != 0 ? 1 : 0);
+          }
+        }
+      }
+    }
+
+  private:
+    const ScalarType* RegionOriginPtr;
+    vtkIdType Increments[3];
+    int RegionExtent[6];
+    unsigned char* Mask;
+  };
+
+  //---------------------------------------------------------------------------
+  template<class ScalarType>
+  void ExtractBinaryMaskOfType(vtkImageData* image, const int regionExtent[6], unsigned char* mask, int numberOfThreads)
+  {
+    ExtractBinaryMaskFunctor<ScalarType> functor(image, regionExtent, mask);
+    RunFunctor(functor, regionExtent[5] - regionExtent[4] + 1, numberOfThreads);
+  }
+
+  //---------------------------------------------------------------------------
+  /// Extract a region of a labelmap into a compact binary mask
+  /// \return False if the scalar type of the labelmap is not supported
+  bool ExtractBinaryMask(vtkImageData* image, const int regionExtent[6], std::vector<unsigned char>& mask, int numberOfThreads)
+  {
+    vtkIdType numberOfVoxels = (vtkIdType)(regionExtent[1] - regionExtent[0] + 1)
+      * (regionExtent[3] - regionExtent[2] + 1) * (regionExtent[5] - regionExtent[4] + 1);
+    mask.assign(numberOfVoxels, 0);
+    switch (image->GetScalarType())
+    {
+      vtkTemplateMacro(ExtractBinaryMaskOfType<VTK_TT>(image, regionExtent, &mask[0], numberOfThreads));
+      default:
+        return false;
+    }
+    return true;
+  }
+
+  //---------------------------------------------------------------------------
+  /// Count the voxels in the reference mask, the compare mask and their overlap, and sum up their
+  /// IJK coordinates (for computing the centers of mass), slice by slice
+  class CountOverlapFunctor
+  {
+  public:
+    struct Counts
+    {
+      vtkIdType Reference;
+      vtkIdType Compare;
+      vtkIdType Overlap;
+      double ReferenceIjkSum[3];
+      double CompareIjkSum[3];
+    };
+
+    CountOverlapFunctor(const unsigned char* referenceMask, const unsigned char* compareMask, const int dimensions[3])
+      : ReferenceMask(referenceMask)
+      , CompareMask(compareMask)
+    {
+      this->Dimensions[0] = dimensions[0];
+      this->Dimensions[1] = dimensions[1];
+      this->Dimensions[2] = dimensions[2];
+      ResetCounts(this->Result);
+    }
+
+    void Initialize()
+    {
+      ResetCounts(this->ThreadCounts.Local());
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      Counts& counts = this->ThreadCounts.Local();
+      for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+        vtkIdType voxelIndex = k * this->Dimensions[0] * this->Dimensions[1];
+        for (int j = 0; j < this->Dimensions[1]; ++j)
+        {
+          for (int i = 0; i < this->Dimensions[0]; ++i, ++voxelIndex)
+          {
+            bool inReference = (this->ReferenceMask[voxelIndex] != 0);
+            bool inCompare = (this->CompareMask[voxelIndex] != 0);
+            if (inReference)
+            {
+              ++counts.Reference;
+              counts.ReferenceIjkSum[0] += i;
+              counts.ReferenceIjkSum[1] += j;
+              counts.ReferenceIjkSum[2] += k;
+            }
+            if (inCompare)
+            {
+              ++counts.Compare;
+              counts.CompareIjkSum[0] += i;
+              counts.CompareIjkSum[1] += j;
+              counts.CompareIjkSum[2] += k;
+            }
+            if (inReference && inCompare)
+            {
+              ++counts.Overlap;
+            }
+          }
+        }
+      }
+    }
+
+    void Reduce()
+    {
+      for (vtkSMPThreadLocal<Counts>::iterator countsIt = this->ThreadCounts.begin(); countsIt != this->ThreadCounts.end(); ++countsIt)
+      {
+        this->Result.Reference += countsIt->Reference;
+        this->Result.Compare += countsIt->Compare;
+        this->Result.Overlap += countsIt->Overlap;
+        for (int axis=0; axis<3; ++axis)
+        {
+          this->Result.ReferenceIjkSum[axis] += countsIt->ReferenceIjkSum[axis];
+          this->Result.CompareIjkSum[axis] += countsIt->CompareIjkSum[axis];
+        }
+      }
+    }
+
+    /// Counts summed over all threads, valid after \sa Reduce
+    Counts Result;
+
+  private:
+    static void ResetCounts(Counts& counts)
+    {
+      counts.Reference = counts.Compare = counts.Overlap = 0;
+      for (int axis=0; axis<3; ++axis)
+      {
+        counts.ReferenceIjkSum[axis] = counts.CompareIjkSum[axis] = 0.0;
+      }
+    }
+
+    const unsigned char* ReferenceMask;
+    const unsigned char* CompareMask;
+    int Dimensions[3];
+    vtkSMPThreadLocal<Counts> ThreadCounts;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Mark the voxels of the mask that have a 6-connected neighbor outside the mask.
+  /// Voxels outside the region are considered to be outside the mask (zero padding).
+  class ExtractBoundaryFunctor
+  {
+  public:
+    ExtractBoundaryFunctor(const unsigned char* mask, const int dimensions[3], unsigned char* boundary)
+      : Mask(mask)
+      , Boundary(boundary)
+    {
+      this->Dimensions[0] = dimensions[0];
+      this->Dimensions[1] = dimensions[1];
+      this->Dimensions[2] = dimensions[2];
+    }
+
+    void operator()(vtkIdType beginSlice, vtkIdType endSlice)
+    {
+      const vtkIdType increments[3] = { 1, this->Dimensions[0], (vtkIdType)this->Dimensions[0] * this->Dimensions[1] };
+      for (vtkIdType k = beginSlice; k < endSlice; ++k)
+      {
+        vtkIdType voxelIndex = k * increments[2];
+        for (int j = 0; j < this->Dimensions[1]; ++j)
+        {
+          for (int i = 0; i < this->Dimensions[0]; ++i, ++voxelIndex)
+          {
+            const unsigned char* m = this->Mask + voxelIndex;
+            this->Boundary[voxelIndex] = ( *m && (
+                 i == 0 || !m[-increments[0]] || i == this->Dimensions[0]-1 || !m[increments[0]]
+              || j == 0 || !m[-increments[1]] || j == this->Dimensions[1]-1 || !m[increments[1]]
+              || k == 0 || !m[-increments[2]] || k == this->Dimensions[2]-1 || !m[increments[2]] ) ? 1 : 0 );
+          }
+        }
+      }
+    }
+
+  private:
+    const unsigned char* Mask;
+    unsigned char* Boundary;
+    int Dimensions[3];
+  };
+
+  //---------------------------------------------------------------------------
+  /// Exact squared Euclidean distance transform along the lines of one axis (lower envelope of parabolas).
+  /// The passes along the three axes together give the squared distance to the nearest feature voxel.
+  class SquaredDistanceTransformFunctor
+  {
+  public:
+    SquaredDistanceTransformFunctor(float* squaredDistances, const int dimensions[3], int axis, double spacing)
+      : SquaredDistances(squaredDistances)
+      , Axis(axis)
+      , Spacing(spacing)
+    {
+      this->Dimensions[0] = dimensions[0];
+      this->Dimensions[1] = dimensions[1];
+      this->Dimensions[2] = dimensions[2];
+    }
+
+    void operator()(vtkIdType beginLine, vtkIdType endLine)
+    {
+      const vtkIdType increments[3] = { 1, this->Dimensions[0], (vtkIdType)this->Dimensions[0] * this->Dimensions[1] };
+      int otherAxis1 = (this->Axis + 1) % 3;
+      int otherAxis2 = (this->Axis + 2) % 3;
+      int length = this->Dimensions[this->Axis];
+      std::vector<double> f(length);
+      std::vector<int> v(length);
+      std::vector<double> z(length + 1);
+      for (vtkIdType line = beginLine; line < endLine; ++line)
+      {
+        vtkIdType lineStart = (line % this->Dimensions[otherAxis1]) * increments[otherAxis1]
+          + (line / this->Dimensions[otherAxis1]) * increments[otherAxis2];
+        float* linePtr = this->SquaredDistances + lineStart;
+        vtkIdType stride = increments[this->Axis];
+        for (int q = 0; q < length; ++q)
+        {
+          f[q] = linePtr[q * stride];
+        }
+        this->TransformLine(&f[0], length, &v[0], &z[0], linePtr, stride);
+      }
+    }
+
+  private:
+    void TransformLine(const double* f, int length, int* v, double* z, float* output, vtkIdType stride)
+    {
+      const double spacingSquared = this->Spacing * this->Spacing;
+      int k = -1;
+      for (int q = 0; q < length; ++q)
+      {
+        if (f[q] >= DISTANCE_MAP_INFINITY)
+        {
+          continue;
+        }
+        double s = 0.0;
+        while (k >= 0)
+        {
+          int r = v[k];
+          s = ((f[q] + q*q*spacingSquared) - (f[r] + r*r*spacingSquared)) / (2.0 * spacingSquared * (q - r));
+          if (s > z[k])
+          {
+            break;
+          }
+          --k;
+        }
+        ++k;
+        v[k] = q;
+        z[k] = (k == 0 ? -VTK_DOUBLE_MAX : s);
+      }
+      if (k < 0)
+      {
+        // No feature voxel is reachable along this line
+        for (int p = 0; p < length; ++p)
+        {
+          output[p * stride] = DISTANCE_MAP_INFINITY;
+        }
+        return;
+      }
+      z[k+1] = VTK_DOUBLE_MAX;
+      int j = 0;
+      for (int p = 0; p < length; ++p)
+      {
+        while (z[j+1] < p)
+        {
+          ++j;
+        }
+        double distance = (p - v[j]) * this->Spacing;
+        output[p * stride] = static_cast<float>(distance * distance + f[v[j]]);
+      }
+    }
+
+    float* SquaredDistances;
+    int Dimensions[3];
+    int Axis;
+    double Spacing;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Compute the squared distance (in mm^2) of each voxel from the nearest feature voxel
+  void ComputeSquaredDistanceMap(const std::vector<unsigned char>& featureMask, const int dimensions[3], const double spacing[3],
+    int numberOfThreads, std::vector<float>& squaredDistances)
+  {
+    squaredDistances.resize(featureMask.size());
+    for (size_t voxelIndex = 0; voxelIndex < featureMask.size(); ++voxelIndex)
+    {
+      squaredDistances[voxelIndex] = (featureMask[voxelIndex] ? 0.0f : DISTANCE_MAP_INFINITY);
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      SquaredDistanceTransformFunctor functor(&squaredDistances[0], dimensions, axis, spacing[axis]);
+      vtkIdType numberOfLines = (vtkIdType)dimensions[(axis + 1) % 3] * dimensions[(axis + 2) % 3];
+      RunFunctor(functor, numberOfLines, numberOfThreads);
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  /// Compute statistics of the distances from the voxels of the source mask to the nearest voxel of the target mask.
+  /// Both masks must be non-empty.
+  /// \param squaredDistanceMap Buffer for the distance map, so that it can be reused between calls
+  void ComputeDirectedDistanceStatistics(const std::vector<unsigned char>& sourceMask, const std::vector<unsigned char>& targetMask,
+    const int dimensions[3], const double spacing[3], int numberOfThreads, std::vector<float>& squaredDistanceMap,
+    DirectedDistanceStatistics& statistics)
+  {
+    ComputeSquaredDistanceMap(targetMask, dimensions, spacing, numberOfThreads, squaredDistanceMap);
+
+    std::vector<double> distances;
+    double sum = 0.0;
+    for (size_t voxelIndex = 0; voxelIndex < sourceMask.size(); ++voxelIndex)
+    {
+      if (sourceMask[voxelIndex])
+      {
+        double distance = sqrt((double)squaredDistanceMap[voxelIndex]);
+        distances.push_back(distance);
+        sum += distance;
+      }
+    }
+    if (distances.empty())
+    {
+      statistics.Maximum = statistics.Average = statistics.Percent95 = 0.0;
+      return;
+    }
+
+    statistics.Maximum = *std::max_element(distances.begin(), distances.end());
+    statistics.Average = sum / distances.size();
+    size_t percent95Index = (size_t)vtkMath::Round(0.95 * (distances.size() - 1));
+    std::nth_element(distances.begin(), distances.begin() + percent95Index, distances.end());
+    statistics.Percent95 = distances[percent95Index];
+  }
+
+  //---------------------------------------------------------------------------
+  bool IsExtentEmpty(const int extent[6])
+  {
+    return extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5];
+  }
+
+  //---------------------------------------------------------------------------
+  /// Get center of mass in world coordinate system from the sum of the region IJK coordinates of the voxels
+  void GetCenterOfMass(const double regionIjkSum[3], vtkIdType numberOfVoxels, const int regionExtent[6],
+    vtkMatrix4x4* imageToWorldMatrix, double center[3])
+  {
+    if (numberOfVoxels == 0)
+    {
+      center[0] = center[1] = center[2] = 0.0;
+      return;
+    }
+    double ijk[4] = { regionExtent[0] + regionIjkSum[0] / numberOfVoxels,
+      regionExtent[2] + regionIjkSum[1] / numberOfVoxels, regionExtent[4] + regionIjkSum[2] / numberOfVoxels, 1.0 };
+    double world[4] = { 0.0, 0.0, 0.0, 1.0 };
+    imageToWorldMatrix->MultiplyPoint(ijk, world);
+    center[0] = world[0];
+    center[1] = world[1];
+    center[2] = world[2];
+  }
+}
 
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_SegmentComparison
@@ -60,6 +498,13 @@ public:
   static vtkSlicerSegmentComparisonModuleLogicPrivate *New();
   vtkTypeMacro(vtkSlicerSegmentComparisonModuleLogicPrivate,vtkObject);
 
+  /// Get the binary labelmaps of the selected input segments
+  /// \return Error message, empty string if no error
+  std::string GetInputSegmentLabelmaps(
+    vtkMRMLSegmentComparisonNode* parameterNode,
+    vtkOrientedImageData* referenceSegmentLabelmap,
+    vtkOrientedImageData* compareSegmentLabelmap);
+
   /// Get input segments as labelmaps, then convert them to Plm_image volumes
   /// \return Error message, empty string if no error
   std::string GetInputSegmentsAsPlmVolumes(
@@ -68,6 +513,17 @@ public:
     Plm_image::Pointer& plmCmpSegmentLabelmap,
     double &checkpointItkConvertStart);
 
+  /// Compute Dice statistics and/or Hausdorff distances of two segment labelmaps without Plastimatch.
+  /// Only the bounding box of the two segments is processed, using the given number of threads.
+  /// Hausdorff distances are not defined if one of the segments is empty. This is an error if only
+  /// Hausdorff distances are requested, otherwise the Dice statistics are computed and the distances are set to NaN.
+  /// \return Error message, empty string if no error
+  std::string ComputeMetricsNative(
+    vtkOrientedImageData* referenceSegmentLabelmap,
+    vtkOrientedImageData* compareSegmentLabelmap,
+    bool computeDice, bool computeHausdorff, int numberOfThreads,
+    SegmentComparisonResults& results);
+
   void SetLogic(vtkSlicerSegmentComparisonModuleLogic* logic) { this->Logic = logic; };
 
 protected:
@@ -96,16 +552,15 @@ vtkSlicerSegmentComparisonModuleLogicPrivate::~vtkSlicerSegmentComparisonModuleL
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
-  vtkMRMLSegmentComparisonNode* parameterNode, 
-  Plm_image::Pointer& plmRefSegmentLabelmap,
-  Plm_image::Pointer& plmCmpSegmentLabelmap,
-  double &checkpointItkConvertStart )
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentLabelmaps(
+  vtkMRMLSegmentComparisonNode* parameterNode,
+  vtkOrientedImageData* referenceSegmentLabelmap,
+  vtkOrientedImageData* compareSegmentLabelmap )
 {
   if (!parameterNode || !this->Logic->GetMRMLScene())
   {
     std::string errorMessage("Invalid MRML scene or parameter set node");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
@@ -118,31 +573,48 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   if (!referenceSegmentationNode || !referenceSegmentID)
   {
     std::string errorMessage("Invalid reference segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
   if (!compareSegmentationNode || !compareSegmentID)
   {
     std::string errorMessage("Invalid compare segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
   // Get segment binary labelmaps
-  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
   if ( !vtkSlicerSegmentationsModuleLogic::GetSegmentBinaryLabelmapRepresentation(
     referenceSegmentationNode, referenceSegmentID, referenceSegmentLabelmap ) )
   {
     std::string errorMessage("Failed to get binary labelmap from reference segment: " + std::string(referenceSegmentID));
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
-  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
   if ( !vtkSlicerSegmentationsModuleLogic::GetSegmentBinaryLabelmapRepresentation(
     compareSegmentationNode, compareSegmentID, compareSegmentLabelmap ) )
   {
     std::string errorMessage("Failed to get binary labelmap from reference segment: " + std::string(compareSegmentID));
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
+  vtkMRMLSegmentComparisonNode* parameterNode, 
+  Plm_image::Pointer& plmRefSegmentLabelmap,
+  Plm_image::Pointer& plmCmpSegmentLabelmap,
+  double &checkpointItkConvertStart )
+{
+  // Get segment binary labelmaps
+  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  std::string errorMessage = this->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+  if (!errorMessage.empty())
+  {
     return errorMessage;
   }
 
@@ -169,6 +641,159 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   return "";
 }
 
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::ComputeMetricsNative(
+  vtkOrientedImageData* referenceSegmentLabelmap,
+  vtkOrientedImageData* compareSegmentLabelmap,
+  bool computeDice, bool computeHausdorff, int numberOfThreads,
+  SegmentComparisonResults& results )
+{
+  if (!referenceSegmentLabelmap || !compareSegmentLabelmap)
+  {
+    std::string errorMessage("Invalid input segment labelmaps");
+    vtkErrorMacro("ComputeMetricsNative: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Resample compare labelmap to the geometry of the reference labelmap so that their voxels correspond to each other
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmapOnReferenceGrid = compareSegmentLabelmap;
+  if ( !vtkOrientedImageDataResample::DoGeometriesMatch(referenceSegmentLabelmap, compareSegmentLabelmap)
+    || !vtkOrientedImageDataResample::DoExtentsMatch(referenceSegmentLabelmap, compareSegmentLabelmap) )
+  {
+    compareLabelmapOnReferenceGrid = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      compareSegmentLabelmap, referenceSegmentLabelmap, compareLabelmapOnReferenceGrid) )
+    {
+      std::string errorMessage("Failed to resample compare segment labelmap to reference segment labelmap geometry");
+      vtkErrorMacro("ComputeMetricsNative: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  // Only the bounding box of the two segments needs to be visited. Outside of it both labelmaps are empty,
+  // so these voxels are all true negatives and they do not influence the distances.
+  int referenceEffectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int compareEffectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool referenceEmpty = !vtkOrientedImageDataResample::CalculateEffectiveExtent(referenceSegmentLabelmap, referenceEffectiveExtent)
+    || IsExtentEmpty(referenceEffectiveExtent);
+  bool compareEmpty = !vtkOrientedImageDataResample::CalculateEffectiveExtent(compareLabelmapOnReferenceGrid, compareEffectiveExtent)
+    || IsExtentEmpty(compareEffectiveExtent);
+  if (computeHausdorff && (referenceEmpty || compareEmpty))
+  {
+    if (!computeDice)
+    {
+      std::string errorMessage("Hausdorff distances cannot be computed for empty segments");
+      vtkErrorMacro("ComputeMetricsNative: " << errorMessage);
+      return errorMessage;
+    }
+    computeHausdorff = false;
+    results.MaximumHausdorffDistanceForVolumeMm = results.MaximumHausdorffDistanceForBoundaryMm = vtkMath::Nan();
+    results.AverageHausdorffDistanceForVolumeMm = results.AverageHausdorffDistanceForBoundaryMm = vtkMath::Nan();
+    results.Percent95HausdorffDistanceForVolumeMm = results.Percent95HausdorffDistanceForBoundaryMm = vtkMath::Nan();
+  }
+
+  int regionExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int axis=0; axis<3; ++axis)
+  {
+    if (referenceEmpty)
+    {
+      regionExtent[2*axis] = compareEffectiveExtent[2*axis];
+      regionExtent[2*axis+1] = compareEffectiveExtent[2*axis+1];
+    }
+    else if (compareEmpty)
+    {
+      regionExtent[2*axis] = referenceEffectiveExtent[2*axis];
+      regionExtent[2*axis+1] = referenceEffectiveExtent[2*axis+1];
+    }
+    else
+    {
+      regionExtent[2*axis] = std::min(referenceEffectiveExtent[2*axis], compareEffectiveExtent[2*axis]);
+      regionExtent[2*axis+1] = std::max(referenceEffectiveExtent[2*axis+1], compareEffectiveExtent[2*axis+1]);
+    }
+  }
+  int regionDimensions[3] = { regionExtent[1] - regionExtent[0] + 1, regionExtent[3] - regionExtent[2] + 1, regionExtent[5] - regionExtent[4] + 1 };
+
+  std::vector<unsigned char> referenceMask;
+  std::vector<unsigned char> compareMask;
+  if (!referenceEmpty || !compareEmpty)
+  {
+    if ( !ExtractBinaryMask(referenceSegmentLabelmap, regionExtent, referenceMask, numberOfThreads)
+      || !ExtractBinaryMask(compareLabelmapOnReferenceGrid, regionExtent, compareMask, numberOfThreads) )
+    {
+      std::string errorMessage("Unsupported segment labelmap scalar type");
+      vtkErrorMacro("ComputeMetricsNative: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  referenceSegmentLabelmap->GetSpacing(spacing);
+
+  if (computeDice)
+  {
+    // Count voxels of the two segments and their overlap in one pass over the bounding box
+    CountOverlapFunctor countFunctor(referenceMask.empty() ? NULL : &referenceMask[0], compareMask.empty() ? NULL : &compareMask[0], regionDimensions);
+    if (!referenceMask.empty())
+    {
+      RunFunctor(countFunctor, regionDimensions[2], numberOfThreads);
+    }
+    const CountOverlapFunctor::Counts& counts = countFunctor.Result;
+
+    int referenceDimensions[3] = { 0, 0, 0 };
+    referenceSegmentLabelmap->GetDimensions(referenceDimensions);
+    double numberOfVoxels = (double)referenceDimensions[0] * referenceDimensions[1] * referenceDimensions[2];
+    vtkIdType truePositives = counts.Overlap;
+    vtkIdType falsePositives = counts.Compare - counts.Overlap;
+    vtkIdType falseNegatives = counts.Reference - counts.Overlap;
+    double trueNegatives = numberOfVoxels - truePositives - falsePositives - falseNegatives;
+
+    results.DiceCoefficient = (counts.Reference + counts.Compare > 0 ? 2.0 * counts.Overlap / (counts.Reference + counts.Compare) : 0.0);
+    results.TruePositivesPercent = (numberOfVoxels > 0 ? truePositives * 100.0 / numberOfVoxels : 0.0);
+    results.TrueNegativesPercent = (numberOfVoxels > 0 ? trueNegatives * 100.0 / numberOfVoxels : 0.0);
+    results.FalsePositivesPercent = (numberOfVoxels > 0 ? falsePositives * 100.0 / numberOfVoxels : 0.0);
+    results.FalseNegativesPercent = (numberOfVoxels > 0 ? falseNegatives * 100.0 / numberOfVoxels : 0.0);
+
+    double voxelVolumeCc = spacing[0] * spacing[1] * spacing[2] / 1000.0;
+    results.ReferenceVolumeCc = counts.Reference * voxelVolumeCc;
+    results.CompareVolumeCc = counts.Compare * voxelVolumeCc;
+
+    // Centers of mass in world (RAS) coordinate system
+    vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    referenceSegmentLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+    GetCenterOfMass(counts.ReferenceIjkSum, counts.Reference, regionExtent, imageToWorldMatrix, results.ReferenceCenter);
+    GetCenterOfMass(counts.CompareIjkSum, counts.Compare, regionExtent, imageToWorldMatrix, results.CompareCenter);
+  }
+
+  if (computeHausdorff)
+  {
+    // Distances of all voxels of one segment from the other segment
+    std::vector<float> squaredDistanceMap;
+    DirectedDistanceStatistics referenceToCompare = { 0.0, 0.0, 0.0 };
+    DirectedDistanceStatistics compareToReference = { 0.0, 0.0, 0.0 };
+    ComputeDirectedDistanceStatistics(referenceMask, compareMask, regionDimensions, spacing, numberOfThreads, squaredDistanceMap, referenceToCompare);
+    ComputeDirectedDistanceStatistics(compareMask, referenceMask, regionDimensions, spacing, numberOfThreads, squaredDistanceMap, compareToReference);
+    results.MaximumHausdorffDistanceForVolumeMm = std::max(referenceToCompare.Maximum, compareToReference.Maximum);
+    results.AverageHausdorffDistanceForVolumeMm = 0.5 * (referenceToCompare.Average + compareToReference.Average);
+    results.Percent95HausdorffDistanceForVolumeMm = std::max(referenceToCompare.Percent95, compareToReference.Percent95);
+
+    // Distances of the boundary voxels of one segment from the boundary of the other segment
+    std::vector<unsigned char> referenceBoundary(referenceMask.size());
+    ExtractBoundaryFunctor referenceBoundaryFunctor(&referenceMask[0], regionDimensions, &referenceBoundary[0]);
+    RunFunctor(referenceBoundaryFunctor, regionDimensions[2], numberOfThreads);
+    std::vector<unsigned char> compareBoundary(compareMask.size());
+    ExtractBoundaryFunctor compareBoundaryFunctor(&compareMask[0], regionDimensions, &compareBoundary[0]);
+    RunFunctor(compareBoundaryFunctor, regionDimensions[2], numberOfThreads);
+
+    ComputeDirectedDistanceStatistics(referenceBoundary, compareBoundary, regionDimensions, spacing, numberOfThreads, squaredDistanceMap, referenceToCompare);
+    ComputeDirectedDistanceStatistics(compareBoundary, referenceBoundary, regionDimensions, spacing, numberOfThreads, squaredDistanceMap, compareToReference);
+    results.MaximumHausdorffDistanceForBoundaryMm = std::max(referenceToCompare.Maximum, compareToReference.Maximum);
+    results.AverageHausdorffDistanceForBoundaryMm = 0.5 * (referenceToCompare.Average + compareToReference.Average);
+    results.Percent95HausdorffDistanceForBoundaryMm = std::max(referenceToCompare.Percent95, compareToReference.Percent95);
+  }
+
+  return "";
+}
+
 //-----------------------------------------------------------------------------
 // vtkSlicerSegmentComparisonModuleLogic methods
 
@@ -300,54 +925,103 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeDiceStatistics(vtkMRML
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
 
-  // Convert input images to the format Plastimatch can use
-  Plm_image::Pointer plmRefSegmentLabelmap;
-  Plm_image::Pointer plmCmpSegmentLabelmap;
-  std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
-  if (!inputToPlmResult.empty())
-  {
-    std::string errorMessage("Error occurred during ITK conversion");
-    vtkErrorMacro("ComputeDiceStatistics: " << errorMessage);
-    return errorMessage;
-  }
+  double checkpointDiceStart = 0.0;
 
   // Compute Dice similarity metrics
-  double checkpointDiceStart = timer->GetUniversalTime();
+  double diceCoefficient = 0.0;
+  double truePositivesPercent = 0.0;
+  double trueNegativesPercent = 0.0;
+  double falsePositivesPercent = 0.0;
+  double falseNegativesPercent = 0.0;
+  double referenceCenterArray[3] = { 0.0, 0.0, 0.0 };
+  double compareCenterArray[3] = { 0.0, 0.0, 0.0 };
+  double referenceVolumeCc = 0.0;
+  double compareVolumeCc = 0.0;
+  if (parameterNode->GetComparisonBackend() == vtkMRMLSegmentComparisonNode::NativeComparisonBackend)
+  {
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->LogicPrivate->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    // No conversion is needed
+    checkpointItkConvertStart = checkpointDiceStart = timer->GetUniversalTime();
+
+    SegmentComparisonResults results;
+    errorMessage = this->LogicPrivate->ComputeMetricsNative(referenceSegmentLabelmap, compareSegmentLabelmap,
+      true, false, parameterNode->GetNumberOfThreads(), results);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    diceCoefficient = results.DiceCoefficient;
+    truePositivesPercent = results.TruePositivesPercent;
+    trueNegativesPercent = results.TrueNegativesPercent;
+    falsePositivesPercent = results.FalsePositivesPercent;
+    falseNegativesPercent = results.FalseNegativesPercent;
+    for (int i=0; i<3; ++i)
+    {
+      referenceCenterArray[i] = results.ReferenceCenter[i];
+      compareCenterArray[i] = results.CompareCenter[i];
+    }
+    referenceVolumeCc = results.ReferenceVolumeCc;
+    compareVolumeCc = results.CompareVolumeCc;
+  }
+  else
+  {
+    // Convert input images to the format Plastimatch can use
+    Plm_image::Pointer plmRefSegmentLabelmap;
+    Plm_image::Pointer plmCmpSegmentLabelmap;
+    std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
+    if (!inputToPlmResult.empty())
+    {
+      std::string errorMessage("Error occurred during ITK conversion");
+      vtkErrorMacro("ComputeDiceStatistics: " << errorMessage);
+      return errorMessage;
+    }
+
+    checkpointDiceStart = timer->GetUniversalTime();
+    Dice_statistics dice;
+    dice.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
+    dice.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
+
+    dice.run();
+
+    unsigned long numberOfVoxels = dice.get_true_positives() 
+      + dice.get_true_negatives() + dice.get_false_positives()
+      + dice.get_false_negatives();
+
+    diceCoefficient = dice.get_dice();
+    truePositivesPercent = dice.get_true_positives() * 100.0 / (double)numberOfVoxels;
+    trueNegativesPercent = dice.get_true_negatives() * 100.0 / (double)numberOfVoxels;
+    falsePositivesPercent = dice.get_false_positives() * 100.0 / (double)numberOfVoxels;
+    falseNegativesPercent = dice.get_false_negatives() * 100.0 / (double)numberOfVoxels;
+
+    // Centers are returned in LPS
+    itk::Vector<double, 3> referenceCenterItk = dice.get_reference_center();
+    referenceCenterArray[0] = - referenceCenterItk[0];
+    referenceCenterArray[1] = - referenceCenterItk[1];
+    referenceCenterArray[2] = referenceCenterItk[2];
+    itk::Vector<double, 3> compareCenterItk = dice.get_compare_center();
+    compareCenterArray[0] = - compareCenterItk[0];
+    compareCenterArray[1] = - compareCenterItk[1];
+    compareCenterArray[2] = compareCenterItk[2];
+
+    referenceVolumeCc = dice.get_reference_volume() / 1000.0;
+    compareVolumeCc = dice.get_compare_volume() / 1000.0;
+  }
   UNUSED_VARIABLE(checkpointDiceStart); // Although it is used later, a warning is logged so needs to be suppressed
-  Dice_statistics dice;
-  dice.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
-  dice.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
-
-  dice.run();
-
-  unsigned long numberOfVoxels = dice.get_true_positives() 
-    + dice.get_true_negatives() + dice.get_false_positives()
-    + dice.get_false_negatives();
 
   // Set results to parameter set node
-  double diceCoefficient = dice.get_dice();
-  double truePositivesPercent = dice.get_true_positives() * 100.0 / (double)numberOfVoxels;
-  double trueNegativesPercent = dice.get_true_negatives() * 100.0 / (double)numberOfVoxels;
-  double falsePositivesPercent = dice.get_false_positives() * 100.0 / (double)numberOfVoxels;
-  double falseNegativesPercent = dice.get_false_negatives() * 100.0 / (double)numberOfVoxels;
   parameterNode->SetDiceCoefficient(diceCoefficient);
   parameterNode->SetTruePositivesPercent(truePositivesPercent);
   parameterNode->SetTrueNegativesPercent(trueNegativesPercent);
   parameterNode->SetFalsePositivesPercent(falsePositivesPercent);
   parameterNode->SetFalseNegativesPercent(falseNegativesPercent);
-
-  itk::Vector<double, 3> referenceCenterItk = dice.get_reference_center();
-  double referenceCenterArray[3] =
-    { - referenceCenterItk[0], - referenceCenterItk[1], referenceCenterItk[2] };
   parameterNode->SetReferenceCenter(referenceCenterArray);
-
-  itk::Vector<double, 3> compareCenterItk = dice.get_compare_center();
-  double compareCenterArray[3] =
-    { - compareCenterItk[0], - compareCenterItk[1], compareCenterItk[2] };
   parameterNode->SetCompareCenter(compareCenterArray);
-
-  double referenceVolumeCc = dice.get_reference_volume() / 1000.0;
-  double compareVolumeCc = dice.get_compare_volume() / 1000.0;
   parameterNode->SetReferenceVolumeCc(referenceVolumeCc);
   parameterNode->SetCompareVolumeCc(compareVolumeCc);
 
@@ -444,34 +1118,75 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
 
-  // Convert input images to the format Plastimatch can use
-  Plm_image::Pointer plmRefSegmentLabelmap;
-  Plm_image::Pointer plmCmpSegmentLabelmap;
-  std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
-  if (!inputToPlmResult.empty())
-  {
-    std::string errorMessage("Error occurred during ITK conversion");
-    vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
-    return errorMessage;
-  }
+  double checkpointHausdorffStart = 0.0;
 
   // Compute Hausdorff distances
-  double checkpointHausdorffStart = timer->GetUniversalTime();
+  double maximumHausdorffDistanceForVolumeMm = 0.0;
+  double maximumHausdorffDistanceForBoundaryMm = 0.0;
+  double averageHausdorffDistanceForVolumeMm = 0.0;
+  double averageHausdorffDistanceForBoundaryMm = 0.0;
+  double percent95HausdorffDistanceForVolumeMm = 0.0;
+  double percent95HausdorffDistanceForBoundaryMm = 0.0;
+  if (parameterNode->GetComparisonBackend() == vtkMRMLSegmentComparisonNode::NativeComparisonBackend)
+  {
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    std::string errorMessage = this->LogicPrivate->GetInputSegmentLabelmaps(parameterNode, referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    // No conversion is needed
+    checkpointItkConvertStart = checkpointHausdorffStart = timer->GetUniversalTime();
+
+    SegmentComparisonResults results;
+    errorMessage = this->LogicPrivate->ComputeMetricsNative(referenceSegmentLabelmap, compareSegmentLabelmap,
+      false, true, parameterNode->GetNumberOfThreads(), results);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    maximumHausdorffDistanceForVolumeMm = results.MaximumHausdorffDistanceForVolumeMm;
+    maximumHausdorffDistanceForBoundaryMm = results.MaximumHausdorffDistanceForBoundaryMm;
+    averageHausdorffDistanceForVolumeMm = results.AverageHausdorffDistanceForVolumeMm;
+    averageHausdorffDistanceForBoundaryMm = results.AverageHausdorffDistanceForBoundaryMm;
+    percent95HausdorffDistanceForVolumeMm = results.Percent95HausdorffDistanceForVolumeMm;
+    percent95HausdorffDistanceForBoundaryMm = results.Percent95HausdorffDistanceForBoundaryMm;
+  }
+  else
+  {
+    // Convert input images to the format Plastimatch can use
+    Plm_image::Pointer plmRefSegmentLabelmap;
+    Plm_image::Pointer plmCmpSegmentLabelmap;
+    std::string inputToPlmResult = this->LogicPrivate->GetInputSegmentsAsPlmVolumes(parameterNode, plmRefSegmentLabelmap, plmCmpSegmentLabelmap, checkpointItkConvertStart);
+    if (!inputToPlmResult.empty())
+    {
+      std::string errorMessage("Error occurred during ITK conversion");
+      vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+      return errorMessage;
+    }
+
+    checkpointHausdorffStart = timer->GetUniversalTime();
+    Hausdorff_distance hausdorff;
+    hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
+    hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
+    hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
+    hausdorff.run();
+
+    maximumHausdorffDistanceForVolumeMm = hausdorff.get_hausdorff();
+    maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
+    averageHausdorffDistanceForVolumeMm = hausdorff.get_avg_average_hausdorff();
+    averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
+    percent95HausdorffDistanceForVolumeMm = hausdorff.get_percent_hausdorff();
+    percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
+  }
   UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
-  Hausdorff_distance hausdorff;
-  hausdorff.set_reference_image(plmRefSegmentLabelmap->itk_uchar());
-  hausdorff.set_compare_image(plmCmpSegmentLabelmap->itk_uchar());
-  hausdorff.set_volume_boundary_behavior(ZERO_PADDING);
-  hausdorff.run();
-
-  double maximumHausdorffDistanceForBoundaryMm = hausdorff.get_boundary_hausdorff();
-  double averageHausdorffDistanceForBoundaryMm = hausdorff.get_avg_average_boundary_hausdorff();
-  double percent95HausdorffDistanceForBoundaryMm = hausdorff.get_percent_boundary_hausdorff();
-  parameterNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.get_hausdorff());
+
+  parameterNode->SetMaximumHausdorffDistanceForVolumeMm(maximumHausdorffDistanceForVolumeMm);
   parameterNode->SetMaximumHausdorffDistanceForBoundaryMm(maximumHausdorffDistanceForBoundaryMm);
-  parameterNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.get_avg_average_hausdorff());
+  parameterNode->SetAverageHausdorffDistanceForVolumeMm(averageHausdorffDistanceForVolumeMm);
   parameterNode->SetAverageHausdorffDistanceForBoundaryMm(averageHausdorffDistanceForBoundaryMm);
-  parameterNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.get_percent_hausdorff());
+  parameterNode->SetPercent95HausdorffDistanceForVolumeMm(percent95HausdorffDistanceForVolumeMm);
   parameterNode->SetPercent95HausdorffDistanceForBoundaryMm(percent95HausdorffDistanceForBoundaryMm);
   parameterNode->HausdorffResultsValidOn();
 
@@ -526,3 +1241,133 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances(vtk
 
   return "";
 }
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogic::ComputeSegmentPairComparisons(vtkMRMLSegmentComparisonNode* parameterNode,
+  vtkStringArray* referenceSegmentIDs, vtkStringArray* compareSegmentIDs, vtkMRMLTableNode* resultsTableNode)
+{
+  if (!parameterNode || !this->GetMRMLScene())
+  {
+    std::string errorMessage("Invalid MRML scene or parameter set node");
+    vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+    return errorMessage;
+  }
+  vtkMRMLSegmentationNode* referenceSegmentationNode = parameterNode->GetReferenceSegmentationNode();
+  vtkMRMLSegmentationNode* compareSegmentationNode = parameterNode->GetCompareSegmentationNode();
+  if (!referenceSegmentationNode || !compareSegmentationNode)
+  {
+    std::string errorMessage("Invalid input segmentation selection");
+    vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+    return errorMessage;
+  }
+  if ( !referenceSegmentIDs || !compareSegmentIDs
+    || referenceSegmentIDs->GetNumberOfValues() != compareSegmentIDs->GetNumberOfValues() )
+  {
+    std::string errorMessage("Reference and compare segment ID lists must be given and have the same length");
+    vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+    return errorMessage;
+  }
+  if (!resultsTableNode)
+  {
+    std::string errorMessage("Invalid results table node");
+    vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
+
+  vtkIdType numberOfPairs = referenceSegmentIDs->GetNumberOfValues();
+  vtkSmartPointer<vtkStringArray> referenceSegmentColumn = vtkSmartPointer<vtkStringArray>::New();
+  referenceSegmentColumn->SetName("Reference segment");
+  vtkSmartPointer<vtkStringArray> compareSegmentColumn = vtkSmartPointer<vtkStringArray>::New();
+  compareSegmentColumn->SetName("Compare segment");
+  const char* metricNames[] = { "Dice coefficient", "True positives (%)", "True negatives (%)", "False positives (%)",
+    "False negatives (%)", "Reference volume (cc)", "Compare volume (cc)", "Maximum Hausdorff (mm)", "Average Hausdorff (mm)", "95% Hausdorff (mm)" };
+  const int numberOfMetrics = sizeof(metricNames) / sizeof(metricNames[0]);
+  std::vector< vtkSmartPointer<vtkDoubleArray> > metricColumns;
+  for (int metricIndex = 0; metricIndex < numberOfMetrics; ++metricIndex)
+  {
+    vtkSmartPointer<vtkDoubleArray> metricColumn = vtkSmartPointer<vtkDoubleArray>::New();
+    metricColumn->SetName(metricNames[metricIndex]);
+    metricColumn->SetNumberOfValues(numberOfPairs);
+    metricColumns.push_back(metricColumn);
+  }
+
+  // Segments may occur in multiple pairs, so their labelmaps are only extracted once
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> > referenceSegmentLabelmaps;
+  std::map<std::string, vtkSmartPointer<vtkOrientedImageData> > compareSegmentLabelmaps;
+  for (vtkIdType pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+  {
+    std::string referenceSegmentID = referenceSegmentIDs->GetValue(pairIndex);
+    std::string compareSegmentID = compareSegmentIDs->GetValue(pairIndex);
+    vtkSmartPointer<vtkOrientedImageData>& referenceSegmentLabelmap = referenceSegmentLabelmaps[referenceSegmentID];
+    if (!referenceSegmentLabelmap)
+    {
+      referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if ( !vtkSlicerSegmentationsModuleLogic::GetSegmentBinaryLabelmapRepresentation(
+        referenceSegmentationNode, referenceSegmentID, referenceSegmentLabelmap ) )
+      {
+        std::string errorMessage("Failed to get binary labelmap from reference segment: " + referenceSegmentID);
+        vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+        return errorMessage;
+      }
+    }
+    vtkSmartPointer<vtkOrientedImageData>& compareSegmentLabelmap = compareSegmentLabelmaps[compareSegmentID];
+    if (!compareSegmentLabelmap)
+    {
+      compareSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if ( !vtkSlicerSegmentationsModuleLogic::GetSegmentBinaryLabelmapRepresentation(
+        compareSegmentationNode, compareSegmentID, compareSegmentLabelmap ) )
+      {
+        std::string errorMessage("Failed to get binary labelmap from compare segment: " + compareSegmentID);
+        vtkErrorMacro("ComputeSegmentPairComparisons: " << errorMessage);
+        return errorMessage;
+      }
+    }
+
+    // If one of the segments is empty, then the Dice statistics are still computed and the Hausdorff distances are NaN
+    SegmentComparisonResults results;
+    std::string errorMessage = this->LogicPrivate->ComputeMetricsNative(referenceSegmentLabelmap, compareSegmentLabelmap,
+      true, true, parameterNode->GetNumberOfThreads(), results);
+    if (!errorMessage.empty())
+    {
+      errorMessage += " (reference segment: " + referenceSegmentID + ", compare segment: " + compareSegmentID + ")";
+      return errorMessage;
+    }
+
+    referenceSegmentColumn->InsertNextValue(referenceSegmentID);
+    compareSegmentColumn->InsertNextValue(compareSegmentID);
+    double metricValues[numberOfMetrics] = { results.DiceCoefficient, results.TruePositivesPercent, results.TrueNegativesPercent,
+      results.FalsePositivesPercent, results.FalseNegativesPercent, results.ReferenceVolumeCc, results.CompareVolumeCc,
+      results.MaximumHausdorffDistanceForBoundaryMm, results.AverageHausdorffDistanceForBoundaryMm, results.Percent95HausdorffDistanceForBoundaryMm };
+    for (int metricIndex = 0; metricIndex < numberOfMetrics; ++metricIndex)
+    {
+      metricColumns[metricIndex]->SetValue(pairIndex, metricValues[metricIndex]);
+    }
+  }
+
+  // Set results to table node, one row per segment pair
+  resultsTableNode->SetUseColumnNameAsColumnHeader(true);
+  resultsTableNode->RemoveAllColumns();
+  vtkTable* table = resultsTableNode->GetTable();
+  table->AddColumn(referenceSegmentColumn);
+  table->AddColumn(compareSegmentColumn);
+  for (int metricIndex = 0; metricIndex < numberOfMetrics; ++metricIndex)
+  {
+    table->AddColumn(metricColumns[metricIndex]);
+  }
+  // Trigger UI update
+  resultsTableNode->Modified();
+
+  if (this->LogSpeedMeasurements)
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+    vtkDebugMacro("ComputeSegmentPairComparisons: Total computation time for " << numberOfPairs << " segment pairs: "
+      << checkpointEnd-checkpointStart << " s");
+  }
+
+  return "";
+}
@@ -33,6 +33,8 @@
 #include "vtkSlicerSegmentComparisonModuleLogicExport.h"
 
 class vtkMRMLSegmentComparisonNode;
+class vtkMRMLTableNode;
+class vtkStringArray;
 class vtkSlicerSegmentComparisonModuleLogicPrivate;
 
 /// \ingroup SlicerRt_QtModules_SegmentComparison
@@ -53,6 +55,17 @@ public:
   /// \return Error message, empty string if no error
   std::string ComputeHausdorffDistances(vtkMRMLSegmentComparisonNode* parameterNode);
 
+  /// Compute Dice statistics and Hausdorff distances for multiple segment pairs in one call.
+  /// The i-th reference segment of the reference segmentation is compared to the i-th compare segment
+  /// of the compare segmentation selected in the parameter set node. The native (multi-threaded,
+  /// bounding box restricted) computation is used regardless of the comparison backend selection,
+  /// and each segment labelmap is extracted only once even if the segment is part of multiple pairs.
+  /// \param resultsTableNode Table that receives one row per segment pair. Hausdorff distances are computed on the boundary,
+  ///   they are NaN for pairs where one of the segments is empty.
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentPairComparisons(vtkMRMLSegmentComparisonNode* parameterNode,
+    vtkStringArray* referenceSegmentIDs, vtkStringArray* compareSegmentIDs, vtkMRMLTableNode* resultsTableNode);
+
 public:
   vtkGetMacro(LogSpeedMeasurements, bool);
   vtkSetMacro(LogSpeedMeasurements, bool);
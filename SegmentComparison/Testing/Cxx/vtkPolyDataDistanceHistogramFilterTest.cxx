@@ -11,10 +11,16 @@
 // vtk includes
 #include <vtkDelimitedTextWriter.h>
 #include <vtkDoubleArray.h>
+#include <vtkMath.h>
 #include <vtkSphereSource.h>
 #include <vtkTable.h>
 #include <vtkVariantArray.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 //-----------------------------------------------------------------------------
 int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
 {
@@ -117,5 +123,68 @@ int vtkPolyDataDistanceHistogramFilterTest( int argc, char* argv[] )
   histogramWriter->SetFileName( histogramFilename );
   histogramWriter->Write();
 
+  // Percentiles must match the ones selected from the fully sorted distances, in any query order
+  std::vector<double> sortedDistances( rawDistancesDoubleArray->GetPointer(0),
+    rawDistancesDoubleArray->GetPointer(0) + rawDistancesDoubleArray->GetNumberOfValues() );
+  std::sort( sortedDistances.begin(), sortedDistances.end() );
+  const double percentiles[4] = { 95.0, 50.0, 0.0, 95.0 };
+  for ( int i = 0; i < 4; ++i )
+  {
+    int percentileIndex = vtkMath::Round( (percentiles[i] / 100.0) * (sortedDistances.size() - 1) );
+    double percentileDistance = polyDataDistanceHistogramFilter->GetNthPercentileHausdorffDistance( percentiles[i] );
+    if ( percentileDistance != sortedDistances[percentileIndex] )
+    {
+      errorStream << "Percentile " << percentiles[i] << " mismatch: " << percentileDistance << " != " << sortedDistances[percentileIndex] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Single-threaded computation must give the same distances as the multi-threaded one
+  vtkSmartPointer< vtkDoubleArray > multiThreadedDistances = vtkSmartPointer< vtkDoubleArray >::New();
+  multiThreadedDistances->DeepCopy( rawDistancesDoubleArray );
+  polyDataDistanceHistogramFilter->SetNumberOfThreads( 1 );
+  polyDataDistanceHistogramFilter->Update();
+  vtkDoubleArray* singleThreadedDistances = polyDataDistanceHistogramFilter->GetOutputDistances();
+  if ( singleThreadedDistances->GetNumberOfValues() != multiThreadedDistances->GetNumberOfValues() )
+  {
+    errorStream << "Number of distances differs between single and multi-threaded computation" << std::endl;
+    return EXIT_FAILURE;
+  }
+  for ( vtkIdType i = 0; i < singleThreadedDistances->GetNumberOfValues(); ++i )
+  {
+    if ( singleThreadedDistances->GetValue(i) != multiThreadedDistances->GetValue(i) )
+    {
+      errorStream << "Distance " << i << " differs between single and multi-threaded computation" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Symmetric distances must contain the distances of both directions
+  vtkSmartPointer< vtkPolyDataDistanceHistogramFilter > reverseFilter = vtkSmartPointer< vtkPolyDataDistanceHistogramFilter >::New();
+  reverseFilter->SetInputReferencePolyData( sphereSource2->GetOutput() );
+  reverseFilter->SetInputComparePolyData( sphereSource1->GetOutput() );
+  reverseFilter->SetSamplePolyDataVertices( 1 );
+  reverseFilter->SetSamplePolyDataEdges( 1 );
+  reverseFilter->SetSamplePolyDataFaces( 1 );
+  reverseFilter->SetSamplingDistance( 0.025 );
+  reverseFilter->Update();
+
+  polyDataDistanceHistogramFilter->SymmetricDistancesOn();
+  polyDataDistanceHistogramFilter->Update();
+  vtkIdType expectedNumberOfSymmetricDistances = multiThreadedDistances->GetNumberOfValues() + reverseFilter->GetOutputDistances()->GetNumberOfValues();
+  if ( polyDataDistanceHistogramFilter->GetOutputDistances()->GetNumberOfValues() != expectedNumberOfSymmetricDistances )
+  {
+    errorStream << "Number of symmetric distances mismatch: " << polyDataDistanceHistogramFilter->GetOutputDistances()->GetNumberOfValues()
+      << " != " << expectedNumberOfSymmetricDistances << std::endl;
+    return EXIT_FAILURE;
+  }
+  double expectedSymmetricMaximum = std::max( multiThreadedDistances->GetMaxNorm(), reverseFilter->GetMaximumHausdorffDistance() );
+  if ( fabs( polyDataDistanceHistogramFilter->GetMaximumHausdorffDistance() - expectedSymmetricMaximum ) > 1e-9 )
+  {
+    errorStream << "Symmetric maximum Hausdorff distance mismatch: " << polyDataDistanceHistogramFilter->GetMaximumHausdorffDistance()
+      << " != " << expectedSymmetricMaximum << std::endl;
+    return EXIT_FAILURE;
+  }
+
   return EXIT_SUCCESS;
 }
@@ -31,16 +31,24 @@
 #include "vtkPlanarContourToClosedSurfaceConversionRule.h"
 
 // SegmentationCore includes
+#include "vtkSegmentation.h"
+#include "vtkSegment.h"
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
 
 // MRML includes
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
 
 // ITK includes
 #include "itkFactoryRegistration.h"
@@ -49,6 +57,7 @@
 #include <vtksys/SystemTools.hxx>
 
 bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double baseline);
+bool CheckHausdorffResult(double result, double baseline, double tolerance);
 
 //-----------------------------------------------------------------------------
 int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
@@ -279,6 +288,18 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
     return EXIT_FAILURE;
   }
 
+  // Optional arguments
+  bool useNativeBackend = false;
+  if (argc > argIndex+1)
+  {
+    if (STRCASECMP(argv[argIndex], "-ComparisonBackend") == 0)
+    {
+      useNativeBackend = (STRCASECMP(argv[argIndex+1], "Native") == 0);
+      std::cout << "Comparison backend: " << argv[argIndex+1] << std::endl;
+      argIndex += 2;
+    }
+  }
+
 
   // Make sure NRRD reading works
   itk::itkFactoryRegistration();
@@ -379,6 +400,10 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
   paramNode->SetReferenceSegmentID(referenceSegmentID.c_str());
   paramNode->SetAndObserveCompareSegmentationNode(compareSegmentationNode);
   paramNode->SetCompareSegmentID(compareSegmentID.c_str());
+  if (useNativeBackend)
+  {
+    paramNode->SetComparisonBackend(vtkMRMLSegmentComparisonNode::NativeComparisonBackend);
+  }
 
   // Create and set up logic
   vtkSmartPointer<vtkSlicerSegmentComparisonModuleLogic> segmentComparisonLogic = vtkSmartPointer<vtkSlicerSegmentComparisonModuleLogic>::New();
@@ -397,27 +422,67 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
 
   mrmlScene->Commit();
 
+  // The baselines were computed with Plastimatch. Both backends measure Euclidean distances between voxel centers,
+  // but the compare labelmap is resampled to the reference grid differently (VTK vs. ITK nearest neighbor),
+  // which may move the boundary by half a voxel. The Dice statistics need to match.
+  double hausdorffToleranceMm = 0.0;
+  if (useNativeBackend)
+  {
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    vtkSlicerSegmentationsModuleLogic::GetSegmentBinaryLabelmapRepresentation(referenceSegmentationNode, referenceSegmentID, referenceSegmentLabelmap);
+    double spacing[3] = { 0.0, 0.0, 0.0 };
+    referenceSegmentLabelmap->GetSpacing(spacing);
+    hausdorffToleranceMm = 0.5 * std::min(spacing[0], std::min(spacing[1], spacing[2]));
+  }
+
   // Compare results to baseline
   int result(EXIT_SUCCESS);
   double resultHausdorffMaximumMm = paramNode->GetMaximumHausdorffDistanceForBoundaryMm();
-  if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultHausdorffMaximumMm, hausdorffMaximumMm))
+  if (!CheckHausdorffResult(resultHausdorffMaximumMm, hausdorffMaximumMm, hausdorffToleranceMm))
   {
     std::cerr << "Hausdorff maximum (mm) mismatch: " << resultHausdorffMaximumMm << " instead of " << hausdorffMaximumMm << std::endl;
     result = EXIT_FAILURE;
   }
   double resultHausdorffAverageMm = paramNode->GetAverageHausdorffDistanceForBoundaryMm();
-  if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultHausdorffAverageMm, hausdorffAverageMm))
+  if (!CheckHausdorffResult(resultHausdorffAverageMm, hausdorffAverageMm, hausdorffToleranceMm))
   {
     std::cerr << "Hausdorff average (mm) mismatch: " << resultHausdorffAverageMm << " instead of " << hausdorffAverageMm << std::endl;
     result = EXIT_FAILURE;
   }
   double resultHausdorff95PercentMm = paramNode->GetPercent95HausdorffDistanceForBoundaryMm();
-  if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultHausdorff95PercentMm, hausdorff95PercentMm))
+  if (!CheckHausdorffResult(resultHausdorff95PercentMm, hausdorff95PercentMm, hausdorffToleranceMm))
   {
     std::cerr << "Hausdorff 95% mismatch: " << resultHausdorff95PercentMm << " instead of " << hausdorff95PercentMm << std::endl;
     result = EXIT_FAILURE;
   }
 
+  // There are no baselines for the volume Hausdorff distances, so the native ones are compared to Plastimatch
+  if (useNativeBackend)
+  {
+    double nativeVolumeHausdorffMm[3] = { paramNode->GetMaximumHausdorffDistanceForVolumeMm(),
+      paramNode->GetAverageHausdorffDistanceForVolumeMm(), paramNode->GetPercent95HausdorffDistanceForVolumeMm() };
+    paramNode->SetComparisonBackend(vtkMRMLSegmentComparisonNode::PlastimatchComparisonBackend);
+    std::string errorMessagePlastimatchHausdorff = segmentComparisonLogic->ComputeHausdorffDistances(paramNode);
+    paramNode->SetComparisonBackend(vtkMRMLSegmentComparisonNode::NativeComparisonBackend);
+    if (!errorMessagePlastimatchHausdorff.empty())
+    {
+      std::cerr << "Failed to compute Hausdorff distances with Plastimatch!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    double plastimatchVolumeHausdorffMm[3] = { paramNode->GetMaximumHausdorffDistanceForVolumeMm(),
+      paramNode->GetAverageHausdorffDistanceForVolumeMm(), paramNode->GetPercent95HausdorffDistanceForVolumeMm() };
+    const char* volumeHausdorffNames[3] = { "maximum", "average", "95%" };
+    for (int i = 0; i < 3; ++i)
+    {
+      if (!CheckHausdorffResult(nativeVolumeHausdorffMm[i], plastimatchVolumeHausdorffMm[i], hausdorffToleranceMm))
+      {
+        std::cerr << "Volume Hausdorff " << volumeHausdorffNames[i] << " (mm) mismatch: " << nativeVolumeHausdorffMm[i]
+          << " instead of " << plastimatchVolumeHausdorffMm[i] << " (Plastimatch)" << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
   double resultDiceCoefficient = paramNode->GetDiceCoefficient();
   if (!CheckIfResultIsWithinOneTenthPercentFromBaseline(resultDiceCoefficient, diceCoefficient))
   {
@@ -449,6 +514,75 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
     result = EXIT_FAILURE;
   }
 
+  // Batch comparison of the same pair listed twice must give the same results as the single comparison
+  if (useNativeBackend)
+  {
+    vtkSmartPointer<vtkStringArray> referenceSegmentIDArray = vtkSmartPointer<vtkStringArray>::New();
+    referenceSegmentIDArray->InsertNextValue(referenceSegmentID);
+    referenceSegmentIDArray->InsertNextValue(referenceSegmentID);
+    vtkSmartPointer<vtkStringArray> compareSegmentIDArray = vtkSmartPointer<vtkStringArray>::New();
+    compareSegmentIDArray->InsertNextValue(compareSegmentID);
+    compareSegmentIDArray->InsertNextValue(compareSegmentID);
+
+    // A pair with an empty segment must not fail the batch: its Dice statistics are computed, Hausdorff distances are NaN.
+    // The empty segment is only added if it can be given as a master representation labelmap.
+    const std::string binaryLabelmapName = vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName();
+    vtkSegmentation* compareSegmentation = compareSegmentationNode->GetSegmentation();
+    bool testEmptySegment = (compareSegmentation->GetMasterRepresentationName() == binaryLabelmapName);
+    if (testEmptySegment)
+    {
+      vtkSmartPointer<vtkOrientedImageData> emptyLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      emptyLabelmap->DeepCopy(compareSegmentation->GetSegment(compareSegmentID)->GetRepresentation(binaryLabelmapName));
+      vtkOrientedImageDataResample::FillImage(emptyLabelmap, 0.0);
+      vtkSmartPointer<vtkSegment> emptySegment = vtkSmartPointer<vtkSegment>::New();
+      emptySegment->SetName("Empty");
+      emptySegment->AddRepresentation(binaryLabelmapName, emptyLabelmap);
+      compareSegmentation->AddSegment(emptySegment, "Empty");
+      referenceSegmentIDArray->InsertNextValue(referenceSegmentID);
+      compareSegmentIDArray->InsertNextValue("Empty");
+    }
+
+    vtkSmartPointer<vtkMRMLTableNode> pairsTableNode = vtkSmartPointer<vtkMRMLTableNode>::New();
+    mrmlScene->AddNode(pairsTableNode);
+    std::string errorMessagePairs = segmentComparisonLogic->ComputeSegmentPairComparisons(
+      paramNode, referenceSegmentIDArray, compareSegmentIDArray, pairsTableNode);
+    vtkTable* pairsTable = pairsTableNode->GetTable();
+    if (!errorMessagePairs.empty() || pairsTable->GetNumberOfRows() != referenceSegmentIDArray->GetNumberOfValues())
+    {
+      std::cerr << "Failed to compute segment pair comparisons!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (vtkIdType row = 0; row < 2; ++row)
+    {
+      double pairDiceCoefficient = pairsTable->GetValueByName(row, "Dice coefficient").ToDouble();
+      double pairHausdorffMaximumMm = pairsTable->GetValueByName(row, "Maximum Hausdorff (mm)").ToDouble();
+      double pairHausdorffAverageMm = pairsTable->GetValueByName(row, "Average Hausdorff (mm)").ToDouble();
+      double pairHausdorff95PercentMm = pairsTable->GetValueByName(row, "95% Hausdorff (mm)").ToDouble();
+      if ( pairDiceCoefficient != resultDiceCoefficient || pairHausdorffMaximumMm != resultHausdorffMaximumMm
+        || pairHausdorffAverageMm != resultHausdorffAverageMm || pairHausdorff95PercentMm != resultHausdorff95PercentMm )
+      {
+        std::cerr << "Segment pair comparison mismatch in row " << row << ": Dice coefficient " << pairDiceCoefficient
+          << " instead of " << resultDiceCoefficient << ", Hausdorff maximum, average, 95% (mm) " << pairHausdorffMaximumMm
+          << ", " << pairHausdorffAverageMm << ", " << pairHausdorff95PercentMm << " instead of " << resultHausdorffMaximumMm
+          << ", " << resultHausdorffAverageMm << ", " << resultHausdorff95PercentMm << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+    if (testEmptySegment)
+    {
+      double emptyPairDiceCoefficient = pairsTable->GetValueByName(2, "Dice coefficient").ToDouble();
+      double emptyPairCompareVolumeCc = pairsTable->GetValueByName(2, "Compare volume (cc)").ToDouble();
+      double emptyPairHausdorffMaximumMm = pairsTable->GetValueByName(2, "Maximum Hausdorff (mm)").ToDouble();
+      if (emptyPairDiceCoefficient != 0.0 || emptyPairCompareVolumeCc != 0.0 || !vtkMath::IsNan(emptyPairHausdorffMaximumMm))
+      {
+        std::cerr << "Segment pair comparison with empty segment mismatch: Dice coefficient " << emptyPairDiceCoefficient
+          << ", compare volume (cc) " << emptyPairCompareVolumeCc << ", Hausdorff maximum (mm) " << emptyPairHausdorffMaximumMm
+          << " instead of 0, 0, NaN" << std::endl;
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
   return result;
 }
 
@@ -465,3 +599,13 @@ bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double base
 
   return absoluteDifferencePercent < 0.1;
 }
+
+//-----------------------------------------------------------------------------
+bool CheckHausdorffResult(double result, double baseline, double tolerance)
+{
+  if (tolerance > 0.0)
+  {
+    return (fabs(result - baseline) <= tolerance);
+  }
+  return CheckIfResultIsWithinOneTenthPercentFromBaseline(result, baseline);
+}
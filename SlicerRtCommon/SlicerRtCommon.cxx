@@ -371,7 +371,7 @@ void SlicerRtCommon::WriteImageDataToFile(vtkMRMLScene* scene, vtkImageData* ima
 }
 
 //---------------------------------------------------------------------------
-bool SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolumeNode* inVolumeNode, vtkOrientedImageData* outImageData, bool applyRasToWorldConversion/*=true*/)
+bool SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolumeNode* inVolumeNode, vtkOrientedImageData* outImageData, bool applyRasToWorldConversion/*=true*/, bool shallowCopy/*=false*/)
 {
   if (!inVolumeNode || !inVolumeNode->GetImageData())
   {
@@ -384,7 +384,15 @@ bool SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolume
     return false;
   }
 
-  outImageData->vtkImageData::DeepCopy(inVolumeNode->GetImageData());
+  if (shallowCopy)
+  {
+    // Transforming the image creates new scalars instead of changing the shared ones
+    outImageData->vtkImageData::ShallowCopy(inVolumeNode->GetImageData());
+  }
+  else
+  {
+    outImageData->vtkImageData::DeepCopy(inVolumeNode->GetImageData());
+  }
 
   vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
   inVolumeNode->GetIJKToRASMatrix(ijkToRasMatrix);
@@ -161,9 +161,12 @@ public:
     \param inVolumeNode Input volume node
     \param outImageData Output oriented image data
     \param applyRasToWorldConversion Apply parent linear transform to image. True by default.
+    \param shallowCopy Share the scalars of the volume instead of copying them. Resampling due to the
+      parent transform creates new scalars, so the volume is not modified, but changing the voxels of the
+      output image changes the volume as well. False by default.
     \return Success
   */
-  static bool ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolumeNode* inVolumeNode, vtkOrientedImageData* outImageData, bool applyRasToWorldConversion=true);
+  static bool ConvertVolumeNodeToVtkOrientedImageData(vtkMRMLScalarVolumeNode* inVolumeNode, vtkOrientedImageData* outImageData, bool applyRasToWorldConversion=true, bool shallowCopy=false);
 
 //BTX
   /*!
@@ -172,27 +175,37 @@ public:
     \param outItkVolume Output ITK image
     \param applyRasToWorldConversion Apply parent linear transform to image. True by default
     \param applyRasToLpsConversion Apply RAS (Slicer) to LPS (ITK, DICOM) coordinate frame conversion. True by default
+    \param shareBuffer Let the ITK image use the scalar buffer of the volume instead of a copy if possible. False by default
     \return Success
+    \sa ConvertVtkOrientedImageDataToItkImage
   */
-  template<typename T> static bool ConvertVolumeNodeToItkImage(vtkMRMLScalarVolumeNode* inVolumeNode, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToWorldConversion=true, bool applyRasToLpsConversion=true);
+  template<typename T> static bool ConvertVolumeNodeToItkImage(vtkMRMLScalarVolumeNode* inVolumeNode, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToWorldConversion=true, bool applyRasToLpsConversion=true, bool shareBuffer=false);
 
   /*!
     Convert oriented image data to ITK image
     \param inImageData Input oriented image data
     \param outItkVolume Output ITK image
     \param applyRasToLpsConversion Apply RAS (Slicer) to LPS (ITK, DICOM) coordinate frame conversion. True by default
+    \param shareBuffer Let the ITK image use the scalar buffer of the input image instead of a copy if possible
+      (single component image with scalar type matching T). The ITK image keeps a reference to the scalar array,
+      so it remains valid after the input image is deleted, but changing the voxels of one image changes the other
+      as well. If the buffer cannot be shared, then it is copied in one block. False by default
     \return Success
   */
-  template<typename T> static bool ConvertVtkOrientedImageDataToItkImage(vtkOrientedImageData* inImageData, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToLpsConversion=true);
+  template<typename T> static bool ConvertVtkOrientedImageDataToItkImage(vtkOrientedImageData* inImageData, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToLpsConversion=true, bool shareBuffer=false);
 
   /*!
     Convert ITK image to VTK image data. The image geometry is not considered!
     \param inItkImage Input ITK image
     \param outVtkImageData Output VTK image data
     \param vtkType Data scalar type (i.e VTK_FLOAT)
+    \param shareBuffer Let the VTK image data use the pixel buffer of the ITK image instead of a copy if possible
+      (whole image is buffered and vtkType matches T). The VTK scalar array keeps a reference to the ITK pixel
+      container, so it remains valid after the input image is deleted, but changing the voxels of one image
+      changes the other as well. If the buffer cannot be shared, then it is copied in one block. False by default
     \return Success
   */
-  template<typename T> static bool ConvertItkImageToVtkImageData(typename itk::Image<T, 3>::Pointer inItkImage, vtkImageData* outVtkImageData, int vtkType);
+  template<typename T> static bool ConvertItkImageToVtkImageData(typename itk::Image<T, 3>::Pointer inItkImage, vtkImageData* outVtkImageData, int vtkType, bool shareBuffer=false);
 
   /*!
     Convert ITK image to MRML volume node. Image geometry is transferred.
@@ -200,9 +213,26 @@ public:
     \param outVolumeNode Output MRML scalar volume node
     \param vtkType Data scalar type (i.e VTK_FLOAT)
     \param applyLpsToRasConversion Apply LPS (ITK, DICOM) to RAS (Slicer) coordinate frame conversion. True by default
+    \param shareBuffer Let the volume use the pixel buffer of the ITK image instead of a copy if possible. False by default
     \return Success
+    \sa ConvertItkImageToVtkImageData
   */
-  template<typename T> static bool ConvertItkImageToVolumeNode(typename itk::Image<T, 3>::Pointer inItkImage, vtkMRMLScalarVolumeNode* outVolumeNode, int vtkType, bool applyLpsToRasConversion=true);
+  template<typename T> static bool ConvertItkImageToVolumeNode(typename itk::Image<T, 3>::Pointer inItkImage, vtkMRMLScalarVolumeNode* outVolumeNode, int vtkType, bool applyLpsToRasConversion=true, bool shareBuffer=false);
+
+  /*!
+    Execute a vtkSMPTools functor on the range [first, last) with the requested number of threads.
+    The process-wide vtkSMPTools settings are not changed. Instead, the requested number of workers are
+    started as vtkSMPTools tasks, and they take chunks of items from a shared counter, so at most that many
+    threads call the functor. The threads come from the vtkSMPTools backend, so fewer threads may be used
+    if the backend has fewer (e.g. the sequential backend always uses the calling thread).
+    \param first First item index
+    \param last One past the last item index
+    \param grain Number of items processed by a thread at once. 0 uses the vtkSMPTools default
+    \param functor Functor called with item ranges. Initialize and Reduce are called if the functor defines them
+    \param numberOfThreads Maximum number of threads to use. 0 uses the current vtkSMPTools setting,
+      1 executes the functor in the calling thread
+  */
+  template<class FunctorType> static void SmpFor(vtkIdType first, vtkIdType last, vtkIdType grain, FunctorType& functor, int numberOfThreads);
 //ETX
 };
 
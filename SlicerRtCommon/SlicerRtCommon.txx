@@ -26,13 +26,23 @@
 
 // VTK includes
 #include <vtkSmartPointer.h>
+#include <vtkAtomic.h>
+#include <vtkCallbackCommand.h>
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
-#include <vtkImageExport.h>
 #include <vtkImageThreshold.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
 #include <vtkTransform.h>
+#include <vtkTypeTraits.h>
 
 // ITK includes
 #include <itkImageRegionIteratorWithIndex.h>
+#include <itkImportImageContainer.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
 
 // Segmentations includes
 #include "vtkOrientedImageData.h"
@@ -49,10 +59,121 @@ namespace
     }
     return val < EPSILON;
   }
+
+  //---------------------------------------------------------------------------
+  /// Tells whether a vtkSMPTools functor has an Initialize method (the same check as in vtkSMPTools)
+  template<typename FunctorType> class SmpFunctorHasInitialize
+  {
+    typedef char (&Yes)[1];
+    typedef char (&No)[2];
+    template<typename U, void (U::*)()> struct MethodSignature {};
+    template<typename U> static Yes Check(MethodSignature<U, &U::Initialize>*);
+    template<typename U> static No Check(...);
+  public:
+    static const bool Value = (sizeof(Check<FunctorType>(0)) == sizeof(Yes));
+  };
+
+  //---------------------------------------------------------------------------
+  /// Call Initialize and Reduce of a vtkSMPTools functor if it defines them
+  template<typename FunctorType, bool HasInitialize> struct SmpFunctorCalls
+  {
+    static void Initialize(FunctorType&) { }
+    static void Reduce(FunctorType&) { }
+  };
+  template<typename FunctorType> struct SmpFunctorCalls<FunctorType, true>
+  {
+    static void Initialize(FunctorType& functor) { functor.Initialize(); }
+    static void Reduce(FunctorType& functor) { functor.Reduce(); }
+  };
+
+  //---------------------------------------------------------------------------
+  /// vtkSMPTools functor executing a fixed number of workers. Each worker takes chunks of items from a shared
+  /// counter and passes them to the wrapped functor, so at most as many threads process the items as there are
+  /// workers, without changing the process-wide vtkSMPTools settings.
+  template<typename FunctorType> class SmpForWorkersFunctor
+  {
+  public:
+    SmpForWorkersFunctor(FunctorType& functor, vtkIdType first, vtkIdType last, vtkIdType grain)
+      : Functor(functor)
+      , Last(last)
+      , Grain(grain)
+    {
+      this->NextItem = first;
+    }
+
+    void Initialize()
+    {
+      SmpFunctorCalls<FunctorType, SmpFunctorHasInitialize<FunctorType>::Value>::Initialize(this->Functor);
+    }
+
+    void operator()(vtkIdType beginWorker, vtkIdType endWorker)
+    {
+      for (vtkIdType worker = beginWorker; worker < endWorker; ++worker)
+      {
+        vtkIdType chunkEnd = (this->NextItem += this->Grain);
+        while (chunkEnd - this->Grain < this->Last)
+        {
+          this->Functor(chunkEnd - this->Grain, std::min(chunkEnd, this->Last));
+          chunkEnd = (this->NextItem += this->Grain);
+        }
+      }
+    }
+
+    void Reduce()
+    {
+      SmpFunctorCalls<FunctorType, SmpFunctorHasInitialize<FunctorType>::Value>::Reduce(this->Functor);
+    }
+
+  private:
+    FunctorType& Functor;
+    vtkAtomic<vtkIdType> NextItem;
+    vtkIdType Last;
+    vtkIdType Grain;
+  };
+
+  //---------------------------------------------------------------------------
+  /// ITK pixel container that uses the buffer of a VTK data array without copying it.
+  /// The container keeps a reference to the data array so that the buffer stays valid
+  /// for the lifetime of the ITK image.
+  template<typename T> class VtkDataArrayImportImageContainer : public itk::ImportImageContainer<itk::SizeValueType, T>
+  {
+  public:
+    typedef VtkDataArrayImportImageContainer Self;
+    typedef itk::ImportImageContainer<itk::SizeValueType, T> Superclass;
+    typedef itk::SmartPointer<Self> Pointer;
+    typedef itk::SmartPointer<const Self> ConstPointer;
+
+    itkNewMacro(Self);
+    itkTypeMacro(VtkDataArrayImportImageContainer, ImportImageContainer);
+
+    void SetDataArray(vtkDataArray* dataArray)
+    {
+      this->DataArray = dataArray;
+      this->SetImportPointer(static_cast<T*>(dataArray->GetVoidPointer(0)),
+        static_cast<itk::SizeValueType>(dataArray->GetNumberOfTuples()), false);
+    }
+
+  protected:
+    VtkDataArrayImportImageContainer() { }
+    virtual ~VtkDataArrayImportImageContainer() { }
+
+  private:
+    VtkDataArrayImportImageContainer(const Self&); // Not implemented
+    void operator=(const Self&); // Not implemented
+
+    vtkSmartPointer<vtkDataArray> DataArray;
+  };
+
+  //---------------------------------------------------------------------------
+  /// Release the ITK object referenced by a VTK data array that uses its buffer
+  inline void UnRegisterItkObject(void* itkObject)
+  {
+    static_cast<itk::LightObject*>(itkObject)->UnRegister();
+  }
 }
 
 //----------------------------------------------------------------------------
-template<typename T> bool SlicerRtCommon::ConvertVolumeNodeToItkImage(vtkMRMLScalarVolumeNode* inVolumeNode, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToWorldConversion/*=true*/, bool applyRasToLpsConversion/*=true*/)
+template<typename T> bool SlicerRtCommon::ConvertVolumeNodeToItkImage(vtkMRMLScalarVolumeNode* inVolumeNode, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToWorldConversion/*=true*/, bool applyRasToLpsConversion/*=true*/, bool shareBuffer/*=false*/)
 {
   if (inVolumeNode == NULL)
   {
@@ -78,18 +199,19 @@ template<typename T> bool SlicerRtCommon::ConvertVolumeNodeToItkImage(vtkMRMLSca
   
   // Convert volume to oriented image data
   vtkSmartPointer<vtkOrientedImageData> orientedImageData = vtkSmartPointer<vtkOrientedImageData>::New();
-  if (!SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(inVolumeNode, orientedImageData, applyRasToWorldConversion))
+  // The scalars are copied into the ITK image unless sharing is requested, so there is no need for an intermediate copy
+  if (!SlicerRtCommon::ConvertVolumeNodeToVtkOrientedImageData(inVolumeNode, orientedImageData, applyRasToWorldConversion, true))
   {
     vtkErrorWithObjectMacro(inVolumeNode, "ConvertVolumeNodeToItkImage: Failed to convert volume node to oriented image data!");
     return false; 
   }
   
   // Convert vtkOrientedImageData to itkImage
-  return SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage<T>(orientedImageData, outItkImage, applyRasToLpsConversion);
+  return SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage<T>(orientedImageData, outItkImage, applyRasToLpsConversion, shareBuffer);
 }
 
 //----------------------------------------------------------------------------
-template<typename T> bool SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage(vtkOrientedImageData* inImageData, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToLpsConversion/*=true*/)
+template<typename T> bool SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage(vtkOrientedImageData* inImageData, typename itk::Image<T, 3>::Pointer outItkImage, bool applyRasToLpsConversion/*=true*/, bool shareBuffer/*=false*/)
 {
   if (inImageData == NULL)
   {
@@ -106,11 +228,13 @@ template<typename T> bool SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage(
     vtkErrorWithObjectMacro(inImageData, "ConvertVtkOrientedImageDataToItkImage: Requested type has a different scalar size than input type - output image is NULL!");
     return false; 
   }
-
-  // Convert vtkOrientedImageData to itkImage 
-  vtkSmartPointer<vtkImageExport> imageExport = vtkSmartPointer<vtkImageExport>::New(); 
-  imageExport->SetInputData(inImageData);
-  imageExport->Update(); 
+  vtkDataArray* inScalars = inImageData->GetPointData()->GetScalars();
+  if (inScalars == NULL || inScalars->GetNumberOfComponents() != 1
+    || inScalars->GetNumberOfTuples() != inImageData->GetNumberOfPoints())
+  {
+    vtkErrorWithObjectMacro(inImageData, "ConvertVtkOrientedImageDataToItkImage: Input image must have single component scalars for each voxel!");
+    return false;
+  }
 
   // Determine input image to world transform
   vtkSmartPointer<vtkMatrix4x4> inImageToWorldRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -194,7 +318,16 @@ template<typename T> bool SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage(
   region.SetIndex(start);
   outItkImage->SetRegions(region);
 
-  // Create and export ITK image
+  // Use the scalar buffer of the VTK image directly if the types match exactly
+  if (shareBuffer && inScalars->GetDataType() == vtkTypeTraits<T>::VTKTypeID())
+  {
+    typename VtkDataArrayImportImageContainer<T>::Pointer pixelContainer = VtkDataArrayImportImageContainer<T>::New();
+    pixelContainer->SetDataArray(inScalars);
+    outItkImage->SetPixelContainer(pixelContainer);
+    return true;
+  }
+
+  // Create ITK image and copy the voxels in one block
   try
   {
     outItkImage->Allocate();
@@ -205,13 +338,13 @@ template<typename T> bool SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage(
     return false;
   }
 
-  imageExport->Export( outItkImage->GetBufferPointer() );
+  memcpy(outItkImage->GetBufferPointer(), inScalars->GetVoidPointer(0), inScalars->GetNumberOfTuples() * sizeof(T));
 
   return true;
 }
 
 //----------------------------------------------------------------------------
-template<typename T> bool SlicerRtCommon::ConvertItkImageToVtkImageData(typename itk::Image<T, 3>::Pointer inItkImage, vtkImageData* outVtkImageData, int vtkType)
+template<typename T> bool SlicerRtCommon::ConvertItkImageToVtkImageData(typename itk::Image<T, 3>::Pointer inItkImage, vtkImageData* outVtkImageData, int vtkType, bool shareBuffer/*=false*/)
 {
   if ( outVtkImageData == NULL )
   {
@@ -229,7 +362,43 @@ template<typename T> bool SlicerRtCommon::ConvertItkImageToVtkImageData(typename
   typename itk::Image<T, 3>::SizeType imageSize = region.GetSize();
   int extent[6]={0, (int) imageSize[0]-1, 0, (int) imageSize[1]-1, 0, (int) imageSize[2]-1};
   outVtkImageData->SetExtent(extent);
+
+  // The pixel buffer can be used as a whole only if it contains exactly the largest possible region
+  bool wholeImageBuffered = (region == inItkImage->GetLargestPossibleRegion());
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(region.GetNumberOfPixels());
+
+  // Use the pixel buffer of the ITK image directly if the types match exactly
+  if (shareBuffer && wholeImageBuffered && vtkType == vtkTypeTraits<T>::VTKTypeID())
+  {
+    vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(vtkType));
+    scalars->SetNumberOfComponents(1);
+    scalars->SetVoidArray(inItkImage->GetBufferPointer(), numberOfVoxels, 1);
+
+    // Keep the pixel container alive until the scalar array is deleted
+    typename itk::Image<T, 3>::PixelContainer* pixelContainer = inItkImage->GetPixelContainer();
+    pixelContainer->Register();
+    vtkSmartPointer<vtkCallbackCommand> releasePixelContainerCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+    releasePixelContainerCommand->SetClientData(pixelContainer);
+    releasePixelContainerCommand->SetClientDataDeleteCallback(UnRegisterItkObject);
+    scalars->AddObserver(vtkCommand::DeleteEvent, releasePixelContainerCommand);
+
+    outVtkImageData->GetPointData()->SetScalars(scalars);
+    return true;
+  }
+
   outVtkImageData->AllocateScalars(vtkType, 1);
+  if (outVtkImageData->GetScalarSize() != sizeof(T))
+  {
+    vtkErrorWithObjectMacro(outVtkImageData, "ConvertItkImageToVtkImageData: Requested VTK type has a different scalar size than input type!");
+    return false;
+  }
+
+  // Copy the voxels in one block if possible
+  if (wholeImageBuffered)
+  {
+    memcpy(outVtkImageData->GetScalarPointer(), inItkImage->GetBufferPointer(), numberOfVoxels * sizeof(T));
+    return true;
+  }
 
   T* outVtkImageDataPtr = (T*)outVtkImageData->GetScalarPointer();
   typename itk::ImageRegionIteratorWithIndex< itk::Image<T, 3> > itInItkImage(
@@ -245,7 +414,7 @@ template<typename T> bool SlicerRtCommon::ConvertItkImageToVtkImageData(typename
 }
 
 //----------------------------------------------------------------------------
-template<typename T> bool SlicerRtCommon::ConvertItkImageToVolumeNode(typename itk::Image<T, 3>::Pointer inItkImage, vtkMRMLScalarVolumeNode* outVolumeNode, int vtkType, bool applyLpsToRasConversion/*=true*/)
+template<typename T> bool SlicerRtCommon::ConvertItkImageToVolumeNode(typename itk::Image<T, 3>::Pointer inItkImage, vtkMRMLScalarVolumeNode* outVolumeNode, int vtkType, bool applyLpsToRasConversion/*=true*/, bool shareBuffer/*=false*/)
 {
   if (outVolumeNode == NULL)
   {
@@ -285,7 +454,7 @@ template<typename T> bool SlicerRtCommon::ConvertItkImageToVolumeNode(typename i
   }
   
   // Convert ITK image to the VTK image data member of the output volume node
-  if (!SlicerRtCommon::ConvertItkImageToVtkImageData<T>(inItkImage, outImageData, vtkType))
+  if (!SlicerRtCommon::ConvertItkImageToVtkImageData<T>(inItkImage, outImageData, vtkType, shareBuffer))
   {
     vtkErrorWithObjectMacro(outVolumeNode, "ConvertItkImageToVolumeNode: Failed to convert ITK image to VTK image data");
     return false; 
@@ -320,3 +489,42 @@ template<typename T> bool SlicerRtCommon::ConvertItkImageToVolumeNode(typename i
 
   return true;
 }
+
+//----------------------------------------------------------------------------
+template<class FunctorType> void SlicerRtCommon::SmpFor(vtkIdType first, vtkIdType last, vtkIdType grain, FunctorType& functor, int numberOfThreads)
+{
+  if (last <= first)
+  {
+    return;
+  }
+
+  if (numberOfThreads == 1 || last - first == 1)
+  {
+    // A single chunk is processed in the calling thread (including Initialize and Reduce of the functor)
+    vtkSMPTools::For(first, last, last - first, functor);
+    return;
+  }
+
+  if (numberOfThreads <= 0)
+  {
+    if (grain > 0)
+    {
+      vtkSMPTools::For(first, last, grain, functor);
+    }
+    else
+    {
+      vtkSMPTools::For(first, last, functor);
+    }
+    return;
+  }
+
+  // The requested number of workers share the items, so the thread count is limited for this call only.
+  // By default each worker takes about a quarter of its share at once, similarly to the vtkSMPTools backends.
+  if (grain <= 0)
+  {
+    grain = std::max<vtkIdType>(1, (last - first) / (4 * numberOfThreads));
+  }
+  vtkIdType numberOfWorkers = std::min<vtkIdType>(numberOfThreads, (last - first + grain - 1) / grain);
+  SmpForWorkersFunctor<FunctorType> workersFunctor(functor, first, last, grain);
+  vtkSMPTools::For(0, numberOfWorkers, 1, workersFunctor);
+}
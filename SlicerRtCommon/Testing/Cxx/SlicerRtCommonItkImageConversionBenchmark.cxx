@@ -0,0 +1,215 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerRT includes
+#include "SlicerRtCommon.h"
+
+// Segmentations includes
+#include "vtkOrientedImageData.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageExport.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// ITK includes
+#include <itkImage.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+  typedef itk::Image<float, 3> FloatImageType;
+
+  //-----------------------------------------------------------------------------
+  /// Convert the image the way it was done before the conversions could share buffers:
+  /// export into a newly allocated ITK image, then copy back voxel by voxel
+  void ConvertUsingImageExportAndIterator(vtkOrientedImageData* image, vtkImageData* outImage)
+  {
+    FloatImageType::Pointer itkImage = FloatImageType::New();
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    image->GetExtent(extent);
+    FloatImageType::SizeType size;
+    size[0] = extent[1] - extent[0] + 1;
+    size[1] = extent[3] - extent[2] + 1;
+    size[2] = extent[5] - extent[4] + 1;
+    FloatImageType::RegionType region;
+    region.SetSize(size);
+    itkImage->SetRegions(region);
+    itkImage->Allocate();
+
+    vtkSmartPointer<vtkImageExport> imageExport = vtkSmartPointer<vtkImageExport>::New();
+    imageExport->SetInputData(image);
+    imageExport->Update();
+    imageExport->Export(itkImage->GetBufferPointer());
+
+    outImage->SetExtent(0, size[0]-1, 0, size[1]-1, 0, size[2]-1);
+    outImage->AllocateScalars(VTK_FLOAT, 1);
+    float* outImagePtr = static_cast<float*>(outImage->GetScalarPointer());
+    itk::ImageRegionConstIteratorWithIndex<FloatImageType> it(itkImage, itkImage->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      *(outImagePtr++) = itkImage->GetPixel(it.GetIndex());
+    }
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Convert the image to ITK and back using SlicerRtCommon and return true on success
+  bool ConvertUsingSlicerRtCommon(vtkOrientedImageData* image, vtkImageData* outImage, bool shareBuffer)
+  {
+    FloatImageType::Pointer itkImage = FloatImageType::New();
+    if (!SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage<float>(image, itkImage, true, shareBuffer))
+    {
+      return false;
+    }
+    return SlicerRtCommon::ConvertItkImageToVtkImageData<float>(itkImage, outImage, VTK_FLOAT, shareBuffer);
+  }
+
+  //-----------------------------------------------------------------------------
+  /// Return true if the voxels of the two images are identical
+  bool CompareVoxels(vtkImageData* image, vtkImageData* referenceImage)
+  {
+    int dimensions[3] = { 0, 0, 0 };
+    int referenceDimensions[3] = { 0, 0, 0 };
+    image->GetDimensions(dimensions);
+    referenceImage->GetDimensions(referenceDimensions);
+    if (dimensions[0] != referenceDimensions[0] || dimensions[1] != referenceDimensions[1] || dimensions[2] != referenceDimensions[2])
+    {
+      std::cerr << "Dimension mismatch: (" << dimensions[0] << ", " << dimensions[1] << ", " << dimensions[2] << ") != ("
+        << referenceDimensions[0] << ", " << referenceDimensions[1] << ", " << referenceDimensions[2] << ")" << std::endl;
+      return false;
+    }
+    if (image->GetScalarType() != VTK_FLOAT)
+    {
+      std::cerr << "Scalar type mismatch: " << image->GetScalarTypeAsString() << " != float" << std::endl;
+      return false;
+    }
+    size_t numberOfBytes = static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2] * sizeof(float);
+    if (memcmp(image->GetScalarPointer(), referenceImage->GetScalarPointer(), numberOfBytes) != 0)
+    {
+      std::cerr << "Voxel values do not match" << std::endl;
+      return false;
+    }
+    return true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+/// Compare the results and the computation times of a VTK to ITK and back round trip
+/// using per-voxel copy, bulk copy, and shared buffers on a synthetic CT sized volume
+int SlicerRtCommonItkImageConversionBenchmark(int argc, char* argv[])
+{
+  int numberOfRepetitions = 3;
+  if (argc > 2 && STRCASECMP(argv[1], "-NumberOfRepetitions") == 0)
+  {
+    numberOfRepetitions = atoi(argv[2]);
+    if (numberOfRepetitions < 1)
+    {
+      numberOfRepetitions = 1;
+    }
+  }
+
+  // Create synthetic volume of typical CT size
+  const int dimensions[3] = { 512, 512, 300 };
+  vtkSmartPointer<vtkOrientedImageData> image = vtkSmartPointer<vtkOrientedImageData>::New();
+  image->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  image->SetSpacing(0.9, 0.9, 1.25);
+  image->AllocateScalars(VTK_FLOAT, 1);
+  float* imagePtr = static_cast<float*>(image->GetScalarPointer());
+  for (int k = 0; k < dimensions[2]; ++k)
+  {
+    for (int j = 0; j < dimensions[1]; ++j)
+    {
+      for (int i = 0; i < dimensions[0]; ++i)
+      {
+        *(imagePtr++) = static_cast<float>(sin(i * 0.05) * cos(j * 0.03) + k * 0.01);
+      }
+    }
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double iteratorTime = 0.0;
+  double bulkCopyTime = 0.0;
+  double sharedBufferTime = 0.0;
+  bool resultsMatch = true;
+  for (int i = 0; i < numberOfRepetitions; ++i)
+  {
+    vtkSmartPointer<vtkImageData> iteratorImage = vtkSmartPointer<vtkImageData>::New();
+    timer->StartTimer();
+    ConvertUsingImageExportAndIterator(image, iteratorImage);
+    timer->StopTimer();
+    iteratorTime += timer->GetElapsedTime();
+    resultsMatch = CompareVoxels(iteratorImage, image) && resultsMatch;
+  }
+  for (int i = 0; i < numberOfRepetitions; ++i)
+  {
+    vtkSmartPointer<vtkImageData> bulkCopyImage = vtkSmartPointer<vtkImageData>::New();
+    timer->StartTimer();
+    bool success = ConvertUsingSlicerRtCommon(image, bulkCopyImage, false);
+    timer->StopTimer();
+    bulkCopyTime += timer->GetElapsedTime();
+    resultsMatch = success && CompareVoxels(bulkCopyImage, image) && resultsMatch;
+    if (bulkCopyImage->GetScalarPointer() == image->GetScalarPointer())
+    {
+      std::cerr << "Image buffer is shared even though sharing was not requested" << std::endl;
+      resultsMatch = false;
+    }
+  }
+  for (int i = 0; i < numberOfRepetitions; ++i)
+  {
+    vtkSmartPointer<vtkImageData> sharedBufferImage = vtkSmartPointer<vtkImageData>::New();
+    timer->StartTimer();
+    bool success = ConvertUsingSlicerRtCommon(image, sharedBufferImage, true);
+    timer->StopTimer();
+    sharedBufferTime += timer->GetElapsedTime();
+    resultsMatch = success && CompareVoxels(sharedBufferImage, image) && resultsMatch;
+    if (sharedBufferImage->GetScalarPointer() != image->GetScalarPointer())
+    {
+      std::cerr << "Image buffer is not shared even though sharing was requested" << std::endl;
+      resultsMatch = false;
+    }
+  }
+
+  // The shared buffer must remain valid after the image it originates from is deleted
+  vtkSmartPointer<vtkImageData> sharedBufferImage = vtkSmartPointer<vtkImageData>::New();
+  {
+    FloatImageType::Pointer itkImage = FloatImageType::New();
+    vtkSmartPointer<vtkOrientedImageData> imageCopy = vtkSmartPointer<vtkOrientedImageData>::New();
+    imageCopy->DeepCopy(image);
+    SlicerRtCommon::ConvertVtkOrientedImageDataToItkImage<float>(imageCopy, itkImage, true, true);
+    imageCopy = NULL;
+    SlicerRtCommon::ConvertItkImageToVtkImageData<float>(itkImage, sharedBufferImage, VTK_FLOAT, true);
+  }
+  resultsMatch = CompareVoxels(sharedBufferImage, image) && resultsMatch;
+
+  std::cout << "Round trip time using image export and iterator: " << iteratorTime / numberOfRepetitions << " s" << std::endl;
+  std::cout << "Round trip time using bulk copy: " << bulkCopyTime / numberOfRepetitions << " s" << std::endl;
+  std::cout << "Round trip time using shared buffer: " << sharedBufferTime / numberOfRepetitions << " s" << std::endl;
+
+  if (!resultsMatch)
+  {
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Results of all conversion methods match" << std::endl;
+  return EXIT_SUCCESS;
+}
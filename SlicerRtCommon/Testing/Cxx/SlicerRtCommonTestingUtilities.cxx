@@ -0,0 +1,34 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "SlicerRtCommonTestingUtilities.h"
+
+// VTK includes
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> SlicerRtCommonTesting::CreateSphere(double radius)
+{
+  vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
+  sphereSource->SetRadius(radius);
+  sphereSource->SetThetaResolution(32);
+  sphereSource->SetPhiResolution(32);
+  sphereSource->Update();
+  vtkSmartPointer<vtkPolyData> sphere = vtkSmartPointer<vtkPolyData>::New();
+  sphere->DeepCopy(sphereSource->GetOutput());
+  return sphere;
+}
@@ -0,0 +1,32 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __SlicerRtCommonTestingUtilities_h
+#define __SlicerRtCommonTestingUtilities_h
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+class vtkPolyData;
+
+/// Helper functions shared by the SlicerRtCommon tests
+namespace SlicerRtCommonTesting
+{
+  /// Create a triangulated sphere mesh centered at the origin
+  vtkSmartPointer<vtkPolyData> CreateSphere(double radius);
+}
+
+#endif
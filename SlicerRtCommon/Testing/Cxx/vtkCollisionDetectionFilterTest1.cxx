@@ -0,0 +1,98 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerRT includes
+#include "vtkCollisionDetectionFilter.h"
+#include "SlicerRtCommonTestingUtilities.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+using SlicerRtCommonTesting::CreateSphere;
+
+//----------------------------------------------------------------------------
+int vtkCollisionDetectionFilterTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkPolyData> sphere0 = CreateSphere(10.0);
+  vtkSmartPointer<vtkPolyData> sphere1 = CreateSphere(10.0);
+
+  vtkSmartPointer<vtkMatrix4x4> matrix0 = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> matrix1 = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  vtkSmartPointer<vtkCollisionDetectionFilter> collisionDetection = vtkSmartPointer<vtkCollisionDetectionFilter>::New();
+  collisionDetection->SetInput(0, sphere0);
+  collisionDetection->SetInput(1, sphere1);
+  collisionDetection->SetMatrix(0, matrix0);
+  collisionDetection->SetMatrix(1, matrix1);
+
+  // Trees are built in advance
+  collisionDetection->BuildLocators();
+  if (collisionDetection->GetNumberOfTreeBuilds() != 2)
+  {
+    std::cerr << __LINE__ << ": Number of tree builds after building locators: " << collisionDetection->GetNumberOfTreeBuilds() << " instead of 2" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Move the second sphere through overlapping and separate positions. Only the matrix changes, so the trees must be kept.
+  const double offsets[4] = { 15.0, 25.0, 19.0, 40.0 };
+  const bool expectedCollisions[4] = { true, false, true, false };
+  for (int i=0; i<4; ++i)
+  {
+    matrix1->SetElement(0, 3, offsets[i]);
+    collisionDetection->Update();
+    bool collision = (collisionDetection->GetNumberOfContacts() > 0);
+    std::cout << "Offset " << offsets[i] << " mm: " << collisionDetection->GetNumberOfContacts() << " contacts, build time: "
+      << collisionDetection->GetLastBuildTime() << " s, query time: " << collisionDetection->GetLastQueryTime() << " s" << std::endl;
+    if (collision != expectedCollisions[i])
+    {
+      std::cerr << __LINE__ << ": Collision at offset " << offsets[i] << " mm: " << collision << " instead of " << expectedCollisions[i] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (collisionDetection->GetNumberOfTreeBuilds() != 2)
+  {
+    std::cerr << __LINE__ << ": Trees were rebuilt when only the transform changed: " << collisionDetection->GetNumberOfTreeBuilds() << " builds instead of 2" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Setting the same input again must not rebuild the tree
+  collisionDetection->SetInput(1, sphere1);
+  collisionDetection->Update();
+  if (collisionDetection->GetNumberOfTreeBuilds() != 2)
+  {
+    std::cerr << __LINE__ << ": Tree was rebuilt when the same input was set again: " << collisionDetection->GetNumberOfTreeBuilds() << " builds instead of 2" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Modifying an input mesh rebuilds only its tree
+  vtkSmartPointer<vtkPolyData> largeSphere = CreateSphere(25.0);
+  sphere1->DeepCopy(largeSphere);
+  collisionDetection->Update();
+  if (collisionDetection->GetNumberOfTreeBuilds() != 3)
+  {
+    std::cerr << __LINE__ << ": Number of tree builds after modifying input: " << collisionDetection->GetNumberOfTreeBuilds() << " instead of 3" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (collisionDetection->GetNumberOfContacts() == 0)
+  {
+    std::cerr << __LINE__ << ": No collision detected with the enlarged sphere" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
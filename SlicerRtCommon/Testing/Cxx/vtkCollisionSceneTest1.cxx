@@ -0,0 +1,415 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerRT includes
+#include "vtkCollisionDetectionFilter.h"
+#include "vtkCollisionProxyMeshFilter.h"
+#include "vtkCollisionScene.h"
+#include "SlicerRtCommonTestingUtilities.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+//----------------------------------------------------------------------------
+using SlicerRtCommonTesting::CreateSphere;
+
+//----------------------------------------------------------------------------
+namespace
+{
+  /// Count the contacts of a part pair of the scene using the collision detection filter
+  int GetNumberOfContactsUsingFilter(vtkCollisionScene* scene, int pairIndex)
+  {
+    int partIndex1 = -1;
+    int partIndex2 = -1;
+    scene->GetPartPair(pairIndex, partIndex1, partIndex2);
+    vtkSmartPointer<vtkMatrix4x4> matrix1 = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> matrix2 = vtkSmartPointer<vtkMatrix4x4>::New();
+    scene->GetPartToWorldMatrix(partIndex1, matrix1);
+    scene->GetPartToWorldMatrix(partIndex2, matrix2);
+
+    vtkSmartPointer<vtkCollisionDetectionFilter> collisionDetection = vtkSmartPointer<vtkCollisionDetectionFilter>::New();
+    collisionDetection->SetCollisionModeToHalfContacts();
+    collisionDetection->SetInput(0, scene->GetPartMesh(partIndex1));
+    collisionDetection->SetInput(1, scene->GetPartMesh(partIndex2));
+    collisionDetection->SetMatrix(0, matrix1);
+    collisionDetection->SetMatrix(1, matrix2);
+    collisionDetection->Update();
+    return collisionDetection->GetNumberOfContacts();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionSceneTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkSmartPointer<vtkCollisionScene> scene = vtkSmartPointer<vtkCollisionScene>::New();
+  int part0 = scene->AddPart("sphere0", CreateSphere(10.0));
+  int part1 = scene->AddPart("sphere1", CreateSphere(10.0));
+  int part2 = scene->AddPart("sphere2", CreateSphere(10.0));
+  int emptyPart = scene->AddPart("empty", NULL);
+  if (scene->GetPartIndex("sphere2") != part2 || scene->GetPartIndex("nonexistent") != -1)
+  {
+    std::cerr << __LINE__ << ": Part lookup by name failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  scene->AddPartPair(part0, part1);
+  scene->AddPartPair(part0, part2);
+  scene->AddPartPair(part1, part2);
+  int emptyPair = scene->AddPartPair(part0, emptyPart);
+
+  // Trees are built once for the parts with mesh, regardless of how many pairs contain them
+  scene->BuildLocators();
+  if (scene->GetNumberOfTreeBuilds() != 3)
+  {
+    std::cerr << __LINE__ << ": Number of tree builds after building locators: " << scene->GetNumberOfTreeBuilds() << " instead of 3" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Sphere 1 is moved along the X axis, sphere 2 is placed at 30 mm. Sphere 0 stays at the origin.
+  vtkSmartPointer<vtkMatrix4x4> part2ToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  part2ToWorldMatrix->SetElement(0, 3, 30.0);
+  scene->SetPartToWorldMatrix(part2, part2ToWorldMatrix);
+
+  const double offsets[4] = { 15.0, 25.0, 5.0, 45.0 };
+  const bool expectedCollisions[4][3] = { { true, false, true }, { false, false, true }, { true, false, false }, { false, false, true } };
+  vtkSmartPointer<vtkMatrix4x4> part1ToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int i=0; i<4; ++i)
+  {
+    part1ToWorldMatrix->SetElement(0, 3, offsets[i]);
+    scene->SetPartToWorldMatrix(part1, part1ToWorldMatrix);
+
+    // Any contact mode, parallel
+    scene->FirstContactOnlyOn();
+    scene->SetNumberOfThreads(0);
+    scene->CheckCollisions();
+    bool firstContactCollisions[3] = { false, false, false };
+    for (int pairIndex=0; pairIndex<3; ++pairIndex)
+    {
+      firstContactCollisions[pairIndex] = scene->GetPartPairInCollision(pairIndex);
+      if (firstContactCollisions[pairIndex] != expectedCollisions[i][pairIndex])
+      {
+        std::cerr << __LINE__ << ": Collision of pair " << pairIndex << " at offset " << offsets[i] << " mm: "
+          << firstContactCollisions[pairIndex] << " instead of " << expectedCollisions[i][pairIndex] << std::endl;
+        return EXIT_FAILURE;
+      }
+      if (scene->GetPartPairNumberOfContacts(pairIndex) > 1)
+      {
+        std::cerr << __LINE__ << ": More than one contact found in first contact mode" << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+    if (scene->GetPartPairInCollision(emptyPair))
+    {
+      std::cerr << __LINE__ << ": Part without mesh is in collision" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // All contacts mode, serial and parallel execution must find the same contacts as the filter
+    scene->FirstContactOnlyOff();
+    for (int numberOfThreads=1; numberOfThreads>=0; --numberOfThreads)
+    {
+      scene->SetNumberOfThreads(numberOfThreads);
+      scene->CheckCollisions();
+      for (int pairIndex=0; pairIndex<3; ++pairIndex)
+      {
+        int expectedNumberOfContacts = GetNumberOfContactsUsingFilter(scene, pairIndex);
+        if (scene->GetPartPairNumberOfContacts(pairIndex) != expectedNumberOfContacts)
+        {
+          std::cerr << __LINE__ << ": Number of contacts of pair " << pairIndex << " at offset " << offsets[i] << " mm using "
+            << numberOfThreads << " threads: " << scene->GetPartPairNumberOfContacts(pairIndex) << " instead of " << expectedNumberOfContacts << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+    std::cout << "Offset " << offsets[i] << " mm: build time: " << scene->GetLastBuildTime()
+      << " s, query time: " << scene->GetLastQueryTime() << " s" << std::endl;
+  }
+
+  // Moving the parts must not rebuild the trees
+  if (scene->GetNumberOfTreeBuilds() != 3)
+  {
+    std::cerr << __LINE__ << ": Trees were rebuilt when only the transforms changed: " << scene->GetNumberOfTreeBuilds() << " builds instead of 3" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Setting a mesh on the empty part builds only its tree
+  scene->SetPartMesh(emptyPart, CreateSphere(5.0));
+  vtkSmartPointer<vtkMatrix4x4> emptyPartToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  emptyPartToWorldMatrix->SetElement(0, 3, 12.0);
+  scene->SetPartToWorldMatrix(emptyPart, emptyPartToWorldMatrix);
+  scene->FirstContactOnlyOn();
+  scene->CheckCollisions();
+  if (scene->GetNumberOfTreeBuilds() != 4)
+  {
+    std::cerr << __LINE__ << ": Number of tree builds after setting mesh: " << scene->GetNumberOfTreeBuilds() << " instead of 4" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!scene->GetPartPairInCollision(emptyPair))
+  {
+    std::cerr << __LINE__ << ": No collision detected with the newly set mesh" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Checking many poses at once must give the same results as checking them one by one
+  const int numberOfPoses = 50;
+  int numberOfParts = scene->GetNumberOfParts();
+  int numberOfPairs = scene->GetNumberOfPartPairs();
+  vtkSmartPointer<vtkDoubleArray> partToWorldMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+  partToWorldMatrices->SetNumberOfComponents(numberOfParts * 16);
+  partToWorldMatrices->SetNumberOfTuples(numberOfPoses);
+  std::vector<unsigned char> expectedPairCollisions;
+  vtkSmartPointer<vtkMatrix4x4> partToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  for (int poseIndex=0; poseIndex<numberOfPoses; ++poseIndex)
+  {
+    part1ToWorldMatrix->SetElement(0, 3, poseIndex - 10.0);
+    part1ToWorldMatrix->SetElement(1, 3, (poseIndex % 7) - 3.0);
+    scene->SetPartToWorldMatrix(part1, part1ToWorldMatrix);
+    scene->CheckCollisions();
+    for (int partIndex=0; partIndex<numberOfParts; ++partIndex)
+    {
+      scene->GetPartToWorldMatrix(partIndex, partToWorldMatrix);
+      vtkMatrix4x4::DeepCopy(partToWorldMatrices->GetPointer(poseIndex * numberOfParts * 16 + partIndex * 16), partToWorldMatrix);
+    }
+    for (int pairIndex=0; pairIndex<numberOfPairs; ++pairIndex)
+    {
+      expectedPairCollisions.push_back(scene->GetPartPairInCollision(pairIndex) ? 1 : 0);
+    }
+  }
+  int expectedNumberOfPosesInCollision = 0;
+  for (int poseIndex=0; poseIndex<numberOfPoses; ++poseIndex)
+  {
+    for (int pairIndex=0; pairIndex<numberOfPairs; ++pairIndex)
+    {
+      if (expectedPairCollisions[poseIndex * numberOfPairs + pairIndex])
+      {
+        expectedNumberOfPosesInCollision++;
+        break;
+      }
+    }
+  }
+
+  vtkSmartPointer<vtkUnsignedCharArray> pairCollisions = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  for (int numberOfThreads=1; numberOfThreads>=0; --numberOfThreads)
+  {
+    scene->SetNumberOfThreads(numberOfThreads);
+    int numberOfPosesInCollision = scene->CheckCollisionsForPoses(partToWorldMatrices, pairCollisions);
+    std::cout << numberOfPoses << " poses using " << numberOfThreads << " threads: query time: " << scene->GetLastQueryTime() << " s" << std::endl;
+    if (numberOfPosesInCollision != expectedNumberOfPosesInCollision)
+    {
+      std::cerr << __LINE__ << ": Number of poses in collision using " << numberOfThreads << " threads: "
+        << numberOfPosesInCollision << " instead of " << expectedNumberOfPosesInCollision << std::endl;
+      return EXIT_FAILURE;
+    }
+    if ( pairCollisions->GetNumberOfTuples() != numberOfPoses || pairCollisions->GetNumberOfComponents() != numberOfPairs
+      || !std::equal(expectedPairCollisions.begin(), expectedPairCollisions.end(), pairCollisions->GetPointer(0)) )
+    {
+      std::cerr << __LINE__ << ": Pair collisions of the poses using " << numberOfThreads << " threads do not match the single pose checks" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // No proxy mesh is created for meshes that are too small to be simplified, and the stored parameters identify the proxy meshes
+  // that can be reused with the current settings
+  vtkSmartPointer<vtkCollisionProxyMeshFilter> smallMeshProxyFilter = vtkSmartPointer<vtkCollisionProxyMeshFilter>::New();
+  smallMeshProxyFilter->SetInputData(scene->GetPartMesh(part0));
+  smallMeshProxyFilter->SetMinimumNumberOfTriangles(scene->GetPartMesh(part0)->GetNumberOfCells() + 1);
+  smallMeshProxyFilter->Update();
+  if (smallMeshProxyFilter->GetOutput()->GetNumberOfCells() != 0)
+  {
+    std::cerr << __LINE__ << ": Proxy mesh with " << smallMeshProxyFilter->GetOutput()->GetNumberOfCells()
+      << " triangles is created for a mesh below the minimum number of triangles" << std::endl;
+    return EXIT_FAILURE;
+  }
+  smallMeshProxyFilter->SetMinimumNumberOfTriangles(0);
+  smallMeshProxyFilter->Update();
+  vtkSmartPointer<vtkPolyData> cachedProxyMesh = vtkSmartPointer<vtkPolyData>::New();
+  cachedProxyMesh->DeepCopy(smallMeshProxyFilter->GetOutput());
+  bool upToDateWithSameSettings = smallMeshProxyFilter->IsProxyMeshUpToDate(cachedProxyMesh);
+  smallMeshProxyFilter->SetTargetReduction(0.5);
+  bool upToDateWithOtherTargetReduction = smallMeshProxyFilter->IsProxyMeshUpToDate(cachedProxyMesh);
+  smallMeshProxyFilter->SetTargetReduction(0.9);
+  smallMeshProxyFilter->SetMinimumNumberOfTriangles(10);
+  bool upToDateWithOtherMinimumNumberOfTriangles = smallMeshProxyFilter->IsProxyMeshUpToDate(cachedProxyMesh);
+  if ( cachedProxyMesh->GetNumberOfCells() == 0 || !upToDateWithSameSettings
+    || upToDateWithOtherTargetReduction || upToDateWithOtherMinimumNumberOfTriangles )
+  {
+    std::cerr << __LINE__ << ": Proxy mesh parameters are not checked correctly. Up to date with same settings: " << upToDateWithSameSettings
+      << ", with other target reduction: " << upToDateWithOtherTargetReduction << ", with other minimum number of triangles: "
+      << upToDateWithOtherMinimumNumberOfTriangles << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Simplified proxy meshes only skip part pairs that cannot collide, so the results must not change
+  for (int partIndex=0; partIndex<numberOfParts; ++partIndex)
+  {
+    vtkSmartPointer<vtkCollisionProxyMeshFilter> proxyMeshFilter = vtkSmartPointer<vtkCollisionProxyMeshFilter>::New();
+    proxyMeshFilter->SetInputData(scene->GetPartMesh(partIndex));
+    proxyMeshFilter->SetMinimumNumberOfTriangles(0);
+    proxyMeshFilter->SetTargetReduction(0.8);
+    proxyMeshFilter->Update();
+    double maximumDeviation = -1.0;
+    if ( proxyMeshFilter->GetOutput()->GetNumberOfCells() >= scene->GetPartMesh(partIndex)->GetNumberOfCells()
+      || !vtkCollisionProxyMeshFilter::GetMaximumDeviation(proxyMeshFilter->GetOutput(), maximumDeviation)
+      || maximumDeviation != proxyMeshFilter->GetMaximumDeviation() )
+    {
+      std::cerr << __LINE__ << ": Invalid proxy mesh for part " << partIndex << ": " << proxyMeshFilter->GetOutput()->GetNumberOfCells()
+        << " triangles, maximum deviation " << maximumDeviation << std::endl;
+      return EXIT_FAILURE;
+    }
+    scene->SetPartProxyMesh(partIndex, proxyMeshFilter->GetOutput(), maximumDeviation + 0.5);
+  }
+  for (int numberOfThreads=1; numberOfThreads>=0; --numberOfThreads)
+  {
+    scene->SetNumberOfThreads(numberOfThreads);
+    int numberOfPosesInCollision = scene->CheckCollisionsForPoses(partToWorldMatrices, pairCollisions);
+    std::cout << numberOfPoses << " poses with proxy meshes using " << numberOfThreads << " threads: query time: " << scene->GetLastQueryTime() << " s" << std::endl;
+    if ( numberOfPosesInCollision != expectedNumberOfPosesInCollision
+      || !std::equal(expectedPairCollisions.begin(), expectedPairCollisions.end(), pairCollisions->GetPointer(0)) )
+    {
+      std::cerr << __LINE__ << ": Pair collisions of the poses with proxy meshes using " << numberOfThreads << " threads do not match the checks without proxies" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (scene->GetNumberOfTreeBuilds() != 8)
+  {
+    std::cerr << __LINE__ << ": Number of tree builds after setting proxy meshes: " << scene->GetNumberOfTreeBuilds() << " instead of 8" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Continuous collision detection: a sphere rotating around the Z axis at 50 mm radius from 0 to 170 degrees
+  // passes through an obstacle at 50 degrees, while it is clear of it at both ends of the rotation.
+  // Another obstacle is 30 mm above the rotation plane, so it is never touched.
+  vtkSmartPointer<vtkCollisionScene> motionScene = vtkSmartPointer<vtkCollisionScene>::New();
+  int armPart = motionScene->AddPart("arm", CreateSphere(10.0));
+  int obstaclePart = motionScene->AddPart("obstacle", CreateSphere(10.0));
+  int clearObstaclePart = motionScene->AddPart("clear obstacle", CreateSphere(10.0));
+  motionScene->AddPartPair(armPart, obstaclePart);
+  motionScene->AddPartPair(armPart, clearObstaclePart);
+  int numberOfMotionParts = motionScene->GetNumberOfParts();
+
+  vtkSmartPointer<vtkTransform> obstacleToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+  obstacleToWorldTransform->RotateZ(50.0);
+  obstacleToWorldTransform->Translate(50.0, 0.0, 0.0);
+  vtkSmartPointer<vtkTransform> clearObstacleToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+  clearObstacleToWorldTransform->Translate(0.0, 0.0, 30.0);
+  clearObstacleToWorldTransform->RotateZ(50.0);
+  clearObstacleToWorldTransform->Translate(50.0, 0.0, 0.0);
+  const double armAngles[2] = { 0.0, 170.0 };
+  vtkSmartPointer<vtkDoubleArray> armPoseMatrices[2];
+  for (int poseIndex=0; poseIndex<2; ++poseIndex)
+  {
+    vtkSmartPointer<vtkTransform> armToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+    armToWorldTransform->RotateZ(armAngles[poseIndex]);
+    armToWorldTransform->Translate(50.0, 0.0, 0.0);
+    armPoseMatrices[poseIndex] = vtkSmartPointer<vtkDoubleArray>::New();
+    armPoseMatrices[poseIndex]->SetNumberOfComponents(numberOfMotionParts * 16);
+    armPoseMatrices[poseIndex]->SetNumberOfTuples(1);
+    double* poseElements = armPoseMatrices[poseIndex]->GetPointer(0);
+    vtkMatrix4x4::DeepCopy(poseElements + armPart * 16, armToWorldTransform->GetMatrix());
+    vtkMatrix4x4::DeepCopy(poseElements + obstaclePart * 16, obstacleToWorldTransform->GetMatrix());
+    vtkMatrix4x4::DeepCopy(poseElements + clearObstaclePart * 16, clearObstacleToWorldTransform->GetMatrix());
+  }
+
+  // Discrete checks at the ends of the rotation miss the collision
+  vtkSmartPointer<vtkUnsignedCharArray> motionPairCollisions = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  for (int poseIndex=0; poseIndex<2; ++poseIndex)
+  {
+    if (motionScene->CheckCollisionsForPoses(armPoseMatrices[poseIndex], motionPairCollisions) != 0)
+    {
+      std::cerr << __LINE__ << ": Collision found at arm angle " << armAngles[poseIndex] << " degrees" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  for (int numberOfThreads=1; numberOfThreads>=0; --numberOfThreads)
+  {
+    motionScene->SetNumberOfThreads(numberOfThreads);
+    if ( motionScene->CheckCollisionsBetweenPoses(armPoseMatrices[0], armPoseMatrices[1], motionPairCollisions) != 1
+      || motionPairCollisions->GetValue(0) != 1 || motionPairCollisions->GetValue(1) != 0 )
+    {
+      std::cerr << __LINE__ << ": Collision during the rotation of the arm is not detected correctly using " << numberOfThreads
+        << " threads. Obstacle: " << (int)motionPairCollisions->GetValue(0) << ", clear obstacle: " << (int)motionPairCollisions->GetValue(1) << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Continuous collision detection using " << numberOfThreads << " threads: query time: " << motionScene->GetLastQueryTime() << " s" << std::endl;
+  }
+  // Reverse motion must give the same result
+  if (motionScene->CheckCollisionsBetweenPoses(armPoseMatrices[1], armPoseMatrices[0], motionPairCollisions) != 1)
+  {
+    std::cerr << __LINE__ << ": Collision during the reverse rotation of the arm is not detected" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Rotation of 270 degrees with an obstacle at 135 degrees. The scene takes the shorter rotation of -90 degrees
+  // between the two poses, so the rotation must be split into sub-motions to reach the obstacle. The split into
+  // sub-motions of at most 90 degrees is done here directly, its computation from gantry angles is tested in RoomsEyeView.
+  vtkSmartPointer<vtkTransform> longArcObstacleToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+  longArcObstacleToWorldTransform->RotateZ(135.0);
+  longArcObstacleToWorldTransform->Translate(50.0, 0.0, 0.0);
+  vtkSmartPointer<vtkDoubleArray> motionAngles = vtkSmartPointer<vtkDoubleArray>::New();
+  for (double motionAngle = 0.0; motionAngle <= 270.0; motionAngle += 90.0)
+  {
+    motionAngles->InsertNextValue(motionAngle);
+  }
+  vtkSmartPointer<vtkDoubleArray> longArcPoseMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+  longArcPoseMatrices->SetNumberOfComponents(numberOfMotionParts * 16);
+  longArcPoseMatrices->SetNumberOfTuples(motionAngles->GetNumberOfTuples());
+  for (vtkIdType angleIndex=0; angleIndex<motionAngles->GetNumberOfTuples(); ++angleIndex)
+  {
+    vtkSmartPointer<vtkTransform> armToWorldTransform = vtkSmartPointer<vtkTransform>::New();
+    armToWorldTransform->RotateZ(motionAngles->GetValue(angleIndex));
+    armToWorldTransform->Translate(50.0, 0.0, 0.0);
+    double* poseElements = longArcPoseMatrices->GetPointer(angleIndex * numberOfMotionParts * 16);
+    vtkMatrix4x4::DeepCopy(poseElements + armPart * 16, armToWorldTransform->GetMatrix());
+    vtkMatrix4x4::DeepCopy(poseElements + obstaclePart * 16, longArcObstacleToWorldTransform->GetMatrix());
+    vtkMatrix4x4::DeepCopy(poseElements + clearObstaclePart * 16, clearObstacleToWorldTransform->GetMatrix());
+  }
+  vtkIdType numberOfSubMotions = longArcPoseMatrices->GetNumberOfTuples() - 1;
+  vtkSmartPointer<vtkDoubleArray> longArcStartPoseMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+  longArcStartPoseMatrices->SetNumberOfComponents(numberOfMotionParts * 16);
+  vtkSmartPointer<vtkDoubleArray> longArcEndPoseMatrices = vtkSmartPointer<vtkDoubleArray>::New();
+  longArcEndPoseMatrices->SetNumberOfComponents(numberOfMotionParts * 16);
+  longArcStartPoseMatrices->InsertNextTuple(longArcPoseMatrices->GetPointer(0));
+  longArcEndPoseMatrices->InsertNextTuple(longArcPoseMatrices->GetPointer(numberOfSubMotions * numberOfMotionParts * 16));
+  if (motionScene->CheckCollisionsBetweenPoses(longArcStartPoseMatrices, longArcEndPoseMatrices, motionPairCollisions) != 0)
+  {
+    std::cerr << __LINE__ << ": Collision found during the shorter rotation between 0 and 270 degrees" << std::endl;
+    return EXIT_FAILURE;
+  }
+  longArcStartPoseMatrices->Initialize();
+  longArcEndPoseMatrices->Initialize();
+  for (vtkIdType subMotionIndex=0; subMotionIndex<numberOfSubMotions; ++subMotionIndex)
+  {
+    longArcStartPoseMatrices->InsertNextTuple(longArcPoseMatrices->GetPointer(subMotionIndex * numberOfMotionParts * 16));
+    longArcEndPoseMatrices->InsertNextTuple(longArcPoseMatrices->GetPointer((subMotionIndex + 1) * numberOfMotionParts * 16));
+  }
+  if (motionScene->CheckCollisionsBetweenPoses(longArcStartPoseMatrices, longArcEndPoseMatrices, motionPairCollisions) != 1
+    || motionPairCollisions->GetValue(1 * 2 + 0) != 1)
+  {
+    std::cerr << __LINE__ << ": Collision during the 270 degree rotation of the arm is not detected in the second sub-motion" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -41,6 +41,7 @@
 #include "vtkTransform.h"
 #include "vtkSmartPointer.h"
 #include "vtkCellArray.h"
+#include "vtkTimerLog.h"
 #include <vtkTrivialProducer.h>
 
 vtkStandardNewMacro(vtkCollisionDetectionFilter);
@@ -68,6 +69,9 @@ vtkCollisionDetectionFilter::vtkCollisionDetectionFilter()
   this->GenerateScalars = 0;
   this->CollisionMode = VTK_ALL_CONTACTS;
   this->Opacity = 1.0;
+  this->LastBuildTime = 0.0;
+  this->LastQueryTime = 0.0;
+  this->NumberOfTreeBuilds = 0;
 }
 
 // Destroy any allocated memory.
@@ -116,6 +120,12 @@ void vtkCollisionDetectionFilter::SetInput(int idx, vtkPolyData *input)
     vtkErrorMacro(<< "Index " << idx 
       << " is out of range in SetInput. Only two inputs allowed!");
     }
+
+  // Setting the same input again would modify the pipeline although the input did not change
+  if (input && this->GetNumberOfInputConnections(idx) > 0 && this->GetInput(idx) == input)
+    {
+    return;
+    }
     
   // Ask the superclass to connect the input.
   vtkSmartPointer<vtkTrivialProducer> inputProducer = vtkSmartPointer<vtkTrivialProducer>::New();
@@ -496,27 +506,22 @@ int vtkCollisionDetectionFilter::RequestData(
   this->InvokeEvent(vtkCommand::StartEvent, NULL);
   
 
-  // rebuild the obb trees... they do their own mtime checking with input data
-  tree0->SetDataSet(input[0]);
-  tree0->AutomaticOn();
-  tree0->SetNumberOfCellsPerNode(this->NumberOfCellsPerNode);
-  tree0->BuildLocator();
-
-  tree1->SetDataSet(input[1]);
-  tree1->AutomaticOn();
-  tree1->SetNumberOfCellsPerNode(this->NumberOfCellsPerNode);
-  tree1->BuildLocator();
+  // rebuild the obb trees only if the input meshes changed, the transforms are
+  // applied when the trees are intersected
+  double buildStartTime = vtkTimerLog::GetUniversalTime();
+  this->UpdateTree(0, input[0]);
+  this->UpdateTree(1, input[1]);
+  double queryStartTime = vtkTimerLog::GetUniversalTime();
+  this->LastBuildTime = queryStartTime - buildStartTime;
     
   // Set the Box Tolerance
   tree0->SetTolerance(this->BoxTolerance);
   tree1->SetTolerance(this->BoxTolerance);
 
-
-
-
   // Do the collision detection...
   int boxTests = 
     tree0->IntersectWithOBBTree(tree1,  matrix, ComputeCollisions, this);
+  this->LastQueryTime = vtkTimerLog::GetUniversalTime() - queryStartTime;
 
   matrix->Delete();
   tmpMatrix->Delete();
@@ -600,6 +605,46 @@ int vtkCollisionDetectionFilter::RequestData(
 
 }
 
+// Description:
+// Build the OBB trees in advance
+void vtkCollisionDetectionFilter::BuildLocators()
+{
+  double buildStartTime = vtkTimerLog::GetUniversalTime();
+  for (int i=0; i<2; i++)
+    {
+    vtkPolyData *input = this->GetInput(i);
+    if (!input)
+      {
+      vtkErrorMacro(<< "Input " << i << " hasn't been added... can't build locator!");
+      return;
+      }
+    this->UpdateTree(i, input);
+    }
+  this->LastBuildTime = vtkTimerLog::GetUniversalTime() - buildStartTime;
+}
+
+bool vtkCollisionDetectionFilter::UpdateTree(int i, vtkPolyData *input)
+{
+  vtkOBBTree *tree = (i == 0 ? this->tree0 : this->tree1);
+  if (tree->GetDataSet() == input
+    && tree->GetNumberOfCellsPerNode() == this->NumberOfCellsPerNode
+    && this->TreeBuildTime[i].GetMTime() > input->GetMTime())
+    {
+    return false;
+    }
+
+  vtkDebugMacro(<< "Building OBB tree " << i);
+  tree->SetDataSet(input);
+  tree->AutomaticOn();
+  tree->SetNumberOfCellsPerNode(this->NumberOfCellsPerNode);
+  // make sure the tree does not skip the build based on its own modification time
+  tree->FreeSearchStructure();
+  tree->BuildLocator();
+  this->TreeBuildTime[i].Modified();
+  this->NumberOfTreeBuilds++;
+  return true;
+}
+
 // Method intersects two polygons. You must supply the number of points and
 // point coordinates (npts, *pts) and the bounding box (bounds) of the two
 // polygons. Also supply a tolerance squared for controlling
@@ -784,5 +829,8 @@ void vtkCollisionDetectionFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Box Tolerance: " << this->BoxTolerance << "\n";
   os << indent << "Cell Tolerance: " << this->CellTolerance << "\n";
   os << indent << "Number of cells per Node: " << this->NumberOfCellsPerNode << "\n";
+  os << indent << "Number of tree builds: " << this->NumberOfTreeBuilds << "\n";
+  os << indent << "Last build time: " << this->LastBuildTime << "\n";
+  os << indent << "Last query time: " << this->LastQueryTime << "\n";
 
 }
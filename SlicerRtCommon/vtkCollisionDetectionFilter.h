@@ -90,8 +90,9 @@ public:
   // Intersect two polygons, return x1 and x2 as the twp points of intersection. If
   // CollisionMode = VTK_ALL_CONTACTS, both contact points are found. If 
   // CollisionMode = VTK_FIRST_CONTACT or VTK_HALF_CONTACTS, only
-  // one contact point is found.
-  int IntersectPolygonWithPolygon(int npts, double *pts, double bounds[6],
+  // one contact point is found. Does not use any member of the filter, so it
+  // can be called concurrently from multiple threads.
+  static int IntersectPolygonWithPolygon(int npts, double *pts, double bounds[6],
                                             int npts2, double *pts2, 
                                             double bounds2[6], double tol2,
                                             double x1[2], double x2[3],
@@ -165,6 +166,24 @@ public:
   vtkSetClampMacro(Opacity, float, 0.0, 1.0);
   vtkGetMacro(Opacity, float);
 
+  // Description:
+  // Build the OBB trees of the inputs unless they are up to date. The trees are kept
+  // between updates and only rebuilt when an input mesh or NumberOfCellsPerNode is
+  // modified, so changing only the transforms or matrices does not rebuild them.
+  // Call this after setting the inputs so that the first collision query does not
+  // need to build the trees.
+  void BuildLocators();
+
+  //Description:
+  // Get the time (in seconds) spent on building the OBB trees and on the collision
+  // query in the last update. The build time is zero if the trees were up to date.
+  vtkGetMacro(LastBuildTime, double);
+  vtkGetMacro(LastQueryTime, double);
+
+  //Description:
+  // Get the number of OBB tree builds since the filter was created
+  vtkGetMacro(NumberOfTreeBuilds, int);
+
   // Description:
   // Return the MTime also considering the transform.
   vtkMTimeType GetMTime();
@@ -175,10 +194,21 @@ protected:
 
   // Usual data generation method
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  // Rebuild the OBB tree of input i if the input or the build parameters changed since
+  // the tree was built. Returns true if the tree was rebuilt.
+  bool UpdateTree(int i, vtkPolyData *input);
   
   vtkOBBTree *tree0;
   vtkOBBTree *tree1;
 
+  // Time of the last build of each OBB tree
+  vtkTimeStamp TreeBuildTime[2];
+
+  double LastBuildTime;
+  double LastQueryTime;
+  int NumberOfTreeBuilds;
+
   vtkLinearTransform *Transform[2];
   vtkMatrix4x4 *Matrix[2];
   
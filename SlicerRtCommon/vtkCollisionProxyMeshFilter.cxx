@@ -0,0 +1,221 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+
+#include "vtkCollisionProxyMeshFilter.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCellLocator.h>
+#include <vtkCleanPolyData.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkGenericCell.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkSmartPointer.h>
+#include <vtkTriangleFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+const char* vtkCollisionProxyMeshFilter::MAXIMUM_DEVIATION_ARRAY_NAME = "CollisionProxyMaximumDeviation";
+const char* vtkCollisionProxyMeshFilter::TARGET_REDUCTION_ARRAY_NAME = "CollisionProxyTargetReduction";
+const char* vtkCollisionProxyMeshFilter::MINIMUM_NUMBER_OF_TRIANGLES_ARRAY_NAME = "CollisionProxyMinimumNumberOfTriangles";
+const char* vtkCollisionProxyMeshFilter::ALGORITHM_VERSION_ARRAY_NAME = "CollisionProxyAlgorithmVersion";
+const int vtkCollisionProxyMeshFilter::ALGORITHM_VERSION = 1;
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkCollisionProxyMeshFilter);
+
+//----------------------------------------------------------------------------
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// Get the single value of a field data array
+  bool GetFieldDataValue(vtkPolyData* mesh, const char* arrayName, double& value)
+  {
+    vtkDataArray* array = (mesh && mesh->GetFieldData() ? mesh->GetFieldData()->GetArray(arrayName) : NULL);
+    if (!array || array->GetNumberOfTuples() < 1)
+    {
+      return false;
+    }
+    value = array->GetComponent(0, 0);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Set a field data array with a single value
+  void SetFieldDataValue(vtkPolyData* mesh, const char* arrayName, double value)
+  {
+    vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(arrayName);
+    array->InsertNextValue(value);
+    mesh->GetFieldData()->AddArray(array);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkCollisionProxyMeshFilter::vtkCollisionProxyMeshFilter()
+{
+  this->TargetReduction = 0.9;
+  this->MinimumNumberOfTriangles = 1000;
+  this->MaximumDeviation = 0.0;
+}
+
+//----------------------------------------------------------------------------
+vtkCollisionProxyMeshFilter::~vtkCollisionProxyMeshFilter()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionProxyMeshFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "TargetReduction: " << this->TargetReduction << "\n";
+  os << indent << "MinimumNumberOfTriangles: " << this->MinimumNumberOfTriangles << "\n";
+  os << indent << "MaximumDeviation: " << this->MaximumDeviation << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkCollisionProxyMeshFilter::GetMaximumDeviation(vtkPolyData* proxyMesh, double& maximumDeviation)
+{
+  return GetFieldDataValue(proxyMesh, MAXIMUM_DEVIATION_ARRAY_NAME, maximumDeviation);
+}
+
+//----------------------------------------------------------------------------
+bool vtkCollisionProxyMeshFilter::GetTargetReduction(vtkPolyData* proxyMesh, double& targetReduction)
+{
+  return GetFieldDataValue(proxyMesh, TARGET_REDUCTION_ARRAY_NAME, targetReduction);
+}
+
+//----------------------------------------------------------------------------
+bool vtkCollisionProxyMeshFilter::IsProxyMeshUpToDate(vtkPolyData* proxyMesh)
+{
+  double version = 0.0;
+  double targetReduction = 0.0;
+  double minimumNumberOfTriangles = 0.0;
+  double maximumDeviation = 0.0;
+  return GetFieldDataValue(proxyMesh, ALGORITHM_VERSION_ARRAY_NAME, version) && version == ALGORITHM_VERSION
+    && GetFieldDataValue(proxyMesh, TARGET_REDUCTION_ARRAY_NAME, targetReduction) && targetReduction == this->TargetReduction
+    && GetFieldDataValue(proxyMesh, MINIMUM_NUMBER_OF_TRIANGLES_ARRAY_NAME, minimumNumberOfTriangles)
+    && minimumNumberOfTriangles == this->MinimumNumberOfTriangles
+    && GetFieldDataValue(proxyMesh, MAXIMUM_DEVIATION_ARRAY_NAME, maximumDeviation);
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionProxyMeshFilter::RequestData(vtkInformation* vtkNotUsed(request), vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector);
+  this->MaximumDeviation = 0.0;
+  if (!input || !output)
+  {
+    vtkErrorMacro("RequestData: Invalid input or output poly data");
+    return 0;
+  }
+
+  // Only triangles are used in collision detection
+  vtkSmartPointer<vtkTriangleFilter> triangleFilter = vtkSmartPointer<vtkTriangleFilter>::New();
+  triangleFilter->SetInputData(input);
+  triangleFilter->PassVertsOff();
+  triangleFilter->PassLinesOff();
+  vtkSmartPointer<vtkCleanPolyData> cleaner = vtkSmartPointer<vtkCleanPolyData>::New();
+  cleaner->SetInputConnection(triangleFilter->GetOutputPort());
+  cleaner->Update();
+  vtkPolyData* triangles = cleaner->GetOutput();
+
+  // Small meshes are checked directly, so no proxy is created for them
+  if (triangles->GetNumberOfCells() == 0 || triangles->GetNumberOfCells() < this->MinimumNumberOfTriangles || this->TargetReduction <= 0.0)
+  {
+    output->Initialize();
+    return 1;
+  }
+
+  vtkSmartPointer<vtkQuadricDecimation> decimation = vtkSmartPointer<vtkQuadricDecimation>::New();
+  decimation->SetInputData(triangles);
+  decimation->SetTargetReduction(this->TargetReduction);
+  decimation->Update();
+  vtkPolyData* proxyMesh = decimation->GetOutput();
+  if (proxyMesh->GetNumberOfCells() == 0)
+  {
+    vtkWarningMacro("RequestData: Decimation failed, no proxy mesh is created");
+    output->Initialize();
+    return 1;
+  }
+
+  // Bound the distance of the input surface from the proxy surface. Every point of an input triangle is within
+  // the distance of the triangle center from the proxy plus the distance of the farthest vertex from the center.
+  vtkSmartPointer<vtkCellLocator> locator = vtkSmartPointer<vtkCellLocator>::New();
+  locator->SetDataSet(proxyMesh);
+  locator->BuildLocator();
+  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
+  double closestPoint[3] = { 0.0, 0.0, 0.0 };
+  vtkIdType cellId = -1;
+  int subId = 0;
+  double distance2 = 0.0;
+  vtkPoints* points = triangles->GetPoints();
+  vtkCellArray* polys = triangles->GetPolys();
+  vtkIdType numberOfCellPoints = 0;
+  vtkIdType* cellPointIds = NULL;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds); )
+  {
+    if (numberOfCellPoints != 3)
+    {
+      continue;
+    }
+    double trianglePoints[3][3];
+    double center[3] = { 0.0, 0.0, 0.0 };
+    for (int i = 0; i < 3; ++i)
+    {
+      points->GetPoint(cellPointIds[i], trianglePoints[i]);
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        center[axis] += trianglePoints[i][axis] / 3.0;
+      }
+    }
+    double maximumVertexDistance2 = 0.0;
+    for (int i = 0; i < 3; ++i)
+    {
+      maximumVertexDistance2 = std::max(maximumVertexDistance2, vtkMath::Distance2BetweenPoints(trianglePoints[i], center));
+    }
+    locator->FindClosestPoint(center, closestPoint, cell, cellId, subId, distance2);
+    this->MaximumDeviation = std::max(this->MaximumDeviation, sqrt(distance2) + sqrt(maximumVertexDistance2));
+  }
+
+  // Attributes of the input are not needed for collision detection
+  output->ShallowCopy(proxyMesh);
+  output->GetPointData()->Initialize();
+  output->GetCellData()->Initialize();
+  vtkSmartPointer<vtkFieldData> fieldData = vtkSmartPointer<vtkFieldData>::New();
+  output->SetFieldData(fieldData);
+  SetFieldDataValue(output, MAXIMUM_DEVIATION_ARRAY_NAME, this->MaximumDeviation);
+  SetFieldDataValue(output, TARGET_REDUCTION_ARRAY_NAME, this->TargetReduction);
+  SetFieldDataValue(output, MINIMUM_NUMBER_OF_TRIANGLES_ARRAY_NAME, this->MinimumNumberOfTriangles);
+  SetFieldDataValue(output, ALGORITHM_VERSION_ARRAY_NAME, ALGORITHM_VERSION);
+  return 1;
+}
@@ -0,0 +1,96 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+
+#ifndef __vtkCollisionProxyMeshFilter_h
+#define __vtkCollisionProxyMeshFilter_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Create simplified proxy mesh of a triangle mesh for the broad phase of collision detection
+///
+/// The input is triangulated and decimated. If the input is not decimated (for example because it has fewer triangles
+/// than \sa MinimumNumberOfTriangles), the output is empty, as a proxy that is not simpler than the input would only
+/// add a check before the check of the full mesh. An upper bound of the distance of the input surface from the output
+/// surface is computed from the distance of each input triangle center from the output and the size of the
+/// triangle. It is stored in the output field data (\sa MAXIMUM_DEVIATION_ARRAY_NAME) together with the version of
+/// the algorithm and the decimation parameters, so that they are kept when the proxy mesh is written to file, and
+/// a cached proxy mesh can be checked before use \sa IsProxyMeshUpToDate.
+/// The proxy mesh is conservatively inflated by this deviation plus a safety margin in \sa vtkCollisionScene:
+/// if the proxies of two parts are farther from each other than the sum of their inflations, the full
+/// meshes cannot collide.
+class VTK_SLICERRTCOMMON_EXPORT vtkCollisionProxyMeshFilter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkCollisionProxyMeshFilter* New();
+  vtkTypeMacro(vtkCollisionProxyMeshFilter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Name of the output field data array containing the bound of the distance of the input surface from the output
+  static const char* MAXIMUM_DEVIATION_ARRAY_NAME;
+  /// Name of the output field data array containing the target reduction the output was created with
+  static const char* TARGET_REDUCTION_ARRAY_NAME;
+  /// Name of the output field data array containing the minimum number of triangles the output was created with
+  static const char* MINIMUM_NUMBER_OF_TRIANGLES_ARRAY_NAME;
+  /// Name of the output field data array containing the version of the algorithm the output was created with
+  static const char* ALGORITHM_VERSION_ARRAY_NAME;
+  /// Version of the algorithm. It must be increased when the output of the filter changes for the same input
+  /// and parameters, so that proxy meshes cached in files are created again.
+  static const int ALGORITHM_VERSION;
+
+  /// Desired reduction in the number of triangles (between 0 and 1). Default is 0.9
+  vtkSetClampMacro(TargetReduction, double, 0.0, 1.0);
+  vtkGetMacro(TargetReduction, double);
+
+  /// Input meshes with fewer triangles than this are not decimated, and the output is empty. Default is 1000
+  vtkSetMacro(MinimumNumberOfTriangles, int);
+  vtkGetMacro(MinimumNumberOfTriangles, int);
+
+  /// Get the upper bound of the distance of the input surface from the output surface computed in the last update
+  vtkGetMacro(MaximumDeviation, double);
+
+  /// Get the maximum deviation stored in the field data of a proxy mesh
+  /// \return False if the mesh was not created by this filter
+  static bool GetMaximumDeviation(vtkPolyData* proxyMesh, double& maximumDeviation);
+  /// Get the target reduction stored in the field data of a proxy mesh
+  /// \return False if the mesh was not created by this filter
+  static bool GetTargetReduction(vtkPolyData* proxyMesh, double& targetReduction);
+
+  /// Determine if a proxy mesh, for example one read from file, was created by the current version of this filter
+  /// with the current parameters, so that it can be used instead of updating the filter
+  bool IsProxyMeshUpToDate(vtkPolyData* proxyMesh);
+
+protected:
+  vtkCollisionProxyMeshFilter();
+  ~vtkCollisionProxyMeshFilter();
+
+  int RequestData(vtkInformation* request, vtkInformationVector** inputVector, vtkInformationVector* outputVector) VTK_OVERRIDE;
+
+protected:
+  double TargetReduction;
+  int MinimumNumberOfTriangles;
+  double MaximumDeviation;
+
+private:
+  vtkCollisionProxyMeshFilter(const vtkCollisionProxyMeshFilter&); // Not implemented
+  void operator=(const vtkCollisionProxyMeshFilter&);              // Not implemented
+};
+
+#endif
@@ -0,0 +1,1298 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkCollisionScene.h"
+
+// SlicerRT includes
+#include "SlicerRtCommon.h"
+#include "vtkCollisionDetectionFilter.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkLine.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkOBBTree.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <algorithm>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkCollisionScene);
+
+//----------------------------------------------------------------------------
+namespace
+{
+  //----------------------------------------------------------------------------
+  /// OBB tree giving access to its root node, so that it can be traversed with a tolerance that is specific to
+  /// the query instead of the tolerance stored in the tree
+  class vtkCollisionSceneOBBTree : public vtkOBBTree
+  {
+  public:
+    static vtkCollisionSceneOBBTree* New();
+    vtkTypeMacro(vtkCollisionSceneOBBTree, vtkOBBTree);
+    vtkOBBNode* GetRoot() { return this->Tree; }
+  };
+  vtkStandardNewMacro(vtkCollisionSceneOBBTree);
+
+  //----------------------------------------------------------------------------
+  /// Part of the collision scene
+  struct CollisionPart
+  {
+    std::string Name;
+    vtkSmartPointer<vtkPolyData> Mesh;
+    vtkSmartPointer<vtkCollisionSceneOBBTree> Tree;
+    vtkTimeStamp TreeBuildTime;
+    vtkSmartPointer<vtkMatrix4x4> PartToWorldMatrix;
+    /// Simplified mesh used in the broad phase, the full mesh is within the inflation distance of it
+    vtkSmartPointer<vtkPolyData> ProxyMesh;
+    double ProxyInflation;
+    vtkSmartPointer<vtkCollisionSceneOBBTree> ProxyTree;
+    vtkTimeStamp ProxyTreeBuildTime;
+    /// Sphere containing the mesh and the proxy mesh in the part coordinate system, updated with the trees
+    double BoundingSphereCenter[3];
+    double BoundingSphereRadius;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Pair of parts checked for collision
+  struct CollisionPartPair
+  {
+    int PartIndex1;
+    int PartIndex2;
+    /// Number of contacting triangle pairs found in the last check
+    vtkIdType NumberOfContacts;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Data passed to the OBB tree intersection callback of a part pair
+  struct PartPairQuery
+  {
+    vtkPolyData* Mesh1;
+    vtkPolyData* Mesh2;
+    double CellTolerance;
+    bool FirstContactOnly;
+    vtkIdType NumberOfContacts;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Get the points and bounds of a triangle. Only the point coordinates and the already built cell links are
+  /// read, so unlike vtkPolyData::GetCell it can be called concurrently.
+  /// \return False if the cell is not a triangle
+  bool GetTriangle(vtkPolyData* mesh, vtkIdType cellId, const double* transformElements, double points[9], double bounds[6])
+  {
+    vtkIdType numberOfPoints = 0;
+    vtkIdType* pointIds = NULL;
+    mesh->GetCellPoints(cellId, numberOfPoints, pointIds);
+    if (numberOfPoints != 3)
+    {
+      return false;
+    }
+
+    bounds[0] = bounds[2] = bounds[4] = VTK_DOUBLE_MAX;
+    bounds[1] = bounds[3] = bounds[5] = VTK_DOUBLE_MIN;
+    for (int pointIndex = 0; pointIndex < 3; ++pointIndex)
+    {
+      double point[4] = { 0.0, 0.0, 0.0, 1.0 };
+      mesh->GetPoints()->GetPoint(pointIds[pointIndex], point);
+      if (transformElements)
+      {
+        double transformedPoint[4] = { 0.0, 0.0, 0.0, 1.0 };
+        vtkMatrix4x4::MultiplyPoint(transformElements, point, transformedPoint);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          point[axis] = transformedPoint[axis] / transformedPoint[3];
+        }
+      }
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        points[pointIndex*3 + axis] = point[axis];
+        bounds[axis*2] = std::min(bounds[axis*2], point[axis]);
+        bounds[axis*2+1] = std::max(bounds[axis*2+1], point[axis]);
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Intersect the triangles of two overlapping OBB tree leaves.
+  /// Called by vtkOBBTree::IntersectWithOBBTree, a negative return value stops the traversal.
+  int IntersectPartPairNodes(vtkOBBNode* node1, vtkOBBNode* node2, vtkMatrix4x4* part2ToPart1Matrix, void* clientData)
+  {
+    PartPairQuery* query = static_cast<PartPairQuery*>(clientData);
+    int collisionMode = (query->FirstContactOnly ? vtkCollisionDetectionFilter::VTK_FIRST_CONTACT : vtkCollisionDetectionFilter::VTK_HALF_CONTACTS);
+    double points1[9], points2[9];
+    double bounds1[6], bounds2[6];
+    double contactPoint1[3], contactPoint2[3];
+
+    vtkIdType numberOfCells1 = node1->Cells->GetNumberOfIds();
+    vtkIdType numberOfCells2 = node2->Cells->GetNumberOfIds();
+    for (vtkIdType cellIndex1 = 0; cellIndex1 < numberOfCells1; ++cellIndex1)
+    {
+      if (!GetTriangle(query->Mesh1, node1->Cells->GetId(cellIndex1), NULL, points1, bounds1))
+      {
+        continue;
+      }
+      for (vtkIdType cellIndex2 = 0; cellIndex2 < numberOfCells2; ++cellIndex2)
+      {
+        if (!GetTriangle(query->Mesh2, node2->Cells->GetId(cellIndex2), &part2ToPart1Matrix->Element[0][0], points2, bounds2))
+        {
+          continue;
+        }
+        if ( vtkCollisionDetectionFilter::IntersectPolygonWithPolygon(3, points1, bounds1, 3, points2, bounds2,
+          query->CellTolerance, contactPoint1, contactPoint2, collisionMode) )
+        {
+          query->NumberOfContacts++;
+          if (query->FirstContactOnly)
+          {
+            return -1;
+          }
+        }
+      }
+    }
+    return 1;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine if two OBB tree nodes are farther from each other than the tolerance (separating axis test).
+  /// Unlike vtkOBBTree::DisjointOBBNodes, the tolerance is a parameter, so the same trees can be
+  /// queried with different tolerances concurrently.
+  bool AreOBBNodesSeparated(vtkOBBNode* nodeA, vtkOBBNode* nodeB, const double bToAElements[16], double tolerance)
+  {
+    // Transform box B to the coordinate system of A
+    double cornerB[3] = { 0.0, 0.0, 0.0 };
+    double axesB[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+      const double* m = bToAElements + row*4;
+      cornerB[row] = m[0]*nodeB->Corner[0] + m[1]*nodeB->Corner[1] + m[2]*nodeB->Corner[2] + m[3];
+      for (int i = 0; i < 3; ++i)
+      {
+        axesB[i][row] = m[0]*nodeB->Axes[i][0] + m[1]*nodeB->Axes[i][1] + m[2]*nodeB->Axes[i][2];
+      }
+    }
+
+    // Candidate separating axes: face normals of both boxes and cross products of their edges
+    double testAxes[15][3];
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        testAxes[i][axis] = nodeA->Axes[i][axis];
+        testAxes[3+i][axis] = axesB[i][axis];
+      }
+      for (int j = 0; j < 3; ++j)
+      {
+        vtkMath::Cross(nodeA->Axes[i], axesB[j], testAxes[6 + i*3 + j]);
+      }
+    }
+
+    for (int testAxisIndex = 0; testAxisIndex < 15; ++testAxisIndex)
+    {
+      const double* testAxis = testAxes[testAxisIndex];
+      double testAxisLength = vtkMath::Norm(testAxis);
+      if (testAxisLength < 1e-12)
+      {
+        // Parallel edges, the axis is covered by the face normals
+        continue;
+      }
+      double minimumA = vtkMath::Dot(nodeA->Corner, testAxis);
+      double maximumA = minimumA;
+      double minimumB = vtkMath::Dot(cornerB, testAxis);
+      double maximumB = minimumB;
+      for (int i = 0; i < 3; ++i)
+      {
+        double projectionA = vtkMath::Dot(nodeA->Axes[i], testAxis);
+        (projectionA < 0.0 ? minimumA : maximumA) += projectionA;
+        double projectionB = vtkMath::Dot(axesB[i], testAxis);
+        (projectionB < 0.0 ? minimumB : maximumB) += projectionB;
+      }
+      double scaledTolerance = tolerance * testAxisLength;
+      if (maximumA + scaledTolerance < minimumB || maximumB + scaledTolerance < minimumA)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get squared distance of a point from a triangle if its projection is inside the triangle
+  /// \return False if the projection of the point is outside the triangle
+  bool GetPointToTriangleInteriorDistance2(const double point[3], const double triangle[9], double& distance2)
+  {
+    double edge1[3] = { triangle[3] - triangle[0], triangle[4] - triangle[1], triangle[5] - triangle[2] };
+    double edge2[3] = { triangle[6] - triangle[0], triangle[7] - triangle[1], triangle[8] - triangle[2] };
+    double normal[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross(edge1, edge2, normal);
+    double normalLength2 = vtkMath::Dot(normal, normal);
+    if (normalLength2 < 1e-24)
+    {
+      // Degenerate triangle, its edges give the distance
+      return false;
+    }
+    double fromVertex[3] = { point[0] - triangle[0], point[1] - triangle[1], point[2] - triangle[2] };
+    double cross[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross(fromVertex, edge2, cross);
+    double barycentric1 = vtkMath::Dot(cross, normal) / normalLength2;
+    vtkMath::Cross(edge1, fromVertex, cross);
+    double barycentric2 = vtkMath::Dot(cross, normal) / normalLength2;
+    if (barycentric1 < 0.0 || barycentric2 < 0.0 || barycentric1 + barycentric2 > 1.0)
+    {
+      return false;
+    }
+    double distanceAlongNormal = vtkMath::Dot(fromVertex, normal);
+    distance2 = distanceAlongNormal * distanceAlongNormal / normalLength2;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine if two triangles that do not intersect are within the given distance of each other. The closest
+  /// points of disjoint triangles are either on two edges or on a vertex and the interior of the other triangle.
+  bool AreTrianglesWithinDistance(double triangle1[9], double triangle2[9], double distance)
+  {
+    double distance2 = distance * distance;
+    for (int i = 0; i < 3; ++i)
+    {
+      double pointDistance2 = 0.0;
+      if ( (GetPointToTriangleInteriorDistance2(triangle1 + i*3, triangle2, pointDistance2) && pointDistance2 <= distance2)
+        || (GetPointToTriangleInteriorDistance2(triangle2 + i*3, triangle1, pointDistance2) && pointDistance2 <= distance2) )
+      {
+        return true;
+      }
+    }
+    double closestPoint1[3], closestPoint2[3];
+    double parametricCoordinate1 = 0.0, parametricCoordinate2 = 0.0;
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        if ( vtkLine::DistanceBetweenLineSegments(triangle1 + i*3, triangle1 + ((i+1)%3)*3, triangle2 + j*3, triangle2 + ((j+1)%3)*3,
+          closestPoint1, closestPoint2, parametricCoordinate1, parametricCoordinate2) <= distance2 )
+        {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine if two meshes in the given relative pose have any triangles closer to each other than the distance.
+  /// The OBB trees are traversed with the distance as tolerance, so only the triangles of nearby leaves are tested.
+  bool AreMeshesWithinDistance(vtkPolyData* mesh1, vtkCollisionSceneOBBTree* tree1, vtkPolyData* mesh2, vtkCollisionSceneOBBTree* tree2,
+    const double mesh2ToMesh1Elements[16], double distance)
+  {
+    std::vector< std::pair<vtkOBBNode*, vtkOBBNode*> > nodePairs;
+    nodePairs.push_back(std::make_pair(tree1->GetRoot(), tree2->GetRoot()));
+    double points1[9], points2[9];
+    double bounds1[6], bounds2[6];
+    double contactPoint1[3], contactPoint2[3];
+    while (!nodePairs.empty())
+    {
+      vtkOBBNode* node1 = nodePairs.back().first;
+      vtkOBBNode* node2 = nodePairs.back().second;
+      nodePairs.pop_back();
+      if (!node1 || !node2 || AreOBBNodesSeparated(node1, node2, mesh2ToMesh1Elements, distance))
+      {
+        continue;
+      }
+
+      // Descend into the larger node, as long as it is not a leaf
+      bool isLeaf1 = (node1->Kids == NULL);
+      bool isLeaf2 = (node2->Kids == NULL);
+      if (!isLeaf1 || !isLeaf2)
+      {
+        bool descendInto1 = isLeaf2 || ( !isLeaf1 && vtkMath::Dot(node1->Axes[0], node1->Axes[0]) >= vtkMath::Dot(node2->Axes[0], node2->Axes[0]) );
+        for (int kid = 0; kid < 2; ++kid)
+        {
+          nodePairs.push_back(descendInto1 ? std::make_pair(node1->Kids[kid], node2) : std::make_pair(node1, node2->Kids[kid]));
+        }
+        continue;
+      }
+
+      // Test the triangles of the two leaves
+      for (vtkIdType cellIndex1 = 0; cellIndex1 < node1->Cells->GetNumberOfIds(); ++cellIndex1)
+      {
+        if (!GetTriangle(mesh1, node1->Cells->GetId(cellIndex1), NULL, points1, bounds1))
+        {
+          continue;
+        }
+        for (vtkIdType cellIndex2 = 0; cellIndex2 < node2->Cells->GetNumberOfIds(); ++cellIndex2)
+        {
+          if (!GetTriangle(mesh2, node2->Cells->GetId(cellIndex2), mesh2ToMesh1Elements, points2, bounds2))
+          {
+            continue;
+          }
+          if ( bounds1[0] > bounds2[1] + distance || bounds2[0] > bounds1[1] + distance
+            || bounds1[2] > bounds2[3] + distance || bounds2[2] > bounds1[3] + distance
+            || bounds1[4] > bounds2[5] + distance || bounds2[4] > bounds1[5] + distance )
+          {
+            continue;
+          }
+          if ( vtkCollisionDetectionFilter::IntersectPolygonWithPolygon(3, points1, bounds1, 3, points2, bounds2,
+              0.0, contactPoint1, contactPoint2, vtkCollisionDetectionFilter::VTK_FIRST_CONTACT)
+            || (distance > 0.0 && AreTrianglesWithinDistance(points1, points2, distance)) )
+          {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine if the proxy meshes of two parts prove that the parts are farther from each other than the distance.
+  /// The proxy mesh of a part is used if available, the full mesh otherwise. As the full mesh of a part is within the
+  /// inflation distance of its proxy mesh, the full meshes cannot be within the distance if the proxies are not
+  /// within the distance plus the inflations.
+  /// \return False if neither part has a proxy mesh or the proxies are close, so the full meshes need to be checked
+  bool ArePartsSeparatedByProxies(CollisionPart& part1, CollisionPart& part2, const double part2ToPart1Elements[16], double distance)
+  {
+    if (!part1.ProxyTree && !part2.ProxyTree)
+    {
+      return false;
+    }
+    return !AreMeshesWithinDistance(
+      part1.ProxyTree ? part1.ProxyMesh : part1.Mesh, part1.ProxyTree ? part1.ProxyTree : part1.Tree,
+      part2.ProxyTree ? part2.ProxyMesh : part2.Mesh, part2.ProxyTree ? part2.ProxyTree : part2.Tree,
+      part2ToPart1Elements, distance + (part1.ProxyTree ? part1.ProxyInflation : 0.0) + (part2.ProxyTree ? part2.ProxyInflation : 0.0) );
+  }
+
+  //----------------------------------------------------------------------------
+  /// Determine if two parts in the given relative pose have any triangles closer to each other than the distance.
+  /// The proxy meshes are checked first, the full meshes are only checked if the proxies are close to each other.
+  bool ArePartsWithinDistance(CollisionPart& part1, CollisionPart& part2, const double part2ToPart1Elements[16], double distance)
+  {
+    if (ArePartsSeparatedByProxies(part1, part2, part2ToPart1Elements, distance))
+    {
+      return false;
+    }
+    return AreMeshesWithinDistance(part1.Mesh, part1.Tree, part2.Mesh, part2.Tree, part2ToPart1Elements, distance);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check a range of part pairs in a range of poses for collision. A work item is one part pair in one pose,
+  /// the OBB trees are only read, so the work items can be checked concurrently.
+  class CheckPartPairsFunctor
+  {
+  public:
+    CheckPartPairsFunctor(std::vector<CollisionPart>& parts, std::vector<CollisionPartPair>& partPairs,
+      const double* partToWorldElements, double cellTolerance, bool firstContactOnly, vtkIdType* numberOfContacts)
+      : Parts(parts)
+      , PartPairs(partPairs)
+      , PartToWorldElements(partToWorldElements)
+      , CellTolerance(cellTolerance)
+      , CellDistance(sqrt(std::max(cellTolerance, 0.0)))
+      , FirstContactOnly(firstContactOnly)
+      , NumberOfContacts(numberOfContacts)
+    {
+    }
+
+    void operator()(vtkIdType beginItem, vtkIdType endItem)
+    {
+      vtkIdType numberOfParts = static_cast<vtkIdType>(this->Parts.size());
+      vtkIdType numberOfPairs = static_cast<vtkIdType>(this->PartPairs.size());
+      vtkMatrix4x4* part2ToPart1Matrix = this->Part2ToPart1Matrix.Local();
+      double worldToPart1Elements[16];
+      double part2ToPart1Elements[16];
+      for (vtkIdType itemIndex = beginItem; itemIndex < endItem; ++itemIndex)
+      {
+        this->NumberOfContacts[itemIndex] = 0;
+        vtkIdType poseIndex = itemIndex / numberOfPairs;
+        CollisionPartPair& pair = this->PartPairs[itemIndex % numberOfPairs];
+        CollisionPart& part1 = this->Parts[pair.PartIndex1];
+        CollisionPart& part2 = this->Parts[pair.PartIndex2];
+        if (!part1.Tree || !part2.Tree)
+        {
+          continue;
+        }
+
+        const double* poseElements = this->PartToWorldElements + poseIndex * numberOfParts * 16;
+        vtkMatrix4x4::Invert(poseElements + pair.PartIndex1 * 16, worldToPart1Elements);
+        vtkMatrix4x4::Multiply4x4(worldToPart1Elements, poseElements + pair.PartIndex2 * 16, part2ToPart1Elements);
+
+        // Broad phase: the full meshes are only checked if the proxy meshes are close to each other
+        if (ArePartsSeparatedByProxies(part1, part2, part2ToPart1Elements, this->CellDistance))
+        {
+          continue;
+        }
+
+        part2ToPart1Matrix->DeepCopy(part2ToPart1Elements);
+        PartPairQuery query;
+        query.Mesh1 = part1.Mesh;
+        query.Mesh2 = part2.Mesh;
+        query.CellTolerance = this->CellTolerance;
+        query.FirstContactOnly = this->FirstContactOnly;
+        query.NumberOfContacts = 0;
+        part1.Tree->IntersectWithOBBTree(part2.Tree, part2ToPart1Matrix, IntersectPartPairNodes, &query);
+        this->NumberOfContacts[itemIndex] = query.NumberOfContacts;
+      }
+    }
+
+  private:
+    std::vector<CollisionPart>& Parts;
+    std::vector<CollisionPartPair>& PartPairs;
+    const double* PartToWorldElements;
+    double CellTolerance;
+    /// Distance of triangles considered in contact, corresponding to the squared cell tolerance
+    double CellDistance;
+    bool FirstContactOnly;
+    vtkIdType* NumberOfContacts;
+    vtkSMPThreadLocalObject<vtkMatrix4x4> Part2ToPart1Matrix;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Rigid motion between two poses, described as a rotation around a fixed axis and a translation along it (screw motion).
+  /// Rotation of a treatment machine part around its IEC rotation axis is represented exactly.
+  struct ScrewMotion
+  {
+    /// Unit direction of the screw axis
+    double Axis[3];
+    /// A point of the screw axis
+    double AxisPoint[3];
+    /// Rotation angle around the axis (radians, between 0 and pi)
+    double Angle;
+    /// Translation along the axis
+    double AxialTranslation;
+  };
+
+  //----------------------------------------------------------------------------
+  /// Compute rotation matrix from axis and angle (Rodrigues formula)
+  void GetRotationMatrix(const double axis[3], double angle, double rotation[3][3])
+  {
+    double c = cos(angle);
+    double s = sin(angle);
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int col = 0; col < 3; ++col)
+      {
+        rotation[row][col] = (1.0 - c) * axis[row] * axis[col] + (row == col ? c : 0.0);
+      }
+    }
+    rotation[0][1] -= s * axis[2];
+    rotation[0][2] += s * axis[1];
+    rotation[1][0] += s * axis[2];
+    rotation[1][2] -= s * axis[0];
+    rotation[2][0] -= s * axis[1];
+    rotation[2][1] += s * axis[0];
+  }
+
+  //----------------------------------------------------------------------------
+  /// Compute the screw motion that moves a part from the start to the end pose.
+  /// The shorter rotation is taken, so the poses must be less than 180 degrees apart.
+  void ComputeScrewMotion(const double startElements[16], const double endElements[16], ScrewMotion& motion)
+  {
+    // Motion in world coordinates: end * start^-1
+    double inverseStartElements[16];
+    double motionElements[16];
+    vtkMatrix4x4::Invert(startElements, inverseStartElements);
+    vtkMatrix4x4::Multiply4x4(endElements, inverseStartElements, motionElements);
+    double rotation[3][3];
+    double translation[3];
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int col = 0; col < 3; ++col)
+      {
+        rotation[row][col] = motionElements[row*4 + col];
+      }
+      translation[row] = motionElements[row*4 + 3];
+    }
+
+    // Rotation axis and angle
+    double sinAxis[3] = { (rotation[2][1] - rotation[1][2]) / 2.0, (rotation[0][2] - rotation[2][0]) / 2.0, (rotation[1][0] - rotation[0][1]) / 2.0 };
+    double cosAngle = std::max(-1.0, std::min(1.0, (rotation[0][0] + rotation[1][1] + rotation[2][2] - 1.0) / 2.0));
+    double sinAngle = vtkMath::Norm(sinAxis);
+    motion.Angle = atan2(sinAngle, cosAngle);
+    const double angleTolerance = 1e-9;
+    if (motion.Angle < angleTolerance)
+    {
+      // Pure translation
+      motion.Angle = 0.0;
+      motion.AxialTranslation = vtkMath::Norm(translation);
+      motion.AxisPoint[0] = motion.AxisPoint[1] = motion.AxisPoint[2] = 0.0;
+      motion.Axis[0] = 1.0;
+      motion.Axis[1] = motion.Axis[2] = 0.0;
+      if (motion.AxialTranslation > 0.0)
+      {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          motion.Axis[axis] = translation[axis] / motion.AxialTranslation;
+        }
+      }
+      return;
+    }
+    if (sinAngle > 1e-6)
+    {
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        motion.Axis[axis] = sinAxis[axis] / sinAngle;
+      }
+    }
+    else
+    {
+      // Rotation by (almost) 180 degrees: the axis is the largest column of (R + I), the direction does not matter
+      int bestColumn = 0;
+      double bestNorm = -1.0;
+      for (int col = 0; col < 3; ++col)
+      {
+        double column[3] = { rotation[0][col] + (col == 0 ? 1.0 : 0.0), rotation[1][col] + (col == 1 ? 1.0 : 0.0), rotation[2][col] + (col == 2 ? 1.0 : 0.0) };
+        double norm = vtkMath::Norm(column);
+        if (norm > bestNorm)
+        {
+          bestNorm = norm;
+          bestColumn = col;
+        }
+      }
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        motion.Axis[axis] = (rotation[axis][bestColumn] + (axis == bestColumn ? 1.0 : 0.0)) / bestNorm;
+      }
+    }
+
+    // Split translation to components along and perpendicular to the axis. The perpendicular component
+    // is caused by the rotation around an axis not going through the origin: t = (I - R) c
+    motion.AxialTranslation = vtkMath::Dot(translation, motion.Axis);
+    double perpendicularTranslation[3] = { 0.0, 0.0, 0.0 };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      perpendicularTranslation[axis] = translation[axis] - motion.AxialTranslation * motion.Axis[axis];
+    }
+    double axisCrossTranslation[3] = { 0.0, 0.0, 0.0 };
+    vtkMath::Cross(motion.Axis, perpendicularTranslation, axisCrossTranslation);
+    double cotHalfAngle = 1.0 / tan(motion.Angle / 2.0);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      motion.AxisPoint[axis] = (perpendicularTranslation[axis] + cotHalfAngle * axisCrossTranslation[axis]) / 2.0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get the pose of a part at a given fraction of its screw motion from the start pose
+  void InterpolateScrewMotion(const double startElements[16], const ScrewMotion& motion, double fraction, double elements[16])
+  {
+    double rotation[3][3];
+    GetRotationMatrix(motion.Axis, motion.Angle * fraction, rotation);
+    double motionElements[16] = { 0.0 };
+    for (int row = 0; row < 3; ++row)
+    {
+      double rotatedAxisPoint = 0.0;
+      for (int col = 0; col < 3; ++col)
+      {
+        motionElements[row*4 + col] = rotation[row][col];
+        rotatedAxisPoint += rotation[row][col] * motion.AxisPoint[col];
+      }
+      motionElements[row*4 + 3] = motion.AxisPoint[row] - rotatedAxisPoint + fraction * motion.AxialTranslation * motion.Axis[row];
+    }
+    motionElements[15] = 1.0;
+    vtkMatrix4x4::Multiply4x4(motionElements, startElements, elements);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Get the maximum displacement of the points inside a sphere during the whole screw motion
+  double GetScrewMotionDisplacementBound(const ScrewMotion& motion, const double sphereCenter[3], double sphereRadius)
+  {
+    double centerFromAxisPoint[3] = { sphereCenter[0] - motion.AxisPoint[0], sphereCenter[1] - motion.AxisPoint[1], sphereCenter[2] - motion.AxisPoint[2] };
+    double alongAxis = vtkMath::Dot(centerFromAxisPoint, motion.Axis);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      centerFromAxisPoint[axis] -= alongAxis * motion.Axis[axis];
+    }
+    // The arc length is an upper bound of the chord length
+    return motion.Angle * (vtkMath::Norm(centerFromAxisPoint) + sphereRadius) + fabs(motion.AxialTranslation);
+  }
+
+  //----------------------------------------------------------------------------
+  /// Check a range of part pairs in a range of motions for collision. A work item is one part pair in one motion.
+  /// The motion of each part is interpolated between the start and end poses, and the motion interval is bisected
+  /// until the parts are either farther apart than the largest displacement within the interval, or the largest
+  /// displacement is below the tolerance.
+  class CheckPartPairMotionsFunctor
+  {
+  public:
+    CheckPartPairMotionsFunctor(std::vector<CollisionPart>& parts, std::vector<CollisionPartPair>& partPairs,
+      const double* startPartToWorldElements, const double* endPartToWorldElements, double sweepTolerance, unsigned char* pairCollisions)
+      : Parts(parts)
+      , PartPairs(partPairs)
+      , StartPartToWorldElements(startPartToWorldElements)
+      , EndPartToWorldElements(endPartToWorldElements)
+      , SweepTolerance(sweepTolerance)
+      , PairCollisions(pairCollisions)
+    {
+    }
+
+    void operator()(vtkIdType beginItem, vtkIdType endItem)
+    {
+      vtkIdType numberOfParts = static_cast<vtkIdType>(this->Parts.size());
+      vtkIdType numberOfPairs = static_cast<vtkIdType>(this->PartPairs.size());
+      for (vtkIdType itemIndex = beginItem; itemIndex < endItem; ++itemIndex)
+      {
+        this->PairCollisions[itemIndex] = 0;
+        vtkIdType motionIndex = itemIndex / numberOfPairs;
+        CollisionPartPair& pair = this->PartPairs[itemIndex % numberOfPairs];
+        CollisionPart& part1 = this->Parts[pair.PartIndex1];
+        CollisionPart& part2 = this->Parts[pair.PartIndex2];
+        if (!part1.Tree || !part2.Tree)
+        {
+          continue;
+        }
+
+        const double* start1 = this->StartPartToWorldElements + (motionIndex * numberOfParts + pair.PartIndex1) * 16;
+        const double* start2 = this->StartPartToWorldElements + (motionIndex * numberOfParts + pair.PartIndex2) * 16;
+        const double* end1 = this->EndPartToWorldElements + (motionIndex * numberOfParts + pair.PartIndex1) * 16;
+        const double* end2 = this->EndPartToWorldElements + (motionIndex * numberOfParts + pair.PartIndex2) * 16;
+        ScrewMotion motion1;
+        ScrewMotion motion2;
+        ComputeScrewMotion(start1, end1, motion1);
+        ComputeScrewMotion(start2, end2, motion2);
+        if (this->CheckMotion(part1, part2, start1, start2, motion1, motion2))
+        {
+          this->PairCollisions[itemIndex] = 1;
+        }
+      }
+    }
+
+  private:
+    /// \return True if the parts collide or get closer to each other than the sweep tolerance during the motion
+    bool CheckMotion(CollisionPart& part1, CollisionPart& part2, const double* start1, const double* start2,
+      const ScrewMotion& motion1, const ScrewMotion& motion2)
+    {
+      // Limit the number of bisections, reaching it is reported as collision to stay conservative
+      const int maximumDepth = 30;
+      std::vector< std::pair<double, int> > intervals; // Start of the interval and its bisection depth
+      intervals.push_back(std::make_pair(0.0, 0));
+      double part1ToWorldElements[16], part2ToWorldElements[16], worldToPart1Elements[16], part2ToPart1Elements[16];
+      while (!intervals.empty())
+      {
+        double intervalStart = intervals.back().first;
+        int depth = intervals.back().second;
+        intervals.pop_back();
+        double halfLength = 0.5 / (1 << depth);
+        double middle = intervalStart + halfLength;
+
+        // Relative pose in the middle of the interval
+        InterpolateScrewMotion(start1, motion1, middle, part1ToWorldElements);
+        InterpolateScrewMotion(start2, motion2, middle, part2ToWorldElements);
+        vtkMatrix4x4::Invert(part1ToWorldElements, worldToPart1Elements);
+        vtkMatrix4x4::Multiply4x4(worldToPart1Elements, part2ToWorldElements, part2ToPart1Elements);
+
+        // Bound the displacement of part 2 relative to part 1 within the interval. Points of part 2 move by their
+        // own motion, and the coordinate system of part 1 moves under them by the motion of part 1. As part 2 moves
+        // meanwhile, its bounding sphere is grown by its own displacement for the motion of part 1.
+        double sphereCenter[4] = { part2.BoundingSphereCenter[0], part2.BoundingSphereCenter[1], part2.BoundingSphereCenter[2], 1.0 };
+        double sphereCenterWorld[4] = { 0.0, 0.0, 0.0, 1.0 };
+        vtkMatrix4x4::MultiplyPoint(part2ToWorldElements, sphereCenter, sphereCenterWorld);
+        double displacement2 = halfLength * GetScrewMotionDisplacementBound(motion2, sphereCenterWorld, part2.BoundingSphereRadius);
+        double displacement = displacement2
+          + halfLength * GetScrewMotionDisplacementBound(motion1, sphereCenterWorld, part2.BoundingSphereRadius + displacement2);
+
+        // Swept bounds of the interval do not intersect, no collision in it
+        if (!ArePartsWithinDistance(part1, part2, part2ToPart1Elements, displacement))
+        {
+          continue;
+        }
+        if (displacement <= this->SweepTolerance || depth >= maximumDepth)
+        {
+          return true;
+        }
+        intervals.push_back(std::make_pair(middle, depth + 1));
+        intervals.push_back(std::make_pair(intervalStart, depth + 1));
+      }
+      return false;
+    }
+
+    std::vector<CollisionPart>& Parts;
+    std::vector<CollisionPartPair>& PartPairs;
+    const double* StartPartToWorldElements;
+    const double* EndPartToWorldElements;
+    double SweepTolerance;
+    unsigned char* PairCollisions;
+  };
+}
+
+//----------------------------------------------------------------------------
+class vtkCollisionScene::vtkInternal
+{
+public:
+  bool IsValidPartIndex(int partIndex)
+  {
+    return partIndex >= 0 && partIndex < static_cast<int>(this->Parts.size());
+  }
+
+  bool IsValidPartPairIndex(int pairIndex)
+  {
+    return pairIndex >= 0 && pairIndex < static_cast<int>(this->PartPairs.size());
+  }
+
+  /// Build the OBB tree of a mesh if it is not up to date
+  /// \return True if the tree was built
+  bool UpdateTree(vtkPolyData* mesh, vtkSmartPointer<vtkCollisionSceneOBBTree>& tree, vtkTimeStamp& treeBuildTime, int numberOfCellsPerNode)
+  {
+    if ( tree && tree->GetDataSet() == mesh && tree->GetNumberOfCellsPerNode() == numberOfCellsPerNode
+      && treeBuildTime.GetMTime() > mesh->GetMTime() )
+    {
+      // Tree is up to date
+      return false;
+    }
+
+    // The cells array of the mesh is built on the first cell access, so it is built here while it is still safe to
+    // do so, and the concurrent triangle tests only read it
+    if (mesh->NeedToBuildCells())
+    {
+      mesh->BuildCells();
+    }
+
+    if (!tree)
+    {
+      tree = vtkSmartPointer<vtkCollisionSceneOBBTree>::New();
+    }
+    tree->SetDataSet(mesh);
+    tree->AutomaticOn();
+    tree->SetNumberOfCellsPerNode(numberOfCellsPerNode);
+    // make sure the tree does not skip the build based on its own modification time
+    tree->FreeSearchStructure();
+    tree->BuildLocator();
+    treeBuildTime.Modified();
+    return true;
+  }
+
+  /// Determine if the part has a mesh with cells that can be checked for collision
+  bool IsPartCheckable(int partIndex)
+  {
+    vtkPolyData* mesh = this->Parts[partIndex].Mesh;
+    return mesh != NULL && mesh->GetNumberOfCells() > 0;
+  }
+
+  /// Check all part pairs in all poses for collision. The OBB trees must be up to date.
+  /// \param partToWorldElements Part to world matrix elements of all parts in all poses
+  /// \param numberOfContacts Output number of contacts for each part pair in each pose
+  void CheckPartPairs(const double* partToWorldElements, vtkIdType numberOfPoses, double boxTolerance, double cellTolerance,
+    bool firstContactOnly, int numberOfThreads, std::vector<vtkIdType>& numberOfContacts)
+  {
+    // Everything that modifies shared state happens here, the parallel part below only reads the trees and the meshes
+    for (std::vector<CollisionPart>::iterator partIt = this->Parts.begin(); partIt != this->Parts.end(); ++partIt)
+    {
+      if (partIt->Tree)
+      {
+        partIt->Tree->SetTolerance(boxTolerance);
+      }
+    }
+
+    // One part pair in one pose is one work item, as the cost of the pairs varies a lot
+    vtkIdType numberOfItems = numberOfPoses * static_cast<vtkIdType>(this->PartPairs.size());
+    numberOfContacts.assign(numberOfItems, 0);
+    if (numberOfItems == 0)
+    {
+      return;
+    }
+    CheckPartPairsFunctor functor(this->Parts, this->PartPairs, partToWorldElements, cellTolerance, firstContactOnly, &numberOfContacts[0]);
+    SlicerRtCommon::SmpFor(0, numberOfItems, 1, functor, numberOfThreads);
+  }
+
+  /// Check all part pairs in all motions for collision. The OBB trees must be up to date.
+  /// \param startPartToWorldElements Part to world matrix elements of all parts at the start of all motions
+  /// \param endPartToWorldElements Part to world matrix elements of all parts at the end of all motions
+  /// \param pairCollisions Output collision flag for each part pair in each motion
+  void CheckPartPairMotions(const double* startPartToWorldElements, const double* endPartToWorldElements, vtkIdType numberOfMotions,
+    double sweepTolerance, int numberOfThreads, unsigned char* pairCollisions)
+  {
+    // The OBB trees are traversed by our own code with per query tolerances, so they are only read here
+    vtkIdType numberOfItems = numberOfMotions * static_cast<vtkIdType>(this->PartPairs.size());
+    if (numberOfItems == 0)
+    {
+      return;
+    }
+    CheckPartPairMotionsFunctor functor(this->Parts, this->PartPairs, startPartToWorldElements, endPartToWorldElements, sweepTolerance, pairCollisions);
+    SlicerRtCommon::SmpFor(0, numberOfItems, 1, functor, numberOfThreads);
+  }
+
+  std::vector<CollisionPart> Parts;
+  std::vector<CollisionPartPair> PartPairs;
+};
+
+//----------------------------------------------------------------------------
+vtkCollisionScene::vtkCollisionScene()
+{
+  this->FirstContactOnly = true;
+  this->BoxTolerance = 0.0;
+  this->CellTolerance = 0.0;
+  this->NumberOfCellsPerNode = 2;
+  this->NumberOfThreads = 0;
+  this->SweepTolerance = 1.0;
+
+  this->LastBuildTime = 0.0;
+  this->LastQueryTime = 0.0;
+  this->NumberOfTreeBuilds = 0;
+
+  this->Internal = new vtkInternal();
+}
+
+//----------------------------------------------------------------------------
+vtkCollisionScene::~vtkCollisionScene()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "FirstContactOnly: " << (this->FirstContactOnly ? "true" : "false") << "\n";
+  os << indent << "BoxTolerance: " << this->BoxTolerance << "\n";
+  os << indent << "CellTolerance: " << this->CellTolerance << "\n";
+  os << indent << "NumberOfCellsPerNode: " << this->NumberOfCellsPerNode << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "SweepTolerance: " << this->SweepTolerance << "\n";
+  os << indent << "LastBuildTime: " << this->LastBuildTime << "\n";
+  os << indent << "LastQueryTime: " << this->LastQueryTime << "\n";
+  os << indent << "NumberOfTreeBuilds: " << this->NumberOfTreeBuilds << "\n";
+  os << indent << "Parts:\n";
+  for (std::vector<CollisionPart>::iterator partIt = this->Internal->Parts.begin(); partIt != this->Internal->Parts.end(); ++partIt)
+  {
+    os << indent.GetNextIndent() << partIt->Name << ": "
+      << (partIt->Mesh ? partIt->Mesh->GetNumberOfCells() : 0) << " cells";
+    if (partIt->ProxyMesh)
+    {
+      os << ", proxy: " << partIt->ProxyMesh->GetNumberOfCells() << " cells, inflation: " << partIt->ProxyInflation;
+    }
+    os << "\n";
+  }
+  os << indent << "PartPairs:\n";
+  for (std::vector<CollisionPartPair>::iterator pairIt = this->Internal->PartPairs.begin(); pairIt != this->Internal->PartPairs.end(); ++pairIt)
+  {
+    os << indent.GetNextIndent() << this->Internal->Parts[pairIt->PartIndex1].Name << " - "
+      << this->Internal->Parts[pairIt->PartIndex2].Name << ": " << pairIt->NumberOfContacts << " contacts\n";
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::AddPart(const char* name, vtkPolyData* mesh)
+{
+  CollisionPart part;
+  part.Name = (name ? name : "");
+  part.Mesh = mesh;
+  part.PartToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  part.ProxyInflation = 0.0;
+  part.BoundingSphereCenter[0] = part.BoundingSphereCenter[1] = part.BoundingSphereCenter[2] = 0.0;
+  part.BoundingSphereRadius = 0.0;
+  this->Internal->Parts.push_back(part);
+  this->Modified();
+  return static_cast<int>(this->Internal->Parts.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::RemoveAllParts()
+{
+  this->Internal->Parts.clear();
+  this->Internal->PartPairs.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::GetNumberOfParts()
+{
+  return static_cast<int>(this->Internal->Parts.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::GetPartIndex(const char* name)
+{
+  if (!name)
+  {
+    return -1;
+  }
+  for (int partIndex = 0; partIndex < static_cast<int>(this->Internal->Parts.size()); ++partIndex)
+  {
+    if (!this->Internal->Parts[partIndex].Name.compare(name))
+    {
+      return partIndex;
+    }
+  }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkCollisionScene::GetPartName(int partIndex)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("GetPartName: Invalid part index " << partIndex);
+    return NULL;
+  }
+  return this->Internal->Parts[partIndex].Name.c_str();
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::SetPartMesh(int partIndex, vtkPolyData* mesh)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("SetPartMesh: Invalid part index " << partIndex);
+    return;
+  }
+  if (this->Internal->Parts[partIndex].Mesh == mesh)
+  {
+    return;
+  }
+  this->Internal->Parts[partIndex].Mesh = mesh;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkCollisionScene::GetPartMesh(int partIndex)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("GetPartMesh: Invalid part index " << partIndex);
+    return NULL;
+  }
+  return this->Internal->Parts[partIndex].Mesh;
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::SetPartProxyMesh(int partIndex, vtkPolyData* proxyMesh, double inflation)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("SetPartProxyMesh: Invalid part index " << partIndex);
+    return;
+  }
+  CollisionPart& part = this->Internal->Parts[partIndex];
+  if (part.ProxyMesh == proxyMesh && part.ProxyInflation == inflation)
+  {
+    return;
+  }
+  part.ProxyMesh = proxyMesh;
+  part.ProxyInflation = std::max(inflation, 0.0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkCollisionScene::GetPartProxyMesh(int partIndex)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("GetPartProxyMesh: Invalid part index " << partIndex);
+    return NULL;
+  }
+  return this->Internal->Parts[partIndex].ProxyMesh;
+}
+
+//----------------------------------------------------------------------------
+double vtkCollisionScene::GetPartProxyInflation(int partIndex)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("GetPartProxyInflation: Invalid part index " << partIndex);
+    return 0.0;
+  }
+  return this->Internal->Parts[partIndex].ProxyInflation;
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::SetPartToWorldMatrix(int partIndex, vtkMatrix4x4* partToWorldMatrix)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex))
+  {
+    vtkErrorMacro("SetPartToWorldMatrix: Invalid part index " << partIndex);
+    return;
+  }
+  if (partToWorldMatrix)
+  {
+    this->Internal->Parts[partIndex].PartToWorldMatrix->DeepCopy(partToWorldMatrix);
+  }
+  else
+  {
+    this->Internal->Parts[partIndex].PartToWorldMatrix->Identity();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::GetPartToWorldMatrix(int partIndex, vtkMatrix4x4* partToWorldMatrix)
+{
+  if (!this->Internal->IsValidPartIndex(partIndex) || !partToWorldMatrix)
+  {
+    vtkErrorMacro("GetPartToWorldMatrix: Invalid part index " << partIndex << " or output matrix");
+    return;
+  }
+  partToWorldMatrix->DeepCopy(this->Internal->Parts[partIndex].PartToWorldMatrix);
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::AddPartPair(int partIndex1, int partIndex2)
+{
+  if ( !this->Internal->IsValidPartIndex(partIndex1) || !this->Internal->IsValidPartIndex(partIndex2)
+    || partIndex1 == partIndex2 )
+  {
+    vtkErrorMacro("AddPartPair: Invalid part indices " << partIndex1 << " and " << partIndex2);
+    return -1;
+  }
+  CollisionPartPair pair;
+  pair.PartIndex1 = partIndex1;
+  pair.PartIndex2 = partIndex2;
+  pair.NumberOfContacts = 0;
+  this->Internal->PartPairs.push_back(pair);
+  this->Modified();
+  return static_cast<int>(this->Internal->PartPairs.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::GetNumberOfPartPairs()
+{
+  return static_cast<int>(this->Internal->PartPairs.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::GetPartPair(int pairIndex, int& partIndex1, int& partIndex2)
+{
+  if (!this->Internal->IsValidPartPairIndex(pairIndex))
+  {
+    vtkErrorMacro("GetPartPair: Invalid part pair index " << pairIndex);
+    partIndex1 = partIndex2 = -1;
+    return;
+  }
+  partIndex1 = this->Internal->PartPairs[pairIndex].PartIndex1;
+  partIndex2 = this->Internal->PartPairs[pairIndex].PartIndex2;
+}
+
+//----------------------------------------------------------------------------
+void vtkCollisionScene::BuildLocators()
+{
+  for (int partIndex = 0; partIndex < static_cast<int>(this->Internal->Parts.size()); ++partIndex)
+  {
+    CollisionPart& part = this->Internal->Parts[partIndex];
+    if (!this->Internal->IsPartCheckable(partIndex))
+    {
+      part.Tree = NULL;
+      part.ProxyTree = NULL;
+      continue;
+    }
+    bool treesBuilt = false;
+    if (this->Internal->UpdateTree(part.Mesh, part.Tree, part.TreeBuildTime, this->NumberOfCellsPerNode))
+    {
+      treesBuilt = true;
+      this->NumberOfTreeBuilds++;
+    }
+    if (!part.ProxyMesh || part.ProxyMesh->GetNumberOfCells() == 0)
+    {
+      part.ProxyTree = NULL;
+    }
+    else if (this->Internal->UpdateTree(part.ProxyMesh, part.ProxyTree, part.ProxyTreeBuildTime, this->NumberOfCellsPerNode))
+    {
+      treesBuilt = true;
+      this->NumberOfTreeBuilds++;
+    }
+    if (!treesBuilt)
+    {
+      continue;
+    }
+
+    // Bounding sphere of all points that may be checked for collision
+    double bounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    part.Mesh->GetBounds(bounds);
+    if (part.ProxyTree)
+    {
+      double proxyBounds[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+      part.ProxyMesh->GetBounds(proxyBounds);
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        bounds[2*axis] = std::min(bounds[2*axis], proxyBounds[2*axis]);
+        bounds[2*axis+1] = std::max(bounds[2*axis+1], proxyBounds[2*axis+1]);
+      }
+    }
+    double minimumPoint[3] = { bounds[0], bounds[2], bounds[4] };
+    double maximumPoint[3] = { bounds[1], bounds[3], bounds[5] };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      part.BoundingSphereCenter[axis] = (minimumPoint[axis] + maximumPoint[axis]) / 2.0;
+    }
+    part.BoundingSphereRadius = sqrt(vtkMath::Distance2BetweenPoints(minimumPoint, maximumPoint)) / 2.0;
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::CheckCollisions()
+{
+  double buildStartTime = vtkTimerLog::GetUniversalTime();
+  this->BuildLocators();
+  double queryStartTime = vtkTimerLog::GetUniversalTime();
+  this->LastBuildTime = queryStartTime - buildStartTime;
+
+  // Current part transforms form a single pose
+  std::vector<double> partToWorldElements(this->Internal->Parts.size() * 16, 0.0);
+  for (size_t partIndex = 0; partIndex < this->Internal->Parts.size(); ++partIndex)
+  {
+    vtkMatrix4x4::DeepCopy(&partToWorldElements[partIndex * 16], this->Internal->Parts[partIndex].PartToWorldMatrix);
+  }
+  std::vector<vtkIdType> numberOfContacts;
+  this->Internal->CheckPartPairs(partToWorldElements.empty() ? NULL : &partToWorldElements[0], 1,
+    this->BoxTolerance, this->CellTolerance, this->FirstContactOnly, this->NumberOfThreads, numberOfContacts);
+  this->LastQueryTime = vtkTimerLog::GetUniversalTime() - queryStartTime;
+
+  int numberOfPairsInCollision = 0;
+  for (size_t pairIndex = 0; pairIndex < this->Internal->PartPairs.size(); ++pairIndex)
+  {
+    this->Internal->PartPairs[pairIndex].NumberOfContacts = numberOfContacts[pairIndex];
+    if (numberOfContacts[pairIndex] > 0)
+    {
+      numberOfPairsInCollision++;
+    }
+  }
+  return numberOfPairsInCollision;
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::CheckCollisionsForPoses(vtkDoubleArray* partToWorldMatrices, vtkUnsignedCharArray* pairCollisions)
+{
+  if (!partToWorldMatrices || !pairCollisions)
+  {
+    vtkErrorMacro("CheckCollisionsForPoses: Invalid input or output array");
+    return -1;
+  }
+  int numberOfParts = this->GetNumberOfParts();
+  int numberOfPairs = this->GetNumberOfPartPairs();
+  if (partToWorldMatrices->GetNumberOfComponents() != numberOfParts * 16)
+  {
+    vtkErrorMacro("CheckCollisionsForPoses: Number of components in the part to world matrices array is "
+      << partToWorldMatrices->GetNumberOfComponents() << " instead of " << numberOfParts * 16);
+    return -1;
+  }
+  vtkIdType numberOfPoses = partToWorldMatrices->GetNumberOfTuples();
+  pairCollisions->SetNumberOfComponents(numberOfPairs > 0 ? numberOfPairs : 1);
+  pairCollisions->SetNumberOfTuples(numberOfPoses);
+  if (numberOfPoses == 0 || numberOfPairs == 0)
+  {
+    pairCollisions->FillComponent(0, 0);
+    return 0;
+  }
+
+  double buildStartTime = vtkTimerLog::GetUniversalTime();
+  this->BuildLocators();
+  double queryStartTime = vtkTimerLog::GetUniversalTime();
+  this->LastBuildTime = queryStartTime - buildStartTime;
+
+  // Only the presence of collision is reported, so each pair stops at the first contact
+  std::vector<vtkIdType> numberOfContacts;
+  this->Internal->CheckPartPairs(partToWorldMatrices->GetPointer(0), numberOfPoses,
+    this->BoxTolerance, this->CellTolerance, true, this->NumberOfThreads, numberOfContacts);
+  this->LastQueryTime = vtkTimerLog::GetUniversalTime() - queryStartTime;
+
+  int numberOfPosesInCollision = 0;
+  unsigned char* pairCollisionsPtr = pairCollisions->GetPointer(0);
+  for (vtkIdType poseIndex = 0; poseIndex < numberOfPoses; ++poseIndex)
+  {
+    bool poseInCollision = false;
+    for (int pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+    {
+      vtkIdType itemIndex = poseIndex * numberOfPairs + pairIndex;
+      pairCollisionsPtr[itemIndex] = (numberOfContacts[itemIndex] > 0 ? 1 : 0);
+      poseInCollision = poseInCollision || (numberOfContacts[itemIndex] > 0);
+    }
+    if (poseInCollision)
+    {
+      numberOfPosesInCollision++;
+    }
+  }
+  return numberOfPosesInCollision;
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::CheckCollisionsBetweenPoses(vtkDoubleArray* startPartToWorldMatrices, vtkDoubleArray* endPartToWorldMatrices,
+  vtkUnsignedCharArray* pairCollisions)
+{
+  if (!startPartToWorldMatrices || !endPartToWorldMatrices || !pairCollisions)
+  {
+    vtkErrorMacro("CheckCollisionsBetweenPoses: Invalid input or output array");
+    return -1;
+  }
+  int numberOfParts = this->GetNumberOfParts();
+  int numberOfPairs = this->GetNumberOfPartPairs();
+  if ( startPartToWorldMatrices->GetNumberOfComponents() != numberOfParts * 16
+    || endPartToWorldMatrices->GetNumberOfComponents() != numberOfParts * 16 )
+  {
+    vtkErrorMacro("CheckCollisionsBetweenPoses: Number of components in the part to world matrices arrays is "
+      << startPartToWorldMatrices->GetNumberOfComponents() << " and " << endPartToWorldMatrices->GetNumberOfComponents()
+      << " instead of " << numberOfParts * 16);
+    return -1;
+  }
+  vtkIdType numberOfMotions = startPartToWorldMatrices->GetNumberOfTuples();
+  if (endPartToWorldMatrices->GetNumberOfTuples() != numberOfMotions)
+  {
+    vtkErrorMacro("CheckCollisionsBetweenPoses: Number of start poses (" << numberOfMotions
+      << ") differs from the number of end poses (" << endPartToWorldMatrices->GetNumberOfTuples() << ")");
+    return -1;
+  }
+  pairCollisions->SetNumberOfComponents(numberOfPairs > 0 ? numberOfPairs : 1);
+  pairCollisions->SetNumberOfTuples(numberOfMotions);
+  if (numberOfMotions == 0 || numberOfPairs == 0)
+  {
+    pairCollisions->FillComponent(0, 0);
+    return 0;
+  }
+
+  double buildStartTime = vtkTimerLog::GetUniversalTime();
+  this->BuildLocators();
+  double queryStartTime = vtkTimerLog::GetUniversalTime();
+  this->LastBuildTime = queryStartTime - buildStartTime;
+
+  unsigned char* pairCollisionsPtr = pairCollisions->GetPointer(0);
+  this->Internal->CheckPartPairMotions(startPartToWorldMatrices->GetPointer(0), endPartToWorldMatrices->GetPointer(0), numberOfMotions,
+    this->SweepTolerance, this->NumberOfThreads, pairCollisionsPtr);
+  this->LastQueryTime = vtkTimerLog::GetUniversalTime() - queryStartTime;
+
+  int numberOfMotionsInCollision = 0;
+  for (vtkIdType motionIndex = 0; motionIndex < numberOfMotions; ++motionIndex)
+  {
+    for (int pairIndex = 0; pairIndex < numberOfPairs; ++pairIndex)
+    {
+      if (pairCollisionsPtr[motionIndex * numberOfPairs + pairIndex])
+      {
+        numberOfMotionsInCollision++;
+        break;
+      }
+    }
+  }
+  return numberOfMotionsInCollision;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCollisionScene::GetPartPairInCollision(int pairIndex)
+{
+  return this->GetPartPairNumberOfContacts(pairIndex) > 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkCollisionScene::GetPartPairNumberOfContacts(int pairIndex)
+{
+  if (!this->Internal->IsValidPartPairIndex(pairIndex))
+  {
+    vtkErrorMacro("GetPartPairNumberOfContacts: Invalid part pair index " << pairIndex);
+    return 0;
+  }
+  return static_cast<int>(this->Internal->PartPairs[pairIndex].NumberOfContacts);
+}
@@ -0,0 +1,195 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkCollisionScene_h
+#define __vtkCollisionScene_h
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkDoubleArray;
+class vtkMatrix4x4;
+class vtkPolyData;
+class vtkUnsignedCharArray;
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Collision detection between multiple rigidly moving triangle meshes
+///
+/// The parts of the scene and the pairs of parts to check are registered once. The OBB tree
+/// of each part is built only once and is shared by all pairs containing the part, then all
+/// pairs are checked in one call in parallel. Moving the parts only requires setting their
+/// part to world transforms. The OBB tree of a part is rebuilt only if its mesh is replaced or modified.
+///
+/// A simplified proxy mesh can be set for each part (\sa vtkCollisionProxyMeshFilter). Proxies are checked first,
+/// and the full meshes of a part pair are only checked if the proxies are close to each other.
+///
+/// Only triangles are processed, the same way as in \sa vtkCollisionDetectionFilter.
+class VTK_SLICERRTCOMMON_EXPORT vtkCollisionScene : public vtkObject
+{
+public:
+  static vtkCollisionScene* New();
+  vtkTypeMacro(vtkCollisionScene, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /// Add part to the scene
+  /// \param name Name of the part, also used to look up the part \sa GetPartIndex
+  /// \param mesh Triangle mesh of the part in the part coordinate system. Can be NULL if not available yet,
+  ///   pairs containing a part without mesh are not in collision.
+  /// \return Index of the new part
+  int AddPart(const char* name, vtkPolyData* mesh);
+  /// Remove all parts and part pairs
+  void RemoveAllParts();
+  /// Get number of parts
+  int GetNumberOfParts();
+  /// Get index of part by name
+  /// \return Index of the part, -1 if not found
+  int GetPartIndex(const char* name);
+  /// Get name of part
+  const char* GetPartName(int partIndex);
+
+  /// Set mesh of part. The OBB tree of the part is rebuilt before the next collision check.
+  void SetPartMesh(int partIndex, vtkPolyData* mesh);
+  /// Get mesh of part
+  vtkPolyData* GetPartMesh(int partIndex);
+
+  /// Set simplified mesh of part used in the broad phase of the collision checks. The full mesh of the part
+  /// must be within the inflation distance of the proxy mesh, so that part pairs whose proxy meshes are farther
+  /// apart than the sum of their inflations can be skipped without missing a collision.
+  /// \param proxyMesh Simplified triangle mesh in the part coordinate system. NULL if the full mesh is used.
+  /// \param inflation Largest distance of the full mesh from the proxy mesh including safety margin (mm)
+  void SetPartProxyMesh(int partIndex, vtkPolyData* proxyMesh, double inflation);
+  /// Get simplified mesh of part used in the broad phase
+  vtkPolyData* GetPartProxyMesh(int partIndex);
+  /// Get inflation distance of the proxy mesh of part
+  double GetPartProxyInflation(int partIndex);
+
+  /// Set transform from the part coordinate system to world. The matrix is copied. Identity by default.
+  void SetPartToWorldMatrix(int partIndex, vtkMatrix4x4* partToWorldMatrix);
+  /// Get transform from the part coordinate system to world
+  void GetPartToWorldMatrix(int partIndex, vtkMatrix4x4* partToWorldMatrix);
+
+  /// Add pair of parts to be checked for collision
+  /// \return Index of the new part pair, -1 on error
+  int AddPartPair(int partIndex1, int partIndex2);
+  /// Get number of part pairs
+  int GetNumberOfPartPairs();
+  /// Get the indices of the parts in a part pair
+  void GetPartPair(int pairIndex, int& partIndex1, int& partIndex2);
+
+  /// Build the OBB trees of all part meshes and proxy meshes that are not up to date. This is done automatically
+  /// by \sa CheckCollisions, but can be called in advance so that the first check is fast.
+  void BuildLocators();
+
+  /// Check all part pairs for collision with the current part transforms
+  /// \return Number of part pairs in collision
+  int CheckCollisions();
+
+  /// Check all part pairs for collision in many poses of the parts at once, for example to sweep the treatment machine
+  /// through an arc. All part pairs in all poses are checked in parallel. Each part pair stops at its first contact,
+  /// as only the presence of collision is reported. The transforms set by \sa SetPartToWorldMatrix are not used and
+  /// the results of \sa CheckCollisions are not changed.
+  /// \param partToWorldMatrices Part to world transforms, one tuple per pose. Each tuple contains the 16 elements
+  ///   of the row-major 4x4 matrix of each part, in part index order.
+  /// \param pairCollisions Output array with one tuple per pose and one component per part pair. A component is 1 if
+  ///   the part pair is in collision in the pose, 0 otherwise.
+  /// \return Number of poses with at least one part pair in collision, -1 on error
+  int CheckCollisionsForPoses(vtkDoubleArray* partToWorldMatrices, vtkUnsignedCharArray* pairCollisions);
+
+  /// Check all part pairs for collision during motions of the parts (continuous collision detection), for example
+  /// between two consecutive sampled gantry angles of an arc, where discrete checks could miss a collision.
+  /// Each part moves from its start pose to its end pose along a screw motion (rotation around a fixed axis combined
+  /// with translation along it), which is exact for the rotations of the treatment machine axes. The shorter rotation
+  /// is taken, so the start and end poses of a part must be less than 180 degrees apart.
+  ///
+  /// The motion is checked conservatively: the OBBs are inflated by a bound of the relative displacement of the parts
+  /// within a motion interval, and the interval is bisected only where the inflated boxes and then the triangles are
+  /// within that bound. A collision is therefore never missed, but a part pair that gets closer than \sa SweepTolerance
+  /// during the motion may be reported as in collision. The results of \sa CheckCollisions are not changed.
+  /// \param startPartToWorldMatrices Part to world transforms at the start of each motion, in the same format as in \sa CheckCollisionsForPoses
+  /// \param endPartToWorldMatrices Part to world transforms at the end of each motion
+  /// \param pairCollisions Output array with one tuple per motion and one component per part pair. A component is 1 if
+  ///   the part pair is in collision at any time during the motion, 0 otherwise.
+  /// \return Number of motions with at least one part pair in collision, -1 on error
+  int CheckCollisionsBetweenPoses(vtkDoubleArray* startPartToWorldMatrices, vtkDoubleArray* endPartToWorldMatrices,
+    vtkUnsignedCharArray* pairCollisions);
+
+  /// Get whether the part pair was in collision in the last check
+  bool GetPartPairInCollision(int pairIndex);
+  /// Get the number of contacting triangle pairs found for the part pair in the last check.
+  /// It is at most one if \sa FirstContactOnly is on.
+  int GetPartPairNumberOfContacts(int pairIndex);
+
+  /// If on, the check of a part pair stops at the first contacting triangle pair. This is enough when only
+  /// the presence of collision is needed. If off, all contacting triangle pairs are counted. On by default.
+  vtkSetMacro(FirstContactOnly, bool);
+  vtkGetMacro(FirstContactOnly, bool);
+  vtkBooleanMacro(FirstContactOnly, bool);
+
+  /// Tolerance of the OBB tests (absolute value, in world coordinates). Default is 0.0
+  vtkSetMacro(BoxTolerance, double);
+  vtkGetMacro(BoxTolerance, double);
+
+  /// Tolerance of the triangle tests (squared value). Default is 0.0
+  vtkSetMacro(CellTolerance, double);
+  vtkGetMacro(CellTolerance, double);
+
+  /// Number of cells in each OBB tree leaf. Default is 2
+  vtkSetMacro(NumberOfCellsPerNode, int);
+  vtkGetMacro(NumberOfCellsPerNode, int);
+
+  /// Number of threads used to check the part pairs. \sa SlicerRtCommon::SmpFor
+  vtkSetMacro(NumberOfThreads, int);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Distance (in mm) below which parts are considered to be in collision by \sa CheckCollisionsBetweenPoses.
+  /// Smaller values give fewer false alarms at the expense of more subdivisions of the motion. Default is 1.0
+  vtkSetMacro(SweepTolerance, double);
+  vtkGetMacro(SweepTolerance, double);
+
+  /// Get the time (in seconds) spent on building OBB trees and on the collision queries in the last check
+  vtkGetMacro(LastBuildTime, double);
+  vtkGetMacro(LastQueryTime, double);
+
+  /// Get the number of OBB tree builds since the scene was created
+  vtkGetMacro(NumberOfTreeBuilds, int);
+
+protected:
+  vtkCollisionScene();
+  ~vtkCollisionScene();
+
+protected:
+  bool FirstContactOnly;
+  double BoxTolerance;
+  double CellTolerance;
+  int NumberOfCellsPerNode;
+  int NumberOfThreads;
+  double SweepTolerance;
+
+  double LastBuildTime;
+  double LastQueryTime;
+  int NumberOfTreeBuilds;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkCollisionScene(const vtkCollisionScene&); // Not implemented
+  void operator=(const vtkCollisionScene&);    // Not implemented
+};
+
+#endif